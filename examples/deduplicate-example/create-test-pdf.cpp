@@ -22,32 +22,32 @@ int main()
         auto& duplicateString1 = doc.GetObjects().CreateObject(PdfObject(PdfString("Duplicate String")));
         auto& duplicateString2 = doc.GetObjects().CreateObject(PdfObject(PdfString("Duplicate String")));
         
-        auto& duplicateNumber1 = doc.GetObjects().CreateObject(PdfObject(42));
-        auto& duplicateNumber2 = doc.GetObjects().CreateObject(PdfObject(42));
-        auto& duplicateNumber3 = doc.GetObjects().CreateObject(PdfObject(42));
+        auto& duplicateNumber1 = doc.GetObjects().CreateObject(PdfObject(static_cast<int64_t>(42)));
+        auto& duplicateNumber2 = doc.GetObjects().CreateObject(PdfObject(static_cast<int64_t>(42)));
+        auto& duplicateNumber3 = doc.GetObjects().CreateObject(PdfObject(static_cast<int64_t>(42)));
         
         // Create duplicate arrays
         PdfArray arr1;
-        arr1.Add(PdfObject(1));
-        arr1.Add(PdfObject(2));
-        arr1.Add(PdfObject(3));
+        arr1.Add(PdfObject(static_cast<int64_t>(1)));
+        arr1.Add(PdfObject(static_cast<int64_t>(2)));
+        arr1.Add(PdfObject(static_cast<int64_t>(3)));
         
         PdfArray arr2;
-        arr2.Add(PdfObject(1));
-        arr2.Add(PdfObject(2));
-        arr2.Add(PdfObject(3));
+        arr2.Add(PdfObject(static_cast<int64_t>(1)));
+        arr2.Add(PdfObject(static_cast<int64_t>(2)));
+        arr2.Add(PdfObject(static_cast<int64_t>(3)));
         
         auto& duplicateArray1 = doc.GetObjects().CreateObject(arr1);
         auto& duplicateArray2 = doc.GetObjects().CreateObject(arr2);
         
         // Create duplicate dictionaries
         PdfDictionary dict1;
-        dict1.AddKey("Key1", PdfObject(100));
+        dict1.AddKey("Key1", PdfObject(static_cast<int64_t>(100)));
         dict1.AddKey("Key2", PdfObject(PdfString("Value")));
         dict1.AddKey("Key3", duplicateNumber1.GetIndirectReference());
         
         PdfDictionary dict2;
-        dict2.AddKey("Key1", PdfObject(100));
+        dict2.AddKey("Key1", PdfObject(static_cast<int64_t>(100)));
         dict2.AddKey("Key2", PdfObject(PdfString("Value")));
         dict2.AddKey("Key3", duplicateNumber2.GetIndirectReference());
         
@@ -55,12 +55,14 @@ int main()
         auto& duplicateDict2 = doc.GetObjects().CreateObject(dict2);
         
         // Create some content on the page that references these objects
-        auto& painter = page.GetPainter();
-        painter.SetColor(0.5, 0.5, 0.5);
-        painter.DrawRect(100, 100, 200, 200);
-        
+        PdfPainter painter;
+        painter.SetCanvas(page);
+        painter.GraphicsState.SetNonStrokingColor(PdfColor(0.5, 0.5, 0.5));
+        painter.DrawRectangle(100, 100, 200, 200, PdfPathDrawMode::Fill);
+
         // Add some text
-        painter.SetColor(0, 0, 0);
+        painter.GraphicsState.SetNonStrokingColor(PdfColor(0, 0, 0));
+        painter.TextState.SetFont(doc.GetFonts().GetStandard14Font(PdfStandard14FontType::Helvetica), 12);
         painter.DrawText("Test PDF with duplicate objects", 100, 300);
         painter.FinishDrawing();
         
@@ -25,6 +25,42 @@ bool InputStreamDevice::Peek(char& ch) const
     return peek(ch);
 }
 
+bool InputStreamDevice::TryGetView(bufferview& view) const
+{
+    EnsureAccess(DeviceAccess::Read);
+    return tryGetView(view);
+}
+
+bool InputStreamDevice::tryGetView(bufferview& view) const
+{
+    (void)view;
+    return false;
+}
+
+bool InputStreamDevice::TryPeekBuffer(bufferview& view) const
+{
+    EnsureAccess(DeviceAccess::Read);
+    return tryPeekBuffer(view);
+}
+
+void InputStreamDevice::Advance(size_t count)
+{
+    EnsureAccess(DeviceAccess::Read);
+    advance(count);
+}
+
+bool InputStreamDevice::tryPeekBuffer(bufferview& view) const
+{
+    (void)view;
+    return false;
+}
+
+void InputStreamDevice::advance(size_t count)
+{
+    (void)count;
+    PODOFO_RAISE_ERROR(PdfErrorCode::NotImplemented);
+}
+
 void InputStreamDevice::checkRead() const
 {
     EnsureAccess(DeviceAccess::Read);
@@ -10,6 +10,7 @@
 #include <istream>
 #include <fstream>
 
+#include "basetypes.h"
 #include "StreamDeviceBase.h"
 #include "InputStream.h"
 
@@ -31,12 +32,49 @@ public:
      */
     bool Peek(char& ch) const;
 
+    /** Try to get a view on the whole content of the device,
+     * if it's backed by memory
+     * \returns false if the device content is not available in memory
+     * \remarks The view is valid as long as the device is not
+     * modified or destroyed
+     */
+    bool TryGetView(bufferview& view) const;
+
+    /** Try to get a view on the contiguous data that can be read
+     * from the current position, without consuming it
+     * \returns false if the device doesn't support peeking buffers.
+     * The view may be empty if no data is currently available
+     * as a contiguous buffer, e.g. on EOF
+     * \remarks The view is valid until the next operation on the device
+     */
+    bool TryPeekBuffer(bufferview& view) const;
+
+    /** Consume data previously peeked with TryPeekBuffer
+     * \param count number of bytes to consume, must not exceed
+     * the size of the peeked view
+     */
+    void Advance(size_t count);
+
 protected:
     /** Peek at next char in stream.
      *  /returns true if success, false if EOF
      */
     virtual bool peek(char& ch) const = 0;
 
+    /** Try to get a view on the whole content of the device
+     * The default implementation returns false
+     */
+    virtual bool tryGetView(bufferview& view) const;
+
+    /** Try to get a view on the contiguous data that can be read
+     * from the current position. The default implementation returns false
+     */
+    virtual bool tryPeekBuffer(bufferview& view) const;
+
+    /** Consume peeked data. The default implementation raises NotImplemented
+     */
+    virtual void advance(size_t count);
+
     void checkRead() const override;
 };
 
@@ -10,6 +10,17 @@
 #include <fstream>
 
 #include <podofo/private/FileSystem.h>
+#include <podofo/private/utfcpp_extensions.h>
+
+#ifdef _WIN32
+#include <podofo/private/WindowsLeanMean.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#endif // _WIN32
 
 using namespace std;
 using namespace PoDoFo;
@@ -86,6 +97,8 @@ void seek(TStream& stream, ssize_t pos, SeekDirection direction)
 }
 
 static FILE* createFile(const string_view& filename, FileMode mode, DeviceAccess access);
+static const char* mapFile(const string_view& filepath, size_t& length);
+static void unmapFile(const char* buffer, size_t length);
 
 StreamDevice::StreamDevice(DeviceAccess access)
     : InputStreamDevice(false), OutputStreamDevice(false)
@@ -459,6 +472,59 @@ void FileStreamDevice::writeBuffer(const char* buffer, size_t size)
         PODOFO_RAISE_ERROR_INFO(PdfErrorCode::IOError, "Failed to write the given buffer");
 }
 
+void FileStreamDevice::writeBuffers(const bufferview& first, const bufferview& second)
+{
+#ifndef _WIN32
+    // Flush the stdio buffer, so the descriptor is in sync with the
+    // FILE position, and write both the buffers with one system call
+    flush();
+    int fd = fileno(m_file);
+    if (fd != -1)
+    {
+        iovec vecs[2] = {
+            { const_cast<char*>(first.data()), first.size() },
+            { const_cast<char*>(second.data()), second.size() },
+        };
+        iovec* vec = vecs;
+        int count = 2;
+        while (count != 0)
+        {
+            ssize_t written = ::writev(fd, vec, count);
+            if (written == -1)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                PODOFO_RAISE_ERROR_INFO(PdfErrorCode::IOError, "Failed to write the given buffer");
+            }
+
+            // Skip what was written, the write may be partial
+            while (count != 0 && (size_t)written >= vec->iov_len)
+            {
+                written -= (ssize_t)vec->iov_len;
+                vec++;
+                count--;
+            }
+
+            if (count != 0)
+            {
+                vec->iov_base = (char*)vec->iov_base + written;
+                vec->iov_len -= (size_t)written;
+            }
+        }
+
+        // Sync again the FILE position with the descriptor
+        if (utls::fseek(m_file, 0, SEEK_CUR) != 0)
+            PODOFO_RAISE_ERROR_INFO(PdfErrorCode::IOError, "Failed to seek after writing the given buffer");
+
+        return;
+    }
+#endif // _WIN32
+
+    writeBuffer(first.data(), first.size());
+    writeBuffer(second.data(), second.size());
+}
+
 void FileStreamDevice::flush()
 {
     int rc = std::fflush(m_file);
@@ -553,6 +619,222 @@ void FileStreamDevice::close()
     m_file = nullptr;
 }
 
+BufferedOutputStreamDevice::BufferedOutputStreamDevice(OutputStreamDevice& device, size_t bufferSize)
+    : m_device(&device), m_file(dynamic_cast<FileStreamDevice*>(&device)),
+    m_BufferSize(bufferSize), m_Position(device.GetPosition())
+{
+    m_buffer.reserve(bufferSize);
+}
+
+BufferedOutputStreamDevice::~BufferedOutputStreamDevice()
+{
+    try
+    {
+        close();
+    }
+    catch (...)
+    {
+        // Do nothing, it should not throw
+    }
+}
+
+size_t BufferedOutputStreamDevice::GetLength() const
+{
+    const_cast<BufferedOutputStreamDevice&>(*this).flushBuffer();
+    return m_device->GetLength();
+}
+
+size_t BufferedOutputStreamDevice::GetPosition() const
+{
+    return m_Position;
+}
+
+bool BufferedOutputStreamDevice::CanSeek() const
+{
+    return m_device->CanSeek();
+}
+
+bool BufferedOutputStreamDevice::Eof() const
+{
+    return false;
+}
+
+void BufferedOutputStreamDevice::writeBuffer(const char* buffer, size_t size)
+{
+    if (m_buffer.size() + size <= m_BufferSize)
+    {
+        m_buffer.append(buffer, size);
+    }
+    else
+    {
+        if (m_file == nullptr)
+        {
+            flushBuffer();
+            m_device->Write(buffer, size);
+        }
+        else
+        {
+            m_file->writeBuffers(m_buffer, { buffer, size });
+            m_buffer.clear();
+        }
+    }
+
+    m_Position += size;
+}
+
+void BufferedOutputStreamDevice::flush()
+{
+    flushBuffer();
+}
+
+void BufferedOutputStreamDevice::seek(ssize_t offset, SeekDirection direction)
+{
+    flushBuffer();
+    m_device->Seek(offset, direction);
+    m_Position = m_device->GetPosition();
+}
+
+void BufferedOutputStreamDevice::close()
+{
+    flushBuffer();
+}
+
+void BufferedOutputStreamDevice::flushBuffer()
+{
+    if (m_buffer.size() == 0)
+        return;
+
+    m_device->Write(m_buffer.data(), m_buffer.size());
+    m_buffer.clear();
+}
+
+MappedFileStreamDevice::MappedFileStreamDevice(const string_view& filepath)
+    : StreamDevice(DeviceAccess::Read), m_buffer(nullptr), m_Length(0), m_Position(0), m_Filepath(filepath)
+{
+    m_buffer = mapFile(filepath, m_Length);
+}
+
+MappedFileStreamDevice::~MappedFileStreamDevice()
+{
+    try
+    {
+        close();
+    }
+    catch (...)
+    {
+        // Do nothing, it should not throw
+    }
+}
+
+void MappedFileStreamDevice::Unmap()
+{
+    if (!IsMapped())
+        return;
+
+    m_copy.assign(m_buffer, m_buffer + m_Length);
+    unmapFile(m_buffer, m_Length);
+    m_buffer = m_copy.data();
+}
+
+size_t MappedFileStreamDevice::GetLength() const
+{
+    return m_Length;
+}
+
+size_t MappedFileStreamDevice::GetPosition() const
+{
+    return m_Position;
+}
+
+bool MappedFileStreamDevice::CanSeek() const
+{
+    return true;
+}
+
+bool MappedFileStreamDevice::Eof() const
+{
+    return m_Position == m_Length;
+}
+
+void MappedFileStreamDevice::writeBuffer(const char* buffer, size_t size)
+{
+    (void)buffer;
+    (void)size;
+    PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Unsupported write on a memory mapped file");
+}
+
+size_t MappedFileStreamDevice::readBuffer(char* buffer, size_t size, bool& eof)
+{
+    size_t readCount = std::min(size, m_Length - m_Position);
+    std::memcpy(buffer, m_buffer + m_Position, readCount);
+    m_Position += readCount;
+    eof = m_Position == m_Length;
+    return readCount;
+}
+
+bool MappedFileStreamDevice::readChar(char& ch)
+{
+    if (m_Position == m_Length)
+    {
+        ch = '\0';
+        return false;
+    }
+
+    ch = m_buffer[m_Position];
+    m_Position++;
+    return true;
+}
+
+bool MappedFileStreamDevice::peek(char& ch) const
+{
+    if (m_Position == m_Length)
+    {
+        ch = '\0';
+        return false;
+    }
+
+    ch = m_buffer[m_Position];
+    return true;
+}
+
+void MappedFileStreamDevice::seek(ssize_t offset, SeekDirection direction)
+{
+    m_Position = SeekPosition(m_Position, m_Length, offset, direction);
+}
+
+bool MappedFileStreamDevice::tryGetView(bufferview& view) const
+{
+    view = bufferview(m_buffer, m_Length);
+    return true;
+}
+
+bool MappedFileStreamDevice::tryPeekBuffer(bufferview& view) const
+{
+    view = bufferview(m_buffer + m_Position, m_Length - m_Position);
+    return true;
+}
+
+void MappedFileStreamDevice::advance(size_t count)
+{
+    PODOFO_ASSERT(count <= m_Length - m_Position);
+    m_Position += count;
+}
+
+void MappedFileStreamDevice::close()
+{
+    if (m_buffer == nullptr)
+        return;
+
+    if (m_copy.size() == 0)
+        unmapFile(m_buffer, m_Length);
+    else
+        m_copy = charbuff();
+
+    m_buffer = nullptr;
+    m_Length = 0;
+    m_Position = 0;
+}
+
 NullStreamDevice::NullStreamDevice()
     : StreamDevice(DeviceAccess::ReadWrite), m_Length(0), m_Position(0)
 {
@@ -719,6 +1001,24 @@ void SpanStreamDevice::seek(ssize_t offset, SeekDirection direction)
     m_Position = SeekPosition(m_Position, m_Length, offset, direction);
 }
 
+bool SpanStreamDevice::tryGetView(bufferview& view) const
+{
+    view = bufferview(m_buffer, m_Length);
+    return true;
+}
+
+bool SpanStreamDevice::tryPeekBuffer(bufferview& view) const
+{
+    view = bufferview(m_buffer + m_Position, m_Length - m_Position);
+    return true;
+}
+
+void SpanStreamDevice::advance(size_t count)
+{
+    PODOFO_ASSERT(count <= m_Length - m_Position);
+    m_Position += count;
+}
+
 FILE* createFile(const string_view& filepath, FileMode mode, DeviceAccess access)
 {
     string cmode;
@@ -858,3 +1158,90 @@ FILE* createFile(const string_view& filepath, FileMode mode, DeviceAccess access
 
     return stream;
 }
+
+#ifdef _WIN32
+
+const char* mapFile(const string_view& filepath, size_t& length)
+{
+    auto filepath16 = utf8::utf8to16((string)filepath);
+    HANDLE file = CreateFileW((wchar_t*)filepath16.c_str(), GENERIC_READ, FILE_SHARE_READ,
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::IOError, "Error accessing file {}", filepath);
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size))
+    {
+        CloseHandle(file);
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::IOError, "Failed to determine the file length of {}", filepath);
+    }
+
+    length = (size_t)size.QuadPart;
+    if (length == 0)
+    {
+        // Empty files can't be mapped
+        CloseHandle(file);
+        return nullptr;
+    }
+
+    // NOTE: The view keeps a reference to the mapping,
+    // so both handles can be closed right after mapping
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::IOError, "Failed to map file {}", filepath);
+
+    auto ret = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (ret == nullptr)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::IOError, "Failed to map file {}", filepath);
+
+    return ret;
+}
+
+void unmapFile(const char* buffer, size_t length)
+{
+    (void)length;
+    if (!UnmapViewOfFile(buffer))
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::IOError, "Failed to unmap file");
+}
+
+#else // _WIN32
+
+const char* mapFile(const string_view& filepath, size_t& length)
+{
+    int fd = ::open(((string)filepath).c_str(), O_RDONLY);
+    if (fd == -1)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::IOError, "Error accessing file {}", filepath);
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::IOError, "Failed to determine the file length of {}", filepath);
+    }
+
+    length = (size_t)st.st_size;
+    if (length == 0)
+    {
+        // Empty files can't be mapped
+        ::close(fd);
+        return nullptr;
+    }
+
+    // NOTE: The mapping stays valid after closing the descriptor
+    void* ret = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (ret == MAP_FAILED)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::IOError, "Failed to map file {}", filepath);
+
+    return (const char*)ret;
+}
+
+void unmapFile(const char* buffer, size_t length)
+{
+    if (::munmap(const_cast<char*>(buffer), length) != 0)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::IOError, "Failed to unmap file");
+}
+
+#endif // _WIN32
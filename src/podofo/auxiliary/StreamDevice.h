@@ -135,11 +135,79 @@ protected:
     void seek(ssize_t offset, SeekDirection direction) override;
     void close() override;
 
+private:
+    PODOFO_PRIVATE_FRIEND(class PdfParserObjectStream);
+    friend class BufferedOutputStreamDevice;
+
+    void writeBuffers(const bufferview& first, const bufferview& second);
+
 private:
     FILE* m_file;
     std::string m_Filepath;
 };
 
+/** A read-only device that maps the whole file in memory
+ *
+ * Reads don't go through stdio: they are plain memory accesses
+ * on the mapped pages, which are shared with the OS page cache.
+ * \remarks The file must not be truncated or overwritten while
+ * it's mapped, also by this process: accessing pages past the
+ * new end of file raises a SIGBUS signal. Call Unmap() first
+ */
+class PODOFO_API MappedFileStreamDevice final : public StreamDevice
+{
+public:
+    /** Map for reading the supplied filepath
+     */
+    MappedFileStreamDevice(const std::string_view& filepath);
+
+    ~MappedFileStreamDevice();
+
+public:
+    const std::string& GetFilepath() const { return m_Filepath; }
+
+    /** Get a view on the whole mapped file content
+     * \remarks The view is valid until the device is closed or destroyed
+     */
+    bufferview GetView() const { return bufferview(m_buffer, m_Length); }
+
+    /** Copy the file content in memory and release the mapping,
+     * so the file can be overwritten while the device is still read
+     * \remarks Views obtained before are invalidated
+     */
+    void Unmap();
+
+    /** True if the device still maps the file
+     */
+    bool IsMapped() const { return m_buffer != nullptr && m_copy.size() == 0; }
+
+    size_t GetLength() const override;
+
+    size_t GetPosition() const override;
+
+    bool CanSeek() const override;
+
+    bool Eof() const override;
+
+protected:
+    void writeBuffer(const char* buffer, size_t size) override;
+    size_t readBuffer(char* buffer, size_t size, bool& eof) override;
+    bool readChar(char& ch) override;
+    bool peek(char& ch) const override;
+    void seek(ssize_t offset, SeekDirection direction) override;
+    bool tryGetView(bufferview& view) const override;
+    bool tryPeekBuffer(bufferview& view) const override;
+    void advance(size_t count) override;
+    void close() override;
+
+private:
+    const char* m_buffer;
+    size_t m_Length;
+    size_t m_Position;
+    std::string m_Filepath;
+    charbuff m_copy;
+};
+
 template <typename TContainer>
 class ContainerStreamDevice : public StreamDevice
 {
@@ -220,6 +288,23 @@ protected:
         m_Position = SeekPosition(m_Position, m_container->size(), offset, direction);
     }
 
+    bool tryGetView(bufferview& view) const override
+    {
+        view = bufferview(m_container->data(), m_container->size());
+        return true;
+    }
+
+    bool tryPeekBuffer(bufferview& view) const override
+    {
+        view = bufferview(m_container->data() + m_Position, m_container->size() - m_Position);
+        return true;
+    }
+
+    void advance(size_t count) override
+    {
+        m_Position += std::min(count, m_container->size() - m_Position);
+    }
+
 private:
     TContainer* m_container;
     size_t m_Position;
@@ -258,6 +343,9 @@ protected:
     bool readChar(char& ch) override;
     bool peek(char& ch) const override;
     void seek(ssize_t offset, SeekDirection direction) override;
+    bool tryGetView(bufferview& view) const override;
+    bool tryPeekBuffer(bufferview& view) const override;
+    void advance(size_t count) override;
 
 private:
     SpanStreamDevice(std::nullptr_t) = delete;
@@ -295,6 +383,60 @@ private:
     size_t m_Position;
 };
 
+/** An output device that combines the writes to another device
+ *  in a large buffer
+ *
+ *  Small writes are only copied to the buffer. A write that doesn't
+ *  fit is written to the device together with the buffered data,
+ *  with a single vectored write when the device is a FileStreamDevice
+ *  on POSIX systems. The position is tracked without querying
+ *  the device.
+ *  \remarks Flush() only writes the buffered data to the device,
+ *  which is not flushed itself: call Flush() before using the device
+ *  directly and flush the device when done writing
+ */
+class PODOFO_API BufferedOutputStreamDevice final : public OutputStreamDevice
+{
+public:
+    static constexpr size_t DefaultBufferSize = 1024 * 1024;
+
+    /**
+     * \param device the device where the data is written. It is
+     *     not owned, and it must outlive this device
+     * \param bufferSize the size of the buffer
+     */
+    BufferedOutputStreamDevice(OutputStreamDevice& device, size_t bufferSize = DefaultBufferSize);
+
+    ~BufferedOutputStreamDevice();
+
+public:
+    size_t GetLength() const override;
+
+    size_t GetPosition() const override;
+
+    bool CanSeek() const override;
+
+    bool Eof() const override;
+
+    OutputStreamDevice& GetDevice() const { return *m_device; }
+
+protected:
+    void writeBuffer(const char* buffer, size_t size) override;
+    void flush() override;
+    void seek(ssize_t offset, SeekDirection direction) override;
+    void close() override;
+
+private:
+    void flushBuffer();
+
+private:
+    OutputStreamDevice* m_device;
+    FileStreamDevice* m_file;
+    charbuff m_buffer;
+    size_t m_BufferSize;
+    size_t m_Position;
+};
+
 using VectorStreamDevice = ContainerStreamDevice<std::vector<char>>;
 using StringStreamDevice = ContainerStreamDevice<std::string>;
 using BufferStreamDevice = ContainerStreamDevice<charbuff>;
@@ -5,6 +5,7 @@
  */
 
 #include <podofo/private/PdfDeclarationsPrivate.h>
+#include <podofo/private/PdfArena.h>
 #include "PdfArray.h"
 
 #include <podofo/auxiliary/OutputDevice.h>
@@ -93,6 +94,17 @@ PdfArray& PdfArray::operator=(PdfArray&& rhs) noexcept
     return *this;
 }
 
+void* PdfArray::operator new(size_t size)
+{
+    static_assert(alignof(PdfArray) <= PdfArena::Alignment, "Unsupported alignment");
+    return PdfArena::Allocate(size);
+}
+
+void PdfArray::operator delete(void* ptr) noexcept
+{
+    PdfArena::Deallocate(ptr);
+}
+
 unsigned PdfArray::GetSize() const
 {
     return (unsigned)m_Objects.size();
@@ -118,6 +118,13 @@ public:
     PdfArray& operator=(const PdfArray& rhs);
     PdfArray& operator=(PdfArray&& rhs) noexcept;
 
+    /** Arrays are allocated from the arena active on the
+     * current thread, if any
+     * \see PdfLoadOptions::ArenaAllocation
+     */
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr) noexcept;
+
     /**
      *  \returns the size of the array
      */
@@ -81,6 +81,22 @@ bool PdfCanvasInputDevice::peek(char& ch) const
     }
 }
 
+bool PdfCanvasInputDevice::tryPeekBuffer(bufferview& view) const
+{
+    // Offer only the remaining content of the current device:
+    // device switches and EOF are handled by per character reads
+    if (m_eof || m_deviceSwitchOccurred || !m_currDevice->TryPeekBuffer(view))
+        view = { };
+
+    return true;
+}
+
+void PdfCanvasInputDevice::advance(size_t count)
+{
+    PODOFO_ASSERT(!m_eof && !m_deviceSwitchOccurred);
+    m_currDevice->Advance(count);
+}
+
 size_t PdfCanvasInputDevice::readBuffer(char* buffer, size_t size, bool& eof)
 {
     PODOFO_ASSERT(size != 0);
@@ -37,6 +37,8 @@ protected:
     size_t readBuffer(char* buffer, size_t size, bool& eof) override;
     bool readChar(char& ch) override;
     bool peek(char& ch) const override;
+    bool tryPeekBuffer(bufferview& view) const override;
+    void advance(size_t count) override;
 private:
     bool m_eof;
     std::list<const PdfObject*> m_contents;
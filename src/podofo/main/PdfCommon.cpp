@@ -9,6 +9,8 @@
 #include "PdfCommon.h"
 #include "PdfFontManager.h"
 
+#include <atomic>
+
 using namespace std;
 using namespace PoDoFo;
 
@@ -39,6 +41,15 @@ PODOFO_EXPORT ssl::OpenSSLMain s_SSL;
 
 static unsigned s_MaxObjectCount = (1U << 23) - 1;
 
+// NOTE: The flate settings are read by the threads
+// compressing the streams in parallel while saving
+static atomic<int> s_FlateCompressionLevel(-1);
+#ifdef PODOFO_HAVE_LIBDEFLATE
+static atomic<PdfFlateBackend> s_FlateBackend(PdfFlateBackend::LibDeflate);
+#else
+static atomic<PdfFlateBackend> s_FlateBackend(PdfFlateBackend::ZLib);
+#endif // PODOFO_HAVE_LIBDEFLATE
+
 void ssl::Init()
 {
     // Initialize the OpenSSL singleton
@@ -95,3 +106,47 @@ unsigned PdfCommon::GetMaxRecursionDepth()
 {
     return s_MaxRecursionDepth;
 }
+
+void PdfCommon::SetFlateCompressionLevel(int level)
+{
+    if (level < -1 || level > 12)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "The compression level must be between -1 and 12");
+
+    s_FlateCompressionLevel = level;
+}
+
+int PdfCommon::GetFlateCompressionLevel()
+{
+    return s_FlateCompressionLevel;
+}
+
+void PdfCommon::SetFlateBackend(PdfFlateBackend backend)
+{
+    switch (backend)
+    {
+        case PdfFlateBackend::Default:
+#ifdef PODOFO_HAVE_LIBDEFLATE
+            s_FlateBackend = PdfFlateBackend::LibDeflate;
+#else
+            s_FlateBackend = PdfFlateBackend::ZLib;
+#endif // PODOFO_HAVE_LIBDEFLATE
+            break;
+        case PdfFlateBackend::ZLib:
+            s_FlateBackend = backend;
+            break;
+        case PdfFlateBackend::LibDeflate:
+#ifdef PODOFO_HAVE_LIBDEFLATE
+            s_FlateBackend = backend;
+            break;
+#else
+            PODOFO_RAISE_ERROR_INFO(PdfErrorCode::NotImplemented, "PoDoFo was built without libdeflate support");
+#endif // PODOFO_HAVE_LIBDEFLATE
+        default:
+            PODOFO_RAISE_ERROR(PdfErrorCode::InvalidEnumValue);
+    }
+}
+
+PdfFlateBackend PdfCommon::GetFlateBackend()
+{
+    return s_FlateBackend;
+}
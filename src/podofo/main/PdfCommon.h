@@ -46,6 +46,30 @@ public:
 
     static unsigned GetMaxObjectCount();
     static void SetMaxObjectCount(unsigned maxObjectCount);
+
+    /** Set the compression level used for FlateDecode streams
+     * \param level -1 for the default level, 0 for no compression
+     *     up to 9 for the best zlib compression. Levels 10 to 12
+     *     are slower archival levels available with libdeflate,
+     *     they are clamped to 9 with zlib
+     * \remarks The setting is process wide. It's safe to change it
+     *     while other threads save, and it applies to the streams
+     *     compressed afterwards
+     */
+    static void SetFlateCompressionLevel(int level);
+
+    static int GetFlateCompressionLevel();
+
+    /** Set the library used to compress and decompress FlateDecode streams
+     * \remarks PdfFlateBackend::LibDeflate requires PoDoFo to be
+     *     built with libdeflate support
+     */
+    static void SetFlateBackend(PdfFlateBackend backend);
+
+    /** Get the library used to compress and decompress FlateDecode
+     * streams, resolving PdfFlateBackend::Default
+     */
+    static PdfFlateBackend GetFlateBackend();
 };
 
 }
@@ -237,6 +237,16 @@ enum class PdfFilterType : uint8_t
     Crypt
 };
 
+/**
+ * The library used to compress and decompress FlateDecode streams
+ */
+enum class PdfFlateBackend : uint8_t
+{
+    Default = 0,               ///< Use libdeflate if available, zlib otherwise
+    ZLib,                      ///< Always use the zlib streaming API
+    LibDeflate,                ///< Compress and, when the decoded length is known, decompress whole buffers with libdeflate
+};
+
 enum class PdfExportFormat : uint8_t
 {
     Png = 1,        ///< NOTE: Not yet supported
@@ -490,6 +500,25 @@ enum class PdfSaveOptions
      * a regular save operation
      */
     SaveOnSigning = 64,
+    /** Pack the objects that are not streams in flate compressed
+     * object streams, writing a cross-reference stream. It requires
+     * PDF 1.5, so the output version is raised if needed
+     * \remarks It has no effect on incremental updates
+     */
+    ObjectStreams = 128,
+    /** Write a linearized ("Fast Web View") file, where the first
+     * page can be displayed before the whole file is downloaded.
+     * The objects are renumbered and reordered, see ISO 32000-2:2020 Annex F
+     * \remarks It has no effect on incremental updates. The objects are
+     * written with a cross-reference table, so ObjectStreams is ignored
+     */
+    Linearize = 256,
+    /** Compress and encrypt the streams with a thread per hardware
+     * core. The objects are still written in order
+     * \remarks Streams still referenced in the source device of
+     * a loaded document are written serially
+     */
+    ParallelWrite = 512,
 
     /**
       * \deprecated Use NoMetadataUpdate instead
@@ -497,6 +526,43 @@ enum class PdfSaveOptions
     NoModifyDateUpdate = NoMetadataUpdate
 };
 
+enum class PdfLoadOptions
+{
+    None = 0,
+    /** Map the file in memory instead of reading it through stdio.
+     * \remarks Only meaningful when loading from a file path
+     */
+    MemoryMapped = 1,
+    /** Fully load the document, parsing the objects with a thread
+     * per hardware core, instead of loading them on demand.
+     * When loading from a file path, the file is also mapped in memory
+     * \remarks Encrypted documents and devices not backed by memory
+     * are loaded serially
+     */
+    ParallelLoad = 2,
+    /** Rebuild the xref table with a scan of the whole file,
+     * when it's broken or it doesn't locate the document catalog
+     */
+    RebuildBrokenXRef = 4,
+    /** Allocate the objects created while loading from an arena
+     * owned by the document, which is released all at once when
+     * the document is cleared or destroyed. It's best combined
+     * with ParallelLoad, which creates all the objects while loading
+     * \remarks Dictionaries, arrays and objects of the document must
+     * not be moved to objects outliving the document. Objects
+     * removed from the document are handed out as heap copies
+     */
+    ArenaAllocation = 8,
+    /** Reference the raw data of unencrypted streams in the source
+     * device also when fully loading the document, instead of copying
+     * it in memory, so unchanged streams are written verbatim from the
+     * source when saving. Demand loaded documents always do so
+     * \remarks The source device is kept alive with the document and
+     * its content must not change until the document is closed
+     */
+    ReferenceStreamData = 16,
+};
+
 enum class PdfAdditionalMetadata : uint8_t
 {
     PdfAIdAmd = 1,
@@ -879,6 +945,7 @@ using PdfFilterList = std::vector<PdfFilterType>;
 };
 
 ENABLE_BITMASK_OPERATORS(PoDoFo::PdfSaveOptions);
+ENABLE_BITMASK_OPERATORS(PoDoFo::PdfLoadOptions);
 ENABLE_BITMASK_OPERATORS(PoDoFo::PdfWriteFlags);
 ENABLE_BITMASK_OPERATORS(PoDoFo::PdfInfoInitial);
 ENABLE_BITMASK_OPERATORS(PoDoFo::PdfFontStyle);
@@ -5,6 +5,7 @@
  */
 
 #include <podofo/private/PdfDeclarationsPrivate.h>
+#include <podofo/private/PdfArena.h>
 #include "PdfDictionary.h"
 
 #include <podofo/auxiliary/OutputDevice.h>
@@ -45,6 +46,17 @@ PdfDictionary& PdfDictionary::operator=(PdfDictionary&& rhs) noexcept
     return *this;
 }
 
+void* PdfDictionary::operator new(size_t size)
+{
+    static_assert(alignof(PdfDictionary) <= PdfArena::Alignment, "Unsupported alignment");
+    return PdfArena::Allocate(size);
+}
+
+void PdfDictionary::operator delete(void* ptr) noexcept
+{
+    PdfArena::Deallocate(ptr);
+}
+
 bool PdfDictionary::operator==(const PdfDictionary& rhs) const
 {
     if (this == &rhs)
@@ -111,6 +111,13 @@ public:
     PdfDictionary& operator=(const PdfDictionary& rhs);
     PdfDictionary& operator=(PdfDictionary&& rhs) noexcept;
 
+    /** Dictionaries are allocated from the arena active on the
+     * current thread, if any
+     * \see PdfLoadOptions::ArenaAllocation
+     */
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr) noexcept;
+
     /**
      * Comparison operator. If this dictionary contains all the same keys
      * as the other dictionary, and for each key the values compare equal,
@@ -6,6 +6,7 @@
 
 #include <podofo/private/PdfDeclarationsPrivate.h>
 #include <podofo/private/XMPUtils.h>
+#include <podofo/private/PdfDocumentMerger.h>
 #include "PdfDocument.h"
 
 #include "PdfExtGState.h"
@@ -62,6 +63,7 @@ void PdfDocument::Clear()
     m_AcroForm = nullptr;
     m_Outlines = nullptr;
     m_NameTrees = nullptr;
+    m_Merger = nullptr;
     m_Objects.Clear();
     clear();
 }
@@ -96,75 +98,50 @@ void PdfDocument::Init()
 
 void PdfDocument::AppendDocumentPages(const PdfDocument& doc)
 {
-    append(doc, true);
+    insertDocumentPages(m_Pages->GetCount(), doc, 0, doc.GetPages().GetCount(), true);
 }
 
-void PdfDocument::append(const PdfDocument& doc, bool appendAll)
+void PdfDocument::InsertDocumentPageAt(unsigned atIndex, const PdfDocument& doc, unsigned pageIndex)
+{
+    insertDocumentPages(atIndex, doc, pageIndex, 1, false);
+}
+
+void PdfDocument::AppendDocumentPages(const PdfDocument& doc, unsigned pageIndex, unsigned pageCount)
 {
-    // CHECK-ME: The following is fishy. We switched from m_Objects.GetSize() to m_Objects.GetObjectCount()
-    // to not fall in overlaps in case of removed objects (see https://github.com/podofo/podofo/issues/253),
-    // but in this way free objects should be already taken into account. We'll eventually fix it by not
-    // relying on computing a static difference between inserted objects and objects being inserted but just
-    // inserting objects normally and remapping them with a support map
-    unsigned difference = static_cast<unsigned>(m_Objects.GetObjectCount() + m_Objects.GetFreeObjects().size());
+    insertDocumentPages(m_Pages->GetCount(), doc, pageIndex, pageCount, false);
+}
 
-    // create all free objects again, to have a clean free object list
-    for (auto& ref : doc.GetObjects().GetFreeObjects())
-        m_Objects.AddFreeObject(PdfReference(ref.ObjectNumber() + difference, ref.GenerationNumber()));
+void PdfDocument::insertDocumentPages(unsigned atIndex, const PdfDocument& doc, unsigned pageIndex,
+    unsigned pageCount, bool appendOutlines)
+{
+    if (&doc == this)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "Can't insert pages of the same document");
 
-    // append all objects first and fix their references
-    for (auto& obj : doc.GetObjects())
+    auto& sourcePages = doc.GetPages();
+    if (atIndex > m_Pages->GetCount() || pageIndex > sourcePages.GetCount()
+        || pageCount > sourcePages.GetCount() - pageIndex)
     {
-        PdfReference ref(static_cast<uint32_t>(obj->GetIndirectReference().ObjectNumber() + difference), obj->GetIndirectReference().GenerationNumber());
-        auto newObj = new PdfObject(PdfDictionary());
-        newObj->setDirty();
-        newObj->SetIndirectReference(ref);
-        m_Objects.PushObject(newObj);
-        *newObj = *obj;
-
-        PoDoFo::LogMessage(PdfLogSeverity::Debug, "Fixing references in {} {} R by {}",
-            newObj->GetIndirectReference().ObjectNumber(), newObj->GetIndirectReference().GenerationNumber(), difference);
-        fixObjectReferences(*newObj, difference);
+        PODOFO_RAISE_ERROR(PdfErrorCode::ValueOutOfRange);
     }
 
-    if (appendAll)
-    {
-        const PdfName inheritableAttributes[] = {
-            "Resources"_n,
-            "MediaBox"_n,
-            "CropBox"_n,
-            "Rotate"_n,
-            PdfName::Null
-        };
-
-        // append all pages now to our page tree
-        for (unsigned i = 0; i < doc.GetPages().GetCount(); i++)
-        {
-            auto& page = doc.GetPages().GetPageAt(i);
-            auto& obj = m_Objects.MustGetObject(PdfReference(page.GetObject().GetIndirectReference().ObjectNumber()
-                + difference, page.GetObject().GetIndirectReference().GenerationNumber()));
-            if (obj.IsDictionary() && obj.GetDictionary().HasKey("Parent"))
-                obj.GetDictionary().RemoveKey("Parent");
-
-            // Deal with inherited attributes
-            auto inherited = inheritableAttributes;
-            while (!inherited->IsNull())
-            {
-                auto attribute = page.GetDictionary().FindKeyParent(*inherited);
-                if (attribute != nullptr)
-                {
-                    PdfObject attributeCopy(*attribute);
-                    fixObjectReferences(attributeCopy, difference);
-                    obj.GetDictionary().AddKey(*inherited, attributeCopy);
-                }
+    // Only the objects reachable from the selected pages are copied,
+    // and resources already copied from other documents are shared
+    vector<const PdfPage*> pages(pageCount);
+    for (unsigned i = 0; i < pageCount; i++)
+        pages[i] = &sourcePages.GetPageAt(pageIndex + i);
 
-                inherited++;
-            }
+    auto& merger = getMerger();
+    merger.BeginCopy(doc);
+    auto pageObjs = merger.CopyPages(pages);
 
-            m_Pages->InsertPageAt(m_Pages->GetCount(), *new PdfPage(obj));
-        }
+    vector<PdfPage*> newPages(pageObjs.size());
+    for (unsigned i = 0; i < pageObjs.size(); i++)
+        newPages[i] = new PdfPage(*pageObjs[i]);
 
-        // Append all outlines
+    m_Pages->InsertPagesAt(atIndex, newPages);
+
+    if (appendOutlines)
+    {
         const PdfOutlineItem* appendRoot = doc.GetOutlines();
         if (appendRoot != nullptr && (appendRoot = appendRoot->First()) != nullptr)
         {
@@ -175,9 +152,9 @@ void PdfDocument::append(const PdfDocument& doc, bool appendAll)
             while (root->Next() != nullptr)
                 root = root->Next();
 
-            PdfReference ref(appendRoot->GetObject().GetIndirectReference().ObjectNumber()
-                + difference, appendRoot->GetObject().GetIndirectReference().GenerationNumber());
-            root->InsertChild(unique_ptr<PdfOutlineItem>(new PdfOutlines(m_Objects.MustGetObject(ref))));
+            auto copied = merger.CopyObject(appendRoot->GetObject());
+            root->InsertChild(unique_ptr<PdfOutlineItem>(new PdfOutlines(
+                m_Objects.MustGetObject(copied.GetReference()))));
         }
     }
 
@@ -185,116 +162,17 @@ void PdfDocument::append(const PdfDocument& doc, bool appendAll)
     // ToDictionary -> then iteratate over all keys and add them to the new one
 }
 
-void PdfDocument::InsertDocumentPageAt(unsigned atIndex, const PdfDocument& doc, unsigned pageIndex)
+void PdfDocument::EndMerge()
 {
-    // CHECK-ME: The following is fishy. We switched from m_Objects.GetSize() to m_Objects.GetObjectCount()
-    // to not fall in overlaps in case of removed objects (see https://github.com/podofo/podofo/issues/253),
-    // but in this way free objects should be already taken into account. We'll eventually fix it by not
-    // relying on computing a static difference between inserted objects and objects being inserted but just
-    // inserting objects normally and remapping them with a support map
-    unsigned difference = static_cast<unsigned>(m_Objects.GetObjectCount() + m_Objects.GetFreeObjects().size());
-
-    // create all free objects again, to have a clean free object list
-    for (auto& freeObj : doc.GetObjects().GetFreeObjects())
-    {
-        m_Objects.AddFreeObject(PdfReference(freeObj.ObjectNumber() + difference, freeObj.GenerationNumber()));
-    }
-
-    // append all objects first and fix their references
-    for (auto& obj : doc.GetObjects())
-    {
-        PdfReference ref(static_cast<uint32_t>(obj->GetIndirectReference().ObjectNumber() + difference), obj->GetIndirectReference().GenerationNumber());
-        auto newObj = new PdfObject(PdfDictionary());
-        newObj->setDirty();
-        newObj->SetIndirectReference(ref);
-        m_Objects.PushObject(newObj);
-        *newObj = *obj;
-
-        PoDoFo::LogMessage(PdfLogSeverity::Debug, "Fixing references in {} {} R by {}",
-            newObj->GetIndirectReference().ObjectNumber(), newObj->GetIndirectReference().GenerationNumber(), difference);
-        fixObjectReferences(*newObj, difference);
-    }
-
-    const PdfName inheritableAttributes[] = {
-        "Resources"_n,
-        "MediaBox"_n,
-        "CropBox"_n,
-        "Rotate"_n,
-        PdfName::Null
-    };
-
-    // append all page to our page tree
-    auto& page = doc.GetPages().GetPageAt(pageIndex);
-    auto& obj = m_Objects.MustGetObject(PdfReference(page.GetObject().GetIndirectReference().ObjectNumber()
-                                                     + difference, page.GetObject().GetIndirectReference().GenerationNumber()));
-    if (obj.IsDictionary() && obj.GetDictionary().HasKey("Parent"))
-        obj.GetDictionary().RemoveKey("Parent");
-
-    // Deal with inherited attributes
-    const PdfName* inherited = inheritableAttributes;
-    while (!inherited->IsNull())
-    {
-        auto attribute = page.GetDictionary().FindKeyParent(*inherited);
-        if (attribute != nullptr)
-        {
-            PdfObject attributeCopy(*attribute);
-            fixObjectReferences(attributeCopy, difference);
-            obj.GetDictionary().AddKey(*inherited, attributeCopy);
-        }
-
-        inherited++;
-    }
-
-    m_Pages->InsertPageAt(atIndex, *new PdfPage(obj));
-
-    // TODO: merge name trees
-    // ToDictionary -> then iteratate over all keys and add them to the new one
+    m_Merger = nullptr;
 }
 
-void PdfDocument::AppendDocumentPages(const PdfDocument& doc, unsigned pageIndex, unsigned pageCount)
+PdfDocumentMerger& PdfDocument::getMerger()
 {
-    /*
-      This function works a bit different than one might expect.
-      Rather than copying one page at a time - we copy the ENTIRE document
-      and then delete the pages we aren't interested in.
-
-      We do this because
-      1) SIGNIFICANTLY simplifies the process
-      2) Guarantees that shared objects aren't copied multiple times
-      3) offers MUCH faster performance for the common cases
-
-      HOWEVER: because PoDoFo doesn't currently do any sort of "object garbage collection" during
-      a Write() - we will end up with larger documents, since the data from unused pages
-      will also be in there.
-    */
-
-    // calculate preliminary "left" and "right" page ranges to delete
-    // then offset them based on where the pages were inserted
-    // NOTE: some of this will change if/when we support insertion at locations
-    //       OTHER than the end of the document!
-    unsigned leftStartPage = 0;
-    unsigned leftCount = pageIndex;
-    unsigned rightStartPage = pageIndex + pageCount;
-    unsigned rightCount = doc.GetPages().GetCount() - rightStartPage;
-    unsigned pageOffset = this->GetPages().GetCount();
-
-    leftStartPage += pageOffset;
-    rightStartPage += pageOffset;
+    if (m_Merger == nullptr)
+        m_Merger.reset(new PdfDocumentMerger(*this));
 
-    // append in the whole document
-    this->AppendDocumentPages(doc);
-
-    // delete
-    if (rightCount > 0)
-        this->deletePages(rightStartPage, rightCount);
-    if (leftCount > 0)
-        this->deletePages(leftStartPage, leftCount);
-}
-
-void PdfDocument::deletePages(unsigned atIndex, unsigned pageCount)
-{
-    for (unsigned i = 0; i < pageCount; i++)
-        this->GetPages().RemovePageAt(atIndex);
+    return *m_Merger;
 }
 
 void PdfDocument::resetPrivate()
@@ -346,23 +224,8 @@ void PdfDocument::createAction(PdfActionType type, unique_ptr<PdfAction>& action
 
 Rect PdfDocument::FillXObjectFromPage(PdfXObjectForm& xobj, const PdfPage& page, bool useTrimBox)
 {
-    unsigned difference = 0;
     auto& sourceDoc = page.GetDocument();
-    if (this != &sourceDoc)
-    {
-        // CHECK-ME: The following is fishy. We switched from m_Objects.GetSize() to m_Objects.GetObjectCount()
-        // to not fall in overlaps in case of removed objects (see https://github.com/podofo/podofo/issues/253),
-        // but in this way free objects should be already taken into account. We'll eventually fix it by not
-        // relying on computing a static difference between inserted objects and objects being inserted but just
-        // inserting objects normally and remapping them with a support map
-        difference = static_cast<unsigned>(m_Objects.GetObjectCount() + m_Objects.GetFreeObjects().size());
-        append(sourceDoc, false);
-    }
-
-    // TODO: remove unused objects: page, ...
-
-    auto& pageObj = m_Objects.MustGetObject(PdfReference(page.GetObject().GetIndirectReference().ObjectNumber()
-        + difference, page.GetObject().GetIndirectReference().GenerationNumber()));
+    auto& pageObj = page.GetObject();
     Rect box = page.GetMediaBox();
 
     // intersect with crop-box
@@ -372,19 +235,31 @@ Rect PdfDocument::FillXObjectFromPage(PdfXObjectForm& xobj, const PdfPage& page,
     if (useTrimBox)
         box.Intersect(page.GetTrimBox());
 
-    // link resources from external doc to x-object
-    if (pageObj.IsDictionary() && pageObj.GetDictionary().HasKey("Resources"))
-        xobj.GetDictionary().AddKey("Resources"_n, *pageObj.GetDictionary().GetKey("Resources"));
+    // link resources from external doc to x-object, copying
+    // only the objects they use
+    auto resources = pageObj.GetDictionary().GetKey("Resources");
+    if (resources != nullptr)
+    {
+        if (this == &sourceDoc)
+        {
+            xobj.GetDictionary().AddKey("Resources"_n, *resources);
+        }
+        else
+        {
+            auto& merger = getMerger();
+            merger.BeginCopy(sourceDoc);
+            xobj.GetDictionary().AddKey("Resources"_n, merger.CopyObject(*resources));
+        }
+    }
 
     // copy top-level content from external doc to x-object
-    if (pageObj.IsDictionary() && pageObj.GetDictionary().HasKey("Contents"))
+    auto contents = pageObj.GetDictionary().FindKey("Contents");
+    if (contents != nullptr)
     {
-        // get direct pointer to contents
-        auto& contents = pageObj.GetDictionary().MustFindKey("Contents");
-        if (contents.IsArray())
+        if (contents->IsArray())
         {
             // copy array as one stream to xobject
-            PdfArray arr = contents.GetArray();
+            auto& arr = contents->GetArray();
 
             auto& xobjStream = xobj.GetObject().GetOrCreateStream();
             auto output = xobjStream.GetOutputStream({ PdfFilterType::FlateDecode });
@@ -393,21 +268,17 @@ Rect PdfDocument::FillXObjectFromPage(PdfXObjectForm& xobj, const PdfPage& page,
             {
                 if (child.IsReference())
                 {
-                    // TODO: not very efficient !!
-                    auto obj = GetObjects().GetObject(child.GetReference());
-
+                    auto obj = sourceDoc.GetObjects().GetObject(child.GetReference());
                     while (obj != nullptr)
                     {
                         if (obj->IsReference())    // Recursively look for the stream
                         {
-                            obj = GetObjects().GetObject(obj->GetReference());
+                            obj = sourceDoc.GetObjects().GetObject(obj->GetReference());
                         }
                         else if (obj->HasStream())
                         {
-                            PdfObjectStream& contStream = obj->GetOrCreateStream();
-
                             charbuff contStreamBuffer;
-                            contStream.CopyTo(contStreamBuffer);
+                            obj->GetStream()->CopyTo(contStreamBuffer);
                             output.Write(contStreamBuffer);
                             break;
                         }
@@ -427,11 +298,10 @@ Rect PdfDocument::FillXObjectFromPage(PdfXObjectForm& xobj, const PdfPage& page,
                 }
             }
         }
-        else if (contents.HasStream())
+        else if (contents->HasStream())
         {
             // copy stream to xobject
-            auto& contentsStream = contents.GetOrCreateStream();
-            auto contentsInput = contentsStream.GetInputStream();
+            auto contentsInput = contents->GetStream()->GetInputStream();
 
             auto& xobjStream = xobj.GetObject().GetOrCreateStream();
             auto output = xobjStream.GetOutputStream({ PdfFilterType::FlateDecode });
@@ -446,49 +316,9 @@ Rect PdfDocument::FillXObjectFromPage(PdfXObjectForm& xobj, const PdfPage& page,
     return box;
 }
 
-void PdfDocument::fixObjectReferences(PdfObject& obj, int difference)
-{
-    if (obj.IsDictionary())
-    {
-        for (auto& pair : obj.GetDictionary())
-        {
-            if (pair.second.IsReference())
-            {
-                pair.second = PdfObject(PdfReference(pair.second.GetReference().ObjectNumber() + difference,
-                    pair.second.GetReference().GenerationNumber()));
-            }
-            else if (pair.second.IsDictionary() ||
-                pair.second.IsArray())
-            {
-                fixObjectReferences(pair.second, difference);
-            }
-        }
-    }
-    else if (obj.IsArray())
-    {
-        for (auto& child : obj.GetArray())
-        {
-            if (child.IsReference())
-            {
-                child = PdfObject(PdfReference(child.GetReference().ObjectNumber() + difference,
-                    child.GetReference().GenerationNumber()));
-            }
-            else if (child.IsDictionary() || child.IsArray())
-            {
-                fixObjectReferences(child, difference);
-            }
-        }
-    }
-    else if (obj.IsReference())
-    {
-        obj = PdfObject(PdfReference(obj.GetReference().ObjectNumber() + difference,
-            obj.GetReference().GenerationNumber()));
-    }
-}
-
-void PdfDocument::CollectGarbage()
+void PdfDocument::CollectGarbage(bool incremental)
 {
-    m_Objects.CollectGarbage();
+    m_Objects.CollectGarbage(incremental);
 }
 
 PdfOutlines& PdfDocument::GetOrCreateOutlines()
@@ -30,6 +30,7 @@ class PdfAction;
 class PdfExtGState;
 class PdfEncrypt;
 class PdfDocument;
+class PdfDocumentMerger;
 
 template <typename TField>
 class PdfDocumentFieldIterableBase final
@@ -114,6 +115,7 @@ class PODOFO_API PdfDocument
     friend class PdfPageCollection;
     friend class PdfMemDocument;
     friend class PdfStreamedDocument;
+    friend class PdfDocumentMerger;
 
 public:
     /** Close down/destruct the PdfDocument
@@ -148,7 +150,12 @@ public:
      */
     PdfAcroForm& GetOrCreateAcroForm(PdfAcroFormDefaulAppearance eDefaultAppearance = PdfAcroFormDefaulAppearance::ArialBlack);
 
-    void CollectGarbage();
+    /** Delete the objects that are not reachable from the trailer
+     * \param incremental if true, the next collections will scan only
+     *      the objects added or modified since the last one
+     * \see PdfIndirectObjectList::CollectGarbage
+     */
+    void CollectGarbage(bool incremental = false);
 
     /** Construct a new PdfImage object
      */
@@ -433,22 +440,23 @@ private:
     // Called by PdfXObjectForm
     Rect FillXObjectFromPage(PdfXObjectForm& xobj, const PdfPage& page, bool useTrimBox);
 
+    // Called by PdfMemDocument, when saving. It drops the
+    // index of the resources copied from other documents
+    void EndMerge();
+
     PdfInfo& GetOrCreateInfo();
 
     void createAction(PdfActionType type, std::unique_ptr<PdfAction>& action);
 
 private:
-    void append(const PdfDocument& doc, bool appendAll);
-    /** Recursively changes every PdfReference in the PdfObject and in any child
-     *  that is either an PdfArray or a direct object.
-     *  The reference is changed so that difference is added to the object number
-     *  of the reference.
-     *  \param obj object to change
-     *  \param difference add this value to every reference that is encountered
+    /** Copy the given range of pages of another document, with the
+     *  objects they use, and insert them at the given index
+     *  \param appendOutlines if true, also the outlines are appended
      */
-    void fixObjectReferences(PdfObject& obj, int difference);
+    void insertDocumentPages(unsigned atIndex, const PdfDocument& doc, unsigned pageIndex,
+        unsigned pageCount, bool appendOutlines);
 
-    void deletePages(unsigned atIndex, unsigned pageCount);
+    PdfDocumentMerger& getMerger();
 
     void resetPrivate();
 
@@ -469,6 +477,7 @@ private:
     std::unique_ptr<PdfAcroForm> m_AcroForm;
     nullable<std::unique_ptr<PdfOutlines>> m_Outlines;
     std::unique_ptr<PdfNameTrees> m_NameTrees;
+    std::unique_ptr<PdfDocumentMerger> m_Merger;
 };
 
 template<typename TAction>
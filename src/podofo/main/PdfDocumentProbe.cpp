@@ -0,0 +1,335 @@
+/**
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#include <podofo/private/PdfDeclarationsPrivate.h>
+#include "PdfDocumentProbe.h"
+
+#include <podofo/auxiliary/StreamDevice.h>
+#include <podofo/private/PdfParser.h>
+
+#include "PdfArray.h"
+#include "PdfCommon.h"
+#include "PdfDictionary.h"
+#include "PdfObjectStream.h"
+#include "PdfXMPPacket.h"
+
+using namespace std;
+using namespace PoDoFo;
+
+PdfDocumentProbe::PdfDocumentProbe()
+{
+    clear();
+}
+
+PdfDocumentProbe::~PdfDocumentProbe() { }
+
+void PdfDocumentProbe::Load(const string_view& filename, const string_view& password)
+{
+    if (filename.length() == 0)
+        PODOFO_RAISE_ERROR(PdfErrorCode::InvalidHandle);
+
+    load(std::make_shared<FileStreamDevice>(filename), password);
+}
+
+void PdfDocumentProbe::LoadFromBuffer(const bufferview& buffer, const string_view& password)
+{
+    if (buffer.size() == 0)
+        PODOFO_RAISE_ERROR(PdfErrorCode::InvalidHandle);
+
+    load(std::make_shared<SpanStreamDevice>(buffer), password);
+}
+
+void PdfDocumentProbe::Load(shared_ptr<InputStreamDevice> device, const string_view& password)
+{
+    if (device == nullptr)
+        PODOFO_RAISE_ERROR(PdfErrorCode::InvalidHandle);
+
+    load(std::move(device), password);
+}
+
+const PdfMetadataStore& PdfDocumentProbe::GetMetadata()
+{
+    if (m_parser == nullptr)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "No document has been probed");
+
+    if (m_metadata == nullptr)
+        readMetadata();
+
+    return *m_metadata;
+}
+
+const string& PdfDocumentProbe::GetXMPPacket()
+{
+    if (m_parser == nullptr)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "No document has been probed");
+
+    if (m_xmpPacket == nullptr)
+        readXMPPacket();
+
+    return *m_xmpPacket;
+}
+
+bool PdfDocumentProbe::IsTagged() const
+{
+    return m_catalog != nullptr && m_catalog->HasKey("StructTreeRoot");
+}
+
+const PdfEncrypt* PdfDocumentProbe::GetEncrypt() const
+{
+    if (m_parser == nullptr || m_parser->GetEncrypt() == nullptr)
+        return nullptr;
+
+    return &m_parser->GetEncrypt()->GetEncrypt();
+}
+
+const nullable<Rect>& PdfDocumentProbe::GetFirstPageMediaBox()
+{
+    if (m_parser == nullptr)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "No document has been probed");
+
+    if (m_firstPageMediaBox == nullptr)
+        readFirstPageMediaBox();
+
+    return *m_firstPageMediaBox;
+}
+
+bool PdfDocumentProbe::HasInfo()
+{
+    if (m_parser == nullptr)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "No document has been probed");
+
+    return getDictionary(m_parser->GetTrailer().GetDictionary(), "Info") != nullptr;
+}
+
+const PdfObject* PdfDocumentProbe::GetInfoValue(const string_view& key)
+{
+    if (m_parser == nullptr)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "No document has been probed");
+
+    auto info = getDictionary(m_parser->GetTrailer().GetDictionary(), "Info");
+    if (info == nullptr)
+        return nullptr;
+
+    return resolve(info->GetKey(key));
+}
+
+void PdfDocumentProbe::clear()
+{
+    m_metadata = nullptr;
+    m_firstPageMediaBox = nullptr;
+    m_xmpPacket = nullptr;
+    m_catalog = nullptr;
+    m_objects.clear();
+    m_parser = nullptr;
+    m_objectList = nullptr;
+    m_device = nullptr;
+    m_PageCount = 0;
+    m_PdfVersion = PdfVersionDefault;
+    m_IsEncrypted = false;
+    m_IncrementalUpdateCount = 0;
+}
+
+void PdfDocumentProbe::load(shared_ptr<InputStreamDevice>&& device, const string_view& password)
+{
+    clear();
+    try
+    {
+        m_device = std::move(device);
+        // The object list has no document: the read
+        // objects references are resolved by the probe
+        m_objectList.reset(new PdfIndirectObjectList());
+        m_parser.reset(new PdfParser(*m_objectList));
+        m_parser->SetPassword(password);
+        m_parser->ParseStructure(*m_device);
+        m_PdfVersion = m_parser->GetPdfVersion();
+        m_IsEncrypted = m_parser->GetEncrypt() != nullptr;
+        m_IncrementalUpdateCount = (unsigned)m_parser->GetIncrementalUpdatesCount();
+        m_catalog = getDictionary(m_parser->GetTrailer().GetDictionary(), "Root");
+        if (m_catalog == nullptr)
+            PODOFO_RAISE_ERROR_INFO(PdfErrorCode::ObjectNotFound, "The document has no catalog");
+
+        auto versionObj = resolve(m_catalog->GetKey("Version"));
+        const PdfName* versionName;
+        if (versionObj != nullptr && versionObj->TryGetName(versionName))
+        {
+            auto version = PoDoFo::GetPdfVersion(versionName->GetString());
+            if (version != PdfVersion::Unknown && version > m_PdfVersion)
+                m_PdfVersion = version;
+        }
+
+        auto pages = getDictionary(*m_catalog, "Pages");
+        auto countObj = pages == nullptr ? nullptr : resolve(pages->GetKey("Count"));
+        int64_t count;
+        if (countObj != nullptr && countObj->TryGetNumber(count) && count > 0)
+            m_PageCount = (unsigned)count;
+    }
+    catch (PdfError& e)
+    {
+        clear();
+        PODOFO_PUSH_FRAME_INFO(e, "Unable to probe the document");
+        throw;
+    }
+}
+
+void PdfDocumentProbe::readMetadata()
+{
+    unique_ptr<PdfMetadataStore> metadata(new PdfMetadataStore());
+    metadata->Version = m_PdfVersion;
+
+    auto info = getDictionary(m_parser->GetTrailer().GetDictionary(), "Info");
+    if (info != nullptr)
+    {
+        metadata->Title = getString(*info, "Title");
+        metadata->Author = getString(*info, "Author");
+        metadata->Subject = getString(*info, "Subject");
+        metadata->Keywords = getString(*info, "Keywords");
+        metadata->Creator = getString(*info, "Creator");
+        metadata->Producer = getString(*info, "Producer");
+        metadata->CreationDate = getDate(*info, "CreationDate");
+        metadata->ModDate = getDate(*info, "ModDate");
+
+        auto trapped = resolve(info->GetKey("Trapped"));
+        const PdfName* name;
+        if (trapped != nullptr && trapped->TryGetName(name))
+        {
+            if (*name == "True")
+                metadata->Trapped = true;
+            else if (*name == "False")
+                metadata->Trapped = false;
+        }
+    }
+
+    auto packet = PdfXMPPacket::Create(GetXMPPacket());
+    if (packet != nullptr)
+    {
+        auto xmpMetadata = packet->GetMetadata();
+        if (metadata->Title == nullptr)
+            metadata->Title = xmpMetadata.Title;
+        if (metadata->Author == nullptr)
+            metadata->Author = xmpMetadata.Author;
+        if (metadata->Subject == nullptr)
+            metadata->Subject = xmpMetadata.Subject;
+        if (metadata->Keywords == nullptr)
+            metadata->Keywords = xmpMetadata.Keywords;
+        if (metadata->Creator == nullptr)
+            metadata->Creator = xmpMetadata.Creator;
+        if (metadata->Producer == nullptr)
+            metadata->Producer = xmpMetadata.Producer;
+        if (metadata->CreationDate == nullptr)
+            metadata->CreationDate = xmpMetadata.CreationDate;
+        if (metadata->ModDate == nullptr)
+            metadata->ModDate = xmpMetadata.ModDate;
+        if (metadata->Trapped == nullptr)
+            metadata->Trapped = xmpMetadata.Trapped;
+        metadata->PdfaLevel = xmpMetadata.PdfaLevel;
+        metadata->PdfuaLevel = xmpMetadata.PdfuaLevel;
+    }
+
+    m_metadata = std::move(metadata);
+}
+
+void PdfDocumentProbe::readXMPPacket()
+{
+    unique_ptr<string> xmpPacket(new string());
+    auto metadata = resolve(m_catalog->GetKey("Metadata"));
+    const PdfObjectStream* stream;
+    if (metadata != nullptr && (stream = metadata->GetStream()) != nullptr)
+    {
+        StringStreamDevice output(*xmpPacket);
+        stream->CopyTo(output);
+    }
+
+    m_xmpPacket = std::move(xmpPacket);
+}
+
+void PdfDocumentProbe::readFirstPageMediaBox()
+{
+    unique_ptr<nullable<Rect>> mediaBox(new nullable<Rect>());
+    // Descend the first kids of the tree, down to the first
+    // page, remembering the last inheritable /MediaBox
+    const PdfArray* mediaBoxArr = nullptr;
+    auto node = getDictionary(*m_catalog, "Pages");
+    for (unsigned depth = 0; node != nullptr && depth < PdfCommon::GetMaxRecursionDepth(); depth++)
+    {
+        auto mediaBoxObj = resolve(node->GetKey("MediaBox"));
+        if (mediaBoxObj != nullptr)
+            (void)mediaBoxObj->TryGetArray(mediaBoxArr);
+
+        auto typeObj = resolve(node->GetKey("Type"));
+        const PdfName* type;
+        if (typeObj != nullptr && typeObj->TryGetName(type) && *type == "Page")
+        {
+            double coords[4];
+            if (mediaBoxArr == nullptr || mediaBoxArr->GetSize() != 4)
+                break;
+
+            bool valid = true;
+            for (unsigned i = 0; i < 4 && valid; i++)
+            {
+                auto coord = resolve(&(*mediaBoxArr)[i]);
+                valid = coord != nullptr && coord->TryGetReal(coords[i]);
+            }
+
+            if (valid)
+                *mediaBox = Rect::FromCorners(coords[0], coords[1], coords[2], coords[3]);
+
+            break;
+        }
+
+        auto kidsObj = resolve(node->GetKey("Kids"));
+        const PdfArray* kidsArr;
+        if (kidsObj == nullptr || !kidsObj->TryGetArray(kidsArr) || kidsArr->GetSize() == 0)
+            break;
+
+        auto kidObj = resolve(&(*kidsArr)[0]);
+        if (kidObj == nullptr || !kidObj->TryGetDictionary(node))
+            break;
+    }
+
+    m_firstPageMediaBox = std::move(mediaBox);
+}
+
+nullable<PdfString> PdfDocumentProbe::getString(const PdfDictionary& dict, const string_view& key)
+{
+    auto obj = resolve(dict.GetKey(key));
+    const PdfString* str;
+    if (obj == nullptr || !obj->TryGetString(str))
+        return nullptr;
+
+    return *str;
+}
+
+nullable<PdfDate> PdfDocumentProbe::getDate(const PdfDictionary& dict, const string_view& key)
+{
+    auto obj = resolve(dict.GetKey(key));
+    const PdfString* str;
+    PdfDate date;
+    if (obj == nullptr || !obj->TryGetString(str) || !PdfDate::TryParse(str->GetString(), date))
+        return nullptr;
+
+    return date;
+}
+
+const PdfObject* PdfDocumentProbe::resolve(const PdfObject* obj)
+{
+    PdfReference ref;
+    if (obj == nullptr || !obj->TryGetReference(ref))
+        return obj;
+
+    auto found = m_objects.find(ref);
+    if (found == m_objects.end())
+        found = m_objects.emplace(ref, m_parser->ReadObject(*m_device, ref)).first;
+
+    return found->second.get();
+}
+
+const PdfDictionary* PdfDocumentProbe::getDictionary(const PdfDictionary& dict, const string_view& key)
+{
+    auto obj = resolve(dict.GetKey(key));
+    const PdfDictionary* ret;
+    if (obj == nullptr || !obj->TryGetDictionary(ret))
+        return nullptr;
+
+    return ret;
+}
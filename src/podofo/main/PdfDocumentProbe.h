@@ -0,0 +1,147 @@
+/**
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#ifndef PDF_DOCUMENT_PROBE_H
+#define PDF_DOCUMENT_PROBE_H
+
+#include <unordered_map>
+
+#include <podofo/auxiliary/InputDevice.h>
+#include <podofo/auxiliary/Rect.h>
+
+#include "PdfIndirectObjectList.h"
+#include "PdfMetadataStore.h"
+
+namespace PoDoFo {
+
+class PdfParser;
+class PdfEncrypt;
+
+/** PdfDocumentProbe reads the basic properties of a PDF file,
+ *  such as the page count, the version, the encryption status and
+ *  the metadata, without loading the document
+ *
+ *  Only the xref sections and the trailers are read. The document
+ *  catalog, the page tree root, the /Info dictionary and the XMP
+ *  metadata stream are then read on demand, so probing is much
+ *  faster than loading a PdfMemDocument, especially for big files.
+ *
+ *  \see PdfMemDocument
+ */
+class PODOFO_API PdfDocumentProbe final
+{
+public:
+    PdfDocumentProbe();
+
+    ~PdfDocumentProbe();
+
+    /** Probe a PDF file
+     *
+     *  This might throw a PdfError( PdfErrorCode::InvalidPassword ) exception
+     *  if a password is required to read this PDF
+     */
+    void Load(const std::string_view& filename, const std::string_view& password = { });
+
+    /** Probe a PDF file from a buffer in memory
+     *  \remarks The buffer must outlive the probe
+     */
+    void LoadFromBuffer(const bufferview& buffer, const std::string_view& password = { });
+
+    /** Probe a PDF file from an input device
+     */
+    void Load(std::shared_ptr<InputStreamDevice> device, const std::string_view& password = { });
+
+    /** Get the number of pages, as declared by the page tree root
+     */
+    unsigned GetPageCount() const { return m_PageCount; }
+
+    /** Get the version of the document, from the file
+     *  header or from the catalog /Version, if greater
+     */
+    PdfVersion GetPdfVersion() const { return m_PdfVersion; }
+
+    /** \returns true if the document is encrypted
+     */
+    bool IsEncrypted() const { return m_IsEncrypted; }
+
+    /** \returns the number of incremental updates of the file
+     */
+    unsigned GetIncrementalUpdateCount() const { return m_IncrementalUpdateCount; }
+
+    /** \returns true if the document catalog has a structure tree
+     */
+    bool IsTagged() const;
+
+    /** Get the encryption of the document, or nullptr if it's not
+     *  encrypted. It tells the permissions granted to the user
+     */
+    const PdfEncrypt* GetEncrypt() const;
+
+    /** Get the media box of the first page, inherited by the page
+     *  tree nodes if needed, or null if it can't be determined
+     *  \remarks The page is read on the first call
+     */
+    const nullable<Rect>& GetFirstPageMediaBox();
+
+    /** \returns true if the document has an /Info dictionary
+     */
+    bool HasInfo();
+
+    /** Get a value of the /Info dictionary, resolving it if it's
+     *  a reference, or nullptr if it's missing
+     */
+    const PdfObject* GetInfoValue(const std::string_view& key);
+
+    /** Get the document metadata, from the /Info dictionary and,
+     *  for entries missing there, from the XMP metadata
+     *  \remarks The metadata is read on the first call
+     */
+    const PdfMetadataStore& GetMetadata();
+
+    /** Get the raw XMP metadata packet, or an empty
+     *  string if the document has none
+     *  \remarks The metadata stream is read on the first call
+     */
+    const std::string& GetXMPPacket();
+
+private:
+    PdfDocumentProbe(const PdfDocumentProbe&) = delete;
+    PdfDocumentProbe& operator=(const PdfDocumentProbe&) = delete;
+
+    void clear();
+    void load(std::shared_ptr<InputStreamDevice>&& device, const std::string_view& password);
+    void readMetadata();
+    void readXMPPacket();
+    void readFirstPageMediaBox();
+    nullable<PdfString> getString(const PdfDictionary& dict, const std::string_view& key);
+    nullable<PdfDate> getDate(const PdfDictionary& dict, const std::string_view& key);
+
+    /** Resolve the object, if it is a reference, reading the
+     *  referenced object from the device on first access
+     *  \returns the resolved object, or nullptr if it's missing
+     */
+    const PdfObject* resolve(const PdfObject* obj);
+
+    /** Get the dictionary with the given key, resolving it
+     */
+    const PdfDictionary* getDictionary(const PdfDictionary& dict, const std::string_view& key);
+
+private:
+    std::shared_ptr<InputStreamDevice> m_device;
+    std::unique_ptr<PdfIndirectObjectList> m_objectList;
+    std::unique_ptr<PdfParser> m_parser;
+    std::unordered_map<PdfReference, std::unique_ptr<PdfObject>> m_objects;
+    const PdfDictionary* m_catalog;
+    unsigned m_PageCount;
+    PdfVersion m_PdfVersion;
+    bool m_IsEncrypted;
+    unsigned m_IncrementalUpdateCount;
+    std::unique_ptr<PdfMetadataStore> m_metadata;
+    std::unique_ptr<std::string> m_xmpPacket;
+    std::unique_ptr<nullable<Rect>> m_firstPageMediaBox;
+};
+
+};
+
+#endif // PDF_DOCUMENT_PROBE_H
@@ -29,6 +29,7 @@ private:
 
 public:
     PdfEncrypt& GetEncrypt() { return *m_Encrypt; }
+    const PdfEncrypt& GetEncrypt() const { return *m_Encrypt; }
     PdfEncryptContext& GetContext() { return m_Context; }
 
 private:
@@ -5,6 +5,7 @@
  */
 
 #include <podofo/private/PdfDeclarationsPrivate.h>
+#include <podofo/private/PdfArena.h>
 #include "PdfIndirectObjectList.h"
 
 #include <algorithm>
@@ -22,18 +23,12 @@ using namespace std;
 using namespace PoDoFo;
 
 static constexpr unsigned MaxXRefGenerationNum = 65535;
+static constexpr uint32_t NotRecorded = numeric_limits<uint32_t>::max();
+// Size up to which the object vector always grows
+static constexpr size_t MinObjectListSize = 4096;
 
 namespace
 {
-    struct ObjectComparatorPredicate
-    {
-    public:
-        inline bool operator()(const PdfObject* obj1, const PdfObject* obj2) const
-        {
-            return obj1->GetIndirectReference() < obj2->GetIndirectReference();
-        }
-    };
-
     struct ReferenceComparatorPredicate
     {
     public:
@@ -42,31 +37,11 @@ namespace
             return obj1 < obj2;
         }
     };
-
-    //RG: 1) Should this class not be moved to the header file
-    class ObjectsComparator
-    {
-    public:
-        ObjectsComparator(const PdfReference& ref)
-            : m_ref(ref) { }
-
-        bool operator()(const PdfObject* p1) const
-        {
-            return p1 ? (p1->GetIndirectReference() == m_ref) : false;
-        }
-
-    private:
-        ObjectsComparator() = delete;
-        ObjectsComparator(const ObjectsComparator& rhs) = delete;
-        ObjectsComparator& operator=(const ObjectsComparator& rhs) = delete;
-
-    private:
-        const PdfReference m_ref;
-    };
 }
 
 PdfIndirectObjectList::PdfIndirectObjectList() :
     m_Document(nullptr),
+    m_Size(0),
     m_ObjectCount(0),
     m_StreamFactory(nullptr)
 {
@@ -74,6 +49,7 @@ PdfIndirectObjectList::PdfIndirectObjectList() :
 
 PdfIndirectObjectList::PdfIndirectObjectList(PdfDocument& document) :
     m_Document(&document),
+    m_Size(0),
     m_ObjectCount(0),
     m_StreamFactory(nullptr)
 {
@@ -81,19 +57,32 @@ PdfIndirectObjectList::PdfIndirectObjectList(PdfDocument& document) :
 
 PdfIndirectObjectList::PdfIndirectObjectList(PdfDocument& document, const PdfIndirectObjectList& rhs)  :
     m_Document(&document),
+    m_Objects(rhs.m_Objects.size()),
+    m_Size(rhs.m_Size),
     m_ObjectCount(rhs.m_ObjectCount),
     m_FreeObjects(rhs.m_FreeObjects),
     m_unavailableObjects(rhs.m_unavailableObjects),
     m_StreamFactory(nullptr)
 {
     // Copy all objects from source, resetting parent and indirect reference
-    for (auto obj : rhs.m_Objects)
-    {
-        auto newObj = new PdfObject(*obj);
-        newObj->SetIndirectReference(obj->GetIndirectReference());
+    auto copyObject = [&](const PdfObject& obj) {
+        auto newObj = new PdfObject(obj);
+        newObj->SetIndirectReference(obj.GetIndirectReference());
         newObj->SetDocument(&document);
-        m_Objects.insert(newObj);
+        return newObj;
+    };
+
+    for (size_t i = 0; i < rhs.m_Objects.size(); i++)
+    {
+        auto obj = rhs.m_Objects[i];
+        if (obj == nullptr)
+            continue;
+
+        m_Objects[i] = copyObject(*obj);
     }
+
+    for (auto& pair : rhs.m_sparseObjects)
+        m_sparseObjects[pair.first] = copyObject(*pair.second);
 }
 
 PdfIndirectObjectList::~PdfIndirectObjectList()
@@ -106,11 +95,19 @@ void PdfIndirectObjectList::Clear()
     for (auto obj : m_Objects)
         delete obj;
 
+    for (auto& pair : m_sparseObjects)
+        delete pair.second;
+
     m_Objects.clear();
+    m_sparseObjects.clear();
+    m_Size = 0;
     m_ObjectCount = 0;
     m_FreeObjects.clear();
     m_unavailableObjects.clear();
     m_compressedObjectStreams.clear();
+    m_gcSpans.clear();
+    m_gcReferences.clear();
+    m_touchedObjects.clear();
 }
 
 PdfObject& PdfIndirectObjectList::MustGetObject(const PdfReference& ref) const
@@ -124,30 +121,39 @@ PdfObject& PdfIndirectObjectList::MustGetObject(const PdfReference& ref) const
 
 PdfObject* PdfIndirectObjectList::GetObject(const PdfReference& ref) const
 {
-    auto it = m_Objects.lower_bound(ref);
-    if (it == m_Objects.end() || (*it)->GetIndirectReference() != ref)
+    PdfObject* obj;
+    if (ref.ObjectNumber() < m_Objects.size())
+    {
+        obj = m_Objects[ref.ObjectNumber()];
+    }
+    else
+    {
+        auto found = m_sparseObjects.find(ref.ObjectNumber());
+        obj = found == m_sparseObjects.end() ? nullptr : found->second;
+    }
+
+    if (obj == nullptr || obj->GetIndirectReference().GenerationNumber() != ref.GenerationNumber())
         return nullptr;
 
-    return *it;
+    return obj;
 }
 
 unique_ptr<PdfObject> PdfIndirectObjectList::RemoveObject(const PdfReference& ref)
 {
-    return RemoveObject(ref, true);
+    return detachObject(RemoveObject(ref, true));
 }
 
 unique_ptr<PdfObject> PdfIndirectObjectList::RemoveObject(const PdfReference& ref, bool markAsFree)
 {
-    auto it = m_Objects.lower_bound(ref);
-    if (it == m_Objects.end() || (*it)->GetIndirectReference() != ref)
+    if (GetObject(ref) == nullptr)
         return nullptr;
 
-    return removeObject(it, markAsFree);
+    return removeObject(iterator(*this, ref.ObjectNumber()), markAsFree);
 }
 
 unique_ptr<PdfObject> PdfIndirectObjectList::RemoveObject(const iterator& it)
 {
-    return removeObject(it, true);
+    return detachObject(removeObject(it, true));
 }
 
 unique_ptr<PdfObject> PdfIndirectObjectList::removeObject(const iterator& it, bool markAsFree)
@@ -159,10 +165,29 @@ unique_ptr<PdfObject> PdfIndirectObjectList::removeObject(const iterator& it, bo
     if (markAsFree)
         SafeAddFreeObject(obj->GetIndirectReference());
 
-    m_Objects.erase(it);
+    uint32_t objectNum = obj->GetIndirectReference().ObjectNumber();
+    if (objectNum < m_Objects.size())
+        m_Objects[objectNum] = nullptr;
+    else
+        m_sparseObjects.erase(objectNum);
+
+    m_Size--;
     return unique_ptr<PdfObject>(obj);
 }
 
+unique_ptr<PdfObject> PdfIndirectObjectList::detachObject(unique_ptr<PdfObject>&& obj)
+{
+    if (obj == nullptr || m_arena == nullptr)
+        return std::move(obj);
+
+    // Removed objects may outlive the arena, so they are
+    // handed out as deep copies allocated from the heap
+    PdfArena::Scope scope(nullptr);
+    unique_ptr<PdfObject> ret(new PdfObject(*obj));
+    ret->SetIndirectReference(obj->GetIndirectReference());
+    return ret;
+}
+
 PdfReference PdfIndirectObjectList::getNextFreeObject()
 {
     // Try to first use list of free objects
@@ -298,112 +323,178 @@ void PdfIndirectObjectList::PushObject(PdfObject* obj)
 {
     obj->SetDocument(m_Document);
 
-    ObjectList::node_type node;
-    auto it = m_Objects.find(obj);
-    auto hintpos = it;
-    if (it != m_Objects.end())
+    auto& ref = obj->GetIndirectReference();
+    auto& slot = getOrCreateSlot(ref.ObjectNumber());
+    if (slot == nullptr)
     {
-        // Delete existing object and replace
-        // the pointer on its node
-        hintpos++;
-        node = m_Objects.extract(it);
-        delete node.value();
-        node.value() = obj;
+        m_Size++;
     }
+    else
+    {
+        // Delete existing object and replace it. There
+        // can't be two objects with the same object number
+        if (slot->GetIndirectReference() != ref)
+        {
+            PoDoFo::LogMessage(PdfLogSeverity::Debug, "Object {} replaced by {}",
+                slot->GetIndirectReference().ToString(), ref.ToString());
+        }
 
-    pushObject(hintpos, node, obj);
-}
+        delete slot;
+    }
 
-void PdfIndirectObjectList::pushObject(const ObjectList::const_iterator& hintpos, ObjectList::node_type& node, PdfObject* obj)
-{
-    if (node.empty())
-        m_Objects.insert(hintpos, obj);
-    else
-        m_Objects.insert(hintpos, std::move(node));
-    tryIncrementObjectCount(obj->GetIndirectReference());
+    slot = obj;
+    touchObject(ref.ObjectNumber());
+    tryIncrementObjectCount(ref);
 }
 
-void PdfIndirectObjectList::CollectGarbage()
+void PdfIndirectObjectList::CollectGarbage(bool incremental)
 {
     if (m_Document == nullptr)
         return;
 
-    unordered_set<PdfReference> referencedOjects;
-    visitObject(m_Document->GetTrailer().GetObject(), referencedOjects);
+    // Take the references retained by the last incremental
+    // collection, if any, to be reused for untouched objects.
+    // The references are retained again if incremental collection
+    // was requested now or before
+    bool retain = incremental || m_gcSpans.size() != 0;
+    vector<GCSpan> prevSpans;
+    vector<PdfReference> prevReferences;
+    vector<bool> touchedObjects;
+    if (incremental)
+    {
+        prevSpans = std::move(m_gcSpans);
+        prevReferences = std::move(m_gcReferences);
+        touchedObjects = std::move(m_touchedObjects);
+    }
+
+    m_gcSpans.clear();
+    m_gcReferences.clear();
+    m_touchedObjects.clear();
+    if (retain)
+        m_gcSpans.assign(m_Objects.size(), { 0, NotRecorded });
+
+    vector<bool> marked(m_Objects.size());
+    unordered_set<uint32_t> sparseMarked;
+    vector<PdfReference> pending;
+    vector<const PdfObject*> stack;
+    collectReferences(m_Document->GetTrailer().GetObject(), pending, stack);
+
+    // If the compressed object streams are not referenced,
+    // visit them as well as they won't be deleted
     for (auto objId : m_compressedObjectStreams)
+        pending.push_back(PdfReference(objId, 0));
+
+    while (pending.size() != 0)
     {
-        PdfReference ref(objId, 0);
-        if (referencedOjects.find(ref) != referencedOjects.end())
+        auto ref = pending.back();
+        pending.pop_back();
+        auto obj = GetObject(ref);
+        if (obj == nullptr)
+            continue;
+
+        if (ref.ObjectNumber() < marked.size())
+        {
+            if (marked[ref.ObjectNumber()])
+                continue;
+
+            marked[ref.ObjectNumber()] = true;
+        }
+        else if (!sparseMarked.insert(ref.ObjectNumber()).second)
+        {
             continue;
+        }
 
-        // If the compressed object streams are not referenced,
-        // visit them as well as they won't be deleted
-        visitObject(*GetObject(ref), referencedOjects);
+        size_t offset = pending.size();
+        if (ref.ObjectNumber() < prevSpans.size()
+            && prevSpans[ref.ObjectNumber()].Count != NotRecorded
+            && !touchedObjects[ref.ObjectNumber()])
+        {
+            auto& span = prevSpans[ref.ObjectNumber()];
+            pending.insert(pending.end(), prevReferences.begin() + span.Offset,
+                prevReferences.begin() + span.Offset + span.Count);
+        }
+        else
+        {
+            collectReferences(*obj, pending, stack);
+        }
+
+        if (retain && ref.ObjectNumber() < m_gcSpans.size())
+        {
+            m_gcSpans[ref.ObjectNumber()] = { m_gcReferences.size(), (uint32_t)(pending.size() - offset) };
+            m_gcReferences.insert(m_gcReferences.end(), pending.begin() + offset, pending.end());
+        }
     }
 
+    if (retain)
+        m_touchedObjects.resize(m_gcSpans.size());
+
     vector<PdfObject*> objectsToDelete;
-    ObjectList newlist;
-    for (PdfObject* obj : m_Objects)
-    {
+    auto tryDelete = [&](PdfObject* obj) {
         // Delete the object if not referenced and not a compressed object stream
         auto& ref = obj->GetIndirectReference();
-        if (referencedOjects.find(ref) == referencedOjects.end()
-            && m_compressedObjectStreams.find(ref.ObjectNumber()) == m_compressedObjectStreams.end())
-        {
-            SafeAddFreeObject(ref);
-            objectsToDelete.push_back(obj);
+        if (m_compressedObjectStreams.find(ref.ObjectNumber()) != m_compressedObjectStreams.end())
+            return false;
+
+        SafeAddFreeObject(ref);
+        objectsToDelete.push_back(obj);
+        m_Size--;
+        return true;
+    };
+
+    for (size_t i = 0; i < m_Objects.size(); i++)
+    {
+        auto& obj = m_Objects[i];
+        if (obj == nullptr || marked[i])
             continue;
-        }
 
-        newlist.insert(obj);
+        if (tryDelete(obj))
+            obj = nullptr;
+    }
+
+    for (auto it = m_sparseObjects.begin(); it != m_sparseObjects.end(); )
+    {
+        if (sparseMarked.find(it->first) == sparseMarked.end() && tryDelete(it->second))
+            it = m_sparseObjects.erase(it);
+        else
+            it++;
     }
 
     for (auto obj : objectsToDelete)
         delete obj;
-
-    m_Objects.swap(newlist);
 }
 
-void PdfIndirectObjectList::visitObject(const PdfObject& obj, unordered_set<PdfReference>& referencedObjects)
+void PdfIndirectObjectList::collectReferences(const PdfObject& obj, vector<PdfReference>& references,
+    vector<const PdfObject*>& stack)
 {
-    switch (obj.GetDataType())
+    stack.push_back(&obj);
+    while (stack.size() != 0)
     {
-        case PdfDataType::Reference:
+        auto curr = stack.back();
+        stack.pop_back();
+        switch (curr->GetDataType())
         {
-            // Try to check if the object has been already visited
-            auto indirectReference = obj.GetReferenceUnsafe();
-            auto inserted = referencedObjects.insert(indirectReference);
-            if (!inserted.second)
+            case PdfDataType::Reference:
             {
-                // The object has been visited, just return
+                references.push_back(curr->GetReferenceUnsafe());
                 break;
             }
-
-            auto childObj = GetObject(indirectReference);
-            if (childObj == nullptr)
+            case PdfDataType::Array:
+            {
+                for (auto& child : curr->GetArrayUnsafe())
+                    stack.push_back(&child);
                 break;
-
-            visitObject(*childObj, referencedObjects);
-            break;
-        }
-        case PdfDataType::Array:
-        {
-            auto& arr = obj.GetArrayUnsafe();
-            for (auto& child : arr)
-                visitObject(child, referencedObjects);
-            break;
-        }
-        case PdfDataType::Dictionary:
-        {
-            auto& dict = obj.GetDictionaryUnsafe();
-            for (auto& pair : dict)
-                visitObject(pair.second, referencedObjects);
-            break;
-        }
-        default:
-        {
-            // Nothing to do
-            break;
+            }
+            case PdfDataType::Dictionary:
+            {
+                for (auto& pair : curr->GetDictionaryUnsafe())
+                    stack.push_back(&pair.second);
+                break;
+            }
+            default:
+            {
+                // Nothing to do
+                break;
+            }
         }
     }
 }
@@ -452,7 +543,7 @@ void PdfIndirectObjectList::EndAppendStream(PdfObjectStream& stream)
 
 unsigned PdfIndirectObjectList::GetSize() const
 {
-    return (unsigned)m_Objects.size();
+    return m_Size;
 }
 
 void PdfIndirectObjectList::AttachObserver(Observer& observer)
@@ -475,27 +566,172 @@ void PdfIndirectObjectList::tryIncrementObjectCount(const PdfReference& ref)
     }
 }
 
+PdfObject*& PdfIndirectObjectList::getOrCreateSlot(uint32_t objectNum)
+{
+    if (objectNum < m_Objects.size())
+        return m_Objects[objectNum];
+
+    // Don't grow the vector if less than a quarter of its slots
+    // would be used, so a single huge object number doesn't
+    // allocate a huge vector
+    size_t size = (size_t)objectNum + 1;
+    if (size > std::max(MinObjectListSize, ((size_t)m_Size + 1) * 4))
+        return m_sparseObjects[objectNum];
+
+    m_Objects.resize(size);
+
+    // Move the sparse objects that are now in range of the vector
+    auto it = m_sparseObjects.begin();
+    while (it != m_sparseObjects.end() && it->first < size)
+    {
+        m_Objects[it->first] = it->second;
+        it = m_sparseObjects.erase(it);
+    }
+
+    return m_Objects[objectNum];
+}
+
+size_t PdfIndirectObjectList::getEndIndex() const
+{
+    if (m_sparseObjects.empty())
+        return m_Objects.size();
+
+    return (size_t)m_sparseObjects.rbegin()->first + 1;
+}
+
 PdfIndirectObjectList::iterator PdfIndirectObjectList::begin() const
 {
-    return m_Objects.begin();
+    iterator ret(*this, 0);
+    ret.seekForward();
+    return ret;
 }
 
 PdfIndirectObjectList::iterator PdfIndirectObjectList::end() const
 {
-    return m_Objects.end();
+    return iterator(*this, numeric_limits<size_t>::max());
 }
 
 PdfIndirectObjectList::reverse_iterator PdfIndirectObjectList::rbegin() const
 {
-    return m_Objects.rbegin();
+    return reverse_iterator(end());
 }
 
 PdfIndirectObjectList::reverse_iterator PdfIndirectObjectList::rend() const
 {
-    return m_Objects.rend();
+    return reverse_iterator(begin());
 }
 
 size_t PdfIndirectObjectList::size() const
 {
-    return m_Objects.size();
+    return m_Size;
+}
+
+PdfIndirectObjectList::Iterator::Iterator()
+    : m_list(nullptr), m_Index(0) { }
+
+PdfIndirectObjectList::Iterator::Iterator(const PdfIndirectObjectList& list, size_t index)
+    : m_list(&list), m_Index(index) { }
+
+bool PdfIndirectObjectList::Iterator::operator==(const Iterator& rhs) const
+{
+    // NOTE: The end position is not fixed, so objects
+    // pushed during iteration are visited as well
+    bool isEnd = this->isEnd();
+    if (isEnd != rhs.isEnd())
+        return false;
+
+    return isEnd || m_Index == rhs.m_Index;
+}
+
+bool PdfIndirectObjectList::Iterator::operator!=(const Iterator& rhs) const
+{
+    return !(*this == rhs);
+}
+
+PdfIndirectObjectList::Iterator& PdfIndirectObjectList::Iterator::operator++()
+{
+    m_Index++;
+    seekForward();
+    return *this;
+}
+
+PdfIndirectObjectList::Iterator PdfIndirectObjectList::Iterator::operator++(int)
+{
+    auto copy = *this;
+    ++(*this);
+    return copy;
+}
+
+PdfIndirectObjectList::Iterator& PdfIndirectObjectList::Iterator::operator--()
+{
+    auto& objects = m_list->m_Objects;
+    auto& sparseObjects = m_list->m_sparseObjects;
+    m_Index = std::min(m_Index, m_list->getEndIndex());
+    if (m_Index > objects.size())
+    {
+        // Look for the previous object in the sparse objects first
+        auto found = m_Index > numeric_limits<uint32_t>::max()
+            ? sparseObjects.end() : sparseObjects.lower_bound((uint32_t)m_Index);
+        if (found != sparseObjects.begin())
+        {
+            m_Index = std::prev(found)->first;
+            return *this;
+        }
+
+        m_Index = objects.size();
+    }
+
+    do
+    {
+        m_Index--;
+    } while (m_Index != 0 && objects[m_Index] == nullptr);
+
+    return *this;
+}
+
+PdfIndirectObjectList::Iterator PdfIndirectObjectList::Iterator::operator--(int)
+{
+    auto copy = *this;
+    --(*this);
+    return copy;
+}
+
+PdfIndirectObjectList::Iterator::reference PdfIndirectObjectList::Iterator::operator*() const
+{
+    auto& objects = m_list->m_Objects;
+    if (m_Index < objects.size())
+        return objects[m_Index];
+
+    // The iterator is at the end, or its object was removed
+    auto found = m_Index > numeric_limits<uint32_t>::max()
+        ? m_list->m_sparseObjects.end() : m_list->m_sparseObjects.find((uint32_t)m_Index);
+    if (found == m_list->m_sparseObjects.end())
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "Dereferencing an invalid object list iterator");
+
+    return found->second;
+}
+
+PdfIndirectObjectList::Iterator::pointer PdfIndirectObjectList::Iterator::operator->() const
+{
+    return &**this;
+}
+
+bool PdfIndirectObjectList::Iterator::isEnd() const
+{
+    return m_list == nullptr || m_Index >= m_list->getEndIndex();
+}
+
+void PdfIndirectObjectList::Iterator::seekForward()
+{
+    // Skip the unused object numbers, up to the end
+    auto& objects = m_list->m_Objects;
+    while (m_Index < objects.size() && objects[m_Index] == nullptr)
+        m_Index++;
+
+    if (m_Index < objects.size() || m_Index > numeric_limits<uint32_t>::max())
+        return;
+
+    auto found = m_list->m_sparseObjects.lower_bound((uint32_t)m_Index);
+    if (found != m_list->m_sparseObjects.end())
+        m_Index = found->first;
 }
@@ -12,6 +12,7 @@
 namespace PoDoFo {
 
 class PdfObjectStreamProvider;
+class PdfArena;
 using PdfFreeObjectList = std::deque<PdfReference>;
 
 /** A list of PdfObjects that constitutes the indirect object list
@@ -29,6 +30,8 @@ using PdfFreeObjectList = std::deque<PdfReference>;
 class PODOFO_API PdfIndirectObjectList final
 {
     friend class PdfDocument;
+    friend class PdfDocumentProbe;
+    friend class PdfMemDocument;
     friend class PdfObject;
     friend class PdfObjectOutputStream;
     PODOFO_PRIVATE_FRIEND(class PdfObjectStreamParser);
@@ -38,9 +41,10 @@ class PODOFO_API PdfIndirectObjectList final
     PODOFO_PRIVATE_FRIEND(class PdfParserTest);
     PODOFO_PRIVATE_FRIEND(class PdfEncodingTest);
     PODOFO_PRIVATE_FRIEND(class PdfEncryptTest);
+    PODOFO_PRIVATE_FRIEND(class PdfObjectListTest);
 
 private:
-    // NOTE: For testing only
+    // NOTE: For testing and for PdfDocumentProbe only
     PdfIndirectObjectList();
 
 public:
@@ -88,8 +92,17 @@ public:
      * Deletes all objects that are not references by other objects
      * besides the trailer (which references the root dictionary, which in
      * turn should reference all other objects).
+     *
+     * Reachable objects are marked in a bitmap indexed by object
+     * number, with an iterative traversal
+     * \param incremental if true, the references found in the objects
+     *      are retained, and the next collections will scan only the
+     *      objects added or modified since, reusing the retained references
+     *      for the others. The first incremental collection scans all the
+     *      objects. A non incremental collection always scans all the
+     *      objects, refreshing the retained references, if any
      */
-    void CollectGarbage();
+    void CollectGarbage(bool incremental = false);
 
 public:
     /**
@@ -154,15 +167,52 @@ private:
     using ObjectNumSet = std::set<uint32_t>;
     using ReferenceSet = std::set<PdfReference>;
     using ObserverList = std::vector<Observer*>;
-    using ObjectList = std::set<PdfObject*, PdfObjectInequality>;
+    // Objects are indexed by object number, unused slots are null
+    using ObjectList = std::vector<PdfObject*>;
+    // Objects whose number would make the ObjectList too sparse
+    using SparseObjectMap = std::map<uint32_t, PdfObject*>;
 
 public:
+    /** Bidirectional iterator on the objects, in ascending
+     * object number order. Unused object numbers are skipped
+     * \remarks The iterator stays valid if other objects
+     * are pushed or removed
+     */
+    class PODOFO_API Iterator final
+    {
+        friend class PdfIndirectObjectList;
+    public:
+        using difference_type = std::ptrdiff_t;
+        using value_type = PdfObject*;
+        using pointer = PdfObject* const*;
+        using reference = PdfObject* const&;
+        using iterator_category = std::bidirectional_iterator_tag;
+    public:
+        Iterator();
+    private:
+        Iterator(const PdfIndirectObjectList& list, size_t index);
+    public:
+        Iterator(const Iterator&) = default;
+        Iterator& operator=(const Iterator&) = default;
+        bool operator==(const Iterator& rhs) const;
+        bool operator!=(const Iterator& rhs) const;
+        Iterator& operator++();
+        Iterator operator++(int);
+        Iterator& operator--();
+        Iterator operator--(int);
+        reference operator*() const;
+        pointer operator->() const;
+    private:
+        bool isEnd() const;
+        void seekForward();
+    private:
+        const PdfIndirectObjectList* m_list;
+        // The object number of the current object
+        size_t m_Index;
+    };
 
-    // An incomplete set of container typedefs, just enough to handle
-    // the begin() and end() methods we wrap from the internal vector.
-    // TODO: proper wrapper iterator class.
-    using iterator = ObjectList::const_iterator;
-    using reverse_iterator = ObjectList::const_reverse_iterator;
+    using iterator = Iterator;
+    using reverse_iterator = std::reverse_iterator<Iterator>;
 
     /** Iterator pointing at the beginning of the vector
      *  \returns beginning iterator
@@ -207,12 +257,15 @@ private:
      *                     you will always want to have this true
      *                     as invalid PDF files can be generated otherwise
      *  \returns The removed object.
+     *  \remarks If the document was loaded with arena allocation the
+     *  returned object is a copy allocated from the heap
      */
     std::unique_ptr<PdfObject> RemoveObject(const PdfReference& ref);
 
     /** Remove the object with the iterator it from the vector and return it
      *  \param ref the reference of the object to remove
      *  \returns the removed object
+     *  \remarks See RemoveObject(const PdfReference&)
      */
     std::unique_ptr<PdfObject> RemoveObject(const iterator& it);
 
@@ -302,9 +355,8 @@ private:
     void SetStreamFactory(StreamFactory* factory);
 
 private:
-    void pushObject(const ObjectList::const_iterator& hintpos, ObjectList::node_type& node, PdfObject* obj);
-
     std::unique_ptr<PdfObject> removeObject(const iterator& it, bool markAsFree);
+    std::unique_ptr<PdfObject> detachObject(std::unique_ptr<PdfObject>&& obj);
 
     void addNewObject(PdfObject* obj);
 
@@ -315,7 +367,17 @@ private:
 
     int32_t tryAddFreeObject(uint32_t objnum, uint32_t gennum);
 
-    void visitObject(const PdfObject& obj, std::unordered_set<PdfReference>& referencedObj);
+    static void collectReferences(const PdfObject& obj, std::vector<PdfReference>& references,
+        std::vector<const PdfObject*>& stack);
+
+    /** Mark the object as modified since the last incremental
+     * garbage collection, so it will be scanned again
+     */
+    void touchObject(uint32_t objectNum)
+    {
+        if (objectNum < m_touchedObjects.size())
+            m_touchedObjects[objectNum] = true;
+    }
 
     /**
      * Set the object count so that the object described this reference
@@ -325,16 +387,42 @@ private:
      */
     void tryIncrementObjectCount(const PdfReference& ref);
 
+    /** Get the slot of the object with the given object number, creating
+     * it if missing. The objects are indexed by m_Objects as long as at
+     * least a quarter of its slots is used, otherwise by m_sparseObjects
+     */
+    PdfObject*& getOrCreateSlot(uint32_t objectNum);
+
+    /** The number past the last object number with an object
+     */
+    size_t getEndIndex() const;
+
 private:
     PdfDocument* m_Document;
     ObjectList m_Objects;
+    SparseObjectMap m_sparseObjects;
+    unsigned m_Size;
     unsigned m_ObjectCount;
     PdfFreeObjectList m_FreeObjects;
     ObjectNumSet m_unavailableObjects;
     ObjectNumSet m_compressedObjectStreams;
 
+    // The references found in each object reachable at the last
+    // incremental garbage collection, at the ranges of m_gcReferences
+    // indexed by object number, and the objects modified since.
+    // NOTE: The objects in m_sparseObjects are always scanned again
+    struct GCSpan
+    {
+        size_t Offset;
+        uint32_t Count;
+    };
+    std::vector<GCSpan> m_gcSpans;
+    std::vector<PdfReference> m_gcReferences;
+    std::vector<bool> m_touchedObjects;
+
     ObserverList m_observers;
     StreamFactory* m_StreamFactory;
+    std::unique_ptr<PdfArena> m_arena;
 };
 
 };
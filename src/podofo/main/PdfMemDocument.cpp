@@ -10,6 +10,9 @@
 #include <podofo/auxiliary/StreamDevice.h>
 #include <podofo/private/PdfWriter.h>
 #include <podofo/private/PdfParser.h>
+#include <podofo/private/PdfArena.h>
+#include <podofo/private/PdfDeduplicator.h>
+#include <podofo/private/FileSystem.h>
 #include "PdfXObjectForm.h"
 #include "PdfPage.h"
 #include "PdfResources.h"
@@ -19,10 +22,10 @@
 #include "PdfObject.h"
 #include "PdfReference.h"
 #include "PdfObjectStream.h"
+#include "PdfStreamedDocument.h"
 
 #include "PdfCommon.h"
 
-#include <sstream>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -37,7 +40,8 @@ PdfMemDocument::PdfMemDocument(bool empty) :
     m_Version(PdfVersionDefault),
     m_InitialVersion(PdfVersionDefault),
     m_HasXRefStream(false),
-    m_PrevXRefOffset(-1)
+    m_PrevXRefOffset(-1),
+    m_ObjectStreamSize(PdfWriter::DefaultObjectStreamSize)
 {
 }
 
@@ -47,7 +51,7 @@ PdfMemDocument::PdfMemDocument(shared_ptr<InputStreamDevice> device, const strin
     if (device == nullptr)
         PODOFO_RAISE_ERROR(PdfErrorCode::InvalidHandle);
 
-    loadFromDevice(std::move(device), password);
+    loadFromDevice(std::move(device), password, PdfLoadOptions::None);
 }
 
 PdfMemDocument::PdfMemDocument(const PdfMemDocument& rhs) :
@@ -55,7 +59,8 @@ PdfMemDocument::PdfMemDocument(const PdfMemDocument& rhs) :
     m_Version(rhs.m_Version),
     m_InitialVersion(rhs.m_InitialVersion),
     m_HasXRefStream(rhs.m_HasXRefStream),
-    m_PrevXRefOffset(rhs.m_PrevXRefOffset)
+    m_PrevXRefOffset(rhs.m_PrevXRefOffset),
+    m_ObjectStreamSize(rhs.m_ObjectStreamSize)
 {
     // Do a full copy of the encrypt session
     if (rhs.m_Encrypt != nullptr)
@@ -68,6 +73,9 @@ void PdfMemDocument::clear()
     // usage. The other variables get initialized by parsing or reset
     m_Encrypt = nullptr;
     m_device = nullptr;
+
+    // NOTE: The objects are already deleted here
+    GetObjects().m_arena = nullptr;
 }
 
 void PdfMemDocument::reset()
@@ -100,47 +108,80 @@ void PdfMemDocument::initFromParser(PdfParser& parser)
     Init();
 }
 
-void PdfMemDocument::Load(const string_view& filename, const string_view& password)
+void PdfMemDocument::Load(const string_view& filename, const string_view& password,
+    PdfLoadOptions options)
 {
     if (filename.length() == 0)
         PODOFO_RAISE_ERROR(PdfErrorCode::InvalidHandle);
 
-    auto device = std::make_shared<FileStreamDevice>(filename);
-    Load(device, password);
+    shared_ptr<InputStreamDevice> device;
+    // NOTE: Parallel loading requires the content to be accessible in memory
+    if ((options & (PdfLoadOptions::MemoryMapped | PdfLoadOptions::ParallelLoad)) != PdfLoadOptions::None)
+        device = std::make_shared<MappedFileStreamDevice>(filename);
+    else
+        device = std::make_shared<FileStreamDevice>(filename);
+
+    Load(device, password, options);
 }
 
-void PdfMemDocument::LoadFromBuffer(const bufferview& buffer, const string_view& password)
+void PdfMemDocument::LoadFromBuffer(const bufferview& buffer, const string_view& password,
+    PdfLoadOptions options)
 {
     if (buffer.size() == 0)
         PODOFO_RAISE_ERROR(PdfErrorCode::InvalidHandle);
 
     auto device = std::make_shared<SpanStreamDevice>(buffer);
-    Load(device, password);
+    Load(device, password, options);
 }
 
-void PdfMemDocument::Load(shared_ptr<InputStreamDevice> device, const string_view& password)
+void PdfMemDocument::Load(shared_ptr<InputStreamDevice> device, const string_view& password,
+    PdfLoadOptions options)
 {
     if (device == nullptr)
         PODOFO_RAISE_ERROR(PdfErrorCode::InvalidHandle);
 
     this->Clear();
-    loadFromDevice(std::move(device), password);
+    loadFromDevice(std::move(device), password, options);
 }
 
-void PdfMemDocument::loadFromDevice(shared_ptr<InputStreamDevice>&& device, const string_view& password)
+void PdfMemDocument::loadFromDevice(shared_ptr<InputStreamDevice>&& device, const string_view& password,
+    PdfLoadOptions options)
 {
     m_device = std::move(device);
+    if ((options & PdfLoadOptions::ArenaAllocation) != PdfLoadOptions::None)
+        GetObjects().m_arena.reset(new PdfArena());
 
     // Call parse file instead of using the constructor
     // so that m_Parser is initialized for encrypted documents
     PdfParser parser(PdfDocument::GetObjects());
     parser.SetPassword(password);
-    parser.Parse(*m_device, true);
+    parser.SetRebuildBrokenXRef((options & PdfLoadOptions::RebuildBrokenXRef) != PdfLoadOptions::None);
+    parser.SetReferenceStreamData((options & PdfLoadOptions::ReferenceStreamData) != PdfLoadOptions::None);
+    if ((options & PdfLoadOptions::ParallelLoad) != PdfLoadOptions::None)
+    {
+        parser.SetThreadCount(0);
+        parser.Parse(*m_device, false);
+    }
+    else
+    {
+        parser.Parse(*m_device, true);
+    }
+
     initFromParser(parser);
 }
 
 void PdfMemDocument::Save(const string_view& filename, PdfSaveOptions options)
 {
+    // Creating the file truncates it, so a mapped
+    // source file is copied in memory before
+    auto mapped = dynamic_cast<MappedFileStreamDevice*>(m_device.get());
+    std::error_code ec;
+    if (mapped != nullptr && mapped->IsMapped()
+        && fs::equivalent(fs::u8path(mapped->GetFilepath()), fs::u8path(filename), ec))
+    {
+        mapped->Unmap();
+    }
+
     FileStreamDevice device(filename, FileMode::Create);
     this->Save(device, options);
 }
@@ -153,6 +194,9 @@ void PdfMemDocument::Save(OutputStreamDevice& device, PdfSaveOptions opts)
     writer.SetPdfVersion(GetMetadata().GetPdfVersion());
     writer.SetPdfALevel(GetMetadata().GetPdfALevel());
     writer.SetSaveOptions(opts);
+    writer.SetObjectStreamSize(m_ObjectStreamSize);
+    if ((opts & PdfSaveOptions::ParallelWrite) != PdfSaveOptions::None)
+        writer.SetThreadCount(0);
 
     if (m_Encrypt != nullptr)
         writer.SetEncrypt(*m_Encrypt);
@@ -185,6 +229,8 @@ void PdfMemDocument::SaveUpdate(OutputStreamDevice& device, PdfSaveOptions opts)
     writer.SetPrevXRefOffset(m_PrevXRefOffset);
     writer.SetUseXRefStream(m_HasXRefStream);
     writer.SetIncrementalUpdate(false);
+    if ((opts & PdfSaveOptions::ParallelWrite) != PdfSaveOptions::None)
+        writer.SetThreadCount(0);
 
     if (m_Encrypt != nullptr)
         writer.SetEncrypt(*m_Encrypt);
@@ -220,6 +266,10 @@ void PdfMemDocument::beforeWrite(PdfSaveOptions opts)
 
     GetFonts().EmbedFonts();
 
+    // Saving finishes merging other documents, so the resources
+    // copied so far are not compared with the next copies
+    EndMerge();
+
     // After we are done with all operations on objects,
     // we can collect garbage
     if ((opts & PdfSaveOptions::NoCollectGarbage) ==
@@ -252,6 +302,14 @@ const PdfEncrypt* PdfMemDocument::GetEncrypt() const
     return &m_Encrypt->GetEncrypt();
 }
 
+void PdfMemDocument::SetObjectStreamSize(unsigned size)
+{
+    if (size == 0)
+        PODOFO_RAISE_ERROR(PdfErrorCode::ValueOutOfRange);
+
+    m_ObjectStreamSize = size;
+}
+
 void PdfMemDocument::SetPdfVersion(PdfVersion version)
 {
     m_Version = version;
@@ -279,188 +337,52 @@ void PdfMemDocument::Select(const std::vector<unsigned>& pageNumbers)
             validPageNumbers.push_back(pageNum);
     }
     
-    // If no valid page numbers, clear all pages
-    if (validPageNumbers.empty())
-    {
-        while (pages.GetCount() > 0)
-            pages.RemovePageAt(0);
-        return;
-    }
-    
-    // Create a temporary document to store the selected pages
-    PdfMemDocument tempDoc;
-    
-    // Copy selected pages to temporary document in the specified order
-    for (unsigned pageNum : validPageNumbers)
-    {
-        // Get the page from the original document
-        PdfPage& originalPage = pages.GetPageAt(pageNum);
-        
-        // Create a new page in the temporary document with the same size
-        PdfPage& newPage = tempDoc.GetPages().CreatePage(originalPage.GetMediaBox());
-        
-        // Copy the page content by creating an XObject from the original page
-        auto xobj = this->CreateXObjectForm(originalPage.GetMediaBox());
-        this->FillXObjectFromPage(*xobj, originalPage, false);
-        
-        // Add the XObject to the new page
-        newPage.GetResources().AddResource("XObject"_n, "Page"_n, xobj->GetObject());
-        
-        // Create a content stream that shows the XObject
-        auto& contents = newPage.GetOrCreateContents();
-        auto& stream = contents.GetOrCreateStream();
-        auto output = stream.GetOutputStream({ PdfFilterType::FlateDecode });
-        
-        // Write the content stream to display the XObject
-        std::string contentStr = "q\n";
-        contentStr += "1 0 0 1 0 0 cm\n";  // Identity matrix
-        contentStr += "/Page Do\n";         // Display the XObject
-        contentStr += "Q\n";                // Restore graphics state
-        
-        output.Write(contentStr);
-    }
-    
-    // Clear the original document's pages
-    while (pages.GetCount() > 0)
-        pages.RemovePageAt(0);
-    
-    // Copy all pages from temporary document back to original document
-    this->AppendDocumentPages(tempDoc);
+    // Rebuild the page tree with the selected page objects, so only
+    // the selected pages are loaded and nothing is copied, except
+    // the pages selected more than once
+    pages.SelectPages(validPageNumbers);
+
+    // Remove the pages not selected and the objects used only by them
+    this->CollectGarbage();
 }
 
-void PdfMemDocument::DeduplicateObjects(bool aggressive)
+void PdfMemDocument::Split(const cspan<PdfPageRange>& ranges, const PdfSplitDeviceFactory& createDevice,
+    PdfSaveOptions opts) const
 {
-    auto& objects = this->GetObjects();
-    
-    // Step 1: Build a map of object content to object references
-    std::unordered_map<std::string, std::vector<PdfReference>> contentMap;
-    std::unordered_map<PdfReference, std::string> objectContent;
-    
-    for (auto obj : objects)
-    {
-        if (obj == nullptr)
-            continue;
-            
-        std::string content = getObjectContent(*obj, aggressive);
-        contentMap[content].push_back(obj->GetIndirectReference());
-        objectContent[obj->GetIndirectReference()] = content;
-    }
-    
-    // Step 2: Identify duplicates and create replacement map
-    std::unordered_map<PdfReference, PdfReference> replacementMap;
-    std::unordered_set<PdfReference> objectsToRemove;
-    
-    for (const auto& pair : contentMap)
+    unsigned pageCount = GetPages().GetCount();
+    for (auto& range : ranges)
     {
-        const auto& refs = pair.second;
-        if (refs.size() > 1)
-        {
-            // Keep the first reference, replace all others
-            PdfReference keepRef = refs[0];
-            for (size_t i = 1; i < refs.size(); i++)
-            {
-                replacementMap[refs[i]] = keepRef;
-                objectsToRemove.insert(refs[i]);
-            }
-        }
+        if (range.FirstPage > pageCount || range.PageCount > pageCount - range.FirstPage)
+            PODOFO_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Invalid page range");
     }
-    
-    // Step 3: Update all references in the document
-    updateObjectReferences(replacementMap);
-    
-    // Step 4: Remove duplicate objects
-    for (const auto& ref : objectsToRemove)
+
+    for (unsigned i = 0; i < ranges.size(); i++)
     {
-        objects.RemoveObject(ref);
+        auto device = createDevice(i);
+        if (device == nullptr)
+            PODOFO_RAISE_ERROR(PdfErrorCode::InvalidHandle);
+
+        PdfStreamedDocument part(std::move(device), m_Version, nullptr, opts);
+        part.AppendDocumentPages(*this, ranges[i].FirstPage, ranges[i].PageCount);
+        // NOTE: Close explicitly, so write errors are reported
+        part.Close();
     }
-    
-    // Step 5: Perform garbage collection
-    this->CollectGarbage();
 }
 
-std::string PdfMemDocument::getObjectContent(const PdfObject& obj, bool aggressive)
+void PdfMemDocument::DeduplicateObjects(bool aggressive)
 {
-    std::stringstream ss;
-    
-    switch (obj.GetDataType())
-    {
-        case PdfDataType::Null:
-            ss << "null";
-            break;
-            
-        case PdfDataType::Boolean:
-            ss << "bool:" << (obj.GetBool() ? "true" : "false");
-            break;
-            
-        case PdfDataType::Number:
-            if (obj.IsNumber())
-                ss << "num:" << obj.GetNumber();
-            else
-                ss << "int:" << obj.GetInt64();
-            break;
-            
-        case PdfDataType::Real:
-            ss << "real:" << obj.GetReal();
-            break;
-            
-        case PdfDataType::String:
-            ss << "str:" << obj.GetString().GetString();
-            break;
-            
-        case PdfDataType::Name:
-            ss << "name:" << obj.GetName().GetString();
-            break;
-            
-        case PdfDataType::Array:
-        {
-            ss << "array:[";
-            const auto& arr = obj.GetArray();
-            for (size_t i = 0; i < arr.GetSize(); i++)
-            {
-                if (i > 0) ss << ",";
-                ss << getObjectContent(arr[i], aggressive);
-            }
-            ss << "]";
-            break;
-        }
-        
-        case PdfDataType::Dictionary:
-        {
-            ss << "dict:{";
-            const auto& dict = obj.GetDictionary();
-            bool first = true;
-            for (const auto& pair : dict)
-            {
-                if (!first) ss << ",";
-                ss << pair.first.GetString() << ":" << getObjectContent(pair.second, aggressive);
-                first = false;
-            }
-            ss << "}";
-            
-            // Include stream content if aggressive mode is enabled
-            if (aggressive && obj.HasStream())
-            {
-                ss << "stream:";
-                auto& stream = obj.GetOrCreateStream();
-                charbuff buffer;
-                stream.CopyTo(buffer);
-                ss << std::string(buffer.data(), buffer.size());
-            }
-            break;
-        }
-        
-        case PdfDataType::Reference:
-            // For references, we include the reference itself in the content
-            // This ensures that identical references are considered the same
-            ss << "ref:" << obj.GetReference().ObjectNumber() << ":" << obj.GetReference().GenerationNumber();
-            break;
-            
-        default:
-            ss << "unknown";
-            break;
-    }
-    
-    return ss.str();
+    // Step 1: Identify duplicates and create replacement map
+    PdfDeduplicator deduplicator(this->GetObjects(), aggressive);
+    auto replacementMap = deduplicator.FindDuplicates();
+
+    // Step 2: Update all references in the document, trailer included
+    updateObjectReferences(replacementMap);
+    if (!replacementMap.empty())
+        updateObjectReferencesRecursive(this->GetTrailer().GetObject(), replacementMap);
+
+    // Step 3: Remove duplicate objects, which are now unreferenced,
+    // by performing garbage collection
+    this->CollectGarbage();
 }
 
 void PdfMemDocument::updateObjectReferences(const std::unordered_map<PdfReference, PdfReference>& replacementMap)
@@ -495,7 +417,7 @@ void PdfMemDocument::updateObjectReferencesRecursive(PdfObject& obj, const std::
         
         case PdfDataType::Array:
         {
-            auto& arr = obj.GetArrayUnsafe();
+            auto& arr = obj.GetArray();
             for (auto& child : arr)
             {
                 updateObjectReferencesRecursive(child, replacementMap);
@@ -505,7 +427,7 @@ void PdfMemDocument::updateObjectReferencesRecursive(PdfObject& obj, const std::
         
         case PdfDataType::Dictionary:
         {
-            auto& dict = obj.GetDictionaryUnsafe();
+            auto& dict = obj.GetDictionary();
             for (auto& pair : dict)
             {
                 updateObjectReferencesRecursive(pair.second, replacementMap);
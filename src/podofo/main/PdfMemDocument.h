@@ -18,6 +18,20 @@ namespace PoDoFo {
 class PdfParser;
 class PdfEncryptSession;
 
+/** A range of consecutive pages of a document
+ */
+struct PODOFO_API PdfPageRange final
+{
+    unsigned FirstPage = 0;     ///< The index of the first page (0-based)
+    unsigned PageCount = 0;
+};
+
+/** Function called by PdfMemDocument::Split() to get the
+ *  output device where to write each part of the document
+ *  \param index the index of the part
+ */
+using PdfSplitDeviceFactory = std::function<std::shared_ptr<OutputStreamDevice>(unsigned index)>;
+
 /** PdfMemDocument is the core class for reading and manipulating
  *  PDF files and writing them back to disk.
  *
@@ -52,29 +66,36 @@ public:
     /** Load a PdfMemDocument from a file
      *
      *  \param filename filename of the file which is going to be parsed/opened
+     *  \param options use PdfLoadOptions::MemoryMapped to map the file in memory,
+     *      PdfLoadOptions::ParallelLoad to fully load the document with multiple threads
      *
      *  When the bForUpdate is set to true, the filename is copied
      *  for later use by WriteUpdate.
      *
      *  \see WriteUpdate, LoadFromBuffer, LoadFromDevice
      */
-    void Load(const std::string_view& filename, const std::string_view& password = { });
+    void Load(const std::string_view& filename, const std::string_view& password = { },
+        PdfLoadOptions options = PdfLoadOptions::None);
 
     /** Load a PdfMemDocument from a buffer in memory
      *
      *  \param buffer a memory area containing the PDF data
+     *  \param options use PdfLoadOptions::ParallelLoad to fully load the document with multiple threads
      *
      *  \see WriteUpdate, Load, LoadFromDevice
      */
-    void LoadFromBuffer(const bufferview& buffer, const std::string_view& password = { });
+    void LoadFromBuffer(const bufferview& buffer, const std::string_view& password = { },
+        PdfLoadOptions options = PdfLoadOptions::None);
 
     /** Load a PdfMemDocument from a PdfRefCountedInputDevice
      *
      *  \param device the input device containing the PDF
+     *  \param options use PdfLoadOptions::ParallelLoad to fully load the document with multiple threads
      *
      *  \see WriteUpdate, Load, LoadFromBuffer
      */
-    void Load(std::shared_ptr<InputStreamDevice> device, const std::string_view& password = { });
+    void Load(std::shared_ptr<InputStreamDevice> device, const std::string_view& password = { },
+        PdfLoadOptions options = PdfLoadOptions::None);
 
     /** Save the complete document to a file
      *
@@ -137,6 +158,11 @@ public:
      *  page numbers. Pages not included in the pageNumbers vector will be removed.
      *  The order of pages in the resulting document will match the order in pageNumbers.
      *
+     *  The page tree is rebuilt with the existing page objects, so the pages keep
+     *  their annotations, and only the selected pages are loaded. A page selected
+     *  more than once is copied, sharing its contents and resources. The objects
+     *  no longer reachable are then removed, see CollectGarbage()
+     *
      *  \see PyMuPDF Document.select() for similar functionality
      */
     void Select(const std::vector<unsigned>& pageNumbers);
@@ -148,19 +174,42 @@ public:
      *  to point to a single instance of each unique object.
      *
      *  The deduplication process:
-     *  1. Identifies objects with identical content
+     *  1. Identifies objects with identical content, comparing
+     *     referenced objects by their content as well
      *  2. Keeps one instance of each unique object
      *  3. Updates all references to point to the kept objects
      *  4. Removes duplicate objects
      *  5. Performs garbage collection to clean up unreferenced objects
      *
+     *  Objects are compared by a structural hash, confirmed by a full
+     *  comparison, and stream data is read in chunks, so the memory
+     *  used doesn't grow with the size of the document content.
+     *  Catalog and page tree nodes are never merged
+     *
      *  \param aggressive if true, performs more aggressive deduplication including
-     *                    stream content comparison; if false, only compares object structure
+     *                    stream content comparison; if false, only compares object
+     *                    structure and objects with streams are never merged
      *
      *  \see mutool clean -gggg for similar functionality
      */
     void DeduplicateObjects(bool aggressive = true);
 
+    /** Split the document, writing each of the given page ranges
+     *  as a new document
+     *
+     *  The document is loaded once and only read. Each part is a
+     *  PdfStreamedDocument with the objects reachable from its pages,
+     *  written to its own output device, so only one part at a time
+     *  is kept in memory. Catalog entries like outlines and form
+     *  fields are not copied
+     *
+     *  \param ranges the pages of each part
+     *  \param createDevice called for each part, in order, to get its output device
+     *  \param opts additional options for writing the parts
+     */
+    void Split(const cspan<PdfPageRange>& ranges, const PdfSplitDeviceFactory& createDevice,
+        PdfSaveOptions opts = PdfSaveOptions::None) const;
+
     /** Encrypt the document during writing.
      *
      *  \param userPassword the user password (if empty the user does not have
@@ -187,6 +236,14 @@ public:
 
     const PdfEncrypt* GetEncrypt() const override;
 
+    /** Set the maximum number of objects packed in a single
+     * object stream when saving with PdfSaveOptions::ObjectStreams.
+     * Default is 100
+     */
+    void SetObjectStreamSize(unsigned size);
+
+    inline unsigned GetObjectStreamSize() const { return m_ObjectStreamSize; }
+
 protected:
     /** Set the PDF Version of the document. Has to be called before Write() to
      *  have an effect.
@@ -200,7 +257,8 @@ private:
     PdfMemDocument(bool empty);
 
 private:
-    void loadFromDevice(std::shared_ptr<InputStreamDevice>&& device, const std::string_view& password);
+    void loadFromDevice(std::shared_ptr<InputStreamDevice>&& device, const std::string_view& password,
+        PdfLoadOptions options);
 
     /** Internal method to load all objects from a PdfParser object.
      *  The objects will be removed from the parser and are now
@@ -216,13 +274,6 @@ private:
 
     void beforeWrite(PdfSaveOptions options);
 
-    /** Get a string representation of object content for deduplication
-     *  \param obj the object to get content for
-     *  \param aggressive if true, includes stream content in comparison
-     *  \returns string representation of object content
-     */
-    std::string getObjectContent(const PdfObject& obj, bool aggressive);
-
     /** Update all object references in the document according to replacement map
      *  \param replacementMap map of old references to new references
      */
@@ -242,6 +293,7 @@ private:
     PdfVersion m_InitialVersion;
     bool m_HasXRefStream;
     int64_t m_PrevXRefOffset;
+    unsigned m_ObjectStreamSize;
     std::unique_ptr<PdfEncryptSession> m_Encrypt;
     std::shared_ptr<InputStreamDevice> m_device;
 };
@@ -75,7 +75,6 @@ void PdfMemoryObjectStream::Write(OutputStream& stream, const PdfStatefulEncrypt
     }
 
     stream.Write("\nendstream\n");
-    stream.Flush();
 }
 
 size_t PdfMemoryObjectStream::GetLength() const
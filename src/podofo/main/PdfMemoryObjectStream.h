@@ -28,6 +28,7 @@ class PODOFO_API PdfMemoryObjectStream final : public PdfObjectStreamProvider
     friend class PdfObject;
     friend class PdfIndirectObjectList;
     PODOFO_PRIVATE_FRIEND(class PdfImmediateWriter);
+    PODOFO_PRIVATE_FRIEND(class PdfParserObjectStream);
 
 private:
     PdfMemoryObjectStream();
@@ -9,9 +9,13 @@
 
 #include <podofo/private/PdfEncodingPrivate.h>
 
+#include <mutex>
+#include <shared_mutex>
+
 #include <podofo/auxiliary/OutputDevice.h>
 #include "PdfTokenizer.h"
 #include "PdfPredefinedEncoding.h"
+#include <podofo/optional/PdfNames.h>
 
 using namespace std;
 using namespace PoDoFo;
@@ -22,6 +26,37 @@ void hexchr(const unsigned char ch, T& it);
 static void escapeNameTo(string& dst, bufferview view);
 static charbuff unescapeName(string_view view);
 
+namespace
+{
+    /** Process wide table of the names read by the parser,
+     * so equal names share the same data and compare by
+     * pointer. It's seeded with the well known names
+     * \remarks Interned names are never released, so the
+     * size of the table and of the names is bounded
+     */
+    class PdfNameTable final
+    {
+    public:
+        static constexpr unsigned MaxNameCount = 16384;
+        static constexpr unsigned MaxNameLength = 127;
+
+    public:
+        PdfNameTable();
+
+        static PdfNameTable& GetInstance();
+
+        /** Get the canonical name with the given raw data,
+         * interning it if missing and the table is not full
+         */
+        PdfName GetName(const string_view& raw);
+
+    private:
+        shared_mutex m_mutex;
+        // NOTE: The keys are views on the names data
+        unordered_map<string_view, PdfName> m_names;
+    };
+}
+
 const PdfName PdfName::Null = PdfName();
 
 PdfName::PdfName()
@@ -148,22 +183,14 @@ void PdfName::moveFrom(PdfName&& rhs)
 
 PdfName PdfName::FromEscaped(const string_view& view)
 {
-    // Slightly optimize memory usage by checking
-    // against some well known values
-    if (view == "Filter"sv)
-        return "Filter"_n;
-    else if (view == "Length"sv)
-        return "Length"_n;
-    else if (view == "FlateDecode"sv)
-        return "FlateDecode"_n;
-    else if (view == "Type"sv)
-        return "Type"_n;
-    else if (view == "Subtype"sv)
-        return "Subtype"_n;
-    else if (view == "Parent"sv)
-        return "Parent"_n;
-    else
-        return PdfName(unescapeName(view));
+    // Names are interned to reduce allocations and to make
+    // comparisons cheaper, since the same keys are repeated
+    // over and over in a document
+    if (view.find('#') == string_view::npos)
+        return PdfNameTable::GetInstance().GetName(view);
+
+    auto unescaped = unescapeName(view);
+    return PdfNameTable::GetInstance().GetName(string_view(unescaped.data(), unescaped.size()));
 }
 
 PdfName PdfName::FromRaw(const bufferview& rawcontent)
@@ -333,12 +360,12 @@ string_view PdfName::GetRawData() const
 
 bool PdfName::operator==(const PdfName& rhs) const
 {
-    return this->GetRawData() == rhs.GetRawData();
+    return PdfNameEquality()(*this, rhs);
 }
 
 bool PdfName::operator!=(const PdfName& rhs) const
 {
-    return this->GetRawData() != rhs.GetRawData();
+    return !PdfNameEquality()(*this, rhs);
 }
 
 bool PdfName::operator==(const char* str) const
@@ -379,6 +406,110 @@ PdfName::operator string_view() const
         return m_Utf8View;
 }
 
+PdfNameTable::PdfNameTable()
+{
+    // NOTE: Keep in sync with the constants of PdfNames
+    const PdfName* knownNames[] = {
+        &PdfNames::Contents, &PdfNames::Flags, &PdfNames::Length, &PdfNames::Rect,
+        &PdfNames::Size, &PdfNames::Subtype, &PdfNames::Type, &PdfNames::Filter,
+        &PdfNames::Parent, &PdfNames::Kids, &PdfNames::Count, &PdfNames::ExtGState,
+        &PdfNames::ColorSpace, &PdfNames::Pattern, &PdfNames::Shading, &PdfNames::XObject,
+        &PdfNames::Font, &PdfNames::Properties, &PdfNames::Resources, &PdfNames::AP,
+        &PdfNames::AS, &PdfNames::Names, &PdfNames::Limits, &PdfNames::Matrix,
+        &PdfNames::BBox, &PdfNames::Encrypt, &PdfNames::Info, &PdfNames::Root,
+        &PdfNames::ID, &PdfNames::Catalog, &PdfNames::C, &PdfNames::N,
+        &PdfNames::R, &PdfNames::D, &PdfNames::Yes, &PdfNames::Off,
+        &PdfNames::V, &PdfNames::T, &PdfNames::F, &PdfNames::FT,
+        &PdfNames::Ff, &PdfNames::A, &PdfNames::AA, &PdfNames::TU,
+        &PdfNames::TM, &PdfNames::H, &PdfNames::P, &PdfNames::CA,
+        &PdfNames::ca, &PdfNames::S, &PdfNames::CFM, &PdfNames::CF,
+        &PdfNames::OE, &PdfNames::UE, &PdfNames::StrF, &PdfNames::StmF,
+        &PdfNames::StdCF, &PdfNames::Perms, &PdfNames::AuthEvent, &PdfNames::EncryptMetadata,
+        &PdfNames::Fields, &PdfNames::Action, &PdfNames::Annot, &PdfNames::Annots,
+        &PdfNames::Metadata, &PdfNames::PageMode, &PdfNames::PageLayout, &PdfNames::URI,
+        &PdfNames::JS, &PdfNames::Border, &PdfNames::Page, &PdfNames::Pages,
+        &PdfNames::Outlines, &PdfNames::MediaBox, &PdfNames::CropBox, &PdfNames::TrimBox,
+        &PdfNames::BleedBox, &PdfNames::ArtBox, &PdfNames::Rotate, &PdfNames::Alternate,
+        &PdfNames::Title, &PdfNames::Lang, &PdfNames::Base, &PdfNames::ViewerPreferences,
+        &PdfNames::AcroForm, &PdfNames::Filespec, &PdfNames::Prev, &PdfNames::Next,
+        &PdfNames::CreationDate, &PdfNames::ModDate, &PdfNames::Author, &PdfNames::Creator,
+        &PdfNames::Subject, &PdfNames::Producer, &PdfNames::Keywords, &PdfNames::Trapped,
+        &PdfNames::Location, &PdfNames::FormType, &PdfNames::EmbeddedFile, &PdfNames::BaseFont,
+        &PdfNames::DescendantFonts, &PdfNames::FontDescriptor, &PdfNames::W, &PdfNames::DW,
+        &PdfNames::Identity, &PdfNames::Type0, &PdfNames::Type1, &PdfNames::Type3,
+        &PdfNames::TrueType, &PdfNames::FontFile, &PdfNames::FontFile2, &PdfNames::FontFile3,
+        &PdfNames::Length1, &PdfNames::Length2, &PdfNames::Length3, &PdfNames::XRef,
+        &PdfNames::Sig, &PdfNames::SigRef, &PdfNames::TransformParams, &PdfNames::WinAnsiEncoding,
+        &PdfNames::MacRomanEncoding, &PdfNames::MacExpertEncoding, &PdfNames::E, &PdfNames::X,
+        &PdfNames::U, &PdfNames::Fo, &PdfNames::BI, &PdfNames::PO,
+        &PdfNames::PC, &PdfNames::PV, &PdfNames::PI, &PdfNames::K,
+        &PdfNames::I, &PdfNames::O, &PdfNames::Dests, &PdfNames::JavaScript,
+        &PdfNames::Templates, &PdfNames::IDS, &PdfNames::URLS, &PdfNames::EmbeddedFiles,
+        &PdfNames::AlternatePresentations, &PdfNames::Renditions, &PdfNames::MK, &PdfNames::FS,
+        &PdfNames::CIDToGIDMap, &PdfNames::CIDSystemInfo, &PdfNames::Encoding, &PdfNames::ToUnicode,
+        &PdfNames::CIDSet, &PdfNames::Widths, &PdfNames::FontName, &PdfNames::FontFamily,
+        &PdfNames::FontStretch, &PdfNames::ItalicAngle, &PdfNames::FontWeight, &PdfNames::FontBBox,
+        &PdfNames::Ascent, &PdfNames::Descent, &PdfNames::CapHeight, &PdfNames::StemV,
+        &PdfNames::StemH, &PdfNames::XHeight, &PdfNames::MissingWidth, &PdfNames::Leading,
+        &PdfNames::AvgWidth, &PdfNames::MaxWidth, &PdfNames::DecodeParms, &PdfNames::SMask,
+        &PdfNames::ICCBased, &PdfNames::Indexed, &PdfNames::Separation, &PdfNames::DeviceCMYK,
+        &PdfNames::DeviceRGB, &PdfNames::DeviceGray, &PdfNames::FlateDecode, &PdfNames::Lab,
+        &PdfNames::CMap, &PdfNames::Identity_H, &PdfNames::Identity_V, &PdfNames::NeedAppearances,
+        &PdfNames::DA, &PdfNames::DR, &PdfNames::DS, &PdfNames::AC,
+        &PdfNames::BC, &PdfNames::BG, &PdfNames::RC, &PdfNames::RG,
+        &PdfNames::RV, &PdfNames::Open, &PdfNames::QuadPoints, &PdfNames::Index,
+        &PdfNames::MaxLen, &PdfNames::DocMDP, &PdfNames::TransformMethod, &PdfNames::Reference,
+        &PdfNames::ByteRange, &PdfNames::SubFilter, &PdfNames::SigFlags, &PdfNames::Name,
+        &PdfNames::Reason, &PdfNames::M, &PdfNames::Prop_Build, &PdfNames::App,
+        &PdfNames::ProcSet, &PdfNames::Dest, &PdfNames::Opt, &PdfNames::BaseEncoding,
+        &PdfNames::Differences, &PdfNames::Registry, &PdfNames::Ordering, &PdfNames::Supplement,
+        &PdfNames::CMapName, &PdfNames::UF, &PdfNames::Params, &PdfNames::EF,
+        &PdfNames::Version, &PdfNames::BaseVersion, &PdfNames::ExtensionLevel, &PdfNames::Extensions,
+        &PdfNames::FontMatrix, &PdfNames::FirstChar, &PdfNames::LastChar, &PdfNames::BitsPerSample,
+        &PdfNames::Decode, &PdfNames::Domain, &PdfNames::Encode, &PdfNames::FunctionType,
+        &PdfNames::Range, &PdfNames::WhitePoint, &PdfNames::BlackPoint, &PdfNames::First,
+        &PdfNames::Last, &PdfNames::Width, &PdfNames::Height, &PdfNames::BitsPerComponent,
+        &PdfNames::Mask, &PdfNames::Interpolate, &PdfNames::BM, &PdfNames::OP,
+        &PdfNames::op, &PdfNames::OPM, &PdfNames::RI, &PdfNames::HalftoneType,
+        &PdfNames::Frequency, &PdfNames::Angle, &PdfNames::SpotFunction, &PdfNames::HT
+    };
+
+    m_names.reserve(std::size(knownNames));
+    for (auto name : knownNames)
+        m_names.emplace(name->GetRawData(), *name);
+}
+
+PdfNameTable& PdfNameTable::GetInstance()
+{
+    static PdfNameTable s_instance;
+    return s_instance;
+}
+
+PdfName PdfNameTable::GetName(const string_view& raw)
+{
+    if (raw.size() > MaxNameLength)
+        return PdfName((charbuff)raw);
+
+    {
+        shared_lock<shared_mutex> lock(m_mutex);
+        auto found = m_names.find(raw);
+        if (found != m_names.end())
+            return found->second;
+    }
+
+    PdfName name((charbuff)raw);
+    // NOTE: Expand the UTF-8 representation now, since
+    // interned names data is shared among threads
+    (void)name.GetString();
+
+    unique_lock<shared_mutex> lock(m_mutex);
+    if (m_names.size() >= MaxNameCount)
+        return name;
+
+    auto inserted = m_names.try_emplace(name.GetRawData(), name);
+    return inserted.first->second;
+}
+
 /**
  * This function writes a hex encoded representation of the character
  * `ch' to `buf', advancing the iterator by two steps.
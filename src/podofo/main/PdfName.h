@@ -211,7 +211,14 @@ struct PODOFO_API PdfNameEquality
 
     inline bool operator()(const PdfName& lhs, const PdfName& rhs) const
     {
-        return lhs.GetRawData() == rhs.GetRawData();
+        // Interned names share the same data, so try
+        // first a cheap identity check
+        auto lhsData = lhs.GetRawData();
+        auto rhsData = rhs.GetRawData();
+        if (lhsData.data() == rhsData.data())
+            return lhsData.size() == rhsData.size();
+
+        return lhsData == rhsData;
     }
     inline bool operator()(const PdfName& lhs, const std::string_view& rhs) const
     {
@@ -5,6 +5,7 @@
  */
 
 #include <podofo/private/PdfDeclarationsPrivate.h>
+#include <podofo/private/PdfArena.h>
 #include "PdfObject.h"
 
 #include "PdfDocument.h"
@@ -241,43 +242,10 @@ void PdfObject::write(OutputStream& stream, bool skipLengthFix,
     PdfWriteFlags writeMode, const PdfStatefulEncrypt* encrypt, charbuff& buffer) const
 {
     if (m_IndirectReference.IsIndirect())
-        WriteHeader(stream, writeMode, buffer);
+        WriteHeader(stream, m_IndirectReference, writeMode, buffer);
 
     if (m_Stream != nullptr)
-    {
-        // Try to compress the flate compress the stream if it has no filters,
-        // the compression is not disabled and it's not the /MetaData object,
-        // which must be unfiltered as per PDF/A
-        const PdfObject* metadataObj;
-        if ((writeMode & PdfWriteFlags::NoFlateCompress) == PdfWriteFlags::None
-            && m_Stream->GetFilters().size() == 0
-            && (m_Document == nullptr 
-                || (metadataObj = m_Document->GetCatalog().GetMetadataObject()) == nullptr
-                || m_IndirectReference != metadataObj->GetIndirectReference()))
-        {
-            PdfObject object;
-            auto& objStream = object.GetOrCreateStream();
-            {
-                auto output = objStream.GetOutputStream({ PdfFilterType::FlateDecode });
-                auto input = m_Stream->GetInputStream();
-                input.CopyTo(output);
-            }
-
-            m_Stream->MoveFrom(objStream);
-        }
-
-        // Set length if it's not handled by the underlying provider
-        if (!skipLengthFix)
-        {
-            size_t length = m_Stream->GetLength();
-            if (encrypt != nullptr)
-                length = encrypt->CalculateStreamLength(length);
-
-            // Add the key without triggering SetDirty
-            const_cast<PdfObject&>(*this).m_Variant.GetDictionaryUnsafe()
-                .AddKeyNoDirtySet("Length"_n, PdfVariant(static_cast<int64_t>(length)));
-        }
-    }
+        PrepareStreamWrite(skipLengthFix, writeMode, encrypt);
 
     m_Variant.Write(stream, writeMode, encrypt, buffer);
     stream.Write('\n');
@@ -289,18 +257,59 @@ void PdfObject::write(OutputStream& stream, bool skipLengthFix,
         stream.Write("endobj\n");
 }
 
+void PdfObject::PrepareStreamWrite(bool skipLengthFix, PdfWriteFlags writeMode, const PdfStatefulEncrypt* encrypt) const
+{
+    // Try to compress the flate compress the stream if it has no filters,
+    // the compression is not disabled and it's not the /MetaData object,
+    // which must be unfiltered as per PDF/A
+    const PdfObject* metadataObj;
+    if ((writeMode & PdfWriteFlags::NoFlateCompress) == PdfWriteFlags::None
+        && m_Stream->GetFilters().size() == 0
+        && (m_Document == nullptr 
+            || (metadataObj = m_Document->GetCatalog().GetMetadataObject()) == nullptr
+            || m_IndirectReference != metadataObj->GetIndirectReference()))
+    {
+        PdfObject object;
+        auto& objStream = object.GetOrCreateStream();
+        {
+            auto output = objStream.GetOutputStream({ PdfFilterType::FlateDecode });
+            auto input = m_Stream->GetInputStream();
+            input.CopyTo(output);
+        }
+
+        m_Stream->MoveFrom(objStream);
+    }
+
+    // Set length if it's not handled by the underlying provider
+    if (!skipLengthFix)
+    {
+        size_t length = m_Stream->GetLength();
+        if (encrypt != nullptr)
+            length = encrypt->CalculateStreamLength(length);
+
+        // Add the key without triggering SetDirty
+        const_cast<PdfObject&>(*this).m_Variant.GetDictionaryUnsafe()
+            .AddKeyNoDirtySet("Length"_n, PdfVariant(static_cast<int64_t>(length)));
+    }
+}
+
 void PdfObject::WriteHeader(OutputStream& stream, PdfWriteFlags writeMode, charbuff& buffer) const
+{
+    WriteHeader(stream, m_IndirectReference, writeMode, buffer);
+}
+
+void PdfObject::WriteHeader(OutputStream& stream, const PdfReference& reference, PdfWriteFlags writeMode, charbuff& buffer)
 {
     if ((writeMode & PdfWriteFlags::Clean) != PdfWriteFlags::None
         || (writeMode & PdfWriteFlags::PdfAPreserve) != PdfWriteFlags::None)
     {
         // PDF/A compliance requires all objects to be written in a clean way
-        utls::FormatTo(buffer, "{} {} obj\n", m_IndirectReference.ObjectNumber(), m_IndirectReference.GenerationNumber());
+        utls::FormatTo(buffer, "{} {} obj\n", reference.ObjectNumber(), reference.GenerationNumber());
         stream.Write(buffer);
     }
     else
     {
-        utls::FormatTo(buffer, "{} {} obj", m_IndirectReference.ObjectNumber(), m_IndirectReference.GenerationNumber());
+        utls::FormatTo(buffer, "{} {} obj", reference.ObjectNumber(), reference.GenerationNumber());
         stream.Write(buffer);
     }
 }
@@ -421,6 +430,17 @@ PdfObject& PdfObject::operator=(PdfObject&& rhs) noexcept
     return *this;
 }
 
+void* PdfObject::operator new(size_t size)
+{
+    static_assert(alignof(PdfObject) <= PdfArena::Alignment, "Unsupported alignment");
+    return PdfArena::Allocate(size);
+}
+
+void PdfObject::operator delete(void* ptr) noexcept
+{
+    PdfArena::Deallocate(ptr);
+}
+
 void PdfObject::copyStreamFrom(const PdfObject& obj)
 {
     // NOTE: Don't call rhs.DelayedLoad() here. It's implicitly
@@ -581,6 +601,8 @@ void PdfObject::setDirty()
 {
     m_IsDirty = true;
     SetRevised();
+    if (m_Document != nullptr)
+        m_Document->GetObjects().touchObject(m_IndirectReference.ObjectNumber());
 }
 
 void PdfObject::resetDirty()
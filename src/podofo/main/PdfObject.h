@@ -49,6 +49,7 @@ class PODOFO_API PdfObject
     PODOFO_PRIVATE_FRIEND(class PdfParserObject);
     PODOFO_PRIVATE_FRIEND(class PdfWriter);
     PODOFO_PRIVATE_FRIEND(class PdfImmediateWriter);
+    PODOFO_PRIVATE_FRIEND(class PdfLinearizer);
     PODOFO_PRIVATE_FRIEND(class PdfXRef);
     PODOFO_PRIVATE_FRIEND(class PdfXRefStream);
 
@@ -400,6 +401,13 @@ public:
 
     operator const PdfVariant& () const;
 
+    /** Objects are allocated from the arena active on the
+     * current thread, if any
+     * \see PdfLoadOptions::ArenaAllocation
+     */
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr) noexcept;
+
 public:
     /** The dirty flag is set if this variant
      *  has been modified after construction.
@@ -551,6 +559,12 @@ private:
     void SetImmutable();
     void WriteHeader(OutputStream& stream, PdfWriteFlags writeMode, charbuff& buffer) const;
 
+    // To be called by PdfLinearizer
+    static void WriteHeader(OutputStream& stream, const PdfReference& reference,
+        PdfWriteFlags writeMode, charbuff& buffer);
+    void PrepareStreamWrite(bool skipLengthFix, PdfWriteFlags writeMode,
+        const PdfStatefulEncrypt* encrypt) const;
+
     // To be called by PdfDataContainer
     bool IsImmutable() const { return m_IsImmutable; }
 
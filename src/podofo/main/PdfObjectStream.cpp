@@ -359,8 +359,19 @@ unique_ptr<InputStream> PdfObjectStream::getInputStream(bool raw, PdfFilterList&
         }
         else
         {
+            // The /DL key is the length of the data decoded by all
+            // the filters, so it's meaningful only without media filters
+            int64_t decodedLength = -1;
+            if (mediaFilters.size() == 0)
+            {
+                auto decodedLengthObj = m_Parent->GetDictionaryUnsafe().FindKey("DL");
+                if (decodedLengthObj == nullptr || !decodedLengthObj->TryGetNumber(decodedLength))
+                    decodedLength = -1;
+            }
+
             return PdfFilterFactory::CreateDecodeStream(
-                m_Provider->GetInputStream(*m_Parent), nonMediaFilters, decodeParms);
+                m_Provider->GetInputStream(*m_Parent), nonMediaFilters, decodeParms,
+                (ssize_t)decodedLength);
         }
     }
 }
@@ -389,6 +400,14 @@ void PdfObjectStream::InitData(InputStream& stream, size_t size, PdfFilterList&&
     m_Filters = std::move(filterList);
 }
 
+void PdfObjectStream::InitData(unique_ptr<PdfObjectStreamProvider>&& provider, PdfFilterList&& filterList)
+{
+    ensureClosed();
+    m_Provider = std::move(provider);
+    m_Provider->Init(*m_Parent);
+    m_Filters = std::move(filterList);
+}
+
 void PdfObjectStream::ensureClosed() const
 {
     PODOFO_RAISE_LOGIC_IF(m_locked, "The stream should have no read/write operations in progress");
@@ -90,6 +90,8 @@ class PODOFO_API PdfObjectStream final
     friend class PdfObjectOutputStream;
     PODOFO_PRIVATE_FRIEND(class PdfParserObject);
     PODOFO_PRIVATE_FRIEND(class PdfImmediateWriter);
+    PODOFO_PRIVATE_FRIEND(class PdfLinearizer);
+    PODOFO_PRIVATE_FRIEND(class PdfDocumentMerger);
 
 private:
     /** Create a new PdfObjectStream object which has a parent PdfObject.
@@ -225,6 +227,10 @@ private:
 
     void InitData(InputStream& stream, size_t len, PdfFilterList&& filterList);
 
+    /** Initialize the stream with a provider already holding the data
+     */
+    void InitData(std::unique_ptr<PdfObjectStreamProvider>&& provider, PdfFilterList&& filterList);
+
     /** Copy data and non data fields from rhs
      */
     void CopyFrom(const PdfObjectStream& rhs);
@@ -11,6 +11,7 @@
 
 #include "PdfDocument.h"
 #include "PdfArray.h"
+#include "PdfCommon.h"
 #include "PdfDictionary.h"
 #include "PdfObject.h"
 #include <podofo/auxiliary/OutputDevice.h>
@@ -27,20 +28,44 @@ namespace
         Node,
         Page
     };
+
+    // A node in the path from the root to a page, with
+    // the position in /Kids of the next node of the path
+    struct PageTreePathNode
+    {
+        PdfObject* Node;
+        unsigned Position;
+    };
 }
 
+// The maximum number of kids of the nodes of a balanced tree
+constexpr unsigned MaxPageTreeKids = 32;
+
+// The attributes of the pages that can be inherited from the tree nodes,
+// see ISO 32000-2:2020, 7.7.3.4 Inheritance of page attributes
+static const PdfName InheritableAttributes[] = { "Resources"_n, "MediaBox"_n, "CropBox"_n, "Rotate"_n };
+
 static PdfPageTreeNodeType getPageTreeNodeType(const PdfObject& nodeObj);
 static unsigned getChildCount(const PdfObject& nodeObj);
+static unsigned getKidCount(const PdfObject* kidObj);
+static PdfArray& getKids(PdfObject& nodeObj);
+static PdfObject& createNode(PdfObject& parent);
+static void isolatePages(const vector<PageTreePathNode>& path, cspan<PdfPage*> pages);
+static PdfObject& pushDownRoot(PdfObject& root);
+static void findPagePath(PdfObject& root, unsigned index, vector<PageTreePathNode>& path);
+static void updateCounts(const vector<PageTreePathNode>& path, int delta);
+static void splitNode(vector<PageTreePathNode>& path, unsigned level, bool append);
+static PdfObject& clonePage(const PdfObject& pageObj);
 
 PdfPageCollection::PdfPageCollection(PdfDocument& doc)
-    : PdfDictionaryElement(doc, "Pages"_n), m_initialized(true)
+    : PdfDictionaryElement(doc, "Pages"_n), m_initialized(true), m_loaded(true), m_consistent(true)
 {
-    m_kidsArray = &GetDictionary().AddKey("Kids"_n, PdfArray()).GetArray();
+    GetDictionary().AddKey("Kids"_n, PdfArray());
     GetDictionary().AddKey("Count"_n, static_cast<int64_t>(0));
 }
 
 PdfPageCollection::PdfPageCollection(PdfObject& pagesRoot)
-    : PdfDictionaryElement(pagesRoot), m_initialized(false), m_kidsArray(nullptr)
+    : PdfDictionaryElement(pagesRoot), m_initialized(false), m_loaded(false), m_consistent(false)
 {
 }
 
@@ -48,6 +73,9 @@ PdfPageCollection::~PdfPageCollection()
 {
     for (unsigned i = 0; i < m_Pages.size(); i++)
         delete m_Pages[i];
+
+    for (auto page : m_unreachablePages)
+        delete page;
 }
 
 unsigned PdfPageCollection::GetCount() const
@@ -58,32 +86,22 @@ unsigned PdfPageCollection::GetCount() const
 
 PdfPage& PdfPageCollection::GetPageAt(unsigned index)
 {
-    const_cast<PdfPageCollection&>(*this).initPages();
-    if (index >= m_Pages.size())
-        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Page with index {} not found", index);
-
-    return *m_Pages[index];
+    return getPageAt(index);
 }
 
 const PdfPage& PdfPageCollection::GetPageAt(unsigned index) const
 {
-    const_cast<PdfPageCollection&>(*this).initPages();
-    if (index >= m_Pages.size())
-        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Page with index {} not found", index);
-
-    return *m_Pages[index];
+    return const_cast<PdfPageCollection&>(*this).getPageAt(index);
 }
 
 PdfPage& PdfPageCollection::GetPage(const PdfReference& ref)
 {
-    const_cast<PdfPageCollection&>(*this).initPages();
     return getPage(ref);
 }
 
 const PdfPage& PdfPageCollection::GetPage(const PdfReference& ref) const
 {
-    const_cast<PdfPageCollection&>(*this).initPages();
-    return getPage(ref);
+    return const_cast<PdfPageCollection&>(*this).getPage(ref);
 }
 
 Rect PdfPageCollection::getActualRect(const nullable<Rect>& size)
@@ -92,8 +110,10 @@ Rect PdfPageCollection::getActualRect(const nullable<Rect>& size)
     {
         if (m_Pages.size() == 0)
             return PdfPage::CreateStandardPageSize(PdfPageSize::A4);
+        else if (m_Pages.back() == nullptr)
+            return *m_flushedPageRect;
         else
-            return m_Pages[m_Pages.size() - 1]->GetRect();
+            return m_Pages.back()->GetRect();
     }
     else
     {
@@ -101,44 +121,89 @@ Rect PdfPageCollection::getActualRect(const nullable<Rect>& size)
     }
 }
 
-PdfPage& PdfPageCollection::getPage(const PdfReference& ref) const
+PdfPage& PdfPageCollection::getPageAt(unsigned index)
+{
+    initPages();
+    if (index < m_Pages.size() && m_Pages[index] == nullptr && !m_loaded
+        && tryLoadPage(index) == nullptr)
+    {
+        // The /Count entries of the tree are inconsistent
+        loadPages();
+    }
+
+    if (index >= m_Pages.size())
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Page with index {} not found", index);
+
+    if (m_Pages[index] == nullptr)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "Page with index {} was flushed", index);
+
+    return *m_Pages[index];
+}
+
+PdfPage& PdfPageCollection::getPage(const PdfReference& ref)
 {
-    // We have to search through all pages,
-    // as this is the only way
-    // to instantiate the PdfPage with a correct list of parents
+    initPages();
+    auto found = m_pageIndices.find(ref);
+    if (found != m_pageIndices.end())
+        return *m_Pages[found->second];
+
+    if (!m_loaded)
+    {
+        auto pageObj = GetDocument().GetObjects().GetObject(ref);
+        unsigned index;
+        PdfPage* page;
+        if (pageObj != nullptr && tryGetPageIndex(*pageObj, index) && index < m_Pages.size()
+            && (page = m_Pages[index] == nullptr ? tryLoadPage(index) : m_Pages[index]) != nullptr
+            && &page->GetObject() == pageObj)
+        {
+            return *page;
+        }
+
+        loadPages();
+    }
+
+    // Index all the pages, so the next lookups are constant time
     for (unsigned i = 0; i < m_Pages.size(); i++)
     {
-        auto& page = *m_Pages[i];
-        if (page.GetObject().GetIndirectReference() == ref)
-            return page;
+        auto page = m_Pages[i];
+        if (page != nullptr)
+            m_pageIndices[page->GetObject().GetIndirectReference()] = i;
     }
 
-    PODOFO_RAISE_ERROR(PdfErrorCode::ValueOutOfRange);
+    found = m_pageIndices.find(ref);
+    if (found == m_pageIndices.end())
+        PODOFO_RAISE_ERROR(PdfErrorCode::ValueOutOfRange);
+
+    return *m_Pages[found->second];
 }
 
 PdfPageCollection::iterator PdfPageCollection::begin()
 {
+    loadPages();
     return m_Pages.begin();
 }
 
 PdfPageCollection::iterator PdfPageCollection::end()
 {
+    loadPages();
     return m_Pages.end();
 }
 
 PdfPageCollection::const_iterator PdfPageCollection::begin() const
 {
+    const_cast<PdfPageCollection&>(*this).loadPages();
     return m_Pages.begin();
 }
 
 PdfPageCollection::const_iterator PdfPageCollection::end() const
 {
+    const_cast<PdfPageCollection&>(*this).loadPages();
     return m_Pages.end();
 }
 
 void PdfPageCollection::InsertPageAt(unsigned atIndex, PdfPage& pageObj)
 {
-    FlattenStructure();
+    initTree();
     vector<PdfPage*> objs = { &pageObj };
     insertPagesAt(atIndex, objs);
 }
@@ -151,67 +216,75 @@ void PdfPageCollection::insertPageAt(unsigned atIndex, PdfPage& pageObj)
 
 void PdfPageCollection::InsertPagesAt(unsigned atIndex, cspan<PdfPage*> pages)
 {
-    FlattenStructure();
+    initTree();
     insertPagesAt(atIndex, pages);
 }
 
 bool PdfPageCollection::TryMovePageTo(unsigned atIndex, unsigned toIndex)
 {
+    initTree();
     PODOFO_ASSERT(atIndex < m_Pages.size() && atIndex != toIndex);
     if (toIndex >= m_Pages.size())
         return false;
-    
-    FlattenStructure();
 
-    m_kidsArray->MoveTo(atIndex, toIndex);
+    // Check the paths where the page is removed and then inserted,
+    // that after the removal leads where the next page was
+    checkTreePath(atIndex);
+    checkTreePath(atIndex < toIndex ? toIndex + 1 : toIndex);
 
+    // The page may be moved in a node with different
+    // inherited attributes, so it gets its own
     auto temp = m_Pages[atIndex];
+    if (temp == nullptr && !m_loaded)
+        temp = &getPageAt(atIndex);
+
+    if (temp != nullptr)
+        temp->FlattenStructure();
+
+    m_pageIndices.clear();
+    removeTreePage(atIndex);
+    insertTreePages(toIndex, cspan<PdfPage*>(&temp, 1));
+
     if (atIndex > toIndex)
     {
         for (unsigned i = atIndex; i > toIndex; i--)
-        {
             m_Pages[i] = m_Pages[i - 1];
-            m_Pages[i]->SetIndex(i);
-        }
     }
     else
     {
         for (unsigned i = atIndex; i < toIndex; i++)
-        {
             m_Pages[i] = m_Pages[i + 1];
-            m_Pages[i]->SetIndex(i);
-        }
     }
 
     m_Pages[toIndex] = temp;
-    m_Pages[toIndex]->SetIndex(toIndex);
+    for (unsigned i = std::min(atIndex, toIndex); i <= std::max(atIndex, toIndex); i++)
+    {
+        if (m_Pages[i] != nullptr)
+            m_Pages[i]->SetIndex(i);
+    }
 
     return true;
 }
 
 void PdfPageCollection::insertPagesAt(unsigned atIndex, cspan<PdfPage*> pages)
 {
+    checkTreePath(atIndex);
+    m_pageIndices.clear();
+
     // Insert the pages and fix the indices
     m_Pages.insert(m_Pages.begin() + atIndex, pages.begin(), pages.end());
     for (unsigned i = atIndex; i < m_Pages.size(); i++)
-        m_Pages[i]->SetIndex(i);
-
-    // Update the actual /Kids array and set /Parent to the new pages
-    vector<PdfObject> pageObjects;
-    pageObjects.reserve(pages.size());
-    for (unsigned i = 0; i < pages.size(); i++)
     {
-        pageObjects.push_back(pages[i]->GetObject().GetIndirectReference());
-        pages[i]->GetDictionary().AddKey("Parent"_n, GetObject().GetIndirectReference());
+        if (m_Pages[i] != nullptr)
+            m_Pages[i]->SetIndex(i);
     }
 
-    m_kidsArray->insert(m_kidsArray->begin() + atIndex, pageObjects.begin(), pageObjects.end());
-    GetDictionary().AddKey("Count"_n, static_cast<int64_t>(m_Pages.size()));
+    insertTreePages(atIndex, pages);
 }
 
 PdfPage& PdfPageCollection::CreatePage(const nullable<Rect>& size_)
 {
-    FlattenStructure();
+    initTree();
     auto size = getActualRect(size_);
     unique_ptr<PdfPage> page(new PdfPage(GetDocument(), size));
     insertPageAt((unsigned)m_Pages.size(), *page);
@@ -225,7 +298,7 @@ PdfPage& PdfPageCollection::CreatePage(PdfPageSize pageSize)
 
 PdfPage& PdfPageCollection::CreatePageAt(unsigned atIndex, const nullable<Rect>& size_)
 {
-    FlattenStructure();
+    initTree();
     auto size = getActualRect(size_);
 
     unsigned pageCount = this->GetCount();
@@ -244,7 +317,7 @@ PdfPage& PdfPageCollection::CreatePageAt(unsigned atIndex, PdfPageSize pageSize)
 
 void PdfPageCollection::CreatePagesAt(unsigned atIndex, unsigned count, const nullable<Rect>& size_)
 {
-    FlattenStructure();
+    initTree();
     auto size = getActualRect(size_);
 
     unsigned pageCount = this->GetCount();
@@ -280,45 +353,290 @@ void PdfPageCollection::InsertDocumentPageAt(unsigned atIndex, const PdfDocument
 
 void PdfPageCollection::RemovePageAt(unsigned atIndex)
 {
-    FlattenStructure();
+    initTree();
     if (atIndex >= m_Pages.size())
         return;
 
+    checkTreePath(atIndex);
+    m_pageIndices.clear();
     auto page = m_Pages[atIndex];
     m_Pages.erase(m_Pages.begin() + atIndex);
     delete page;
-    m_kidsArray->RemoveAt(atIndex);
+    removeTreePage(atIndex);
 
     // Fix page indices
     for (unsigned i = atIndex; i < m_Pages.size(); i++)
-        m_Pages[i]->SetIndex(i);
-
-    GetDictionary().AddKey("Count"_n, static_cast<int64_t>(m_Pages.size()));
+    {
+        if (m_Pages[i] != nullptr)
+            m_Pages[i]->SetIndex(i);
+    }
 
     // After removing the page the /OpenAction entry may be invalidated,
     // prompting an error using Acrobat. Remove it for safer behavior
     GetDocument().GetCatalog().GetDictionary().RemoveKey("OpenAction");
 }
 
+void PdfPageCollection::DetachFlushedPage(PdfPage& page)
+{
+    PODOFO_ASSERT(m_Pages[page.GetIndex()] == &page);
+    // The page is written with its /Parent, which must not change
+    // anymore. Pages are moved out of a node only when the root is
+    // pushed down or when a node is split, which doesn't move the
+    // flushed pages, so the root must not be the parent
+    if (page.GetDictionary().FindKey("Parent") == &GetObject())
+        (void)pushDownRoot(GetObject());
+
+    m_pageIndices.erase(page.GetObject().GetIndirectReference());
+    m_Pages[page.GetIndex()] = nullptr;
+    m_flushedPageRect = page.GetRect();
+    delete &page;
+}
+
 void PdfPageCollection::initPages()
 {
     if (m_initialized)
         return;
 
-    vector<PdfObject*> parents;
+    // Each page is an object, so a greater count is surely broken
+    auto countObj = GetDictionary().FindKey("Count");
+    int64_t count;
+    if (countObj == nullptr || !countObj->TryGetNumber(count)
+        || count < 0 || count > (int64_t)GetDocument().GetObjects().GetSize()
+        || !checkNodeCount(GetObject()))
+    {
+        loadPages();
+        return;
+    }
+
+    m_Pages.resize((size_t)count);
+    m_initialized = true;
+}
+
+void PdfPageCollection::loadPages()
+{
+    if (m_loaded)
+        return;
+
+    // Reuse the pages already loaded, that may be referenced by the user
+    unordered_map<PdfObject*, PdfPage*> loadedPages;
+    for (auto page : m_Pages)
+    {
+        if (page != nullptr)
+            loadedPages[&page->GetObject()] = page;
+    }
+
+    // NOTE: The /Count entries are not trusted anymore,
+    // so the whole tree is traversed
+    PageList pages;
     unsigned count = getChildCount(GetObject());
-    if (count != 0)
+    if (count != 0 || getPageTreeNodeType(GetObject()) == PdfPageTreeNodeType::Node)
     {
-        m_Pages.reserve(count);
+        pages.reserve(std::min(count, GetDocument().GetObjects().GetSize()));
+        vector<PdfObject*> parents;
         unordered_set<PdfObject*> visitedNodes;
-        (void)traversePageTreeNode(GetObject(), count, parents, visitedNodes);
+        try
+        {
+            (void)traversePageTreeNode(GetObject(), numeric_limits<unsigned>::max(),
+                pages, loadedPages, parents, visitedNodes);
+        }
+        catch (...)
+        {
+            unordered_set<PdfPage*> previousPages(m_Pages.begin(), m_Pages.end());
+            for (auto page : pages)
+            {
+                if (previousPages.find(page) == previousPages.end())
+                    delete page;
+            }
+
+            throw;
+        }
     }
 
+    // NOTE: Loaded pages not found by the traversal may be
+    // referenced by the user, so they are kept alive
+    for (auto& pair : loadedPages)
+        m_unreachablePages.push_back(pair.second);
+
+    m_Pages = std::move(pages);
+    m_pageIndices.clear();
+    m_checkedNodes.clear();
     m_initialized = true;
+    m_loaded = true;
+}
+
+PdfPage* PdfPageCollection::tryLoadPage(unsigned index)
+{
+    PODOFO_ASSERT(index < m_Pages.size() && m_Pages[index] == nullptr);
+    vector<PdfObject*> parents;
+    auto node = &GetObject();
+    unsigned remaining = index;
+    while (true)
+    {
+        if (parents.size() == PdfCommon::GetMaxRecursionDepth()
+            || std::find(parents.begin(), parents.end(), node) != parents.end())
+        {
+            // The tree has loops
+            return nullptr;
+        }
+
+        parents.push_back(node);
+
+        PdfArray* kidsArr;
+        if (!node->GetDictionary().TryFindKeyAs("Kids", kidsArr)
+            || !checkNodeCount(*node))
+        {
+            return nullptr;
+        }
+
+        PdfObject* next = nullptr;
+        for (unsigned i = 0; i < kidsArr->GetSize(); i++)
+        {
+            auto child = kidsArr->FindAt(i);
+            if (child == nullptr || !child->IsDictionary())
+                continue;
+
+            switch (getPageTreeNodeType(*child))
+            {
+                case PdfPageTreeNodeType::Page:
+                {
+                    if (remaining != 0)
+                    {
+                        remaining--;
+                        break;
+                    }
+
+                    auto page = new PdfPage(*child, std::move(parents));
+                    page->SetIndex(index);
+                    m_Pages[index] = page;
+                    m_pageIndices[child->GetIndirectReference()] = index;
+                    return page;
+                }
+                case PdfPageTreeNodeType::Node:
+                {
+                    unsigned count = getChildCount(*child);
+                    if (remaining < count)
+                        next = child;
+                    else if (checkNodeCount(*child))
+                        remaining -= count;
+                    else
+                        return nullptr;
+
+                    break;
+                }
+                default:
+                    return nullptr;
+            }
+
+            if (next != nullptr)
+                break;
+        }
+
+        if (next == nullptr)
+            return nullptr;
+
+        node = next;
+    }
+}
+
+bool PdfPageCollection::checkNodeCount(const PdfObject& nodeObj)
+{
+    if (m_checkedNodes.find(&nodeObj) != m_checkedNodes.end())
+        return true;
+
+    auto countObj = nodeObj.GetDictionary().FindKey("Count");
+    const PdfArray* kidsArr;
+    int64_t count;
+    if (countObj == nullptr || !countObj->TryGetNumber(count)
+        || !nodeObj.GetDictionary().TryFindKeyAs("Kids", kidsArr))
+    {
+        return false;
+    }
+
+    int64_t kidsCount = 0;
+    for (unsigned i = 0; i < kidsArr->GetSize(); i++)
+    {
+        auto child = kidsArr->FindAt(i);
+        if (child == nullptr || !child->IsDictionary())
+            continue;
+
+        switch (getPageTreeNodeType(*child))
+        {
+            case PdfPageTreeNodeType::Page:
+                kidsCount++;
+                break;
+            case PdfPageTreeNodeType::Node:
+                kidsCount += getChildCount(*child);
+                break;
+            default:
+                return false;
+        }
+    }
+
+    if (kidsCount != count)
+        return false;
+
+    m_checkedNodes.insert(&nodeObj);
+    return true;
+}
+
+bool PdfPageCollection::tryGetPageIndex(const PdfObject& pageObj, unsigned& index)
+{
+    if (!pageObj.IsDictionary() || getPageTreeNodeType(pageObj) != PdfPageTreeNodeType::Page)
+        return false;
+
+    index = 0;
+    auto node = &pageObj;
+    for (unsigned depth = 0; node != &GetObject(); depth++)
+    {
+        const PdfObject* parent;
+        const PdfArray* kidsArr;
+        if (depth == PdfCommon::GetMaxRecursionDepth()
+            || (parent = node->GetDictionary().FindKey("Parent")) == nullptr
+            || !parent->IsDictionary()
+            || !parent->GetDictionary().TryFindKeyAs("Kids", kidsArr))
+        {
+            return false;
+        }
+
+        // Count the pages of the preceding siblings
+        bool found = false;
+        for (unsigned i = 0; i < kidsArr->GetSize(); i++)
+        {
+            auto child = kidsArr->FindAt(i);
+            if (child == node)
+            {
+                found = true;
+                break;
+            }
+
+            if (child == nullptr || !child->IsDictionary())
+                continue;
+
+            switch (getPageTreeNodeType(*child))
+            {
+                case PdfPageTreeNodeType::Page:
+                    index++;
+                    break;
+                case PdfPageTreeNodeType::Node:
+                    index += getChildCount(*child);
+                    break;
+                default:
+                    return false;
+            }
+        }
+
+        if (!found)
+            return false;
+
+        node = parent;
+    }
+
+    return true;
 }
 
 // Returns the number of the remaining
-unsigned PdfPageCollection::traversePageTreeNode(PdfObject& obj, unsigned count,
+unsigned PdfPageCollection::traversePageTreeNode(PdfObject& obj, unsigned count, PageList& pages,
+    unordered_map<PdfObject*, PdfPage*>& loadedPages,
     vector<PdfObject*>& parents, unordered_set<PdfObject*>& visitedNodes)
 {
     PODOFO_ASSERT(count != 0);
@@ -350,7 +668,7 @@ unsigned PdfPageCollection::traversePageTreeNode(PdfObject& obj, unsigned count,
                 if (child == nullptr)
                     continue;
 
-                count = traversePageTreeNode(*child, count, parents, visitedNodes);
+                count = traversePageTreeNode(*child, count, pages, loadedPages, parents, visitedNodes);
                 if (count == 0)
                     break;
             }
@@ -360,10 +678,21 @@ unsigned PdfPageCollection::traversePageTreeNode(PdfObject& obj, unsigned count,
         }
         case PdfPageTreeNodeType::Page:
         {
-            unsigned index = (unsigned)m_Pages.size();
-            unique_ptr<PdfPage> page(new PdfPage(obj, vector<PdfObject*>(parents)));
-            m_Pages.push_back(page.get());
-            (*page.release()).SetIndex(index);
+            unsigned index = (unsigned)pages.size();
+            PdfPage* page;
+            auto found = loadedPages.find(&obj);
+            if (found == loadedPages.end())
+            {
+                page = new PdfPage(obj, vector<PdfObject*>(parents));
+            }
+            else
+            {
+                page = found->second;
+                loadedPages.erase(found);
+            }
+
+            pages.push_back(page);
+            page->SetIndex(index);
             return count - 1;
         }
         case PdfPageTreeNodeType::Unknown:
@@ -377,10 +706,7 @@ unsigned PdfPageCollection::traversePageTreeNode(PdfObject& obj, unsigned count,
 
 void PdfPageCollection::FlattenStructure()
 {
-    if (m_kidsArray != nullptr)
-        return;
-
-    initPages();
+    flattenPages();
 
     // Flatten the document page structure by recreating a single /Pages
     // node and insert all pages there. This is allowed by PDF
@@ -389,17 +715,234 @@ void PdfPageCollection::FlattenStructure()
     // structure of the page tree"
     auto& kidsObj = GetDocument().GetObjects().CreateArrayObject();
     GetDictionary().AddKeyIndirect("Kids"_n, kidsObj);
-    m_kidsArray = &kidsObj.GetArray();
-    m_kidsArray->reserve(m_Pages.size());
+    auto& kidsArr = kidsObj.GetArray();
+    kidsArr.reserve(m_Pages.size());
     for (unsigned i = 0; i < m_Pages.size(); i++)
     {
         auto page = m_Pages[i];
-        page->FlattenStructure();
 
         // Fix pages parent and add them to /Kids
         page->GetDictionary().AddKey("Parent"_n, GetObject().GetIndirectReference());
-        (*m_kidsArray).AddIndirect(page->GetObject());
+        kidsArr.AddIndirect(page->GetObject());
+    }
+
+    GetDictionary().AddKey("Count"_n, static_cast<int64_t>(m_Pages.size()));
+    m_checkedNodes.clear();
+    m_consistent = true;
+}
+
+void PdfPageCollection::RebalancePageTree()
+{
+    flattenPages();
+    buildTree();
+}
+
+void PdfPageCollection::SelectPages(cspan<unsigned> pageIndices)
+{
+    initPages();
+    for (auto index : pageIndices)
+    {
+        if (index >= m_Pages.size())
+            PODOFO_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "Page with index {} not found", index);
+    }
+
+    // Load only the selected pages, that don't
+    // inherit anymore from the current tree nodes
+    vector<PdfPage*> pages(pageIndices.size());
+    unordered_set<PdfPage*> selected;
+    for (unsigned i = 0; i < pageIndices.size(); i++)
+    {
+        auto& page = getPageAt(pageIndices[i]);
+        page.FlattenStructure();
+        if (selected.insert(&page).second)
+            pages[i] = &page;
+        else
+            pages[i] = new PdfPage(clonePage(page.GetObject()));
+    }
+
+    // Collect the current intermediate nodes, that are emptied after the
+    // new tree is built, so the pages not selected can't be reached from
+    // the pages still referenced elsewhere, e.g. by outlines
+    unordered_set<PdfObject*> nodes;
+    vector<PdfObject*> pending = { &GetObject() };
+    while (pending.size() != 0)
+    {
+        auto node = pending.back();
+        pending.pop_back();
+        auto& kids = getKids(*node);
+        for (unsigned i = 0; i < kids.GetSize(); i++)
+        {
+            auto kid = kids.FindAt(i);
+            if (kid != nullptr && getPageTreeNodeType(*kid) == PdfPageTreeNodeType::Node
+                && nodes.insert(kid).second)
+            {
+                pending.push_back(kid);
+            }
+        }
+    }
+
+    for (auto page : m_Pages)
+    {
+        if (page != nullptr && selected.find(page) == selected.end())
+            delete page;
+    }
+
+    m_Pages = std::move(pages);
+    for (unsigned i = 0; i < m_Pages.size(); i++)
+        m_Pages[i]->SetIndex(i);
+
+    m_pageIndices.clear();
+    m_loaded = true;
+    buildTree();
+
+    for (auto node : nodes)
+    {
+        getKids(*node).Clear();
+        node->GetDictionary().AddKey("Count"_n, static_cast<int64_t>(0));
+    }
+
+    // The /OpenAction entry may refer to a removed page, see RemovePageAt()
+    GetDocument().GetCatalog().GetDictionary().RemoveKey("OpenAction");
+}
+
+void PdfPageCollection::buildTree()
+{
+    // Build the tree bottom up, grouping the kids of each
+    // level evenly in the least number of nodes
+    vector<PdfObject*> kids(m_Pages.size());
+    vector<unsigned> counts(m_Pages.size(), 1);
+    for (unsigned i = 0; i < m_Pages.size(); i++)
+        kids[i] = &m_Pages[i]->GetObject();
+
+    auto& objects = GetDocument().GetObjects();
+    while (kids.size() > MaxPageTreeKids)
+    {
+        unsigned kidCount = (unsigned)kids.size();
+        unsigned nodeCount = (kidCount + MaxPageTreeKids - 1) / MaxPageTreeKids;
+        vector<PdfObject*> nodes(nodeCount);
+        vector<unsigned> nodeCounts(nodeCount);
+        unsigned offset = 0;
+        for (unsigned i = 0; i < nodeCount; i++)
+        {
+            auto& node = objects.CreateDictionaryObject("Pages"_n);
+            auto& nodeKids = node.GetDictionary().AddKey("Kids"_n, PdfArray()).GetArray();
+            unsigned size = kidCount / nodeCount + (i < kidCount % nodeCount ? 1 : 0);
+            unsigned count = 0;
+            nodeKids.reserve(size);
+            for (unsigned j = offset; j < offset + size; j++)
+            {
+                kids[j]->GetDictionary().AddKey("Parent"_n, node.GetIndirectReference());
+                nodeKids.AddIndirect(*kids[j]);
+                count += counts[j];
+            }
+
+            node.GetDictionary().AddKey("Count"_n, static_cast<int64_t>(count));
+            nodes[i] = &node;
+            nodeCounts[i] = count;
+            offset += size;
+        }
+
+        kids = std::move(nodes);
+        counts = std::move(nodeCounts);
     }
+
+    auto& rootKids = GetDictionary().AddKey("Kids"_n, PdfArray()).GetArray();
+    rootKids.reserve(kids.size());
+    for (auto kid : kids)
+    {
+        kid->GetDictionary().AddKey("Parent"_n, GetObject().GetIndirectReference());
+        rootKids.AddIndirect(*kid);
+    }
+
+    GetDictionary().AddKey("Count"_n, static_cast<int64_t>(m_Pages.size()));
+    m_checkedNodes.clear();
+    m_consistent = true;
+}
+
+void PdfPageCollection::initTree()
+{
+    // NOTE: A loaded tree is modified in place, checking
+    // the nodes of the modified paths when they are found
+    initPages();
+}
+
+void PdfPageCollection::checkTreePath(unsigned index)
+{
+    if (m_consistent)
+        return;
+
+    vector<PageTreePathNode> path;
+    findPagePath(GetObject(), index, path);
+
+    // The /Count entries of a loaded tree must be consistent along the
+    // path, or the pages would be inserted or removed at the wrong place.
+    // Missing kids, that are counted as flushed pages, are not allowed
+    for (auto& pathNode : path)
+    {
+        auto& kids = getKids(*pathNode.Node);
+        bool consistent = checkNodeCount(*pathNode.Node);
+        for (unsigned i = 0; consistent && i < kids.GetSize(); i++)
+        {
+            auto kid = kids.FindAt(i);
+            consistent = kid != nullptr && kid->IsDictionary();
+        }
+
+        if (!consistent)
+        {
+            // Rebuild the inconsistent tree from scratch
+            RebalancePageTree();
+            return;
+        }
+    }
+}
+
+void PdfPageCollection::flattenPages()
+{
+    loadPages();
+    for (unsigned i = 0; i < m_Pages.size(); i++)
+    {
+        auto page = m_Pages[i];
+        if (page == nullptr)
+            PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "The page tree can't be rebuilt after pages were flushed");
+
+        page->FlattenStructure();
+    }
+}
+
+void PdfPageCollection::insertTreePages(unsigned atIndex, cspan<PdfPage*> pages)
+{
+    vector<PageTreePathNode> path;
+    findPagePath(GetObject(), atIndex, path);
+    isolatePages(path, pages);
+    auto& leaf = *path.back().Node;
+    auto& kids = getKids(leaf);
+    unsigned position = path.back().Position;
+    bool append = position == kids.GetSize();
+
+    // Update the actual /Kids array and set /Parent to the new pages
+    vector<PdfObject> pageObjects;
+    pageObjects.reserve(pages.size());
+    for (unsigned i = 0; i < pages.size(); i++)
+    {
+        pageObjects.push_back(pages[i]->GetObject().GetIndirectReference());
+        pages[i]->GetDictionary().AddKey("Parent"_n, leaf.GetIndirectReference());
+    }
+
+    kids.insert(kids.begin() + position, pageObjects.begin(), pageObjects.end());
+    updateCounts(path, (int)pages.size());
+    splitNode(path, (unsigned)path.size() - 1, append);
+}
+
+void PdfPageCollection::removeTreePage(unsigned atIndex)
+{
+    vector<PageTreePathNode> path;
+    findPagePath(GetObject(), atIndex, path);
+    getKids(*path.back().Node).RemoveAt(path.back().Position);
+    updateCounts(path, -1);
+
+    // Remove the nodes left empty, except the root
+    for (unsigned i = (unsigned)path.size() - 1; i > 0 && getKids(*path[i].Node).GetSize() == 0; i--)
+        getKids(*path[i - 1].Node).RemoveAt(path[i - 1].Position);
 }
 
 PdfPageTreeNodeType getPageTreeNodeType(const PdfObject& obj)
@@ -425,3 +968,297 @@ unsigned getChildCount(const PdfObject& nodeObj)
 
     return (unsigned)num;
 }
+
+unsigned getKidCount(const PdfObject* kidObj)
+{
+    // NOTE: Missing kids are flushed pages
+    if (kidObj == nullptr || getPageTreeNodeType(*kidObj) != PdfPageTreeNodeType::Node)
+        return 1;
+
+    return getChildCount(*kidObj);
+}
+
+PdfArray& getKids(PdfObject& nodeObj)
+{
+    PdfArray* kidsArr;
+    if (!nodeObj.GetDictionary().TryFindKeyAs("Kids", kidsArr))
+        kidsArr = &nodeObj.GetDictionary().AddKey("Kids"_n, PdfArray()).GetArray();
+
+    return *kidsArr;
+}
+
+PdfObject& createNode(PdfObject& parent)
+{
+    auto& node = parent.MustGetDocument().GetObjects().CreateDictionaryObject("Pages"_n);
+    node.GetDictionary().AddKey("Kids"_n, PdfArray());
+    node.GetDictionary().AddKey("Count"_n, static_cast<int64_t>(0));
+    node.GetDictionary().AddKey("Parent"_n, parent.GetIndirectReference());
+    return node;
+}
+
+// Give the pages inserted in the node at the end of the path their
+// own value of the attributes that they would inherit from the nodes.
+// The pages have no parents, so they aren't inheriting anything yet
+void isolatePages(const vector<PageTreePathNode>& path, cspan<PdfPage*> pages)
+{
+    for (auto& key : InheritableAttributes)
+    {
+        bool inherited = false;
+        for (auto& pathNode : path)
+        {
+            if (pathNode.Node->GetDictionary().HasKey(key))
+            {
+                inherited = true;
+                break;
+            }
+        }
+
+        if (!inherited)
+            continue;
+
+        for (auto page : pages)
+        {
+            auto& dict = page->GetDictionary();
+            if (dict.HasKey(key))
+                continue;
+
+            if (key == "Resources")
+            {
+                dict.AddKey(key, PdfDictionary());
+            }
+            else if (key == "CropBox")
+            {
+                // The crop box defaults to the media box
+                auto mediaBox = dict.GetKey("MediaBox");
+                if (mediaBox != nullptr)
+                    dict.AddKey(key, *mediaBox);
+            }
+            else if (key == "Rotate")
+            {
+                dict.AddKey(key, static_cast<int64_t>(0));
+            }
+
+            // NOTE: A page without /MediaBox is
+            // invalid, so it's left inheriting it
+        }
+    }
+}
+
+// Move all the kids of the root in a new
+// node, that becomes the only kid of the root
+PdfObject& pushDownRoot(PdfObject& root)
+{
+    auto& node = createNode(root);
+    auto& rootKids = getKids(root);
+    auto& nodeKids = getKids(node);
+    nodeKids.reserve(rootKids.GetSize());
+    for (unsigned i = 0; i < rootKids.GetSize(); i++)
+    {
+        auto& kid = rootKids.MustFindAt(i);
+        kid.GetDictionary().AddKey("Parent"_n, node.GetIndirectReference());
+        nodeKids.AddIndirect(kid);
+    }
+
+    node.GetDictionary().AddKey("Count"_n, static_cast<int64_t>(getChildCount(root)));
+    rootKids.Clear();
+    rootKids.AddIndirect(node);
+    return node;
+}
+
+// Find the path to the page with the given index, descending
+// the tree with the /Count of the nodes. The position in the
+// last node is the position of the page, or the number of
+// kids if the index is the page count
+void findPagePath(PdfObject& root, unsigned index, vector<PageTreePathNode>& path)
+{
+    path.clear();
+    auto node = &root;
+    unsigned remaining = index;
+    while (true)
+    {
+        auto& kids = getKids(*node);
+        unsigned size = kids.GetSize();
+        PdfObject* next = nullptr;
+        unsigned i = 0;
+        for (; i < size; i++)
+        {
+            auto kid = kids.FindAt(i);
+            if (kid == nullptr || getPageTreeNodeType(*kid) != PdfPageTreeNodeType::Node)
+            {
+                if (remaining == 0)
+                    break;
+
+                remaining--;
+                continue;
+            }
+
+            // Descend also in the last node when
+            // appending, so the leaves stay at the same depth
+            unsigned count = getChildCount(*kid);
+            if (remaining < count || (remaining == count && i == size - 1))
+            {
+                next = kid;
+                break;
+            }
+
+            remaining -= count;
+        }
+
+        path.push_back({ node, i });
+        if (next == nullptr)
+            return;
+
+        node = next;
+    }
+}
+
+void updateCounts(const vector<PageTreePathNode>& path, int delta)
+{
+    for (auto& pathNode : path)
+    {
+        pathNode.Node->GetDictionary().AddKey("Count"_n,
+            static_cast<int64_t>(getChildCount(*pathNode.Node)) + delta);
+    }
+}
+
+// Split the node at the given level of the path, if it exceeds
+// the maximum number of kids, moving the exceeding kids in new
+// sibling nodes, and then split the parent node if needed
+void splitNode(vector<PageTreePathNode>& path, unsigned level, bool append)
+{
+    auto node = path[level].Node;
+    if (getKids(*node).GetSize() <= MaxPageTreeKids)
+        return;
+
+    if (level == 0)
+    {
+        // The root must stay the same object, so it gets a new
+        // child with all its kids, that is split instead
+        auto& child = pushDownRoot(*node);
+        path.insert(path.begin() + 1, { &child, path[0].Position });
+        path[0].Position = 0;
+        node = &child;
+        level = 1;
+    }
+
+    auto& kids = getKids(*node);
+    unsigned size = kids.GetSize();
+
+    // Flushed pages were already written with
+    // their /Parent, so they can't be moved
+    unsigned fixedCount = 0;
+    for (unsigned i = size; i > 0; i--)
+    {
+        if (kids.FindAt(i - 1) == nullptr)
+        {
+            fixedCount = i;
+            break;
+        }
+    }
+
+    // When appending, keep the node full, so a tree built
+    // by appending pages has no partially filled nodes
+    unsigned nodeCount = (size + MaxPageTreeKids - 1) / MaxPageTreeKids;
+    unsigned keptCount = append ? MaxPageTreeKids : (size + nodeCount - 1) / nodeCount;
+    keptCount = std::max(keptCount, fixedCount);
+    if (keptCount >= size)
+        return;
+
+    auto& parent = *path[level - 1].Node;
+    auto& parentKids = getKids(parent);
+    unsigned position = path[level - 1].Position;
+    bool isLastKid = position == parentKids.GetSize() - 1;
+
+    // Distribute the exceeding kids evenly in the new siblings
+    unsigned movedCount = size - keptCount;
+    unsigned siblingCount = (movedCount + MaxPageTreeKids - 1) / MaxPageTreeKids;
+    unsigned offset = keptCount;
+    unsigned movedPageCount = 0;
+    for (unsigned i = 0; i < siblingCount; i++)
+    {
+        // The moved kids must inherit the same attributes
+        auto& sibling = createNode(parent);
+        for (auto& key : InheritableAttributes)
+        {
+            auto value = node->GetDictionary().GetKey(key);
+            if (value != nullptr)
+                sibling.GetDictionary().AddKey(key, *value);
+        }
+
+        auto& siblingKids = getKids(sibling);
+        unsigned siblingSize = movedCount / siblingCount + (i < movedCount % siblingCount ? 1 : 0);
+        unsigned count = 0;
+        siblingKids.reserve(siblingSize);
+        for (unsigned j = offset; j < offset + siblingSize; j++)
+        {
+            auto& kid = kids.MustFindAt(j);
+            kid.GetDictionary().AddKey("Parent"_n, sibling.GetIndirectReference());
+            siblingKids.AddIndirect(kid);
+            count += getKidCount(&kid);
+        }
+
+        sibling.GetDictionary().AddKey("Count"_n, static_cast<int64_t>(count));
+        parentKids.insert(parentKids.begin() + position + 1 + i, sibling.GetIndirectReference());
+        offset += siblingSize;
+        movedPageCount += count;
+    }
+
+    kids.erase(kids.begin() + keptCount, kids.end());
+    node->GetDictionary().AddKey("Count"_n,
+        static_cast<int64_t>(getChildCount(*node) - movedPageCount));
+    splitNode(path, level - 1, append && isLastKid);
+}
+
+// Create a shallow copy of a page, sharing its contents and resources.
+// The annotations are copied too, since they refer to their page, but
+// not the widgets, that belong to the fields of the form
+PdfObject& clonePage(const PdfObject& pageObj)
+{
+    auto& objects = pageObj.MustGetDocument().GetObjects();
+    auto& clone = objects.CreateObject(pageObj);
+    const PdfArray* annots;
+    if (!pageObj.GetDictionary().TryFindKeyAs("Annots", annots))
+        return clone;
+
+    // NOTE: Direct annotations have no reference, so
+    // the copies are mapped by the copied object
+    unordered_map<const PdfObject*, PdfReference> clonedAnnots;
+    vector<PdfObject*> annotClones;
+    PdfArray cloneAnnots;
+    for (unsigned i = 0; i < annots->GetSize(); i++)
+    {
+        auto annot = annots->FindAt(i);
+        const PdfName* subtype;
+        if (annot == nullptr || !annot->IsDictionary()
+            || (annot->GetDictionary().TryFindKeyAs("Subtype", subtype) && *subtype == "Widget"))
+        {
+            continue;
+        }
+
+        auto& annotClone = objects.CreateObject(*annot);
+        annotClone.GetDictionary().AddKey("P"_n, clone.GetIndirectReference());
+        clonedAnnots[annot] = annotClone.GetIndirectReference();
+        cloneAnnots.Add(annotClone.GetIndirectReference());
+        annotClones.push_back(&annotClone);
+    }
+
+    // Link the copied popups with their copied parents
+    static const PdfName linkKeys[] = { "Popup"_n, "Parent"_n };
+    for (auto annotClone : annotClones)
+    {
+        auto& dict = annotClone->GetDictionary();
+        for (auto& key : linkKeys)
+        {
+            auto obj = dict.GetKey(key);
+            if (obj == nullptr || !obj->IsReference())
+                continue;
+
+            auto found = clonedAnnots.find(objects.GetObject(obj->GetReference()));
+            if (found != clonedAnnots.end())
+                dict.AddKey(key, found->second);
+        }
+    }
+
+    clone.GetDictionary().AddKey("Annots"_n, cloneAnnots);
+    return clone;
+}
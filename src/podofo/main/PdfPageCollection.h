@@ -18,11 +18,28 @@ namespace PoDoFo {
 /** Class for managing the tree of Pages in a PDF document
  *  Don't use this class directly. Use PdfDocument instead.
  *
+ *  The pages of a loaded document are instantiated lazily: a page
+ *  requested by index is found descending the tree with the /Count
+ *  of the intermediate nodes, and a page requested by reference
+ *  ascending the tree with its /Parent entries. The whole tree is
+ *  traversed only when iterating the pages or when modifying the
+ *  tree, or as a fallback when the /Count entries are inconsistent
+ *
+ *  When the pages are inserted or removed, the tree is kept balanced,
+ *  like a B-tree: the intermediate nodes have a bounded number of kids
+ *  and only the /Count entries of the nodes on the path to the
+ *  modified page are updated. A loaded tree is modified in place too,
+ *  splitting only the nodes that exceed the maximum number of kids:
+ *  it's rebuilt balanced only by RebalancePageTree(), or when the
+ *  /Count entries on the path to the modified page are inconsistent
+ *
  *  \see PdfDocument
  */
 class PODOFO_API PdfPageCollection final : public PdfDictionaryElement
 {
     friend class PdfDocument;
+    friend class PdfStreamedDocument;
+    friend class PdfMemDocument;
     friend class PdfPage;
 
 public:
@@ -50,6 +67,9 @@ public:
      *
      *  \param index page index, 0-based
      *  \returns a pointer to the requested page
+     *  \remarks Pages flushed with PdfStreamedDocument::FlushPage()
+     *      are not available anymore, and they are null when
+     *      iterating the collection
      */
     PdfPage& GetPageAt(unsigned index);
     const PdfPage& GetPageAt(unsigned index) const;
@@ -131,9 +151,24 @@ public:
      *
      * This copy pages inheritable attributes and remove intermediate /Pages nodes.
      * This operation is allowed by the PDF specification, see "ISO 32000-2:2020, 7.7.3.2 Page tree nodes"
+     * \remarks The root node is split by the next insertion,
+     *     if it has too many kids
      */
     void FlattenStructure();
 
+    /** Rebuild the page tree as a balanced tree
+     *
+     * This copy pages inheritable attributes and recreates the
+     * intermediate /Pages nodes, filled evenly with a bounded number
+     * of kids. Inserting and removing pages keeps the tree balanced,
+     * but removing many pages may leave it sparse, and a loaded tree
+     * is kept as it is: this can be called before saving the document
+     * to make it compact again. All the pages are loaded
+     * \remarks It can't be used after pages have been flushed
+     *     with PdfStreamedDocument::FlushPage()
+     */
+    void RebalancePageTree();
+
 public:
     template <typename TObject, typename TListIterator>
     class Iterator final
@@ -209,16 +244,87 @@ private:
 
     bool TryMovePageTo(unsigned atIndex, unsigned toIndex);
 
+    /** Delete the PdfPage of a page whose objects were flushed
+     * \remarks Can be used by PdfStreamedDocument
+     */
+    void DetachFlushedPage(PdfPage& page);
+
+    /** Replace the pages with the pages at the given indices, in the given
+     * order, rebuilding the tree with the existing page objects. A page
+     * selected more than once is copied
+     * \remarks Can be used by PdfMemDocument
+     */
+    void SelectPages(cspan<unsigned> pageIndices);
+
 private:
     void insertPageAt(unsigned atIndex, PdfPage& page);
     void insertPagesAt(unsigned atIndex, cspan<PdfPage*> pages);
     Rect getActualRect(const nullable<Rect>& size);
 
-    PdfPage& getPage(const PdfReference& ref) const;
+    PdfPage& getPageAt(unsigned index);
+    PdfPage& getPage(const PdfReference& ref);
+
+    /** Size the page list before modifying the tree
+     */
+    void initTree();
+
+    /** Check the nodes on the path to the page with the given index,
+     *  before modifying a loaded tree there. An inconsistent tree is
+     *  rebuilt balanced
+     */
+    void checkTreePath(unsigned index);
+
+    /** Load all the pages and move the attributes
+     *  inherited from the tree nodes to them
+     */
+    void flattenPages();
+
+    /** Build a balanced tree with the current pages,
+     *  replacing the kids of the root
+     */
+    void buildTree();
+
+    /** Insert the page objects in the tree at the given index,
+     *  splitting the nodes that exceed the maximum number of kids
+     */
+    void insertTreePages(unsigned atIndex, cspan<PdfPage*> pages);
+
+    /** Remove the page object at the given index from
+     *  the tree, removing the nodes left empty
+     */
+    void removeTreePage(unsigned atIndex);
 
+    /** Size the page list with the /Count of the root node,
+     *  without instantiating the pages
+     */
     void initPages();
 
-    unsigned traversePageTreeNode(PdfObject& obj, unsigned count,
+    /** Instantiate all the pages, with a traversal of the whole tree.
+     *  Pages already handed out stay valid, also if the traversal
+     *  doesn't find them anymore
+     */
+    void loadPages();
+
+    /** Instantiate the page with the given index, descending
+     *  the tree with the /Count of the intermediate nodes. The
+     *  nodes traversed and the sibling nodes skipped are checked
+     *  against the counts of their kids
+     *  \returns the page, or nullptr if the tree is inconsistent
+     */
+    PdfPage* tryLoadPage(unsigned index);
+
+    /** Check the /Count of the node against the counts of its
+     *  kids. Nodes are checked only once
+     */
+    bool checkNodeCount(const PdfObject& nodeObj);
+
+    /** Compute the index of the given page object, ascending the
+     *  tree with the /Parent entries
+     */
+    bool tryGetPageIndex(const PdfObject& pageObj, unsigned& index);
+
+    unsigned traversePageTreeNode(PdfObject& obj, unsigned count, PageList& pages,
+        std::unordered_map<PdfObject*, PdfPage*>& loadedPages,
         std::vector<PdfObject*>& parents, std::unordered_set<PdfObject*>& visitedNodes);
 
     PdfPageCollection(PdfPageCollection&) = delete;
@@ -226,8 +332,22 @@ private:
 
 private:
     bool m_initialized;
+    bool m_loaded;
+    // Pages not yet loaded, or flushed pages of
+    // a PdfStreamedDocument, when loaded, are null
     PageList m_Pages;
-    PdfArray* m_kidsArray;
+    // Indices of the pages by reference. It's cleared
+    // when the tree is modified and rebuilt on lookup
+    std::unordered_map<PdfReference, unsigned> m_pageIndices;
+    // Nodes with a /Count consistent with their kids
+    std::unordered_set<const PdfObject*> m_checkedNodes;
+    // Pages handed out before loading all the pages
+    // that the traversal of the tree didn't find
+    PageList m_unreachablePages;
+    // The /Count entries of a tree built from
+    // scratch are consistent, and are not checked
+    bool m_consistent;
+    nullable<Rect> m_flushedPageRect;
 };
 
 };
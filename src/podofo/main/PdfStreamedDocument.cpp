@@ -6,6 +6,9 @@
 
 #include <podofo/private/PdfDeclarationsPrivate.h>
 #include "PdfStreamedDocument.h"
+
+#include <algorithm>
+
 #include <podofo/auxiliary/StreamDevice.h>
 #include <podofo/private/PdfImmediateWriter.h>
 
@@ -30,7 +33,86 @@ PdfStreamedDocument::PdfStreamedDocument(const string_view& filename, PdfVersion
 
 PdfStreamedDocument::~PdfStreamedDocument()
 {
+    if (m_Writer->IsFinished())
+        return;
+
+    try
+    {
+        Close();
+    }
+    catch (PdfError& e)
+    {
+        PoDoFo::LogMessage(PdfLogSeverity::Error, "Closing the document failed: {}", e.what());
+    }
+}
+
+void PdfStreamedDocument::Close()
+{
+    if (m_Writer->IsFinished())
+        return;
+
     GetFonts().EmbedFonts();
+    m_Writer->Finish();
+}
+
+void PdfStreamedDocument::FlushPage(PdfPage& page)
+{
+    if (&page.GetDocument() != this)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "The page doesn't belong to this document");
+
+    // Collect the objects owned by the page: content
+    // streams and annotations, except form widgets
+    vector<PdfObject*> objects;
+    objects.push_back(&page.GetObject());
+    auto& dict = page.GetDictionary();
+
+    PdfObject* contents = collectObject(dict.GetKey("Contents"), objects);
+    PdfArray* arr;
+    if (contents != nullptr && contents->TryGetArray(arr))
+    {
+        for (auto& obj : *arr)
+            (void)collectObject(&obj, objects);
+    }
+
+    PdfObject* annots = collectObject(dict.GetKey("Annots"), objects);
+    if (annots != nullptr && annots->TryGetArray(arr))
+    {
+        PdfReference ref;
+        PdfObject* annot;
+        PdfDictionary* annotDict;
+        const PdfName* subtype;
+        for (auto& obj : *arr)
+        {
+            if (!obj.TryGetReference(ref) || (annot = GetObjects().GetObject(ref)) == nullptr
+                || !annot->TryGetDictionary(annotDict)
+                || (annotDict->TryFindKeyAs("Subtype", subtype) && *subtype == "Widget"))
+            {
+                continue;
+            }
+
+            objects.push_back(annot);
+        }
+    }
+
+    // Objects may be referenced more than once
+    std::sort(objects.begin(), objects.end());
+    objects.erase(std::unique(objects.begin(), objects.end()), objects.end());
+
+    GetPages().DetachFlushedPage(page);
+    m_Writer->FlushObjects(objects);
+}
+
+PdfObject* PdfStreamedDocument::collectObject(PdfObject* obj, vector<PdfObject*>& objects)
+{
+    PdfReference ref;
+    if (obj == nullptr || !obj->TryGetReference(ref))
+        return obj;
+
+    auto indirectObj = GetObjects().GetObject(ref);
+    if (indirectObj != nullptr)
+        objects.push_back(indirectObj);
+
+    return indirectObj;
 }
 
 void PdfStreamedDocument::init(PdfVersion version, PdfSaveOptions opts)
@@ -45,6 +45,7 @@ class PdfImmediateWriter;
  *  painter.TextState.SetFont(*font, 18);
  *  painter.DrawText("Hello World!", 56.69, page.GetRect().Height - 56.69);
  *  painter.FinishDrawing();
+ *  document.FlushPage(page);
  */
 class PODOFO_API PdfStreamedDocument final : public PdfDocument
 {
@@ -85,6 +86,33 @@ public:
     ~PdfStreamedDocument();
 
 public:
+    /** Write the objects of a completed page to the output device
+     *  and free them, so the memory used by the document doesn't
+     *  grow with the number of pages
+     *
+     *  The page dictionary, its content streams and its annotations,
+     *  except widget annotations of form fields, are flushed. Fonts,
+     *  images, XObjects and the other resources are indirect objects
+     *  that may be shared with other pages, and they are kept
+     *  until the document is finished. The page tree is also written
+     *  at the end, using the already assigned references
+     *
+     *  The page must not be modified after calling this method, and
+     *  its PdfPage instance is deleted: it can't be retrieved anymore
+     *  with PdfPageCollection::GetPageAt()
+     *  \param page a page of this document
+     */
+    void FlushPage(PdfPage& page);
+
+    /** Finish the document, writing the fonts, the remaining objects
+     *  and the cross-reference section to the output device
+     *
+     *  The document must not be modified after calling this method.
+     *  If not called, the document is finished on destruction, where
+     *  write errors can't be reported to the caller
+     */
+    void Close();
+
     const PdfEncrypt* GetEncrypt() const override;
 
 protected:
@@ -105,6 +133,8 @@ private:
      */
     void init(PdfVersion version, PdfSaveOptions opts);
 
+    PdfObject* collectObject(PdfObject* obj, std::vector<PdfObject*>& objects);
+
 private:
     std::shared_ptr<OutputStreamDevice> m_Device;
     std::unique_ptr<PdfImmediateWriter> m_Writer;
@@ -194,7 +194,12 @@ void PdfString::Write(OutputStream& device, PdfWriteFlags writeFlags,
     const PdfStatefulEncrypt* encrypt, charbuff& buffer) const
 {
     (void)buffer; // TODO: Just use the supplied buffer instead of the many ones below
+    write(device, writeFlags, encrypt, m_isHex);
+}
 
+void PdfString::write(OutputStream& device, PdfWriteFlags writeFlags,
+    const PdfStatefulEncrypt* encrypt, bool hex) const
+{
     // Strings in PDF documents may contain \0 especially if they are encrypted
     // this case has to be handled!
 
@@ -256,7 +261,7 @@ void PdfString::Write(OutputStream& device, PdfWriteFlags writeFlags,
         view = string_view(tempBuffer.data(), tempBuffer.size());
     }
 
-    utls::SerializeEncodedString(device, view, m_isHex,
+    utls::SerializeEncodedString(device, view, hex,
         (writeFlags & PdfWriteFlags::SkipDelimiters) != PdfWriteFlags::None);
 }
 
@@ -22,6 +22,8 @@ namespace PoDoFo {
  */
 class PODOFO_API PdfString final : private PdfDataMember, public PdfDataProvider<PdfString>
 {
+    PODOFO_PRIVATE_FRIEND(class PdfLinearizer);
+
 public:
     /** Create an empty string
      */
@@ -157,6 +159,10 @@ private:
     // Delete constructor with nullptr
     PdfString(std::nullptr_t) = delete;
 
+    // To be called by PdfLinearizer
+    void write(OutputStream& stream, PdfWriteFlags writeMode,
+        const PdfStatefulEncrypt* encrypt, bool hex) const;
+
     /** Construct a new PdfString from a 0-terminated string.
      *
      *  The input string will be copied.
@@ -19,6 +19,62 @@
 using namespace std;
 using namespace PoDoFo;
 
+namespace
+{
+    /** Character reader that scans directly the contiguous
+     * data offered by the device with TryPeekBuffer(), if
+     * supported, falling back to per character calls otherwise.
+     * The consumed data must be committed with Commit() before
+     * accessing the device again
+     */
+    class DeviceCursor final
+    {
+    public:
+        DeviceCursor(InputStreamDevice& device);
+
+        bool Peek(char& ch)
+        {
+            if (m_curr == m_end && !tryRefill())
+                return m_device->Peek(ch);
+
+            ch = *m_curr;
+            return true;
+        }
+
+        /** Consume the last peeked character
+         */
+        void Skip()
+        {
+            if (m_curr == m_end)
+                (void)m_device->ReadChar();
+            else
+                m_curr++;
+        }
+
+        bool Read(char& ch)
+        {
+            if (!Peek(ch))
+                return false;
+
+            Skip();
+            return true;
+        }
+
+        void Commit();
+
+    private:
+        bool tryRefill();
+        void setWindow(const bufferview& view);
+
+    private:
+        InputStreamDevice* m_device;
+        const char* m_begin;
+        const char* m_curr;
+        const char* m_end;
+        bool m_Buffered;
+    };
+}
+
 static bool tryGetEscapedCharacter(char ch, char& escapedChar);
 static void readHexString(InputStreamDevice& device, charbuff& buffer);
 static bool isOctalChar(char ch);
@@ -70,19 +126,20 @@ bool PdfTokenizer::TryReadNextToken(InputStreamDevice& device, string_view& toke
 
     tokenType = PdfTokenType::Literal;
 
+    DeviceCursor cursor(device);
     char ch1;
     char ch2;
     size_t count = 0;
     while (count < bufferSize)
     {
-        if (!device.Peek(ch1))
+        if (!cursor.Peek(ch1))
             goto Eof;
 
         // ignore leading whitespaces
         if (count == 0 && IsCharWhitespace(ch1))
         {
             // Consume the whitespace character
-            (void)device.ReadChar();
+            cursor.Skip();
             continue;
         }
         // ignore comments
@@ -91,8 +148,8 @@ bool PdfTokenizer::TryReadNextToken(InputStreamDevice& device, string_view& toke
             // Consume all characters before the next line break
             do
             {
-                (void)device.ReadChar();
-                if (!device.Peek(ch1))
+                cursor.Skip();
+                if (!cursor.Peek(ch1))
                     goto Eof;
 
             } while (ch1 != '\n' && ch1 != '\r');
@@ -107,18 +164,18 @@ bool PdfTokenizer::TryReadNextToken(InputStreamDevice& device, string_view& toke
         else if (count == 0 && (ch1 == '<' || ch1 == '>'))
         {
             // Really consume character from stream
-            (void)device.ReadChar();
+            cursor.Skip();
             buffer[count] = ch1;
             count++;
 
-            if (!device.Peek(ch2))
+            if (!cursor.Peek(ch2))
                 goto Eof;
 
             // Is n another < or > , ie are we opening/closing a dictionary?
             // If so, consume that character too.
             if (ch2 == ch1)
             {
-                (void)device.ReadChar();
+                cursor.Skip();
                 buffer[count++] = ch2;
                 if ((int)m_options.LanguageLevel < 2)
                     continue;
@@ -147,7 +204,7 @@ bool PdfTokenizer::TryReadNextToken(InputStreamDevice& device, string_view& toke
         else
         {
             // Consume the next character and add it to the token we're building.
-            (void)device.ReadChar();
+            cursor.Skip();
             buffer[count] = ch1;
             count++;
 
@@ -164,6 +221,7 @@ bool PdfTokenizer::TryReadNextToken(InputStreamDevice& device, string_view& toke
     }
 
 Exit:
+    cursor.Commit();
     buffer[count] = '\0';
     token = string_view(buffer, count);
     return true;
@@ -171,6 +229,8 @@ Exit:
 Eof:
     if (count == 0)
     {
+        cursor.Commit();
+
         // No characters were read before EOF, so we're out of data.
         // Ensure the buffer points to nullptr in case someone fails to check the return value.
         token = { };
@@ -539,8 +599,9 @@ void PdfTokenizer::ReadString(InputStreamDevice& device, PdfVariant& variant, co
     char octValue = 0;
     int balanceCount = 0; // Balanced parenthesis do not have to be escaped in strings
 
+    DeviceCursor cursor(device);
     m_charBuffer.clear();
-    while (device.Read(ch))
+    while (cursor.Read(ch))
     {
         if (escape)
         {
@@ -623,6 +684,8 @@ void PdfTokenizer::ReadString(InputStreamDevice& device, PdfVariant& variant, co
         }
     }
 
+    cursor.Commit();
+
     // In case the string ends with a octal escape sequence
     if (octEscape)
         m_charBuffer.push_back(octValue);
@@ -731,25 +794,65 @@ bool tryGetEscapedCharacter(char ch, char& escapedChar)
 void readHexString(InputStreamDevice& device, charbuff& buffer)
 {
     buffer.clear();
+    DeviceCursor cursor(device);
     char ch;
-    while (device.Read(ch))
+    while (cursor.Read(ch))
     {
         // end of stream reached
         if (ch == '>')
             break;
 
         // only a hex digits
-        if (isdigit(ch) ||
+        if ((ch >= '0' && ch <= '9') ||
             (ch >= 'A' && ch <= 'F') ||
             (ch >= 'a' && ch <= 'f'))
             buffer.push_back(ch);
     }
 
+    cursor.Commit();
+
     // pad to an even length if necessary
     if (buffer.size() % 2)
         buffer.push_back('0');
 }
 
+DeviceCursor::DeviceCursor(InputStreamDevice& device)
+    : m_device(&device), m_begin(nullptr), m_curr(nullptr), m_end(nullptr)
+{
+    bufferview view;
+    m_Buffered = device.TryPeekBuffer(view);
+    if (m_Buffered)
+        setWindow(view);
+}
+
+void DeviceCursor::Commit()
+{
+    if (m_curr != m_begin)
+        m_device->Advance((size_t)(m_curr - m_begin));
+
+    // The view is not valid anymore after advancing the device
+    setWindow({ });
+}
+
+bool DeviceCursor::tryRefill()
+{
+    if (!m_Buffered)
+        return false;
+
+    Commit();
+    bufferview view;
+    (void)m_device->TryPeekBuffer(view);
+    setWindow(view);
+    return m_curr != m_end;
+}
+
+void DeviceCursor::setWindow(const bufferview& view)
+{
+    m_begin = view.data();
+    m_curr = m_begin;
+    m_end = m_begin + view.size();
+}
+
 bool isOctalChar(char ch)
 {
     switch (ch)
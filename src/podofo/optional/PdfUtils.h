@@ -11,54 +11,44 @@
 
 namespace PoDoFo
 {
-    inline bool IsCharWhitespace(char ch)
+    /** Lookup table of the character classes of the PDF syntax,
+     * ISO 32000-1:2008 7.2.2 "Character Set"
+     */
+    class PdfCharClassTable final
     {
-        switch (ch)
+    public:
+        static constexpr unsigned char Whitespace = 1;
+        static constexpr unsigned char Delimiter = 2;
+
+    public:
+        constexpr PdfCharClassTable() : m_classes{ }
         {
-            case '\0': // NULL
-                return true;
-            case '\t': // TAB
-                return true;
-            case '\n': // Line Feed
-                return true;
-            case '\f': // Form Feed
-                return true;
-            case '\r': // Carriage Return
-                return true;
-            case ' ': // White space
-                return true;
-            default:
-                return false;
+            for (char ch : { '\0', '\t', '\n', '\f', '\r', ' ' })
+                m_classes[(unsigned char)ch] = Whitespace;
+
+            for (char ch : { '(', ')', '<', '>', '[', ']', '{', '}', '/', '%' })
+                m_classes[(unsigned char)ch] = Delimiter;
+        }
+
+        constexpr unsigned char operator[](char ch) const
+        {
+            return m_classes[(unsigned char)ch];
         }
+
+    private:
+        unsigned char m_classes[256];
+    };
+
+    inline constexpr PdfCharClassTable PdfCharClasses;
+
+    inline bool IsCharWhitespace(char ch)
+    {
+        return PdfCharClasses[ch] == PdfCharClassTable::Whitespace;
     }
 
     inline bool IsCharDelimiter(char ch)
     {
-        switch (ch)
-        {
-            case '(':
-                return true;
-            case ')':
-                return true;
-            case '<':
-                return true;
-            case '>':
-                return true;
-            case '[':
-                return true;
-            case ']':
-                return true;
-            case '{':
-                return true;
-            case '}':
-                return true;
-            case '/':
-                return true;
-            case '%':
-                return true;
-            default:
-                return false;
-        }
+        return PdfCharClasses[ch] == PdfCharClassTable::Delimiter;
     }
 
     inline bool IsCharTokenDelimiter(char ch, PdfTokenType& tokenType)
@@ -96,7 +86,7 @@ namespace PoDoFo
      */
     inline bool IsCharRegular(char ch)
     {
-        return !(IsCharWhitespace(ch) || IsCharDelimiter(ch));
+        return PdfCharClasses[ch] == 0;
     }
 
     /** Check if the character is within the range of
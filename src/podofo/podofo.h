@@ -72,6 +72,7 @@
 #include "main/PdfContents.h"
 #include "main/PdfDestination.h"
 #include "main/PdfDocument.h"
+#include "main/PdfDocumentProbe.h"
 #include "main/PdfElement.h"
 #include "main/PdfExtGState.h"
 #include "main/PdfField.h"
@@ -0,0 +1,150 @@
+/**
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#ifndef PODOFO_MURMUR_HASH3_H
+#define PODOFO_MURMUR_HASH3_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace PoDoFo {
+
+struct Hash128
+{
+    uint64_t Low;
+    uint64_t High;
+    bool operator==(const Hash128& rhs) const { return Low == rhs.Low && High == rhs.High; }
+};
+
+struct Hash128Hasher
+{
+    size_t operator()(const Hash128& hash) const { return (size_t)(hash.Low ^ hash.High); }
+};
+
+// A streaming version of MurmurHash3 x64 128 bit,
+// that doesn't require to buffer all the input
+class MurmurHash3 final
+{
+public:
+    MurmurHash3() : m_h1(0), m_h2(0), m_tailLength(0), m_Length(0) { }
+
+    void Update(const void* data, size_t length)
+    {
+        auto bytes = (const unsigned char*)data;
+        m_Length += length;
+        if (m_tailLength != 0)
+        {
+            size_t count = std::min(length, (size_t)16 - m_tailLength);
+            std::memcpy(m_tail + m_tailLength, bytes, count);
+            m_tailLength += count;
+            bytes += count;
+            length -= count;
+            if (m_tailLength < 16)
+                return;
+
+            mixBlock(m_tail);
+            m_tailLength = 0;
+        }
+
+        for (; length >= 16; bytes += 16, length -= 16)
+            mixBlock(bytes);
+
+        std::memcpy(m_tail, bytes, length);
+        m_tailLength = length;
+    }
+
+    void Update(uint64_t value)
+    {
+        Update(&value, sizeof(value));
+    }
+
+    void Update(unsigned char tag)
+    {
+        Update(&tag, 1);
+    }
+
+    void Update(const std::string_view& str)
+    {
+        Update((uint64_t)str.length());
+        Update(str.data(), str.length());
+    }
+
+    void Update(const Hash128& hash)
+    {
+        Update(hash.Low);
+        Update(hash.High);
+    }
+
+    Hash128 Finish() const
+    {
+        uint64_t h1 = m_h1;
+        uint64_t h2 = m_h2;
+        if (m_tailLength != 0)
+        {
+            unsigned char block[16] = { };
+            std::memcpy(block, m_tail, m_tailLength);
+            uint64_t k1;
+            uint64_t k2;
+            std::memcpy(&k1, block, 8);
+            std::memcpy(&k2, block + 8, 8);
+            k2 *= C2; k2 = rotl(k2, 33); k2 *= C1; h2 ^= k2;
+            k1 *= C1; k1 = rotl(k1, 31); k1 *= C2; h1 ^= k1;
+        }
+
+        h1 ^= m_Length;
+        h2 ^= m_Length;
+        h1 += h2;
+        h2 += h1;
+        h1 = fmix(h1);
+        h2 = fmix(h2);
+        h1 += h2;
+        h2 += h1;
+        return { h1, h2 };
+    }
+
+private:
+    void mixBlock(const unsigned char* block)
+    {
+        uint64_t k1;
+        uint64_t k2;
+        std::memcpy(&k1, block, 8);
+        std::memcpy(&k2, block + 8, 8);
+
+        k1 *= C1; k1 = rotl(k1, 31); k1 *= C2; m_h1 ^= k1;
+        m_h1 = rotl(m_h1, 27); m_h1 += m_h2; m_h1 = m_h1 * 5 + 0x52dce729;
+        k2 *= C2; k2 = rotl(k2, 33); k2 *= C1; m_h2 ^= k2;
+        m_h2 = rotl(m_h2, 31); m_h2 += m_h1; m_h2 = m_h2 * 5 + 0x38495ab5;
+    }
+
+    static uint64_t rotl(uint64_t x, int r)
+    {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    static uint64_t fmix(uint64_t k)
+    {
+        k ^= k >> 33;
+        k *= 0xff51afd7ed558ccdULL;
+        k ^= k >> 33;
+        k *= 0xc4ceb3fe1a85ec53ULL;
+        k ^= k >> 33;
+        return k;
+    }
+
+private:
+    static constexpr uint64_t C1 = 0x87c37b91114253d5ULL;
+    static constexpr uint64_t C2 = 0x4cf5ad432745937fULL;
+
+    uint64_t m_h1;
+    uint64_t m_h2;
+    unsigned char m_tail[16];
+    size_t m_tailLength;
+    uint64_t m_Length;
+};
+
+}
+
+#endif // PODOFO_MURMUR_HASH3_H
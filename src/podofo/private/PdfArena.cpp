@@ -0,0 +1,74 @@
+/**
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#include "PdfDeclarationsPrivate.h"
+#include "PdfArena.h"
+
+using namespace std;
+using namespace PoDoFo;
+
+static constexpr size_t InitialArenaSize = 64 * 1024;
+
+static thread_local pmr::memory_resource* s_resource = nullptr;
+
+PdfArena::PdfArena() { }
+
+PdfArena::~PdfArena() { }
+
+void* PdfArena::Allocate(size_t size)
+{
+    if (s_resource == nullptr)
+        return ::operator new(size, align_val_t(HeapAlignment));
+
+    // Shift the memory off the heap alignment, so it's recognized
+    return (char*)s_resource->allocate(size + Alignment, HeapAlignment) + Alignment;
+}
+
+void PdfArena::Deallocate(void* ptr) noexcept
+{
+    // NOTE: Arena memory is released when the arena is destroyed
+    if (ptr != nullptr && !IsArenaMemory(ptr))
+        ::operator delete(ptr, align_val_t(HeapAlignment));
+}
+
+bool PdfArena::IsArenaMemory(const void* ptr)
+{
+    return reinterpret_cast<uintptr_t>(ptr) % HeapAlignment == Alignment;
+}
+
+pmr::monotonic_buffer_resource* PdfArena::acquireResource()
+{
+    lock_guard<mutex> lock(m_mutex);
+    if (m_availableResources.size() != 0)
+    {
+        auto ret = m_availableResources.back();
+        m_availableResources.pop_back();
+        return ret;
+    }
+
+    m_resources.push_back(std::make_unique<pmr::monotonic_buffer_resource>(InitialArenaSize));
+    return m_resources.back().get();
+}
+
+void PdfArena::releaseResource(pmr::monotonic_buffer_resource* resource)
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_availableResources.push_back(resource);
+}
+
+PdfArena::Scope::Scope(PdfArena* arena)
+    : m_arena(arena), m_resource(nullptr), m_prevResource(s_resource)
+{
+    if (arena != nullptr)
+        m_resource = arena->acquireResource();
+
+    s_resource = m_resource;
+}
+
+PdfArena::Scope::~Scope()
+{
+    s_resource = m_prevResource;
+    if (m_arena != nullptr)
+        m_arena->releaseResource(m_resource);
+}
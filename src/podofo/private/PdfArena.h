@@ -0,0 +1,133 @@
+/**
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#ifndef PDF_ARENA_H
+#define PDF_ARENA_H
+
+#include <podofo/main/PdfDeclarations.h>
+
+#include <mutex>
+#include <memory_resource>
+#include <cstddef>
+
+namespace PoDoFo {
+
+/** A monotonic memory arena for the object model of a document
+ *
+ * While a scope is active on a thread, the objects, dictionaries
+ * and arrays created on the thread are allocated from the arena.
+ * Deleting them runs the destructors but doesn't release the memory,
+ * which is released all at once when the arena is destroyed, saving
+ * the cost of the single frees.
+ * Arena memory is told from heap memory by the address alone, with
+ * no lookup: heap memory is aligned to HeapAlignment, while arena
+ * memory starts Alignment bytes past such a boundary
+ * \remarks The arena must outlive all the memory allocated from it
+ */
+class PdfArena final
+{
+public:
+    /** Alignment of the memory returned by Allocate()
+     */
+    static constexpr size_t Alignment = 8;
+
+    /** Alignment of the heap memory returned by Allocate()
+     */
+    static constexpr size_t HeapAlignment = 2 * Alignment;
+
+public:
+    PdfArena();
+
+    ~PdfArena();
+
+public:
+    /** Allocate memory from the arena active on the current
+     * thread, or from the heap if there's none
+     */
+    static void* Allocate(size_t size);
+
+    /** Deallocate memory returned by Allocate()
+     * \remarks Memory of an arena is released only by the arena itself
+     */
+    static void Deallocate(void* ptr) noexcept;
+
+    template <typename T, typename... TArgs>
+    static T* New(TArgs&&... args);
+
+    template <typename T>
+    static void Delete(T* obj) noexcept;
+
+    /** True if the memory was returned by Allocate() from an arena
+     */
+    static bool IsArenaMemory(const void* ptr);
+
+    /** Activate the arena on the current thread for the lifetime
+     * of the scope. A null arena activates the heap allocation
+     * \remarks Scopes of the same arena can be active on different
+     * threads at the same time
+     */
+    class Scope final
+    {
+    public:
+        Scope(PdfArena* arena);
+        ~Scope();
+
+    private:
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        PdfArena* m_arena;
+        std::pmr::monotonic_buffer_resource* m_resource;
+        std::pmr::memory_resource* m_prevResource;
+    };
+
+private:
+    std::pmr::monotonic_buffer_resource* acquireResource();
+    void releaseResource(std::pmr::monotonic_buffer_resource* resource);
+
+private:
+    PdfArena(const PdfArena&) = delete;
+    PdfArena& operator=(const PdfArena&) = delete;
+
+private:
+    using ResourceList = std::vector<std::unique_ptr<std::pmr::monotonic_buffer_resource>>;
+
+private:
+    std::mutex m_mutex;
+    // NOTE: Monotonic resources are not thread safe, so every
+    // thread with an active scope gets its own resource
+    ResourceList m_resources;
+    std::vector<std::pmr::monotonic_buffer_resource*> m_availableResources;
+};
+
+template <typename T, typename... TArgs>
+T* PdfArena::New(TArgs&&... args)
+{
+    static_assert(alignof(T) <= Alignment, "Unsupported alignment");
+    void* ptr = Allocate(sizeof(T));
+    try
+    {
+        return new(ptr)T(std::forward<TArgs>(args)...);
+    }
+    catch (...)
+    {
+        Deallocate(ptr);
+        throw;
+    }
+}
+
+template <typename T>
+void PdfArena::Delete(T* obj) noexcept
+{
+    if (obj == nullptr)
+        return;
+
+    obj->~T();
+    Deallocate(obj);
+}
+
+}
+
+#endif // PDF_ARENA_H
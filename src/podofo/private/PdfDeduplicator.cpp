@@ -0,0 +1,203 @@
+/**
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#include "PdfDeclarationsPrivate.h"
+#include "PdfDeduplicator.h"
+
+#include <limits>
+
+#include "PdfObjectHashing.h"
+
+using namespace std;
+using namespace PoDoFo;
+
+PdfDeduplicator::PdfDeduplicator(PdfIndirectObjectList& objects, bool aggressive)
+    : m_objects(&objects), m_aggressive(aggressive), m_ClassCount(0)
+{
+}
+
+unordered_map<PdfReference, PdfReference> PdfDeduplicator::FindDuplicates()
+{
+    hashObjects();
+
+    // Refine the classes until they are stable, then confirm them
+    // with a full comparison. A failed confirmation, which happens
+    // only on hash collisions, splits a class and requires more
+    // refinement of the classes of the referencing objects
+    do
+    {
+        while (refineClasses());
+    } while (confirmClasses());
+
+    // The first object of each class, which is the one with
+    // lowest object number, replaces the others
+    unordered_map<PdfReference, PdfReference> ret;
+    vector<uint32_t> representatives(m_ClassCount, numeric_limits<uint32_t>::max());
+    for (uint32_t i = 0; i < (uint32_t)m_infos.size(); i++)
+    {
+        auto& representative = representatives[m_classes[i]];
+        if (representative == numeric_limits<uint32_t>::max())
+            representative = i;
+        else
+            ret[m_infos[i].Object->GetIndirectReference()] = m_infos[representative].Object->GetIndirectReference();
+    }
+
+    return ret;
+}
+
+void PdfDeduplicator::hashObjects()
+{
+    for (auto obj : *m_objects)
+    {
+        m_indices[obj->GetIndirectReference()] = (uint32_t)m_infos.size();
+        m_infos.push_back({ obj, canMerge(*obj), { }, { } });
+    }
+
+    // The initial classes group the objects by their local hash.
+    // Objects that can't be merged have a class on their own
+    unordered_map<Hash128, uint32_t, Hash128Hasher> classes;
+    m_classes.resize(m_infos.size());
+    for (size_t i = 0; i < m_infos.size(); i++)
+    {
+        auto& info = m_infos[i];
+        MurmurHash3 hasher;
+        hashDirect(*info.Object, hasher, info.References);
+        if (info.Mergeable && info.Object->HasStream())
+            utls::HashStream(*info.Object, hasher);
+
+        info.LocalHash = hasher.Finish();
+        if (info.Mergeable)
+            m_classes[i] = classes.try_emplace(info.LocalHash, m_ClassCount).first->second;
+        else
+            m_classes[i] = m_ClassCount;
+
+        if (m_classes[i] == m_ClassCount)
+            m_ClassCount++;
+    }
+}
+
+void PdfDeduplicator::hashDirect(const PdfObject& obj, MurmurHash3& hasher, vector<uint64_t>& references) const
+{
+    utls::HashDirect(obj, hasher, [&](const PdfReference& ref, MurmurHash3&) {
+        // The referenced object contributes with its class,
+        // that is known only while refining the classes
+        references.push_back(getTarget(ref));
+    });
+}
+
+bool PdfDeduplicator::refineClasses()
+{
+    // The new class of an object is determined by its current
+    // class and the current classes of the referenced objects
+    unordered_map<Hash128, uint32_t, Hash128Hasher> classes;
+    vector<uint32_t> newClasses(m_infos.size());
+    uint32_t classCount = 0;
+    for (size_t i = 0; i < m_infos.size(); i++)
+    {
+        auto& info = m_infos[i];
+        MurmurHash3 hasher;
+        hasher.Update((uint64_t)m_classes[i]);
+        hasher.Update(info.LocalHash);
+        for (auto target : info.References)
+            hasher.Update(getTargetClass(target));
+
+        newClasses[i] = classes.try_emplace(hasher.Finish(), classCount).first->second;
+        if (newClasses[i] == classCount)
+            classCount++;
+    }
+
+    bool changed = classCount != m_ClassCount;
+    m_classes = std::move(newClasses);
+    m_ClassCount = classCount;
+    return changed;
+}
+
+bool PdfDeduplicator::confirmClasses()
+{
+    // Compare the members of the classes with the first member. The
+    // objects that are not equal to it are moved in new classes
+    vector<vector<uint32_t>> members(m_ClassCount);
+    for (uint32_t i = 0; i < (uint32_t)m_infos.size(); i++)
+        members[m_classes[i]].push_back(i);
+
+    vector<uint32_t> newClasses = m_classes;
+    uint32_t classCount = m_ClassCount;
+    for (auto& classMembers : members)
+    {
+        if (classMembers.size() < 2)
+            continue;
+
+        // The first member of each of the classes split from this one
+        vector<uint32_t> representatives = { classMembers[0] };
+        for (size_t i = 1; i < classMembers.size(); i++)
+        {
+            auto& info = m_infos[classMembers[i]];
+            auto& obj = *info.Object;
+            bool found = false;
+            for (auto representative : representatives)
+            {
+                auto& other = *m_infos[representative].Object;
+                if (info.Mergeable && m_infos[representative].Mergeable && equalDirect(obj, other) && utls::EqualStream(obj, other))
+                {
+                    newClasses[classMembers[i]] = newClasses[representative];
+                    found = true;
+                    break;
+                }
+            }
+
+            if (!found)
+            {
+                newClasses[classMembers[i]] = classCount++;
+                representatives.push_back(classMembers[i]);
+            }
+        }
+    }
+
+    bool changed = classCount != m_ClassCount;
+    m_classes = std::move(newClasses);
+    m_ClassCount = classCount;
+    return changed;
+}
+
+bool PdfDeduplicator::equalDirect(const PdfObject& lhs, const PdfObject& rhs) const
+{
+    return utls::EqualDirect(lhs, rhs, [&](const PdfObject& lhsRef, const PdfObject& rhsRef) {
+        return lhsRef.IsReference() && rhsRef.IsReference()
+            && getTargetClass(getTarget(lhsRef.GetReference())) == getTargetClass(getTarget(rhsRef.GetReference()));
+    });
+}
+
+bool PdfDeduplicator::canMerge(const PdfObject& obj) const
+{
+    if (!m_aggressive && obj.HasStream())
+        return false;
+
+    // Never merge the document structure, since the
+    // page tree requires distinct nodes
+    const PdfDictionary* dict;
+    const PdfName* type;
+    if (!obj.TryGetDictionary(dict) || !dict->TryFindKeyAs("Type", type))
+        return true;
+
+    return *type != "Catalog" && *type != "Pages" && *type != "Page"
+        && *type != "XRef" && *type != "ObjStm";
+}
+
+uint64_t PdfDeduplicator::getTarget(const PdfReference& ref) const
+{
+    auto found = m_indices.find(ref);
+    if (found == m_indices.end())
+        return ~(((uint64_t)ref.ObjectNumber() << 16) | ref.GenerationNumber());
+
+    return found->second;
+}
+
+uint64_t PdfDeduplicator::getTargetClass(uint64_t target) const
+{
+    // Missing targets are only equal to themselves
+    if (target >= m_infos.size())
+        return target;
+
+    return m_classes[(size_t)target];
+}
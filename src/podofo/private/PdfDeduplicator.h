@@ -0,0 +1,75 @@
+/**
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#ifndef PDF_DEDUPLICATOR_H
+#define PDF_DEDUPLICATOR_H
+
+#include <unordered_map>
+
+#include <podofo/main/PdfIndirectObjectList.h>
+
+#include "MurmurHash3.h"
+
+namespace PoDoFo {
+
+/** Finds structurally identical indirect objects
+ *
+ * Every object is hashed once, with a 128 bit hash of its direct
+ * content, where references are placeholders, and of its raw stream
+ * data, read in chunks. Objects are then partitioned by refining
+ * the classes of the hashes with the classes of the referenced
+ * objects, until a fix point is reached, so that objects in
+ * reference cycles are compared correctly. Candidates are finally
+ * confirmed with a full comparison, including the raw stream data
+ *
+ * This is an internal class of PoDoFo used by PdfMemDocument.
+ */
+class PdfDeduplicator final
+{
+public:
+    /**
+     * \param aggressive if true, also objects with streams
+     *     are compared, otherwise they are never merged
+     */
+    PdfDeduplicator(PdfIndirectObjectList& objects, bool aggressive);
+
+    /** Compute the references of the duplicated objects, mapped
+     * to the reference of the object they can be replaced with
+     */
+    std::unordered_map<PdfReference, PdfReference> FindDuplicates();
+
+private:
+    struct ObjectInfo
+    {
+        PdfObject* Object;
+        bool Mergeable;
+        Hash128 LocalHash;
+        // The targets of the references found in the object, in
+        // traversal order. Missing targets are encoded as the
+        // bitwise complement of the reference
+        std::vector<uint64_t> References;
+    };
+
+private:
+    void hashObjects();
+    void hashDirect(const PdfObject& obj, MurmurHash3& hasher, std::vector<uint64_t>& references) const;
+    bool refineClasses();
+    bool confirmClasses();
+    bool equalDirect(const PdfObject& lhs, const PdfObject& rhs) const;
+    bool canMerge(const PdfObject& obj) const;
+    uint64_t getTarget(const PdfReference& ref) const;
+    uint64_t getTargetClass(uint64_t target) const;
+
+private:
+    PdfIndirectObjectList* m_objects;
+    bool m_aggressive;
+    std::vector<ObjectInfo> m_infos;
+    std::unordered_map<PdfReference, uint32_t> m_indices;
+    std::vector<uint32_t> m_classes;
+    uint32_t m_ClassCount;
+};
+
+};
+
+#endif // PDF_DEDUPLICATOR_H
@@ -0,0 +1,344 @@
+/**
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#include "PdfDeclarationsPrivate.h"
+#include "PdfDocumentMerger.h"
+
+#include <podofo/main/PdfArray.h>
+#include <podofo/main/PdfDictionary.h>
+#include <podofo/main/PdfObjectStream.h>
+#include <podofo/main/PdfPage.h>
+#include <podofo/main/PdfStreamedDocument.h>
+
+#include "PdfObjectHashing.h"
+
+using namespace std;
+using namespace PoDoFo;
+
+static bool canCopy(const PdfObject& obj);
+static bool isSharedResource(const PdfObject& obj);
+
+PdfDocumentMerger::PdfDocumentMerger(PdfDocument& doc)
+    : m_doc(&doc), m_source(nullptr),
+    // The streams of a PdfStreamedDocument are written immediately
+    // and they can't be read to confirm the equality of resources
+    m_shareResources(dynamic_cast<PdfStreamedDocument*>(&doc) == nullptr)
+{
+}
+
+void PdfDocumentMerger::BeginCopy(const PdfDocument& source)
+{
+    m_source = &source;
+    m_references.clear();
+    m_copying.clear();
+    m_queue.clear();
+}
+
+vector<PdfObject*> PdfDocumentMerger::CopyPages(const cspan<const PdfPage*>& pages)
+{
+    static const PdfName inheritableAttributes[] = { "Resources"_n, "MediaBox"_n, "CropBox"_n, "Rotate"_n };
+
+    // Create all the copies of the pages first, so
+    // the references among the copied pages are kept
+    vector<PdfObject*> ret(pages.size());
+    for (unsigned i = 0; i < pages.size(); i++)
+    {
+        auto& pageObj = pages[i]->GetObject();
+        auto& copied = m_references[pageObj.GetIndirectReference()];
+        if (copied.IsIndirect())
+        {
+            // The page was already copied: its annotations are
+            // copied again, since they belong to a single page
+            const PdfArray* annots;
+            if (pageObj.GetDictionary().TryFindKeyAs("Annots", annots))
+            {
+                for (auto& annot : *annots)
+                {
+                    if (annot.IsReference())
+                        m_references.erase(annot.GetReference());
+                }
+            }
+        }
+
+        auto& copy = m_doc->GetObjects().CreateDictionaryObject();
+        copied = copy.GetIndirectReference();
+        ret[i] = &copy;
+    }
+
+    for (unsigned i = 0; i < pages.size(); i++)
+    {
+        auto& page = *pages[i];
+        auto& copy = *ret[i];
+        copy = page.GetObject();
+
+        // Deal with inherited attributes
+        auto& dict = copy.GetDictionary();
+        dict.RemoveKey("Parent");
+        for (auto& name : inheritableAttributes)
+        {
+            const PdfObject* attribute;
+            if (dict.HasKey(name) || (attribute = page.GetDictionary().FindKeyParent(name)) == nullptr)
+                continue;
+
+            if (attribute->IsIndirect())
+                dict.AddKey(name, attribute->GetIndirectReference());
+            else
+                dict.AddKey(name, *attribute);
+        }
+
+        fixReferences(copy, false);
+    }
+
+    copyQueued();
+    return ret;
+}
+
+PdfObject PdfDocumentMerger::CopyObject(const PdfObject& obj)
+{
+    PdfObject ret;
+    if (obj.IsIndirect())
+    {
+        ret = copyReference(obj.GetIndirectReference(), false);
+    }
+    else
+    {
+        ret = obj;
+        fixReferences(ret, false);
+    }
+
+    copyQueued();
+    return ret;
+}
+
+PdfObject PdfDocumentMerger::copyReference(const PdfReference& ref, bool shared)
+{
+    auto found = m_references.find(ref);
+    if (found != m_references.end())
+    {
+        if (!found->second.IsIndirect())
+            return PdfObject::Null;
+
+        // The copy may have been removed from the document after
+        // it was made. NOTE: The objects of a PdfStreamedDocument
+        // are removed when written, and they are kept
+        if (!m_shareResources || m_doc->GetObjects().GetObject(found->second) != nullptr)
+            return PdfObject(found->second);
+
+        m_references.erase(found);
+    }
+
+    auto obj = m_source->GetObjects().GetObject(ref);
+    if (obj == nullptr || !canCopy(*obj))
+    {
+        m_references[ref] = PdfReference();
+        return PdfObject::Null;
+    }
+
+    if (m_copying.find(ref) != m_copying.end())
+    {
+        // A reference cycle among shared objects: the object
+        // can't be hashed before it's referenced, so the copy
+        // is created now and it's not shared
+        auto& copy = m_doc->GetObjects().CreateDictionaryObject();
+        m_references[ref] = copy.GetIndirectReference();
+        return PdfObject(copy.GetIndirectReference());
+    }
+
+    if (shared || isSharedResource(*obj))
+        return PdfObject(copyShared(*obj));
+
+    auto& copy = m_doc->GetObjects().CreateDictionaryObject();
+    m_references[ref] = copy.GetIndirectReference();
+    m_queue.push_back({ obj, &copy });
+    return PdfObject(copy.GetIndirectReference());
+}
+
+PdfReference PdfDocumentMerger::copyShared(const PdfObject& obj)
+{
+    utls::RecursionGuard guard;
+    auto& ref = obj.GetIndirectReference();
+
+    // Copy the referenced objects first, so the object
+    // can be hashed with the references of the copies
+    m_copying.insert(ref);
+    copySharedReferences(obj);
+    m_copying.erase(ref);
+
+    PdfObject* copy;
+    auto found = m_references.find(ref);
+    if (found != m_references.end())
+    {
+        // The copy was already created for a reference cycle
+        copy = &m_doc->GetObjects().MustGetObject(found->second);
+    }
+    else if (!m_shareResources)
+    {
+        copy = &m_doc->GetObjects().CreateDictionaryObject();
+        m_references[ref] = copy->GetIndirectReference();
+    }
+    else
+    {
+        MurmurHash3 hasher;
+        hashDirect(obj, hasher);
+        if (obj.HasStream())
+            utls::HashStream(obj, hasher);
+
+        // Share an equal object, if it was already copied. The
+        // comparison is with the current state of the copy, that
+        // may have been modified or removed after being copied
+        auto& candidates = m_sharedObjects[hasher.Finish()];
+        for (auto& candidateRef : candidates)
+        {
+            auto candidate = m_doc->GetObjects().GetObject(candidateRef);
+            if (candidate != nullptr && equalDirect(*candidate, obj) && utls::EqualStream(*candidate, obj))
+            {
+                m_references[ref] = candidateRef;
+                return candidateRef;
+            }
+        }
+
+        copy = &m_doc->GetObjects().CreateDictionaryObject();
+        m_references[ref] = copy->GetIndirectReference();
+        candidates.push_back(copy->GetIndirectReference());
+    }
+
+    assignCopy(*copy, obj, true);
+    return copy->GetIndirectReference();
+}
+
+void PdfDocumentMerger::copyQueued()
+{
+    while (m_queue.size() != 0)
+    {
+        auto pair = m_queue.back();
+        m_queue.pop_back();
+        assignCopy(*pair.second, *pair.first, false);
+    }
+}
+
+void PdfDocumentMerger::assignCopy(PdfObject& copy, const PdfObject& obj, bool shared)
+{
+    // Fix the references before copying the stream, since
+    // a PdfStreamedDocument writes the object when the
+    // stream is copied, and it can't be modified anymore
+    copy = PdfObject(obj.GetVariant());
+    fixReferences(copy, shared);
+    auto stream = obj.GetStream();
+    if (stream != nullptr)
+        copy.GetOrCreateStream().CopyFrom(*stream);
+}
+
+void PdfDocumentMerger::copySharedReferences(const PdfObject& obj)
+{
+    const PdfDictionary* dict;
+    const PdfArray* arr;
+    if (obj.TryGetDictionary(dict))
+    {
+        for (auto& pair : *dict)
+        {
+            if (pair.second.IsReference())
+                (void)copyReference(pair.second.GetReference(), true);
+            else
+                copySharedReferences(pair.second);
+        }
+    }
+    else if (obj.TryGetArray(arr))
+    {
+        for (auto& child : *arr)
+        {
+            if (child.IsReference())
+                (void)copyReference(child.GetReference(), true);
+            else
+                copySharedReferences(child);
+        }
+    }
+}
+
+void PdfDocumentMerger::fixReferences(PdfObject& obj, bool shared)
+{
+    PdfDictionary* dict;
+    PdfArray* arr;
+    if (obj.TryGetDictionary(dict))
+    {
+        for (auto& pair : *dict)
+        {
+            if (pair.second.IsReference())
+                pair.second = copyReference(pair.second.GetReference(), shared);
+            else
+                fixReferences(pair.second, shared);
+        }
+    }
+    else if (obj.TryGetArray(arr))
+    {
+        // ICC profiles are shared, like fonts and images
+        bool iccBased = arr->GetSize() == 2 && (*arr)[0].IsName()
+            && (*arr)[0].GetName() == "ICCBased";
+        for (unsigned i = 0; i < arr->GetSize(); i++)
+        {
+            auto& child = (*arr)[i];
+            if (child.IsReference())
+                child = copyReference(child.GetReference(), shared || iccBased);
+            else
+                fixReferences(child, shared);
+        }
+    }
+}
+
+void PdfDocumentMerger::hashDirect(const PdfObject& obj, MurmurHash3& hasher) const
+{
+    utls::HashDirect(obj, hasher, [&](const PdfReference& ref, MurmurHash3& refHasher) {
+        // References replaced with null are hashed as invalid references
+        auto copied = getCopiedReference(ref);
+        refHasher.Update(((uint64_t)copied.ObjectNumber() << 16) | copied.GenerationNumber());
+    });
+}
+
+// Compare a copy with an object of the source
+// document, whose references are already copied
+bool PdfDocumentMerger::equalDirect(const PdfObject& copy, const PdfObject& obj) const
+{
+    return utls::EqualDirect(copy, obj, [&](const PdfObject& copyRef, const PdfObject& objRef) {
+        if (!objRef.IsReference())
+            return false;
+
+        auto copied = getCopiedReference(objRef.GetReference());
+        if (!copied.IsIndirect())
+            return copyRef.IsNull();
+
+        return copyRef.IsReference() && copyRef.GetReference() == copied;
+    });
+}
+
+PdfReference PdfDocumentMerger::getCopiedReference(const PdfReference& ref) const
+{
+    auto found = m_references.find(ref);
+    if (found == m_references.end())
+        return PdfReference();
+
+    return found->second;
+}
+
+// The page tree, the catalog and the pages not being copied are not followed
+bool canCopy(const PdfObject& obj)
+{
+    const PdfDictionary* dict;
+    const PdfName* type;
+    if (!obj.TryGetDictionary(dict) || !dict->TryFindKeyAs("Type", type))
+        return true;
+
+    return *type != "Page" && *type != "Pages" && *type != "Catalog";
+}
+
+bool isSharedResource(const PdfObject& obj)
+{
+    const PdfDictionary* dict;
+    const PdfName* name;
+    if (!obj.TryGetDictionary(dict))
+        return false;
+
+    if (dict->TryFindKeyAs("Type", name) && (*name == "Font" || *name == "FontDescriptor"))
+        return true;
+
+    return obj.HasStream() && dict->TryFindKeyAs("Subtype", name) && *name == "Image";
+}
@@ -0,0 +1,87 @@
+/**
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#ifndef PDF_DOCUMENT_MERGER_H
+#define PDF_DOCUMENT_MERGER_H
+
+#include <unordered_map>
+#include <unordered_set>
+
+#include <podofo/main/PdfDocument.h>
+
+#include "MurmurHash3.h"
+
+namespace PoDoFo {
+
+/** Copies pages and objects from other documents
+ *
+ * Only the objects reachable from the copied pages are copied, through
+ * a map from the references of the source document to the references
+ * of the copies, that is kept only for a single copy. The page tree
+ * nodes, the catalog and the pages that are not copied are not
+ * followed: references to them are replaced with null, also in the
+ * links and the destinations, that are kept. Fonts, images and ICC
+ * profiles are copied bottom up, with the objects they use, and hashed
+ * with their content: a resource equal to one already copied, also
+ * from another document, is shared instead of being copied again, so
+ * merging many documents with the same resources doesn't duplicate
+ * them. The merger lives until the merge is finished, when the
+ * document is saved. Resources are not shared this way in a
+ * PdfStreamedDocument, that doesn't keep the written streams
+ *
+ * This is an internal class of PoDoFo used by PdfDocument.
+ */
+class PdfDocumentMerger final
+{
+public:
+    PdfDocumentMerger(PdfDocument& doc);
+
+    /** Start copying objects from the given document. The objects
+     *  copied before are not reused, except the shared resources
+     */
+    void BeginCopy(const PdfDocument& source);
+
+    /** Copy the given pages of the source document, with the
+     *  attributes they inherit from the page tree
+     *  \returns the copied page objects, in the same order
+     */
+    std::vector<PdfObject*> CopyPages(const cspan<const PdfPage*>& pages);
+
+    /** Copy an object of the source document
+     *  \returns a reference to the copy, if the object is indirect,
+     *      otherwise a copy with the references remapped
+     */
+    PdfObject CopyObject(const PdfObject& obj);
+
+private:
+    PdfObject copyReference(const PdfReference& ref, bool shared);
+    PdfReference copyShared(const PdfObject& obj);
+    void copyQueued();
+    void assignCopy(PdfObject& copy, const PdfObject& obj, bool shared);
+    void copySharedReferences(const PdfObject& obj);
+    void fixReferences(PdfObject& obj, bool shared);
+    void hashDirect(const PdfObject& obj, MurmurHash3& hasher) const;
+    bool equalDirect(const PdfObject& copy, const PdfObject& obj) const;
+    PdfReference getCopiedReference(const PdfReference& ref) const;
+
+private:
+    PdfDocument* m_doc;
+    const PdfDocument* m_source;
+    // The references of the copies, by source reference, for the
+    // current copy. Objects replaced with null have an invalid reference
+    std::unordered_map<PdfReference, PdfReference> m_references;
+    // The shared objects being copied, to detect reference cycles
+    std::unordered_set<PdfReference> m_copying;
+    // Copies waiting for their content, to copy the
+    // objects without recursion
+    std::vector<std::pair<const PdfObject*, PdfObject*>> m_queue;
+    // The copied shared objects, by hash of their content.
+    // It's kept across copies from different documents
+    std::unordered_map<Hash128, std::vector<PdfReference>, Hash128Hasher> m_sharedObjects;
+    bool m_shareResources;
+};
+
+};
+
+#endif // PDF_DOCUMENT_MERGER_H
@@ -12,7 +12,7 @@ using namespace std;
 using namespace PoDoFo;
 
 PdfFilter::PdfFilter()
-    : m_OutputStream(nullptr)
+    : m_OutputStream(nullptr), m_DecodedLengthHint(-1)
 {
 }
 
@@ -191,6 +191,11 @@ void PdfFilter::EndDecode()
     }
 }
 
+void PdfFilter::SetDecodedLengthHint(ssize_t length)
+{
+    m_DecodedLengthHint = length < 0 ? -1 : length;
+}
+
 void PdfFilter::FailEncodeDecode()
 {
     if (m_OutputStream != nullptr)
@@ -167,6 +167,15 @@ public:
      */
     virtual PdfFilterType GetType() const = 0;
 
+    /** Set the expected length of the decoded data, as found in the
+     *  /DL key of the stream dictionary. Filters may use it to decode
+     *  the data in a single pass, the decoded data is not required
+     *  to match it. It's used by the next BeginDecode() calls
+     *
+     *  \param length the length, or -1 if unknown
+     */
+    void SetDecodedLengthHint(ssize_t length);
+
 protected:
     /**
      * Indicate that the filter has failed, and will be non-functional
@@ -267,12 +276,18 @@ protected:
 
 protected:
     inline OutputStream& GetStream() const { return *m_OutputStream; }
+
+    /** Get the expected length of the decoded data,
+     *  or -1 if unknown
+     */
+    inline ssize_t GetDecodedLengthHint() const { return m_DecodedLengthHint; }
 private:
     void encodeTo(OutputStream& stream, const bufferview& inBuffer);
     void decodeTo(OutputStream& stream, const bufferview& inBuffer, const PdfDictionary* decodeParms);
 
 private:
     OutputStream* m_OutputStream;
+    ssize_t m_DecodedLengthHint;
 };
 
 }
@@ -48,17 +48,18 @@ class PdfFilteredDecodeStream : public OutputStream
 {
 private:
     void init(OutputStream& outputStream, const PdfFilterType filterType,
-        const PdfDictionary* decodeParms)
+        const PdfDictionary* decodeParms, ssize_t decodedLength)
     {
         m_filter = PdfFilterFactory::Create(filterType);
+        m_filter->SetDecodedLengthHint(decodedLength);
         m_filter->BeginDecode(outputStream, decodeParms);
     }
 
 public:
     PdfFilteredDecodeStream(OutputStream& outputStream, const PdfFilterType filterType,
-        const PdfDictionary* decodeParms)
+        const PdfDictionary* decodeParms, ssize_t decodedLength)
     {
-        init(outputStream, filterType, decodeParms);
+        init(outputStream, filterType, decodeParms, decodedLength);
     }
 
     PdfFilteredDecodeStream(unique_ptr<OutputStream> outputStream, const PdfFilterType filterType,
@@ -68,7 +69,7 @@ public:
         if (m_OutputStream == nullptr)
             PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "Output stream must be not null");
 
-        init(*m_OutputStream, filterType, decodeParms);
+        init(*m_OutputStream, filterType, decodeParms, -1);
     }
 
     ~PdfFilteredDecodeStream()
@@ -119,12 +120,13 @@ class PdfBufferedDecodeStream : public InputStream, private OutputStream
 {
 public:
     PdfBufferedDecodeStream(shared_ptr<InputStream>&& inputStream, const PdfFilterList& filters,
-        const vector<const PdfDictionary*>& decodeParms)
+        const vector<const PdfDictionary*>& decodeParms, ssize_t decodedLength)
         : m_inputEof(false), m_inputStream(std::move(inputStream)), m_offset(0)
     {
         PODOFO_INVARIANT(filters.size() != 0);
         int i = (int)filters.size() - 1;
-        m_filterStream.reset(new PdfFilteredDecodeStream(*this, filters[i], decodeParms[i]));
+        // Only the last filter produces the final decoded data
+        m_filterStream.reset(new PdfFilteredDecodeStream(*this, filters[i], decodeParms[i], decodedLength));
         i--;
 
         while (i >= 0)
@@ -236,11 +238,12 @@ unique_ptr<OutputStream> PdfFilterFactory::CreateEncodeStream(shared_ptr<OutputS
 }
 
 unique_ptr<InputStream> PdfFilterFactory::CreateDecodeStream(shared_ptr<InputStream> stream,
-    const PdfFilterList& filters, const std::vector<const PdfDictionary*>& decodeParms)
+    const PdfFilterList& filters, const std::vector<const PdfDictionary*>& decodeParms,
+    ssize_t decodedLength)
 {
     PODOFO_RAISE_LOGIC_IF(stream == nullptr, "Cannot create an DecodeStream from an empty stream");
     PODOFO_RAISE_LOGIC_IF(filters.size() == 0, "Cannot create an DecodeStream from an empty list of filters");
-    return std::make_unique<PdfBufferedDecodeStream>(std::move(stream), filters, decodeParms);
+    return std::make_unique<PdfBufferedDecodeStream>(std::move(stream), filters, decodeParms, decodedLength);
 }
 
 PdfFilterList PdfFilterFactory::CreateFilterList(const PdfObject& filtersObj_)
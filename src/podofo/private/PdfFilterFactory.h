@@ -55,12 +55,15 @@ public:
      *  \param stream write all data to this OutputStream
      *         after it has been decoded.
      *  \param decodeParms list of additional parameters for stream decoding
+     *  \param decodedLength the expected length of the data decoded
+     *         by all the filters, or -1 if unknown
      *  \returns a new OutputStream that has to be deleted by the caller.
      *
      *  \see PdfFilterFactory::CreateFilterList
      */
     static std::unique_ptr<InputStream> CreateDecodeStream(std::shared_ptr<InputStream> stream,
-        const PdfFilterList& filters, const std::vector<const PdfDictionary*>& decodeParms);
+        const PdfFilterList& filters, const std::vector<const PdfDictionary*>& decodeParms,
+        ssize_t decodedLength = -1);
 
     /** The passed PdfObject has to be a dictionary with a Filters key,
      *  a (possibly empty) array of filter names or a filter name.
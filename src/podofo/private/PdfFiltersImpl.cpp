@@ -6,10 +6,15 @@
 #include "PdfDeclarationsPrivate.h"
 #include "PdfFiltersImpl.h"
 
+#include <podofo/main/PdfCommon.h>
 #include <podofo/main/PdfDictionary.h>
 #include <podofo/main/PdfTokenizer.h>
 #include <podofo/auxiliary/StreamDevice.h>
 
+#ifdef PODOFO_HAVE_LIBDEFLATE
+#include <libdeflate.h>
+#endif // PODOFO_HAVE_LIBDEFLATE
+
 using namespace std;
 using namespace PoDoFo;
 
@@ -476,23 +481,116 @@ void PdfAscii85Filter::WidePut(unsigned tuple, int bytes) const
 
 #pragma endregion // PdfAscii85Filter
 
-#pragma endregion PdfFlateFilter
+#pragma region PdfFlateFilter
+
+#ifdef PODOFO_HAVE_LIBDEFLATE
+
+// Deflate can't compress more than about 1032:1
+constexpr size_t MAX_DEFLATE_RATIO = 1032;
+constexpr int LIBDEFLATE_DEFAULT_LEVEL = 6;
+
+namespace
+{
+    // libdeflate compressors and decompressors are expensive to
+    // allocate, but can't be shared among threads: keep them
+    // for the lifetime of the thread
+    class LibDeflateContext final
+    {
+    public:
+        LibDeflateContext()
+            : m_compressor(nullptr), m_compressorLevel(-1), m_decompressor(nullptr) { }
+
+        ~LibDeflateContext()
+        {
+            libdeflate_free_compressor(m_compressor);
+            libdeflate_free_decompressor(m_decompressor);
+        }
+
+        libdeflate_compressor& GetCompressor(int level)
+        {
+            if (m_compressor == nullptr || m_compressorLevel != level)
+            {
+                libdeflate_free_compressor(m_compressor);
+                m_compressor = libdeflate_alloc_compressor(level);
+                m_compressorLevel = level;
+                if (m_compressor == nullptr)
+                    PODOFO_RAISE_ERROR(PdfErrorCode::OutOfMemory);
+            }
+
+            return *m_compressor;
+        }
+
+        libdeflate_decompressor& GetDecompressor()
+        {
+            if (m_decompressor == nullptr)
+            {
+                m_decompressor = libdeflate_alloc_decompressor();
+                if (m_decompressor == nullptr)
+                    PODOFO_RAISE_ERROR(PdfErrorCode::OutOfMemory);
+            }
+
+            return *m_decompressor;
+        }
+
+    private:
+        libdeflate_compressor* m_compressor;
+        int m_compressorLevel;
+        libdeflate_decompressor* m_decompressor;
+    };
+
+    thread_local LibDeflateContext s_libDeflateContext;
+}
+
+#endif // PODOFO_HAVE_LIBDEFLATE
 
 PdfFlateFilter::PdfFlateFilter()
-    : m_buffer{ }, m_stream{ } { }
+    : m_buffer{ }, m_stream{ }, m_Level(-1), m_Buffered(false) { }
 
 void PdfFlateFilter::BeginEncodeImpl()
+{
+    m_Level = PdfCommon::GetFlateCompressionLevel();
+#ifdef PODOFO_HAVE_LIBDEFLATE
+    if (PdfCommon::GetFlateBackend() == PdfFlateBackend::LibDeflate)
+    {
+        m_Buffered = true;
+        m_input.clear();
+        return;
+    }
+#endif // PODOFO_HAVE_LIBDEFLATE
+
+    m_Buffered = false;
+    beginZLibEncode();
+}
+
+void PdfFlateFilter::beginZLibEncode()
 {
     m_stream.zalloc = Z_NULL;
     m_stream.zfree = Z_NULL;
     m_stream.opaque = Z_NULL;
 
-    if (deflateInit(&m_stream, Z_DEFAULT_COMPRESSION))
+    // Levels above 9 are available only with libdeflate
+    if (deflateInit(&m_stream, m_Level < 0 ? Z_DEFAULT_COMPRESSION : std::min(m_Level, (int)Z_BEST_COMPRESSION)))
         PODOFO_RAISE_ERROR(PdfErrorCode::FlateError);
 }
 
 void PdfFlateFilter::EncodeBlockImpl(const char* buffer, size_t len)
 {
+    if (m_Buffered)
+    {
+        if (m_input.size() + len <= MAX_BUFFERED_SIZE)
+        {
+            m_input.append(buffer, len);
+            return;
+        }
+
+        // Too much data to hold in memory: continue with
+        // the zlib streaming API, which has the same output format
+        m_Buffered = false;
+        beginZLibEncode();
+        this->EncodeBlockInternal(m_input.data(), m_input.size(), Z_NO_FLUSH);
+        m_input = charbuff();
+    }
+
     this->EncodeBlockInternal(buffer, len, Z_NO_FLUSH);
 }
 
@@ -534,24 +632,76 @@ void PdfFlateFilter::EncodeBlockInternal(const char* buffer, size_t len, int nMo
 
 void PdfFlateFilter::EndEncodeImpl()
 {
+#ifdef PODOFO_HAVE_LIBDEFLATE
+    if (m_Buffered)
+    {
+        auto& compressor = s_libDeflateContext.GetCompressor(m_Level < 0 ? LIBDEFLATE_DEFAULT_LEVEL : m_Level);
+        charbuff output(libdeflate_zlib_compress_bound(&compressor, m_input.size()));
+        size_t outputSize = libdeflate_zlib_compress(&compressor, m_input.data(), m_input.size(),
+            output.data(), output.size());
+        m_input = charbuff();
+        if (outputSize == 0)
+            PODOFO_RAISE_ERROR(PdfErrorCode::FlateError);
+
+        GetStream().Write(output.data(), outputSize);
+        return;
+    }
+#endif // PODOFO_HAVE_LIBDEFLATE
+
     this->EncodeBlockInternal(nullptr, 0, Z_FINISH);
     deflateEnd(&m_stream);
 }
 
 void PdfFlateFilter::BeginDecodeImpl(const PdfDictionary* decodeParms)
+{
+    if (decodeParms != nullptr)
+        m_Predictor.reset(new PdfPredictorDecoder(*decodeParms));
+
+#ifdef PODOFO_HAVE_LIBDEFLATE
+    // Decoding in a single pass requires the length of the decoded data
+    if (PdfCommon::GetFlateBackend() == PdfFlateBackend::LibDeflate
+        && GetDecodedLengthHint() >= 0 && (size_t)GetDecodedLengthHint() <= MAX_BUFFERED_SIZE)
+    {
+        m_Buffered = true;
+        m_input.clear();
+        return;
+    }
+#endif // PODOFO_HAVE_LIBDEFLATE
+
+    m_Buffered = false;
+    beginZLibDecode();
+}
+
+void PdfFlateFilter::beginZLibDecode()
 {
     m_stream.zalloc = Z_NULL;
     m_stream.zfree = Z_NULL;
     m_stream.opaque = Z_NULL;
 
-    if (decodeParms != nullptr)
-        m_Predictor.reset(new PdfPredictorDecoder(*decodeParms));
-
     if (inflateInit(&m_stream) != Z_OK)
         PODOFO_RAISE_ERROR(PdfErrorCode::FlateError);
 }
 
 void PdfFlateFilter::DecodeBlockImpl(const char* buffer, size_t len)
+{
+    if (m_Buffered)
+    {
+        if (m_input.size() + len <= MAX_BUFFERED_SIZE)
+        {
+            m_input.append(buffer, len);
+            return;
+        }
+
+        m_Buffered = false;
+        beginZLibDecode();
+        decodeZLibBlock(m_input.data(), m_input.size());
+        m_input = charbuff();
+    }
+
+    decodeZLibBlock(buffer, len);
+}
+
+void PdfFlateFilter::decodeZLibBlock(const char* buffer, size_t len)
 {
     int flateErr;
     unsigned writtenDataSize;
@@ -581,29 +731,78 @@ void PdfFlateFilter::DecodeBlockImpl(const char* buffer, size_t len)
         }
 
         writtenDataSize = BUFFER_SIZE - m_stream.avail_out;
-        try
-        {
-            if (m_Predictor != nullptr)
-                m_Predictor->Decode(reinterpret_cast<char*>(m_buffer), writtenDataSize, GetStream());
-            else
-                GetStream().Write(reinterpret_cast<char*>(m_buffer), writtenDataSize);
-        }
-        catch (PdfError& e)
-        {
-            // clean up after any output stream errors
-            FailEncodeDecode();
-            PODOFO_PUSH_FRAME(e);
-            throw;
-        }
+        writeDecoded(reinterpret_cast<char*>(m_buffer), writtenDataSize);
     } while (m_stream.avail_out == 0);
 }
 
+void PdfFlateFilter::writeDecoded(const char* buffer, size_t len)
+{
+    try
+    {
+        if (m_Predictor != nullptr)
+            m_Predictor->Decode(buffer, len, GetStream());
+        else
+            GetStream().Write(buffer, len);
+    }
+    catch (PdfError& e)
+    {
+        // clean up after any output stream errors
+        FailEncodeDecode();
+        PODOFO_PUSH_FRAME(e);
+        throw;
+    }
+}
+
 void PdfFlateFilter::EndDecodeImpl()
 {
+#ifdef PODOFO_HAVE_LIBDEFLATE
+    if (m_Buffered)
+    {
+        m_Buffered = false;
+        if (tryDecodeLibDeflate())
+        {
+            m_input = charbuff();
+            m_Predictor.reset();
+            return;
+        }
+
+        // The decoded length is wrong or the data is broken: retry
+        // with zlib, which is able to recover the data decoded
+        // before the error, as it happens with truncated streams
+        beginZLibDecode();
+        decodeZLibBlock(m_input.data(), m_input.size());
+        m_input = charbuff();
+    }
+#endif // PODOFO_HAVE_LIBDEFLATE
+
     (void)inflateEnd(&m_stream);
     m_Predictor.reset();
 }
 
+#ifdef PODOFO_HAVE_LIBDEFLATE
+
+bool PdfFlateFilter::tryDecodeLibDeflate()
+{
+    // Deflate can't compress more than about 1032:1, a
+    // greater decoded length can only be wrong
+    size_t decodedLength = (size_t)GetDecodedLengthHint();
+    if (decodedLength / MAX_DEFLATE_RATIO > m_input.size())
+        return false;
+
+    charbuff output(decodedLength);
+    size_t outputSize;
+    if (libdeflate_zlib_decompress(&s_libDeflateContext.GetDecompressor(), m_input.data(), m_input.size(),
+        output.data(), output.size(), &outputSize) != LIBDEFLATE_SUCCESS)
+    {
+        return false;
+    }
+
+    writeDecoded(output.data(), outputSize);
+    return true;
+}
+
+#endif // PODOFO_HAVE_LIBDEFLATE
+
 #pragma endregion // PdfFlateFilter
 
 #pragma region PdfRLEFilter
@@ -90,6 +90,8 @@ private:
 class PdfFlateFilter final : public PdfFilter
 {
     static constexpr unsigned BUFFER_SIZE = 4096;
+    // Streams bigger than this are always processed with zlib
+    static constexpr size_t MAX_BUFFERED_SIZE = 64 * 1024 * 1024;
 
 public:
     PdfFlateFilter();
@@ -114,12 +116,24 @@ public:
 
 private:
     void EncodeBlockInternal(const char* buffer, size_t len, int nMode);
+    void beginZLibEncode();
+    void beginZLibDecode();
+    void decodeZLibBlock(const char* buffer, size_t len);
+    void writeDecoded(const char* buffer, size_t len);
+#ifdef PODOFO_HAVE_LIBDEFLATE
+    bool tryDecodeLibDeflate();
+#endif // PODOFO_HAVE_LIBDEFLATE
 
 private:
     unsigned char m_buffer[BUFFER_SIZE];
 
     z_stream m_stream;
     std::shared_ptr<PdfPredictorDecoder> m_Predictor;
+    int m_Level;
+    // If true the whole data is collected in m_input
+    // and then processed in a single pass by libdeflate
+    bool m_Buffered;
+    charbuff m_input;
 };
 
 /** The RLE filter.
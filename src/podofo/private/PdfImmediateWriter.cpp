@@ -7,6 +7,7 @@
 #include <podofo/private/PdfDeclarationsPrivate.h>
 #include "PdfImmediateWriter.h"
 
+#include <podofo/main/PdfDictionary.h>
 #include <podofo/main/PdfStatefulEncrypt.h>
 
 #include "PdfXRefStream.h"
@@ -18,8 +19,9 @@ using namespace PoDoFo;
 PdfImmediateWriter::PdfImmediateWriter(PdfIndirectObjectList& objects, const PdfObject& trailer,
         OutputStreamDevice& device, PdfVersion version, shared_ptr<PdfEncrypt> encrypt, PdfSaveOptions opts) :
     PdfWriter(objects, trailer),
-    m_Device(&device),
-    m_OpenStream(false)
+    m_Device(device),
+    m_OpenStream(false),
+    m_Finished(false)
 {
     SetPdfVersion(version);
     SetSaveOptions(opts);
@@ -42,7 +44,7 @@ PdfImmediateWriter::PdfImmediateWriter(PdfIndirectObjectList& objects, const Pdf
     }
 
     // Start with writing the header
-    this->WritePdfHeader(*m_Device);
+    this->WritePdfHeader(m_Device);
 
     // Manually prepare the cross-reference table/stream
     m_xRef.reset(GetUseXRefStream() ? new PdfXRefStream(*this) : new PdfXRef(*this));
@@ -50,6 +52,27 @@ PdfImmediateWriter::PdfImmediateWriter(PdfIndirectObjectList& objects, const Pdf
 
 PdfImmediateWriter::~PdfImmediateWriter()
 {
+    if (m_Finished)
+        return;
+
+    try
+    {
+        Finish();
+    }
+    catch (PdfError& e)
+    {
+        PoDoFo::LogMessage(PdfLogSeverity::Error, "Finishing the document failed: {}", e.what());
+    }
+}
+
+void PdfImmediateWriter::Finish()
+{
+    if (m_Finished)
+        return;
+
+    // NOTE: A failed write leaves the output broken,
+    // so the writer is not finished twice
+    m_Finished = true;
     finish();
 }
 
@@ -57,8 +80,8 @@ void PdfImmediateWriter::finish()
 {
     // Before writing remaining objects remove
     // the already handled ones from the collection
-    for (unsigned i = 0; i < m_writtenObjects.size(); i++)
-        GetObjects().RemoveObject(m_writtenObjects[i]->GetIndirectReference(), false);
+    for (auto obj : m_writtenObjects)
+        GetObjects().RemoveObject(obj->GetIndirectReference(), false);
 
     // Eetup encrypt dictionary
     auto encrypt = GetEncrypt();
@@ -70,15 +93,16 @@ void PdfImmediateWriter::finish()
     }
 
     // Write all the remaining objects
-    this->WritePdfObjects(*m_Device, GetObjects(), *m_xRef);
+    this->WritePdfObjects(m_Device, GetObjects(), *m_xRef);
 
     // Finally write the XRef
-    m_xRef->Write(*m_Device, m_buffer);
+    m_xRef->Write(m_Device, m_buffer);
+    m_Device.Flush();
 }
 
 unique_ptr<PdfObjectStreamProvider> PdfImmediateWriter::CreateStream()
 {
-    return unique_ptr<PdfObjectStreamProvider>(new PdfStreamedObjectStream(*m_Device));
+    return unique_ptr<PdfObjectStreamProvider>(new PdfStreamedObjectStream(m_Device));
 }
 
 void PdfImmediateWriter::BeginAppendStream(PdfObjectStream& stream)
@@ -101,7 +125,7 @@ void PdfImmediateWriter::BeginAppendStream(PdfObjectStream& stream)
 
     // Manually mark the object as in-use, as it won't be
     // handled by the document object collection
-    m_xRef->AddInUseObject(obj.GetIndirectReference(), m_Device->GetPosition());
+    m_xRef->AddInUseObject(obj.GetIndirectReference(), m_Device.GetPosition());
 
     // Make sure, no one will add keys now to the object
     obj.SetImmutable();
@@ -111,25 +135,72 @@ void PdfImmediateWriter::BeginAppendStream(PdfObjectStream& stream)
     if (encrypt != nullptr)
         statefulEncrypt.reset(new PdfStatefulEncrypt(encrypt->GetEncrypt(), encrypt->GetContext(), obj.GetIndirectReference()));
 
-    obj.WriteHeader(*m_Device, this->GetWriteFlags(), m_buffer);
-    obj.GetVariant().Write(*m_Device, this->GetWriteFlags(), statefulEncrypt.get(), m_buffer);
+    obj.WriteHeader(m_Device, this->GetWriteFlags(), m_buffer);
+    obj.GetVariant().Write(m_Device, this->GetWriteFlags(), statefulEncrypt.get(), m_buffer);
     obj.ResetDirty();
-    m_Device->Write("\nstream\n");
+    m_Device.Write("\nstream\n");
 
     // Already written objects must then be removed
     // from internal document object collection
-    m_writtenObjects.push_back(&obj);
+    m_writtenObjects.insert(&obj);
 }
 
 void PdfImmediateWriter::EndAppendStream(PdfObjectStream& stream)
 {
     (void)stream;
     PODOFO_ASSERT(m_OpenStream);
-    m_Device->Write("\nendstream\nendobj\n");
-    m_Device->Flush();
+    m_Device.Write("\nendstream\nendobj\n");
     m_OpenStream = false;
 }
 
+void PdfImmediateWriter::FlushObjects(const cspan<PdfObject*>& objects)
+{
+    if (m_OpenStream)
+    {
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic,
+            "Can't flush objects while a stream is being written");
+    }
+
+    PdfReference lengthRef;
+    for (auto obj : objects)
+    {
+        if (m_writtenObjects.erase(obj) != 0)
+        {
+            // The /Length object of an already written
+            // stream is final and can be flushed too
+            PdfObject* lengthObj;
+            auto lengthKey = obj->GetDictionary().GetKey("Length");
+            if (lengthKey != nullptr && lengthKey->TryGetReference(lengthRef)
+                && (lengthObj = GetObjects().GetObject(lengthRef)) != nullptr)
+            {
+                writeObject(*lengthObj);
+                GetObjects().RemoveObject(lengthRef, false);
+            }
+        }
+        else if (obj->HasStream())
+        {
+            continue;
+        }
+        else
+        {
+            writeObject(*obj);
+        }
+
+        GetObjects().RemoveObject(obj->GetIndirectReference(), false);
+    }
+}
+
+void PdfImmediateWriter::writeObject(PdfObject& obj)
+{
+    auto encrypt = GetEncrypt();
+    unique_ptr<PdfStatefulEncrypt> statefulEncrypt;
+    if (encrypt != nullptr)
+        statefulEncrypt.reset(new PdfStatefulEncrypt(encrypt->GetEncrypt(), encrypt->GetContext(), obj.GetIndirectReference()));
+
+    m_xRef->AddInUseObject(obj.GetIndirectReference(), m_Device.GetPosition());
+    obj.WriteFinal(m_Device, this->GetWriteFlags(), statefulEncrypt.get(), m_buffer);
+}
+
 PdfVersion PdfImmediateWriter::GetPdfVersion() const
 {
     return PdfWriter::GetPdfVersion();
@@ -7,12 +7,15 @@
 #ifndef PDF_IMMEDIATE_WRITER_H
 #define PDF_IMMEDIATE_WRITER_H
 
+#include <unordered_set>
+
+#include <podofo/auxiliary/StreamDevice.h>
+
 #include "PdfWriter.h"
 
 namespace PoDoFo {
 
 class PdfEncrypt;
-class OutputStreamDevice;
 class PdfXRef;
 
 /** A kind of PdfWriter that writes objects with streams immediately to
@@ -49,18 +52,37 @@ public:
 public:
     PdfVersion GetPdfVersion() const;
 
+    /** Write the given objects to the device now and remove them from
+     *  the document object collection, freeing them. Objects with
+     *  streams that were not written yet are left to be written
+     *  when the document is finished
+     */
+    void FlushObjects(const cspan<PdfObject*>& objects);
+
+    /** Write the remaining objects and the cross-reference section
+     *  \remarks It does nothing if the writer is already finished.
+     *  If not called, the writer is finished on destruction, where
+     *  errors can only be logged
+     */
+    void Finish();
+
+    inline bool IsFinished() const { return m_Finished; }
+
 private:
     void finish();
+    void writeObject(PdfObject& obj);
     void BeginAppendStream(PdfObjectStream& stream) override;
     void EndAppendStream(PdfObjectStream& stream) override;
     std::unique_ptr<PdfObjectStreamProvider> CreateStream() override;
 
 private:
-    OutputStreamDevice* m_Device;
-    std::vector<PdfObject*> m_writtenObjects;
+    // The writes to the device are combined in the buffer
+    BufferedOutputStreamDevice m_Device;
+    std::unordered_set<PdfObject*> m_writtenObjects;
     std::unique_ptr<PdfXRef> m_xRef;
     std::unique_ptr<PdfEncryptSession> m_encrypt;
     bool m_OpenStream;
+    bool m_Finished;
 };
 
 };
@@ -0,0 +1,774 @@
+/**
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#include "PdfDeclarationsPrivate.h"
+#include "PdfLinearizer.h"
+
+#include <podofo/auxiliary/StreamDevice.h>
+#include <podofo/main/PdfDictionary.h>
+#include <podofo/main/PdfArray.h>
+#include <podofo/main/PdfStatefulEncrypt.h>
+
+using namespace std;
+using namespace PoDoFo;
+
+// Length of a single entry of a cross-reference table
+static constexpr size_t XRefEntryLength = 20;
+
+namespace
+{
+    // Writes the bit packed entries of the hint tables,
+    // see ISO 32000-2:2020 F.4 "Hint streams"
+    class BitWriter final
+    {
+    public:
+        BitWriter(charbuff& buffer)
+            : m_buffer(&buffer), m_current(0), m_count(0) { }
+
+        void Write(uint64_t value, unsigned bits)
+        {
+            for (unsigned i = bits; i > 0; i--)
+            {
+                m_current = (unsigned char)((m_current << 1) | ((value >> (i - 1)) & 1));
+                m_count++;
+                if (m_count == 8)
+                {
+                    m_buffer->push_back((char)m_current);
+                    m_current = 0;
+                    m_count = 0;
+                }
+            }
+        }
+
+        // Pad the last byte with zero bits
+        void Flush()
+        {
+            if (m_count == 0)
+                return;
+
+            m_buffer->push_back((char)(m_current << (8 - m_count)));
+            m_current = 0;
+            m_count = 0;
+        }
+
+    private:
+        charbuff* m_buffer;
+        unsigned char m_current;
+        unsigned m_count;
+    };
+}
+
+static unsigned getBitCount(uint64_t value);
+static size_t getLength(const vector<size_t>& lengths);
+
+PdfLinearizer::PdfLinearizer(PdfWriter& writer) :
+    m_writer(&writer),
+    m_objects(&writer.GetObjects()),
+    m_catalog(nullptr),
+    m_metadata(nullptr),
+    m_FirstPageSectionNumber(0),
+    m_HintStreamNumber(0),
+    m_Size(0)
+{
+}
+
+void PdfLinearizer::Write(OutputStreamDevice& device)
+{
+    auto root = m_writer->GetTrailer().GetDictionary().FindKey("Root");
+    if (root == nullptr || !root->IsDictionary())
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidTrailer, "Missing document catalog");
+
+    m_catalog = root;
+    m_metadata = m_catalog->GetDictionary().FindKey("Metadata");
+    auto pages = m_catalog->GetDictionary().FindKey("Pages");
+    if (pages != nullptr && pages->IsDictionary())
+        collectPages(*pages);
+
+    if (m_pages.size() == 0)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidObject, "A linearized document must have at least one page");
+
+    collectObjects();
+    numberObjects();
+
+    measureObjects(m_documentObjects, m_documentLengths);
+    m_pageLengths.resize(m_pageSections.size());
+    for (size_t i = 0; i < m_pageSections.size(); i++)
+        measureObjects(m_pageSections[i].Objects, m_pageLengths[i]);
+    measureObjects(m_sharedObjects, m_sharedLengths);
+    measureObjects(m_otherObjects, m_otherLengths);
+
+    m_writer->WritePdfHeader(device);
+    size_t headerEnd = device.GetPosition();
+
+    // The linearization dictionary and the first page trailer
+    // hold offsets to the rest of the file, which depend on the
+    // length of these same objects. Reserve the space for them,
+    // growing it until the formatted objects fit
+    Layout layout;
+    charbuff hintStream;
+    charbuff linearizationDict;
+    charbuff firstPageXRef;
+    charbuff firstPageTrailer;
+    charbuff mainXRef;
+    charbuff mainTrailer;
+    size_t reserved = 0;
+    size_t fileLength;
+    while (true)
+    {
+        layout = computeLayout(headerEnd + reserved);
+        hintStream = createHintStream(layout);
+        size_t hintLength = hintStream.size();
+        size_t mainXRefOffset = layout.MainXRefOffset + hintLength;
+
+        firstPageXRef = formatFirstPageXRef(headerEnd, layout, hintLength);
+        firstPageTrailer = formatFirstPageTrailer(mainXRefOffset);
+        size_t fixedLength = firstPageXRef.size() + firstPageTrailer.size();
+        size_t linearizationDictLength = reserved > fixedLength ? reserved - fixedLength : 0;
+
+        mainXRef = formatMainXRef(layout, hintLength);
+        utls::FormatTo(mainTrailer, "trailer\n<</Size {}>>\nstartxref\n{}\n%%EOF\n",
+            m_FirstPageSectionNumber, headerEnd + linearizationDictLength);
+
+        // The first entry of the main XRef table follows
+        // the "xref\n0 n\n" header
+        size_t mainXRefEntriesOffset = mainXRefOffset + mainXRef.size() - XRefEntryLength * m_FirstPageSectionNumber;
+        fileLength = mainXRefOffset + mainXRef.size() + mainTrailer.size();
+        linearizationDict = formatLinearizationDict(fileLength, layout.FirstPageOffset, hintLength,
+            layout.FirstPageEnd + hintLength, mainXRefEntriesOffset - 1, 0);
+        if (linearizationDict.size() <= linearizationDictLength)
+        {
+            linearizationDict = formatLinearizationDict(fileLength, layout.FirstPageOffset, hintLength,
+                layout.FirstPageEnd + hintLength, mainXRefEntriesOffset - 1,
+                linearizationDictLength - linearizationDict.size());
+            break;
+        }
+
+        reserved = linearizationDict.size() + fixedLength;
+    }
+
+    device.Write(linearizationDict);
+    device.Write(firstPageXRef);
+    device.Write(firstPageTrailer);
+    writeObjects(device, m_documentObjects);
+    device.Write(hintStream);
+    for (auto& section : m_pageSections)
+        writeObjects(device, section.Objects);
+    writeObjects(device, m_sharedObjects);
+    writeObjects(device, m_otherObjects);
+    device.Write(mainXRef);
+    device.Write(mainTrailer);
+
+    // All the offsets were computed from the measured lengths
+    if (device.GetPosition() != fileLength)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InternalLogic, "The written objects differ from the measured ones");
+}
+
+void PdfLinearizer::collectPages(const PdfObject& node)
+{
+    // Guard against cycles in the page tree
+    if (!m_pageTree.insert(&node).second)
+        return;
+
+    auto& dict = node.GetDictionary();
+    const PdfName* type;
+    if (dict.TryFindKeyAs("Type", type) && *type == "Page")
+    {
+        m_pages.push_back(&node);
+        return;
+    }
+
+    auto kids = dict.FindKey("Kids");
+    if (kids == nullptr || !kids->IsArray())
+        return;
+
+    PdfReference ref;
+    for (auto& kid : kids->GetArray())
+    {
+        if (!kid.TryGetReference(ref))
+            continue;
+
+        auto kidObj = m_objects->GetObject(ref);
+        if (kidObj != nullptr && kidObj->IsDictionary())
+            collectPages(*kidObj);
+    }
+}
+
+void PdfLinearizer::collectObjects()
+{
+    // The document level objects, see ISO 32000-2:2020 F.3.4
+    m_documentObjects.push_back(m_catalog);
+    auto encryptObj = m_writer->GetEncryptObj();
+    if (encryptObj != nullptr)
+        m_documentObjects.push_back(encryptObj);
+
+    ObjectSet visited(m_documentObjects.begin(), m_documentObjects.end());
+    auto& catalogDict = m_catalog->GetDictionary();
+    for (auto key : { "ViewerPreferences"_n, "Threads"_n, "OpenAction"_n, "AcroForm"_n })
+    {
+        auto value = catalogDict.GetKey(key);
+        if (value != nullptr)
+            collectReachable(*value, m_documentObjects, visited);
+    }
+    m_documentSet.insert(m_documentObjects.begin(), m_documentObjects.end());
+
+    // The objects used by the first page all go in the first page
+    // section. The objects used by other pages go in the section of
+    // the page if the page is the only one using them, or in the
+    // shared objects section otherwise
+    vector<vector<const PdfObject*>> pageObjects(m_pages.size());
+    unordered_map<const PdfObject*, unsigned> pageCounts;
+    for (size_t i = 0; i < m_pages.size(); i++)
+    {
+        collectPageObjects(*m_pages[i], pageObjects[i]);
+        if (i == 0)
+            continue;
+
+        for (auto obj : pageObjects[i])
+            pageCounts[obj]++;
+    }
+
+    // Map of the objects to their index in the shared object hint table,
+    // where the objects of the first page come first
+    unordered_map<const PdfObject*, unsigned> sharedIndices;
+    m_pageSections.resize(m_pages.size());
+    m_pageSections[0].Objects = std::move(pageObjects[0]);
+    for (auto obj : m_pageSections[0].Objects)
+        sharedIndices[obj] = (unsigned)sharedIndices.size();
+
+    for (size_t i = 1; i < m_pages.size(); i++)
+    {
+        auto& section = m_pageSections[i];
+        for (auto obj : pageObjects[i])
+        {
+            auto found = sharedIndices.find(obj);
+            if (found != sharedIndices.end())
+            {
+                section.SharedObjects.push_back(found->second);
+            }
+            else if (pageCounts[obj] == 1)
+            {
+                section.Objects.push_back(obj);
+            }
+            else
+            {
+                unsigned index = (unsigned)sharedIndices.size();
+                sharedIndices[obj] = index;
+                m_sharedObjects.push_back(obj);
+                section.SharedObjects.push_back(index);
+            }
+        }
+    }
+
+    // All the remaining objects, as the page tree nodes, the
+    // outlines and the document information dictionary
+    for (auto obj : *m_objects)
+    {
+        if (m_documentSet.find(obj) != m_documentSet.end()
+            || sharedIndices.find(obj) != sharedIndices.end()
+            || pageCounts.find(obj) != pageCounts.end())
+        {
+            continue;
+        }
+
+        // Skip the linearization dictionary of a loaded linearized
+        // document and the object streams of a loaded document,
+        // whose objects are written uncompressed
+        const PdfDictionary* dict;
+        const PdfName* type;
+        if (obj->TryGetDictionary(dict) && (dict->HasKey("Linearized")
+            || (dict->TryFindKeyAs("Type", type) && *type == "ObjStm")))
+        {
+            continue;
+        }
+
+        m_otherObjects.push_back(obj);
+    }
+}
+
+void PdfLinearizer::collectReachable(const PdfObject& obj, vector<const PdfObject*>& objects, ObjectSet& visited) const
+{
+    vector<const PdfObject*> stack = { &obj };
+    while (stack.size() != 0)
+    {
+        auto curr = stack.back();
+        stack.pop_back();
+        switch (curr->GetDataType())
+        {
+            case PdfDataType::Reference:
+            {
+                // Don't cross the page tree and the document level objects
+                auto child = m_objects->GetObject(curr->GetReference());
+                if (child == nullptr
+                    || m_pageTree.find(child) != m_pageTree.end()
+                    || m_documentSet.find(child) != m_documentSet.end()
+                    || !visited.insert(child).second)
+                {
+                    break;
+                }
+
+                objects.push_back(child);
+                stack.push_back(child);
+                break;
+            }
+            case PdfDataType::Array:
+            {
+                for (auto& child : curr->GetArray())
+                    stack.push_back(&child);
+                break;
+            }
+            case PdfDataType::Dictionary:
+            {
+                for (auto& pair : curr->GetDictionary())
+                    stack.push_back(&pair.second);
+                break;
+            }
+            default:
+            {
+                // Nothing to do
+                break;
+            }
+        }
+    }
+}
+
+void PdfLinearizer::collectPageObjects(const PdfObject& page, vector<const PdfObject*>& objects) const
+{
+    objects.push_back(&page);
+    ObjectSet visited;
+    collectReachable(page, objects, visited);
+
+    // Also collect the attributes inherited from the page
+    // tree nodes, see ISO 32000-2:2020 7.7.3.4
+    ObjectSet nodes;
+    auto parent = page.GetDictionary().FindKey("Parent");
+    while (parent != nullptr && parent->IsDictionary() && nodes.insert(parent).second)
+    {
+        auto& dict = parent->GetDictionary();
+        for (auto key : { "Resources"_n, "MediaBox"_n, "CropBox"_n, "Rotate"_n })
+        {
+            auto value = dict.GetKey(key);
+            if (value != nullptr)
+                collectReachable(*value, objects, visited);
+        }
+
+        parent = dict.FindKey("Parent");
+    }
+}
+
+void PdfLinearizer::numberObjects()
+{
+    // The objects after the first page section are numbered first,
+    // so the first page cross-reference section lists the highest
+    // numbers, see ISO 32000-2:2020 F.3.3
+    uint32_t number = 1;
+    auto assign = [&](const vector<const PdfObject*>& objects) {
+        for (auto obj : objects)
+            m_numbers[obj->GetIndirectReference()] = number++;
+    };
+
+    for (size_t i = 1; i < m_pageSections.size(); i++)
+        assign(m_pageSections[i].Objects);
+    assign(m_sharedObjects);
+    assign(m_otherObjects);
+
+    // The linearization dictionary is the first object of the file
+    m_FirstPageSectionNumber = number++;
+    assign(m_documentObjects);
+    m_HintStreamNumber = number++;
+    assign(m_pageSections[0].Objects);
+    m_Size = number;
+}
+
+void PdfLinearizer::measureObjects(const vector<const PdfObject*>& objects, vector<size_t>& lengths)
+{
+    NullStreamDevice device;
+    lengths.reserve(objects.size());
+    for (auto obj : objects)
+    {
+        size_t offset = device.GetPosition();
+        writeObject(device, *obj);
+        lengths.push_back(device.GetPosition() - offset);
+    }
+}
+
+void PdfLinearizer::writeObjects(OutputStream& stream, const vector<const PdfObject*>& objects)
+{
+    for (auto obj : objects)
+        writeObject(stream, *obj);
+}
+
+void PdfLinearizer::writeObject(OutputStream& stream, const PdfObject& obj)
+{
+    PdfReference ref(m_numbers.at(obj.GetIndirectReference()), 0);
+    auto writeFlags = m_writer->GetWriteFlags();
+    // The /Metadata object must be unfiltered as per PDF/A
+    if (&obj == m_metadata)
+        writeFlags |= PdfWriteFlags::NoFlateCompress;
+
+    unique_ptr<PdfStatefulEncrypt> encrypt;
+    auto encryptSession = m_writer->GetEncrypt();
+    if (encryptSession != nullptr && &obj != m_writer->GetEncryptObj())
+        encrypt.reset(new PdfStatefulEncrypt(encryptSession->GetEncrypt(), encryptSession->GetContext(), ref));
+
+    // Write the object with the new number in place, as
+    // PdfObject::WriteFinal would do with its own number.
+    // NOTE: The stream is compressed when the object is first
+    // measured, so it has the same length when it's written
+    PdfObject::WriteHeader(stream, ref, writeFlags, m_writer->m_buffer);
+    obj.DelayedLoadStream();
+    if (obj.m_Stream != nullptr)
+        obj.PrepareStreamWrite(false, writeFlags, encrypt.get());
+
+    writeRemapped(stream, obj, writeFlags, encrypt.get());
+    stream.Write('\n');
+    if (obj.m_Stream != nullptr)
+        obj.m_Stream->Write(stream, encrypt.get());
+
+    stream.Write("endobj\n");
+}
+
+void PdfLinearizer::writeRemapped(OutputStream& stream, const PdfObject& obj, PdfWriteFlags writeMode,
+    const PdfStatefulEncrypt* encrypt)
+{
+    // Write the object as PdfVariant::Write does, but with the references
+    // remapped to the new object numbers, so the document is not modified
+    auto& buffer = m_writer->m_buffer;
+    bool clean = (writeMode & PdfWriteFlags::Clean) == PdfWriteFlags::Clean;
+    switch (obj.GetDataType())
+    {
+        case PdfDataType::Reference:
+        {
+            // References to missing objects are equivalent to null
+            auto found = m_numbers.find(obj.GetReference());
+            if (found == m_numbers.end())
+                PdfObject::Null.GetVariant().Write(stream, writeMode, encrypt, buffer);
+            else
+                PdfReference(found->second, 0).Write(stream, writeMode, encrypt, buffer);
+            break;
+        }
+        case PdfDataType::Array:
+        {
+            // See PdfArray::write
+            stream.Write(clean ? "[ " : "[");
+            unsigned count = 1;
+            for (auto& child : obj.GetArray())
+            {
+                writeRemapped(stream, child, writeMode, encrypt);
+                if (clean)
+                    stream.Write((count % 10 == 0) ? '\n' : ' ');
+                count++;
+            }
+            stream.Write(']');
+            break;
+        }
+        case PdfDataType::Dictionary:
+        {
+            // See PdfDictionary::write. Type has
+            // to be the first key in any dictionary
+            auto& dict = obj.GetDictionary();
+            stream.Write(clean ? "<<\n" : "<<");
+            auto type = dict.GetKey("Type");
+            if (type != nullptr)
+            {
+                stream.Write(clean ? "/Type " : "/Type");
+                writeRemapped(stream, *type, writeMode, encrypt);
+                if (clean)
+                    stream.Write('\n');
+            }
+
+            for (auto& pair : dict)
+            {
+                if (pair.first == "Type")
+                    continue;
+
+                pair.first.Write(stream, writeMode, encrypt, buffer);
+                if (clean)
+                    stream.Write(' ');
+
+                writeRemapped(stream, pair.second, writeMode, encrypt);
+                if (clean)
+                    stream.Write('\n');
+            }
+            stream.Write(">>");
+            break;
+        }
+        case PdfDataType::String:
+        {
+            // Encrypted literal strings have a varying number of escaped
+            // characters, so they are written as hexadecimal strings
+            // to have the same length when measured and when written
+            obj.GetString().write(stream, writeMode, encrypt, encrypt != nullptr || obj.GetString().IsHex());
+            break;
+        }
+        default:
+        {
+            obj.GetVariant().Write(stream, writeMode, encrypt, buffer);
+            break;
+        }
+    }
+}
+
+PdfLinearizer::Layout PdfLinearizer::computeLayout(size_t offset) const
+{
+    Layout layout;
+    layout.DocumentOffset = offset;
+    offset += getLength(m_documentLengths);
+    layout.FirstPageOffset = offset;
+    layout.PageOffsets.reserve(m_pageLengths.size());
+    for (size_t i = 0; i < m_pageLengths.size(); i++)
+    {
+        layout.PageOffsets.push_back(offset);
+        offset += getLength(m_pageLengths[i]);
+        if (i == 0)
+            layout.FirstPageEnd = offset;
+    }
+
+    layout.SharedOffset = offset;
+    offset += getLength(m_sharedLengths);
+    layout.OtherOffset = offset;
+    offset += getLength(m_otherLengths);
+    layout.MainXRefOffset = offset;
+    return layout;
+}
+
+charbuff PdfLinearizer::createHintStream(const Layout& layout)
+{
+    // NOTE: All the offsets in the hint tables are computed as
+    // if the primary hint stream was not present, see ISO 32000-2:2020 F.4
+    charbuff data;
+    BitWriter writer(data);
+
+    // Page offset hint table, see ISO 32000-2:2020 F.4.2
+    size_t pageCount = m_pageSections.size();
+    vector<size_t> pageLengths(pageCount);
+    size_t minObjectCount = numeric_limits<size_t>::max();
+    size_t maxObjectCount = 0;
+    size_t minPageLength = numeric_limits<size_t>::max();
+    size_t maxPageLength = 0;
+    size_t maxSharedCount = 0;
+    unsigned maxSharedIndex = 0;
+    for (size_t i = 0; i < pageCount; i++)
+    {
+        auto& section = m_pageSections[i];
+        pageLengths[i] = (i + 1 == pageCount ? layout.SharedOffset : layout.PageOffsets[i + 1]) - layout.PageOffsets[i];
+        minObjectCount = std::min(minObjectCount, section.Objects.size());
+        maxObjectCount = std::max(maxObjectCount, section.Objects.size());
+        minPageLength = std::min(minPageLength, pageLengths[i]);
+        maxPageLength = std::max(maxPageLength, pageLengths[i]);
+        maxSharedCount = std::max(maxSharedCount, section.SharedObjects.size());
+        for (unsigned index : section.SharedObjects)
+            maxSharedIndex = std::max(maxSharedIndex, index);
+    }
+
+    unsigned objectCountBits = getBitCount(maxObjectCount - minObjectCount);
+    unsigned pageLengthBits = getBitCount(maxPageLength - minPageLength);
+    unsigned sharedCountBits = getBitCount(maxSharedCount);
+    unsigned sharedIndexBits = getBitCount(maxSharedIndex);
+
+    writer.Write(minObjectCount, 32);
+    writer.Write(layout.FirstPageOffset, 32);
+    writer.Write(objectCountBits, 16);
+    writer.Write(minPageLength, 32);
+    writer.Write(pageLengthBits, 16);
+    // The content streams are described as spanning the whole
+    // page section, as most writers do
+    writer.Write(0, 32);
+    writer.Write(0, 16);
+    writer.Write(minPageLength, 32);
+    writer.Write(pageLengthBits, 16);
+    writer.Write(sharedCountBits, 16);
+    writer.Write(sharedIndexBits, 16);
+    // No fractional positions of the shared object references
+    writer.Write(0, 16);
+    writer.Write(1, 16);
+
+    // Each item of the per-page entries is written
+    // for all the pages and starts on a byte boundary
+    for (size_t i = 0; i < pageCount; i++)
+        writer.Write(m_pageSections[i].Objects.size() - minObjectCount, objectCountBits);
+    writer.Flush();
+    for (size_t i = 0; i < pageCount; i++)
+        writer.Write(pageLengths[i] - minPageLength, pageLengthBits);
+    writer.Flush();
+    for (size_t i = 0; i < pageCount; i++)
+        writer.Write(m_pageSections[i].SharedObjects.size(), sharedCountBits);
+    writer.Flush();
+    for (size_t i = 0; i < pageCount; i++)
+    {
+        for (unsigned index : m_pageSections[i].SharedObjects)
+            writer.Write(index, sharedIndexBits);
+    }
+    writer.Flush();
+    for (size_t i = 0; i < pageCount; i++)
+        writer.Write(pageLengths[i] - minPageLength, pageLengthBits);
+    writer.Flush();
+
+    // Shared object hint table, see ISO 32000-2:2020 F.4.3.
+    // Each object of the first page section and of the shared
+    // objects section makes its own group
+    size_t sharedTableOffset = data.size();
+    auto& firstPageLengths = m_pageLengths[0];
+    size_t minGroupLength = numeric_limits<size_t>::max();
+    size_t maxGroupLength = 0;
+    for (auto lengths : { &firstPageLengths, &m_sharedLengths })
+    {
+        for (size_t length : *lengths)
+        {
+            minGroupLength = std::min(minGroupLength, length);
+            maxGroupLength = std::max(maxGroupLength, length);
+        }
+    }
+    unsigned groupLengthBits = getBitCount(maxGroupLength - minGroupLength);
+
+    if (m_sharedObjects.size() == 0)
+    {
+        writer.Write(0, 32);
+        writer.Write(0, 32);
+    }
+    else
+    {
+        writer.Write(m_numbers.at(m_sharedObjects[0]->GetIndirectReference()), 32);
+        writer.Write(layout.SharedOffset, 32);
+    }
+    writer.Write(firstPageLengths.size(), 32);
+    writer.Write(firstPageLengths.size() + m_sharedLengths.size(), 32);
+    writer.Write(0, 16);
+    writer.Write(minGroupLength, 32);
+    writer.Write(groupLengthBits, 16);
+
+    for (auto lengths : { &firstPageLengths, &m_sharedLengths })
+    {
+        for (size_t length : *lengths)
+            writer.Write(length - minGroupLength, groupLengthBits);
+    }
+    writer.Flush();
+    // No MD5 signatures of the groups
+    for (size_t i = 0; i < firstPageLengths.size() + m_sharedLengths.size(); i++)
+        writer.Write(0, 1);
+    writer.Flush();
+
+    PdfObject hintStream;
+    PdfReference ref(m_HintStreamNumber, 0);
+    hintStream.SetIndirectReference(ref);
+    hintStream.GetDictionary().AddKey("S"_n, static_cast<int64_t>(sharedTableOffset));
+    {
+        auto output = hintStream.GetOrCreateStream().GetOutputStream();
+        output.Write(data);
+    }
+
+    unique_ptr<PdfStatefulEncrypt> encrypt;
+    auto encryptSession = m_writer->GetEncrypt();
+    if (encryptSession != nullptr)
+        encrypt.reset(new PdfStatefulEncrypt(encryptSession->GetEncrypt(), encryptSession->GetContext(), ref));
+
+    charbuff ret;
+    BufferStreamDevice device(ret);
+    hintStream.WriteFinal(device, m_writer->GetWriteFlags(), encrypt.get(), m_writer->m_buffer);
+    return ret;
+}
+
+charbuff PdfLinearizer::formatLinearizationDict(size_t fileLength, size_t hintOffset, size_t hintLength,
+    size_t firstPageEnd, size_t mainXRefEntriesOffset, size_t padding) const
+{
+    // See ISO 32000-2:2020 F.3.3 "Linearization parameter dictionary"
+    charbuff ret;
+    utls::FormatTo(ret, "{} 0 obj\n<</Linearized 1/L {}/H[{} {}]/O {}/E {}/N {}/T {}>>{}\nendobj\n",
+        m_FirstPageSectionNumber, fileLength, hintOffset, hintLength,
+        m_numbers.at(m_pages[0]->GetIndirectReference()), firstPageEnd, m_pages.size(),
+        mainXRefEntriesOffset, string(padding, ' '));
+    return ret;
+}
+
+charbuff PdfLinearizer::formatFirstPageXRef(size_t linearizationDictOffset, const Layout& layout, size_t hintLength) const
+{
+    // The first page cross-reference section lists the linearization
+    // dictionary, the document level objects, the primary hint stream
+    // and the objects of the first page
+    charbuff ret;
+    charbuff buffer;
+    utls::FormatTo(ret, "xref\n{} {}\n", m_FirstPageSectionNumber, m_Size - m_FirstPageSectionNumber);
+    auto appendEntry = [&](size_t offset) {
+        utls::FormatTo(buffer, "{:010d} 00000 n \n", offset);
+        ret.append(buffer);
+    };
+
+    appendEntry(linearizationDictOffset);
+    size_t offset = layout.DocumentOffset;
+    for (size_t length : m_documentLengths)
+    {
+        appendEntry(offset);
+        offset += length;
+    }
+
+    appendEntry(layout.FirstPageOffset);
+    offset = layout.FirstPageOffset + hintLength;
+    for (size_t length : m_pageLengths[0])
+    {
+        appendEntry(offset);
+        offset += length;
+    }
+
+    return ret;
+}
+
+charbuff PdfLinearizer::formatFirstPageTrailer(size_t mainXRefOffset)
+{
+    PdfObject trailer;
+    m_writer->FillTrailerObject(trailer, m_Size, false);
+    trailer.GetDictionary().AddKey("Prev"_n, static_cast<int64_t>(mainXRefOffset));
+
+    charbuff ret;
+    BufferStreamDevice device(ret);
+    device.Write("trailer\n");
+    // NOTE: Do not encrypt the trailer dictionary
+    writeRemapped(device, trailer, m_writer->GetWriteFlags(), nullptr);
+    device.Write('\n');
+    // The startxref of the first page trailer is ignored by readers
+    device.Write("startxref\n0\n%%EOF\n");
+    return ret;
+}
+
+charbuff PdfLinearizer::formatMainXRef(const Layout& layout, size_t hintLength) const
+{
+    charbuff ret;
+    charbuff buffer;
+    utls::FormatTo(ret, "xref\n0 {}\n", m_FirstPageSectionNumber);
+    ret.append("0000000000 65535 f \n");
+
+    size_t offset = layout.PageOffsets.size() > 1 ? layout.PageOffsets[1] : layout.SharedOffset;
+    offset += hintLength;
+    auto appendEntries = [&](const vector<size_t>& lengths) {
+        for (size_t length : lengths)
+        {
+            utls::FormatTo(buffer, "{:010d} 00000 n \n", offset);
+            ret.append(buffer);
+            offset += length;
+        }
+    };
+
+    for (size_t i = 1; i < m_pageLengths.size(); i++)
+        appendEntries(m_pageLengths[i]);
+    appendEntries(m_sharedLengths);
+    appendEntries(m_otherLengths);
+    return ret;
+}
+
+unsigned getBitCount(uint64_t value)
+{
+    unsigned ret = 0;
+    while (value != 0)
+    {
+        ret++;
+        value >>= 1;
+    }
+    return ret;
+}
+
+size_t getLength(const vector<size_t>& lengths)
+{
+    size_t ret = 0;
+    for (size_t length : lengths)
+        ret += length;
+    return ret;
+}
@@ -0,0 +1,112 @@
+/**
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#ifndef PDF_LINEARIZER_H
+#define PDF_LINEARIZER_H
+
+#include <unordered_map>
+#include <unordered_set>
+
+#include "PdfWriter.h"
+
+namespace PoDoFo {
+
+/** Writes a linearized ("Fast Web View") PDF file, as described
+ * in ISO 32000-2:2020 Annex F
+ *
+ * The objects are renumbered and reordered so the first page and
+ * the objects it uses come first in the file, preceded by the
+ * linearization dictionary, the first-page cross-reference table,
+ * the document catalog and the primary hint stream. The remaining
+ * pages follow, each with its private objects, then the objects
+ * shared by more pages and finally all the other objects.
+ *
+ * The objects are written twice: first only to measure their
+ * lengths, which determine all the offsets, then to the device.
+ *
+ * This is an internal class of PoDoFo used by PdfWriter.
+ */
+class PdfLinearizer final
+{
+public:
+    PdfLinearizer(PdfWriter& writer);
+
+    void Write(OutputStreamDevice& device);
+
+private:
+    using ObjectSet = std::unordered_set<const PdfObject*>;
+
+    struct PageSection
+    {
+        // The page object followed by the objects used only by the page
+        std::vector<const PdfObject*> Objects;
+        // Indices in the shared object hint table of the objects used
+        // by the page that are in the first page section or in the
+        // shared objects section
+        std::vector<unsigned> SharedObjects;
+    };
+
+    // The layout of the objects, computed as if the
+    // primary hint stream was not present
+    struct Layout
+    {
+        size_t DocumentOffset;
+        size_t FirstPageOffset;
+        size_t FirstPageEnd;
+        std::vector<size_t> PageOffsets;
+        size_t SharedOffset;
+        size_t OtherOffset;
+        size_t MainXRefOffset;
+    };
+
+private:
+    void collectPages(const PdfObject& node);
+    void collectObjects();
+    void collectReachable(const PdfObject& obj, std::vector<const PdfObject*>& objects, ObjectSet& visited) const;
+    void collectPageObjects(const PdfObject& page, std::vector<const PdfObject*>& objects) const;
+    void numberObjects();
+    void measureObjects(const std::vector<const PdfObject*>& objects, std::vector<size_t>& lengths);
+    void writeObjects(OutputStream& stream, const std::vector<const PdfObject*>& objects);
+    void writeObject(OutputStream& stream, const PdfObject& obj);
+    void writeRemapped(OutputStream& stream, const PdfObject& obj, PdfWriteFlags writeMode,
+        const PdfStatefulEncrypt* encrypt);
+    Layout computeLayout(size_t offset) const;
+    charbuff createHintStream(const Layout& layout);
+    charbuff formatLinearizationDict(size_t fileLength, size_t hintOffset, size_t hintLength,
+        size_t firstPageEnd, size_t mainXRefEntriesOffset, size_t padding) const;
+    charbuff formatFirstPageXRef(size_t linearizationDictOffset, const Layout& layout, size_t hintLength) const;
+    charbuff formatFirstPageTrailer(size_t mainXRefOffset);
+    charbuff formatMainXRef(const Layout& layout, size_t hintLength) const;
+
+private:
+    PdfWriter* m_writer;
+    PdfIndirectObjectList* m_objects;
+    const PdfObject* m_catalog;
+    const PdfObject* m_metadata;
+    std::vector<const PdfObject*> m_pages;
+    // Page tree nodes and pages, that are not crossed
+    // when collecting the objects used by a page
+    ObjectSet m_pageTree;
+    // Catalog, encryption dictionary and other document level objects
+    std::vector<const PdfObject*> m_documentObjects;
+    ObjectSet m_documentSet;
+    // The sections of all the pages. The section of
+    // the first page is the first page section
+    std::vector<PageSection> m_pageSections;
+    std::vector<const PdfObject*> m_sharedObjects;
+    std::vector<const PdfObject*> m_otherObjects;
+    std::unordered_map<PdfReference, uint32_t> m_numbers;
+    // The written lengths of the objects, measured before writing them
+    std::vector<size_t> m_documentLengths;
+    std::vector<std::vector<size_t>> m_pageLengths;
+    std::vector<size_t> m_sharedLengths;
+    std::vector<size_t> m_otherLengths;
+    uint32_t m_FirstPageSectionNumber;
+    uint32_t m_HintStreamNumber;
+    uint32_t m_Size;
+};
+
+};
+
+#endif // PDF_LINEARIZER_H
@@ -0,0 +1,60 @@
+/**
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#include "PdfDeclarationsPrivate.h"
+#include "PdfObjectHashing.h"
+
+#include <podofo/main/PdfObjectStream.h>
+
+using namespace std;
+using namespace PoDoFo;
+
+void utls::HashStream(const PdfObject& obj, MurmurHash3& hasher)
+{
+    // Hash the raw data, that is equal if the
+    // filters in the dictionary are also equal
+    hasher.Update((unsigned char)'S');
+    auto input = obj.GetStream()->GetInputStream(true);
+    charbuff buffer(StreamChunkSize);
+    uint64_t length = 0;
+    bool eof;
+    do
+    {
+        size_t read = input.Read(buffer.data(), buffer.size(), eof);
+        hasher.Update(buffer.data(), read);
+        length += read;
+    } while (!eof);
+
+    hasher.Update(length);
+}
+
+bool utls::EqualStream(const PdfObject& lhs, const PdfObject& rhs)
+{
+    if (lhs.HasStream() != rhs.HasStream())
+        return false;
+
+    if (!lhs.HasStream())
+        return true;
+
+    auto& lhsStream = *lhs.GetStream();
+    auto& rhsStream = *rhs.GetStream();
+    if (lhsStream.GetLength() != rhsStream.GetLength())
+        return false;
+
+    auto lhsInput = lhsStream.GetInputStream(true);
+    auto rhsInput = rhsStream.GetInputStream(true);
+    charbuff lhsBuffer(StreamChunkSize);
+    charbuff rhsBuffer(StreamChunkSize);
+    bool lhsEof;
+    bool rhsEof;
+    do
+    {
+        size_t lhsRead = lhsInput.Read(lhsBuffer.data(), lhsBuffer.size(), lhsEof);
+        size_t rhsRead = rhsInput.Read(rhsBuffer.data(), rhsBuffer.size(), rhsEof);
+        if (lhsRead != rhsRead || std::memcmp(lhsBuffer.data(), rhsBuffer.data(), lhsRead) != 0)
+            return false;
+    } while (!lhsEof && !rhsEof);
+
+    return lhsEof == rhsEof;
+}
@@ -0,0 +1,155 @@
+/**
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#ifndef PDF_OBJECT_HASHING_H
+#define PDF_OBJECT_HASHING_H
+
+#include <cstring>
+
+#include <podofo/main/PdfArray.h>
+#include <podofo/main/PdfDictionary.h>
+
+#include "MurmurHash3.h"
+
+namespace utls
+{
+    /** The size of the chunks used to read the raw stream data
+     */
+    constexpr size_t StreamChunkSize = 65536;
+
+    /** Hash the raw stream data of the object, read in chunks
+     */
+    void HashStream(const PoDoFo::PdfObject& obj, PoDoFo::MurmurHash3& hasher);
+
+    /** Compare the raw stream data of the objects, read in chunks
+     * \returns true if both objects have no stream or the streams are equal
+     */
+    bool EqualStream(const PoDoFo::PdfObject& lhs, const PoDoFo::PdfObject& rhs);
+
+    /** Hash the direct content of the object
+     * \param hashReference called as hashReference(ref, hasher) to
+     *     hash the references, after their data type
+     */
+    template <typename THashReference>
+    void HashDirect(const PoDoFo::PdfObject& obj, PoDoFo::MurmurHash3& hasher, const THashReference& hashReference)
+    {
+        using namespace PoDoFo;
+        auto type = obj.GetDataType();
+        hasher.Update((unsigned char)type);
+        switch (type)
+        {
+            case PdfDataType::Bool:
+                hasher.Update((unsigned char)obj.GetBool());
+                break;
+            case PdfDataType::Number:
+                hasher.Update((uint64_t)obj.GetNumber());
+                break;
+            case PdfDataType::Real:
+            {
+                double real = obj.GetReal();
+                uint64_t bits;
+                std::memcpy(&bits, &real, sizeof(bits));
+                hasher.Update(bits);
+                break;
+            }
+            case PdfDataType::String:
+                hasher.Update(obj.GetString().GetString());
+                break;
+            case PdfDataType::Name:
+                hasher.Update(obj.GetName().GetString());
+                break;
+            case PdfDataType::Array:
+            {
+                auto& arr = obj.GetArray();
+                hasher.Update((uint64_t)arr.GetSize());
+                for (auto& child : arr)
+                    HashDirect(child, hasher, hashReference);
+                break;
+            }
+            case PdfDataType::Dictionary:
+            {
+                // NOTE: Entries are iterated in ascending key order
+                auto& dict = obj.GetDictionary();
+                hasher.Update((uint64_t)dict.GetSize());
+                for (auto& pair : dict)
+                {
+                    hasher.Update(pair.first.GetString());
+                    HashDirect(pair.second, hasher, hashReference);
+                }
+                break;
+            }
+            case PdfDataType::Reference:
+                hashReference(obj.GetReference(), hasher);
+                break;
+            default:
+                break;
+        }
+    }
+
+    /** Compare the direct content of the objects
+     * \param equalReference called as equalReference(lhs, rhs) to
+     *     compare the objects when any of them is a reference
+     */
+    template <typename TEqualReference>
+    bool EqualDirect(const PoDoFo::PdfObject& lhs, const PoDoFo::PdfObject& rhs, const TEqualReference& equalReference)
+    {
+        using namespace PoDoFo;
+        if (lhs.IsReference() || rhs.IsReference())
+            return equalReference(lhs, rhs);
+
+        auto type = lhs.GetDataType();
+        if (type != rhs.GetDataType())
+            return false;
+
+        switch (type)
+        {
+            case PdfDataType::Null:
+                return true;
+            case PdfDataType::Bool:
+                return lhs.GetBool() == rhs.GetBool();
+            case PdfDataType::Number:
+                return lhs.GetNumber() == rhs.GetNumber();
+            case PdfDataType::Real:
+                return lhs.GetReal() == rhs.GetReal();
+            case PdfDataType::String:
+                return lhs.GetString().GetString() == rhs.GetString().GetString();
+            case PdfDataType::Name:
+                return lhs.GetName() == rhs.GetName();
+            case PdfDataType::Array:
+            {
+                auto& lhsArr = lhs.GetArray();
+                auto& rhsArr = rhs.GetArray();
+                if (lhsArr.GetSize() != rhsArr.GetSize())
+                    return false;
+
+                for (unsigned i = 0; i < lhsArr.GetSize(); i++)
+                {
+                    if (!EqualDirect(lhsArr[i], rhsArr[i], equalReference))
+                        return false;
+                }
+
+                return true;
+            }
+            case PdfDataType::Dictionary:
+            {
+                auto& lhsDict = lhs.GetDictionary();
+                auto& rhsDict = rhs.GetDictionary();
+                if (lhsDict.GetSize() != rhsDict.GetSize())
+                    return false;
+
+                for (auto lhsIt = lhsDict.begin(), rhsIt = rhsDict.begin(); lhsIt != lhsDict.end(); lhsIt++, rhsIt++)
+                {
+                    if (lhsIt->first != rhsIt->first || !EqualDirect(lhsIt->second, rhsIt->second, equalReference))
+                        return false;
+                }
+
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+}
+
+#endif // PDF_OBJECT_HASHING_H
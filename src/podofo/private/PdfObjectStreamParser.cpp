@@ -17,71 +17,255 @@ using namespace std;
 using namespace PoDoFo;
 
 PdfObjectStreamParser::PdfObjectStreamParser(PdfParserObject& parser,
-        PdfIndirectObjectList& objects, const shared_ptr<charbuff>& buffer)
-    : m_Parser(&parser), m_Objects(&objects), m_buffer(buffer)
+        PdfIndirectObjectList& objects, const shared_ptr<charbuff>& buffer,
+        const shared_ptr<PdfObjectStreamCache>& cache)
+    : m_StreamReference(parser.GetIndirectReference()), m_Objects(&objects), m_buffer(buffer),
+    m_cache(cache), m_PendingCount(0), m_Loaded(false)
 {
     if (buffer == nullptr)
         PODOFO_RAISE_ERROR(PdfErrorCode::InvalidHandle);
 }
 
+PdfObjectStreamParser::~PdfObjectStreamParser()
+{
+    if (m_cache != nullptr)
+        m_cache->Remove(*this);
+}
+
 void PdfObjectStreamParser::Parse(const cspan<int64_t>& objectList)
 {
-    int64_t num = m_Parser->GetDictionary().FindKeyAsSafe<int64_t>("N", 0);
-    int64_t first = m_Parser->GetDictionary().FindKeyAsSafe<int64_t>("First", 0);
+    auto objects = Read(objectList);
+    for (auto& obj : objects)
+        m_Objects->PushObject(obj.release());
+}
+
+vector<unique_ptr<PdfObject>> PdfObjectStreamParser::Read(const cspan<int64_t>& objectList)
+{
+    ensureLoaded();
+
+    vector<int64_t> sortedList(objectList.begin(), objectList.end());
+    std::sort(sortedList.begin(), sortedList.end());
+
+    vector<unique_ptr<PdfObject>> ret;
+    PdfVariant var;
+    for (auto& pair : m_offsets)
+    {
+        bool shouldRead = std::binary_search(sortedList.begin(), sortedList.end(), (int64_t)pair.first);
+#ifndef VERBOSE_DEBUG_DISABLED
+        std::cerr << "ReadObjectsFromStream STREAM=" << m_StreamReference.ToString() <<
+            ", OBJ=" << pair.first <<
+            ", " << (shouldRead ? "read" : "skipped") << std::endl;
+#endif
+        if (!shouldRead)
+            continue;
+
+        readVariant(pair.second, var);
 
-    charbuff buffer;
-    m_Parser->GetOrCreateStream().CopyTo(buffer);
+        // The generation number of an object stream and of any
+        // compressed object is implicitly zero
+        PdfReference reference(pair.first, 0);
+        unique_ptr<PdfObject> obj(new PdfObject(std::move(var)));
+        obj->SetIndirectReference(reference);
+        ret.push_back(std::move(obj));
+    }
 
-    this->readObjectsFromStream(buffer.data(), buffer.size(), num, first, objectList);
-    m_Parser = nullptr;
+    Evict();
+    return ret;
 }
 
-void PdfObjectStreamParser::readObjectsFromStream(char* buffer, size_t bufferLen,
-    int64_t num, int64_t first, const cspan<int64_t>& objectList)
+void PdfObjectStreamParser::ReadObject(const PdfReference& reference, unsigned index, PdfVariant& variant)
 {
-    SpanStreamDevice device(buffer, bufferLen);
-    PdfTokenizer tokenizer(m_buffer);
-    PdfVariant var;
-    int i = 0;
+    ensureLoaded();
+    if (m_cache != nullptr)
+        m_cache->Touch(*this);
 
-    while (i < num)
+    // The XRef entry reports the index of the object in the stream,
+    // but some producers write it wrong: fallback to a search
+    size_t offset;
+    if (index < m_offsets.size() && m_offsets[index].first == reference.ObjectNumber())
+    {
+        offset = m_offsets[index].second;
+    }
+    else
+    {
+        auto found = std::find_if(m_offsets.begin(), m_offsets.end(),
+            [&](const pair<uint32_t, size_t>& pair) { return pair.first == reference.ObjectNumber(); });
+        if (found == m_offsets.end())
+        {
+            // Reference to a non-existent object should be treated as null
+            PoDoFo::LogMessage(PdfLogSeverity::Warning, "Object {} not found in object stream {}",
+                reference.ToString(), m_StreamReference.ToString());
+            variant = PdfVariant();
+            return;
+        }
+
+        offset = found->second;
+    }
+
+    readVariant(offset, variant);
+}
+
+void PdfObjectStreamParser::Evict()
+{
+    if (!m_Loaded)
+        return;
+
+    m_data = charbuff();
+    m_offsets = ObjectOffsets();
+    m_Loaded = false;
+    if (m_cache != nullptr)
+        m_cache->Remove(*this);
+}
+
+bool PdfObjectStreamParser::CanReadObjects() const
+{
+    return m_Objects->GetObject(m_StreamReference) != nullptr;
+}
+
+void PdfObjectStreamParser::AddPendingObject()
+{
+    m_PendingCount++;
+}
+
+void PdfObjectStreamParser::RemovePendingObject()
+{
+    PODOFO_ASSERT(m_PendingCount != 0);
+    m_PendingCount--;
+    if (m_PendingCount == 0)
+        Evict();
+}
+
+void PdfObjectStreamParser::ensureLoaded()
+{
+    if (m_Loaded)
+        return;
+
+    auto streamObj = m_Objects->GetObject(m_StreamReference);
+    if (streamObj == nullptr)
+    {
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidObject, "Loading of object stream {} failed!",
+            m_StreamReference.ToString());
+    }
+
+    int64_t num = streamObj->GetDictionary().FindKeyAsSafe<int64_t>("N", 0);
+    int64_t first = streamObj->GetDictionary().FindKeyAsSafe<int64_t>("First", 0);
+    if (num < 0 || first < 0)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::BrokenFile, "Invalid object stream /N or /First");
+
+    streamObj->GetOrCreateStream().CopyTo(m_data);
+
+    // Read the table of contents: pairs of object number and offset
+    SpanStreamDevice device(m_data.data(), m_data.size());
+    PdfTokenizer tokenizer(m_buffer);
+    m_offsets.reserve((size_t)std::min<int64_t>(num, m_data.size()));
+    for (int64_t i = 0; i < num; i++)
     {
         int64_t objNo = tokenizer.ReadNextNumber(device);
         int64_t offset = tokenizer.ReadNextNumber(device);
-        size_t pos = device.GetPosition();
-
-        if (first >= std::numeric_limits<int64_t>::max() - offset)
+        if (offset < 0 || first >= std::numeric_limits<int64_t>::max() - offset)
         {
             PODOFO_RAISE_ERROR_INFO(PdfErrorCode::BrokenFile,
                 "Object position out of max limit");
         }
 
-        // move to the position of the object in the stream
-        device.Seek(static_cast<size_t>(first + offset));
+        m_offsets.push_back({ static_cast<uint32_t>(objNo), static_cast<size_t>(first + offset) });
+    }
 
-        // use a second tokenizer here so that anything that gets dequeued isn't left in the tokenizer that reads the offsets and lengths
-        PdfTokenizer variantTokenizer(m_buffer);
-        variantTokenizer.ReadNextVariant(device, var); // NOTE: The stream is already decrypted
+    m_Loaded = true;
+}
 
-        bool shouldRead = std::find(objectList.begin(), objectList.end(), objNo) != objectList.end();
-#ifndef VERBOSE_DEBUG_DISABLED
-        std::cerr << "ReadObjectsFromStream STREAM=" << m_Parser->GetIndirectReference().ToString() <<
-            ", OBJ=" << objNo <<
-            ", " << (shouldRead ? "read" : "skipped") << std::endl;
-#endif
-        if (shouldRead)
-        {
-            // The generation number of an object stream and of any
-            // compressed object is implicitly zero
-            PdfReference reference(static_cast<uint32_t>(objNo), 0);
-            auto obj = new PdfObject(std::move(var));
-            obj->SetIndirectReference(reference);
-            m_Objects->PushObject(obj);
-        }
+void PdfObjectStreamParser::readVariant(size_t offset, PdfVariant& variant)
+{
+    SpanStreamDevice device(m_data.data(), m_data.size());
+
+    // move to the position of the object in the stream
+    device.Seek(offset);
+
+    PdfTokenizer tokenizer(m_buffer);
+    tokenizer.ReadNextVariant(device, variant); // NOTE: The stream is already decrypted
+}
+
+PdfObjectStreamCache::PdfObjectStreamCache(unsigned capacity)
+    : m_Capacity(capacity)
+{
+    if (capacity == 0)
+        PODOFO_RAISE_ERROR(PdfErrorCode::ValueOutOfRange);
+}
+
+void PdfObjectStreamCache::Touch(PdfObjectStreamParser& parser)
+{
+    auto found = std::find(m_streams.begin(), m_streams.end(), &parser);
+    if (found == m_streams.begin() && found != m_streams.end())
+        return;
+
+    if (found == m_streams.end())
+        m_streams.push_front(&parser);
+    else
+        m_streams.splice(m_streams.begin(), m_streams, found);
+
+    if (m_streams.size() > m_Capacity)
+    {
+        // NOTE: Evict() calls Remove() on this cache
+        m_streams.back()->Evict();
+    }
+}
+
+void PdfObjectStreamCache::Remove(PdfObjectStreamParser& parser)
+{
+    auto found = std::find(m_streams.begin(), m_streams.end(), &parser);
+    if (found != m_streams.end())
+        m_streams.erase(found);
+}
+
+PdfCompressedParserObject::PdfCompressedParserObject(const shared_ptr<PdfObjectStreamParser>& parser,
+    const PdfReference& indirectReference, unsigned index)
+    : PdfObject(PdfVariant()), m_parser(parser), m_Index(index), m_IsRevised(false)
+{
+    if (parser == nullptr)
+        PODOFO_RAISE_ERROR(PdfErrorCode::InvalidHandle);
+
+    SetIndirectReference(indirectReference);
+    EnableDelayedLoading();
+    m_parser->AddPendingObject();
+}
 
-        // move back to the position inside of the table of contents
-        device.Seek(pos);
+PdfCompressedParserObject::~PdfCompressedParserObject()
+{
+    if (!IsDelayedLoadDone())
+        m_parser->RemovePendingObject();
+}
 
-        i++;
+bool PdfCompressedParserObject::TryUnload()
+{
+    // NOTE: The object can't be read again if the
+    // object stream was removed from the document
+    if (!IsDelayedLoadDone() || m_IsRevised || !m_parser->CanReadObjects())
+        return false;
+
+    m_Variant = PdfVariant();
+    EnableDelayedLoading();
+    m_parser->AddPendingObject();
+    return true;
+}
+
+// Only called via the demand loading mechanism
+void PdfCompressedParserObject::delayedLoad()
+{
+    try
+    {
+        m_parser->ReadObject(GetIndirectReference(), m_Index, m_Variant);
     }
+    catch (PdfError& e)
+    {
+        PODOFO_PUSH_FRAME_INFO(e, "Error while loading compressed object {}",
+            GetIndirectReference().ToString());
+        throw;
+    }
+
+    m_parser->RemovePendingObject();
+}
+
+void PdfCompressedParserObject::SetRevised()
+{
+    m_IsRevised = true;
 }
@@ -9,10 +9,13 @@
 
 #include "PdfParserObject.h"
 
+#include <list>
+
 namespace PoDoFo {
 
 class PdfEncrypt;
 class PdfIndirectObjectList;
+class PdfObjectStreamCache;
 
 /**
  * A utility class for PdfParser that can parse
@@ -20,29 +23,121 @@ class PdfIndirectObjectList;
  *
  * It is mainly here to make PdfParser more modular.
  */
-class PdfObjectStreamParser
+class PdfObjectStreamParser final
 {
 public:
     /**
      * Create a new PdfObjectStreamParserObject from an existing
-     * PdfParserObject. The PdfParserObject will be removed and deleted.
-     * All objects from the object stream will be read into memory.
+     * PdfParserObject.
      *
      * \param parser PdfParserObject for an object stream
      * \param objects add loaded objects to this vector of objects
      * \param buffer use this allocated buffer for caching
+     * \param cache an optional cache that bounds how many object
+     *     streams keep their decoded data at the same time
      */
-    PdfObjectStreamParser(PdfParserObject& parser, PdfIndirectObjectList& objects, const std::shared_ptr<charbuff>& buffer);
+    PdfObjectStreamParser(PdfParserObject& parser, PdfIndirectObjectList& objects, const std::shared_ptr<charbuff>& buffer,
+        const std::shared_ptr<PdfObjectStreamCache>& cache = nullptr);
+
+    ~PdfObjectStreamParser();
 
+    /** Read all the objects in the list into memory
+     */
     void Parse(const cspan<int64_t>& objectList);
 
+    /** Read all the objects in the list without adding
+     * them to the object list
+     * \remarks It doesn't modify the object list, so it
+     * can be called concurrently on different object streams
+     */
+    std::vector<std::unique_ptr<PdfObject>> Read(const cspan<int64_t>& objectList);
+
+    /** Read a single object from the stream, decoding the
+     * stream if it's not already cached
+     * \param reference the reference of the compressed object
+     * \param index the index of the object in the stream, as reported by the XRef entry
+     */
+    void ReadObject(const PdfReference& reference, unsigned index, PdfVariant& variant);
+
+    /** Release the decoded stream data, if any
+     */
+    void Evict();
+
+    /** \returns true if the object stream is still in the object
+     * list, so its objects can be read again
+     */
+    bool CanReadObjects() const;
+
+    /** Signal that a demand loaded object has been materialized
+     * or unloaded. When all the objects of the stream have been
+     * materialized, the decoded data is released
+     */
+    void AddPendingObject();
+    void RemovePendingObject();
+
+private:
+    void ensureLoaded();
+    void readVariant(size_t offset, PdfVariant& variant);
+
 private:
-    void readObjectsFromStream(char* buffer, size_t lBufferLen, int64_t lNum, int64_t lFirst, const cspan<int64_t>& list);
+    using ObjectOffsets = std::vector<std::pair<uint32_t, size_t>>;
 
 private:
-    PdfParserObject* m_Parser;
+    PdfReference m_StreamReference;
     PdfIndirectObjectList* m_Objects;
     std::shared_ptr<charbuff> m_buffer;
+    std::shared_ptr<PdfObjectStreamCache> m_cache;
+    charbuff m_data;
+    ObjectOffsets m_offsets;
+    unsigned m_PendingCount;
+    bool m_Loaded;
+};
+
+/**
+ * Bounded LRU list of the object streams currently holding
+ * decoded data, shared by all the object streams of a document
+ */
+class PdfObjectStreamCache final
+{
+public:
+    PdfObjectStreamCache(unsigned capacity);
+
+    /** Mark the stream as the most recently used, evicting
+     * the least recently used one if over capacity
+     */
+    void Touch(PdfObjectStreamParser& parser);
+
+    void Remove(PdfObjectStreamParser& parser);
+
+private:
+    std::list<PdfObjectStreamParser*> m_streams;
+    unsigned m_Capacity;
+};
+
+/**
+ * An object compressed in an object stream, that is
+ * read from the stream only on first access
+ */
+class PdfCompressedParserObject final : public PdfObject
+{
+public:
+    PdfCompressedParserObject(const std::shared_ptr<PdfObjectStreamParser>& parser,
+        const PdfReference& indirectReference, unsigned index);
+
+    ~PdfCompressedParserObject();
+
+public:
+    bool TryUnload() override;
+
+protected:
+    void delayedLoad() override;
+
+    void SetRevised() override;
+
+private:
+    std::shared_ptr<PdfObjectStreamParser> m_parser;
+    unsigned m_Index;
+    bool m_IsRevised;
 };
 
 };
@@ -6,14 +6,20 @@
 
 #include "PdfDeclarationsPrivate.h"
 #include "PdfParser.h"
+#include "PdfArena.h"
 
 #include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
 #include <numerics/checked_math.h>
 
 #include <podofo/auxiliary/OutputDevice.h>
 #include <podofo/auxiliary/InputDevice.h>
+#include <podofo/auxiliary/StreamDevice.h>
 
 #include <podofo/main/PdfArray.h>
+#include <podofo/main/PdfCommon.h>
 #include <podofo/main/PdfDictionary.h>
 #include <podofo/main/PdfEncrypt.h>
 #include <podofo/main/PdfMemoryObjectStream.h>
@@ -25,20 +31,56 @@ constexpr unsigned PDF_MAGIC_LENGHT = 8;
 constexpr unsigned PDF_XREF_ENTRY_SIZE = 20;
 constexpr unsigned PDF_XREF_BUF = 512;
 constexpr unsigned MAX_XREF_SESSION_COUNT = 512;
+// Maximum number of object streams keeping their decoded data when demand loading
+constexpr unsigned OBJECT_STREAM_CACHE_SIZE = 16;
 
 using namespace std;
 using namespace PoDoFo;
 using namespace chromium::base;
 
+namespace
+{
+    // Markers searched by the xref rebuilding scan
+    enum class ScanMarker : uint8_t
+    {
+        Obj = 0,
+        Trailer,
+        Stream,
+        XRef,
+        ObjStm,
+        Catalog,
+    };
+
+    // An object header found by the xref rebuilding scan
+    struct ScannedObject final
+    {
+        uint32_t ObjectNumber = 0;
+        uint16_t Generation = 0;
+        size_t Offset = 0;          ///< Position of the object number
+        size_t DataOffset = 0;      ///< Position after the "obj" keyword
+        bool IsXRef = false;
+        bool IsObjStm = false;
+        bool IsCatalog = false;
+    };
+}
+
+static void scanDocument(const string_view& data, vector<ScannedObject>& objects, vector<size_t>& trailers);
+static bool tryReadObjectHeader(const string_view& data, size_t pos, ScannedObject& obj);
+static bool tryReadNumberBackward(const string_view& data, size_t& pos, unsigned maxDigits, uint64_t& value);
 static bool CheckEOL(char e1, char e2);
 static bool CheckXRefEntryType(char c);
 static bool ReadMagicWord(char ch, unsigned& cursoridx);
+template <typename TFunc>
+static void parallelFor(unsigned threadCount, PdfArena* arena, const bufferview& view, size_t count, const TFunc& func);
 
 PdfParser::PdfParser(PdfIndirectObjectList& objects) :
     m_buffer(std::make_shared<charbuff>(PdfTokenizer::BufferSize)),
     m_tokenizer(m_buffer),
     m_Objects(&objects),
-    m_StrictParsing(false)
+    m_StrictParsing(false),
+    m_ThreadCount(1),
+    m_RebuildBrokenXRef(false),
+    m_ReferenceStreamData(false)
 {
     this->reset();
 }
@@ -60,6 +102,15 @@ void PdfParser::reset()
 
     m_IgnoreBrokenObjects = true;
     m_IncrementalUpdateCount = 0;
+    m_objectStreams.clear();
+}
+
+void PdfParser::SetThreadCount(unsigned count)
+{
+    if (count == 0)
+        count = std::max(1u, std::thread::hardware_concurrency());
+
+    m_ThreadCount = count;
 }
 
 void PdfParser::Parse(InputStreamDevice& device, bool loadOnDemand)
@@ -67,14 +118,137 @@ void PdfParser::Parse(InputStreamDevice& device, bool loadOnDemand)
     reset();
 
     m_LoadOnDemand = loadOnDemand;
+    parse(device, false);
+}
+
+void PdfParser::ParseStructure(InputStreamDevice& device)
+{
+    reset();
+    parse(device, true);
+}
+
+unique_ptr<PdfObject> PdfParser::ReadObject(InputStreamDevice& device, const PdfReference& reference)
+{
+    utls::RecursionGuard guard;
+    if (m_Trailer == nullptr)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidHandle, "The document structure has not been read");
+
+    if (reference.ObjectNumber() >= m_entries.GetSize())
+        return nullptr;
+
+    auto& entry = m_entries[reference.ObjectNumber()];
+    if (!entry.Parsed)
+        return nullptr;
+
+    switch (entry.Type)
+    {
+        case PdfXRefEntryType::InUse:
+        {
+            if (entry.Offset == 0 || entry.Generation != reference.GenerationNumber())
+                return nullptr;
+
+            unique_ptr<PdfParserObject> obj(new PdfParserObject(device, reference, (ssize_t)entry.Offset));
+            obj->SetEncrypt(m_Encrypt);
+            obj->Parse();
+
+            // The object is not part of a document, so the stream
+            // /Length can't be resolved when it's a reference
+            PdfDictionary* dict;
+            const PdfObject* lengthObj;
+            PdfReference lengthRef;
+            if (obj->TryGetDictionary(dict)
+                && (lengthObj = dict->GetKey("Length")) != nullptr
+                && lengthObj->TryGetReference(lengthRef))
+            {
+                auto length = ReadObject(device, lengthRef);
+                int64_t size;
+                if (length == nullptr || !length->TryGetNumber(size))
+                    PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidStream, "Invalid stream /Length");
+
+                dict->AddKey("Length"_n, PdfObject(size));
+            }
+
+            return obj;
+        }
+        case PdfXRefEntryType::Compressed:
+        {
+            // The generation number of an object stream and of any
+            // compressed object is implicitly zero
+            if (reference.GenerationNumber() != 0)
+                return nullptr;
+
+            PdfVariant variant;
+            getObjectStreamParser(device, (uint32_t)entry.ObjectNumber).ReadObject(reference, entry.Index, variant);
+            unique_ptr<PdfObject> obj(new PdfObject(std::move(variant)));
+            obj->SetIndirectReference(reference);
+            return obj;
+        }
+        default:
+            return nullptr;
+    }
+}
+
+PdfObjectStreamParser& PdfParser::getObjectStreamParser(InputStreamDevice& device, uint32_t objNo)
+{
+    auto found = m_objectStreams.find(objNo);
+    if (found != m_objectStreams.end())
+        return *found->second;
+
+    PdfReference streamRef(objNo, 0);
+    auto streamObj = ReadObject(device, streamRef);
+    auto parserObj = dynamic_cast<PdfParserObject*>(streamObj.get());
+    if (parserObj == nullptr)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidObject, "Loading of object stream {} failed!", streamRef.ToString());
+
+    // The object stream parser reads the stream from the object list
+    m_Objects->PushObject(streamObj.release());
+    auto parser = std::make_shared<PdfObjectStreamParser>(*parserObj, *m_Objects, m_buffer);
+    m_objectStreams[objNo] = parser;
+    return *parser;
+}
 
+void PdfParser::parse(InputStreamDevice& device, bool structureOnly)
+{
+
+    // Objects created while parsing are allocated from
+    // the arena of the object list, if any
+    PdfArena::Scope scope(m_Objects->m_arena.get());
     try
     {
         if (!IsPdfFile(device))
             PODOFO_RAISE_ERROR(PdfErrorCode::InvalidPDF);
 
-        ReadDocumentStructure(device);
-        ReadObjects(device);
+        bool rebuildXRef = false;
+        try
+        {
+            ReadDocumentStructure(device);
+            rebuildXRef = m_RebuildBrokenXRef && !isXRefValid(device);
+        }
+        catch (PdfError&)
+        {
+            if (!m_RebuildBrokenXRef)
+                throw;
+
+            rebuildXRef = true;
+        }
+
+        if (rebuildXRef)
+        {
+            PoDoFo::LogMessage(PdfLogSeverity::Warning, "The xref table is broken, rebuilding it from a scan of the file");
+            this->rebuildXRef(device);
+        }
+
+        if (structureOnly)
+        {
+            if (m_Trailer == nullptr)
+                PODOFO_RAISE_ERROR(PdfErrorCode::InvalidTrailer);
+
+            setupEncrypt(device);
+        }
+        else
+        {
+            ReadObjects(device);
+        }
     }
     catch (PdfError& e)
     {
@@ -302,6 +476,259 @@ void PdfParser::findXRef(InputStreamDevice& device, size_t& xRefOffset)
     xRefOffset = (size_t)m_tokenizer.ReadNextNumber(device) + m_magicOffset;
 }
 
+bool PdfParser::isXRefValid(InputStreamDevice& device)
+{
+    try
+    {
+        const PdfObject* rootObj;
+        PdfReference root;
+        if (m_Trailer == nullptr
+            || (rootObj = m_Trailer->GetDictionary().GetKey("Root")) == nullptr
+            || !rootObj->TryGetReference(root)
+            || root.ObjectNumber() >= m_entries.GetSize())
+        {
+            return false;
+        }
+
+        auto& entry = m_entries[root.ObjectNumber()];
+        if (!entry.Parsed)
+            return false;
+
+        switch (entry.Type)
+        {
+            case PdfXRefEntryType::InUse:
+            {
+                // Check the offset points to the catalog object header
+                device.Seek((size_t)entry.Offset);
+                return m_tokenizer.ReadNextNumber(device) == (int64_t)root.ObjectNumber();
+            }
+            case PdfXRefEntryType::Compressed:
+            {
+                // Can't be checked without decoding the object stream
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+    catch (PdfError&)
+    {
+        return false;
+    }
+}
+
+void PdfParser::rebuildXRef(InputStreamDevice& device)
+{
+    // Discard what has been read of the broken structure
+    m_entries.Clear();
+    m_Trailer = nullptr;
+    m_HasXRefStream = false;
+    m_XRefOffset = 0;
+    m_IncrementalUpdateCount = 0;
+    m_visitedXRefOffsets.clear();
+
+    // The scan is performed on the whole content in memory
+    charbuff buffer;
+    bufferview view;
+    if (!device.TryGetView(view))
+    {
+        device.Seek(0);
+        BufferStreamDevice output(buffer);
+        device.CopyTo(output);
+        view = bufferview(buffer.data(), buffer.size());
+    }
+
+    m_FileSize = view.size();
+
+    vector<ScannedObject> objects;
+    vector<size_t> trailers;
+    scanDocument(string_view(view.data(), view.size()), objects, trailers);
+
+    unsigned size = 0;
+    for (auto& obj : objects)
+    {
+        if (obj.ObjectNumber < PdfCommon::GetMaxObjectCount())
+            size = std::max(size, obj.ObjectNumber + 1);
+    }
+
+    m_entries.Enlarge(size);
+
+    // Objects defined later in the file override previous
+    // definitions, as done by incremental updates. Keep
+    // track of the position of the definition of each entry
+    vector<size_t> entryPositions(size);
+    for (auto& obj : objects)
+    {
+        if (obj.ObjectNumber >= size)
+            continue;
+
+        auto& entry = m_entries[obj.ObjectNumber];
+        entry = PdfXRefEntry::CreateInUse(obj.Offset, obj.Generation);
+        entry.Parsed = true;
+        entryPositions[obj.ObjectNumber] = obj.Offset;
+    }
+
+    // The trailer is the last trailer, or xref stream dictionary,
+    // specifying the catalog. The previous ones are merged to it
+    vector<size_t> trailerOffsets = trailers;
+    for (auto& obj : objects)
+    {
+        if (obj.IsXRef)
+            trailerOffsets.push_back(obj.DataOffset);
+    }
+
+    std::sort(trailerOffsets.begin(), trailerOffsets.end(), std::greater<size_t>());
+    for (size_t offset : trailerOffsets)
+    {
+        auto trailer = tryReadRebuiltTrailer(device, offset);
+        if (trailer == nullptr)
+            continue;
+
+        if (m_Trailer == nullptr)
+        {
+            if (trailer->GetDictionary().HasKey("Root"))
+                m_Trailer = std::move(trailer);
+        }
+        else
+        {
+            mergeTrailer(*trailer);
+        }
+    }
+
+    // NOTE: Encrypted object streams can't be decoded yet
+    if (m_Trailer == nullptr || !m_Trailer->GetDictionary().HasKey("Encrypt"))
+    {
+        for (auto& obj : objects)
+        {
+            if (!obj.IsObjStm || obj.ObjectNumber >= size || entryPositions[obj.ObjectNumber] != obj.Offset)
+                continue;
+
+            PdfReference reference(obj.ObjectNumber, obj.Generation);
+            try
+            {
+                rebuildCompressedEntries(device, reference, obj.Offset, entryPositions);
+            }
+            catch (PdfError&)
+            {
+                PoDoFo::LogMessage(PdfLogSeverity::Warning, "Unable to read object stream {} while rebuilding the xref table",
+                    reference.ToString());
+            }
+        }
+    }
+
+    const PdfObject* rootObj;
+    PdfReference root;
+    if (m_Trailer != nullptr
+        && (rootObj = m_Trailer->GetDictionary().GetKey("Root")) != nullptr
+        && rootObj->TryGetReference(root)
+        && root.ObjectNumber() < m_entries.GetSize()
+        && m_entries[root.ObjectNumber()].Parsed)
+    {
+        m_Trailer->GetDictionary().AddKey("Size"_n, PdfObject(static_cast<int64_t>(m_entries.GetSize())));
+        return;
+    }
+
+    // The trailer is missing or it doesn't locate the
+    // catalog: look for the last catalog in the file
+    for (auto it = objects.rbegin(); it != objects.rend(); it++)
+    {
+        auto& obj = *it;
+        if (!obj.IsCatalog || obj.ObjectNumber >= size || entryPositions[obj.ObjectNumber] != obj.Offset)
+            continue;
+
+        PdfReference reference(obj.ObjectNumber, obj.Generation);
+        PdfParserObject catalog(m_Objects->GetDocument(), reference, device, (ssize_t)obj.Offset);
+        const PdfName* type;
+        try
+        {
+            if (!catalog.GetDictionary().TryFindKeyAs("Type", type) || *type != "Catalog")
+                continue;
+        }
+        catch (PdfError&)
+        {
+            continue;
+        }
+
+        if (m_Trailer == nullptr)
+            m_Trailer.reset(new PdfObject(PdfDictionary()));
+
+        m_Trailer->GetDictionary().AddKey("Root"_n, PdfObject(reference));
+        m_Trailer->GetDictionary().AddKey("Size"_n, PdfObject(static_cast<int64_t>(m_entries.GetSize())));
+        return;
+    }
+
+    PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidTrailer, "Unable to find the document catalog while rebuilding the xref table");
+}
+
+void PdfParser::rebuildCompressedEntries(InputStreamDevice& device, const PdfReference& reference,
+    size_t offset, vector<size_t>& entryPositions)
+{
+    PdfParserObject streamObj(m_Objects->GetDocument(), reference, device, (ssize_t)offset);
+    auto& dict = streamObj.GetDictionary();
+    const PdfName* type;
+    if (!dict.TryFindKeyAs("Type", type) || *type != "ObjStm")
+        return;
+
+    // The stream /Length may be a reference to an object not
+    // loaded yet: resolve it with the rebuilt entries
+    auto lengthObj = dict.GetKey("Length");
+    PdfReference lengthRef;
+    if (lengthObj != nullptr && lengthObj->TryGetReference(lengthRef))
+    {
+        if (lengthRef.ObjectNumber() >= m_entries.GetSize()
+            || m_entries[lengthRef.ObjectNumber()].Type != PdfXRefEntryType::InUse)
+        {
+            PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidStream, "Invalid object stream /Length");
+        }
+
+        PdfParserObject length(m_Objects->GetDocument(), lengthRef, device,
+            (ssize_t)m_entries[lengthRef.ObjectNumber()].Offset);
+        dict.AddKey("Length"_n, PdfObject(length.GetNumber()));
+    }
+
+    int64_t num = dict.FindKeyAsSafe<int64_t>("N", 0);
+    charbuff data;
+    streamObj.MustGetStream().CopyTo(data);
+    SpanStreamDevice input(data);
+    for (int64_t i = 0; i < num; i++)
+    {
+        int64_t objNum = m_tokenizer.ReadNextNumber(input);
+        (void)m_tokenizer.ReadNextNumber(input);
+        if (objNum <= 0 || objNum >= (int64_t)PdfCommon::GetMaxObjectCount())
+            continue;
+
+        m_entries.Enlarge((unsigned)objNum + 1);
+        if (entryPositions.size() < m_entries.GetSize())
+            entryPositions.resize(m_entries.GetSize());
+
+        auto& entry = m_entries[(unsigned)objNum];
+        if (entry.Parsed && entryPositions[(size_t)objNum] > offset)
+            continue;
+
+        entry = PdfXRefEntry::CreateCompressed(reference.ObjectNumber(), (unsigned)i);
+        entry.Parsed = true;
+        entryPositions[(size_t)objNum] = offset;
+    }
+}
+
+unique_ptr<PdfObject> PdfParser::tryReadRebuiltTrailer(InputStreamDevice& device, size_t offset)
+{
+    device.Seek(offset);
+    unique_ptr<PdfParserObject> trailer(new PdfParserObject(m_Objects->GetDocument(), device, -1));
+    trailer->SetIsTrailer(true);
+    try
+    {
+        if (!trailer->IsDictionary())
+            return nullptr;
+    }
+    catch (PdfError&)
+    {
+        return nullptr;
+    }
+
+    return trailer;
+}
+
 void PdfParser::ReadXRefContents(InputStreamDevice& device, size_t offset, bool skipFollowPrevious)
 {
     utls::RecursionGuard guard;
@@ -563,8 +990,15 @@ void PdfParser::ReadObjects(InputStreamDevice& device)
     if (m_Trailer == nullptr)
         PODOFO_RAISE_ERROR(PdfErrorCode::InvalidTrailer);
 
-    // Check for encryption and make sure that the encryption object
-    // is loaded before all other objects
+    // Make sure that the encryption object is
+    // loaded before all other objects
+    setupEncrypt(device);
+    readObjectsInternal(device);
+}
+
+void PdfParser::setupEncrypt(InputStreamDevice& device)
+{
+    // Check for encryption
     auto encryptObj = m_Trailer->GetDictionary().GetKey("Encrypt");
     if (encryptObj != nullptr && !encryptObj->IsNull())
     {
@@ -624,8 +1058,6 @@ void PdfParser::ReadObjects(InputStreamDevice& device)
             PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidPassword, "A password is required to read this PDF file");
         }
     }
-
-    readObjectsInternal(device);
 }
 
 void PdfParser::readObjectsInternal(InputStreamDevice& device)
@@ -672,6 +1104,10 @@ void PdfParser::readObjectsInternal(InputStreamDevice& device)
                                 }
                             }
 
+                            // Demand loaded objects already require the device
+                            // to be kept alive, so the stream data can be read
+                            // from it as well
+                            obj->SetReferenceStreamData(m_LoadOnDemand || m_ReferenceStreamData);
                             m_Objects->PushObject(obj.release());
                         }
                         catch (PdfError& e)
@@ -744,19 +1180,26 @@ void PdfParser::readObjectsInternal(InputStreamDevice& device)
         // robustly from all places which are either free or unparsed
     }
 
+    bufferview view;
+    if (!m_LoadOnDemand && m_ThreadCount > 1 && m_Encrypt == nullptr && device.TryGetView(view))
+    {
+        readObjectsParallel(view, compressedObjects);
+        updateDocumentVersion();
+        return;
+    }
+
     // all normal objects including object streams are available now,
     // we can parse the object streams safely now.
     //
-    // Note that even if demand loading is enabled we still currently read all
-    // objects from the stream into memory then free the stream.
-    //
+    // If demand loading is enabled, the object streams are decoded only
+    // when one of their objects is first accessed
+    shared_ptr<PdfObjectStreamCache> cache;
+    if (m_LoadOnDemand && compressedObjects.size() != 0)
+        cache = std::make_shared<PdfObjectStreamCache>(OBJECT_STREAM_CACHE_SIZE);
+
     for (auto& pair : compressedObjects)
     {
-#ifndef VERBOSE_DEBUG_DISABLED
-        if (m_LoadOnDemand)
-            cerr << "Demand loading on, but can't demand-load from object stream." << endl;
-#endif
-        readCompressedObjectFromStream((uint32_t)pair.first, pair.second);
+        readCompressedObjectFromStream((uint32_t)pair.first, pair.second, cache);
         m_Objects->AddCompressedObjectStream((uint32_t)pair.first);
     }
 
@@ -768,15 +1211,19 @@ void PdfParser::readObjectsInternal(InputStreamDevice& device)
         // in a second pass, or (if demand loading is enabled) defer it for later.
         for (auto objToLoad : *m_Objects)
         {
+            // NOTE: Objects read from object streams are
+            // regular objects and they can't have streams
             auto obj = dynamic_cast<PdfParserObject*>(objToLoad);
-            obj->ParseStream();
+            if (obj != nullptr)
+                obj->ParseStream();
         }
     }
 
     updateDocumentVersion();
 }
 
-void PdfParser::readCompressedObjectFromStream(uint32_t objNo, const cspan<int64_t>& objectList)
+void PdfParser::readCompressedObjectFromStream(uint32_t objNo, const cspan<int64_t>& objectList,
+    const shared_ptr<PdfObjectStreamCache>& cache)
 {
     // generation number of object streams is always 0
     auto streamObj = dynamic_cast<PdfParserObject*>(m_Objects->GetObject(PdfReference(objNo, 0)));
@@ -793,8 +1240,99 @@ void PdfParser::readCompressedObjectFromStream(uint32_t objNo, const cspan<int64
         }
     }
 
-    PdfObjectStreamParser parserObject(*streamObj, *m_Objects, m_buffer);
-    parserObject.Parse(objectList);
+    if (cache == nullptr)
+    {
+        PdfObjectStreamParser parserObject(*streamObj, *m_Objects, m_buffer);
+        parserObject.Parse(objectList);
+        return;
+    }
+
+    auto parserObject = std::make_shared<PdfObjectStreamParser>(*streamObj, *m_Objects, m_buffer, cache);
+    for (int64_t compressedObjNo : objectList)
+    {
+        // The generation number of an object stream and of any
+        // compressed object is implicitly zero
+        m_Objects->PushObject(new PdfCompressedParserObject(parserObject,
+            PdfReference((uint32_t)compressedObjNo, 0), m_entries[(unsigned)compressedObjNo].Index));
+    }
+}
+
+void PdfParser::readObjectsParallel(const bufferview& view, const map<int64_t, vector<int64_t>>& compressedObjects)
+{
+    vector<PdfParserObject*> objects;
+    for (auto obj : *m_Objects)
+    {
+        auto parserObj = dynamic_cast<PdfParserObject*>(obj);
+        if (parserObj != nullptr)
+            objects.push_back(parserObj);
+    }
+
+    // Parse all the regular objects first, so the following steps
+    // will only resolve references to already loaded objects.
+    // Each worker has its own device, while the tokenizers are
+    // created by the objects themselves
+    parallelFor(m_ThreadCount, m_Objects->m_arena.get(), view, objects.size(), [&](InputStreamDevice& device, size_t i) {
+        objects[i]->Parse(device);
+    });
+
+    // Decode the object streams concurrently, then add
+    // the read objects to the list serially
+    vector<pair<PdfParserObject*, const vector<int64_t>*>> streams;
+    for (auto& pair : compressedObjects)
+    {
+        auto streamObj = dynamic_cast<PdfParserObject*>(m_Objects->GetObject(PdfReference((uint32_t)pair.first, 0)));
+        if (streamObj == nullptr)
+        {
+            if (m_IgnoreBrokenObjects)
+            {
+                PoDoFo::LogMessage(PdfLogSeverity::Error, "Loading of object {} 0 R failed!", pair.first);
+                continue;
+            }
+            else
+            {
+                PODOFO_RAISE_ERROR_INFO(PdfErrorCode::InvalidObject, "Loading of object {} 0 R failed!", pair.first);
+            }
+        }
+
+        streams.push_back({ streamObj, &pair.second });
+    }
+
+    vector<vector<unique_ptr<PdfObject>>> compressed(streams.size());
+    parallelFor(m_ThreadCount, m_Objects->m_arena.get(), view, streams.size(), [&](InputStreamDevice& device, size_t i) {
+        auto& stream = streams[i];
+        stream.first->ParseStream(device);
+
+        // NOTE: Don't share the parser buffer between threads
+        PdfObjectStreamParser parserObject(*stream.first, *m_Objects,
+            std::make_shared<charbuff>(PdfTokenizer::BufferSize));
+        compressed[i] = parserObject.Read(*stream.second);
+    });
+
+    for (unsigned i = 0; i < streams.size(); i++)
+    {
+        for (auto& obj : compressed[i])
+            m_Objects->PushObject(obj.release());
+
+        m_Objects->AddCompressedObjectStream(streams[i].first->GetIndirectReference().ObjectNumber());
+    }
+
+    // Resolve the /Length references serially, so the workers
+    // loading the streams will only read already loaded objects
+    for (auto obj : objects)
+    {
+        if (!obj->HasStream())
+            continue;
+
+        auto lengthObj = obj->GetDictionary().FindKey("Length");
+        int64_t length;
+        if (lengthObj != nullptr)
+            (void)lengthObj->TryGetNumber(length);
+    }
+
+    // Finally load all the streams
+    parallelFor(m_ThreadCount, m_Objects->m_arena.get(), view, objects.size(), [&](InputStreamDevice& device, size_t i) {
+        objects[i]->ParseStream(device);
+    });
 }
 
 void PdfParser::findTokenBackward(InputStreamDevice& device, const char* token, size_t range, size_t searchEnd)
@@ -1004,3 +1542,192 @@ bool ReadMagicWord(char ch, unsigned& cursoridx)
 
     return false;
 }
+
+// Run the given function on all the indices in [0, count) with a pool
+// of workers, each one with its own device reading from the given view
+// and the given arena, if any, active.
+// The first error raised by a worker is rethrown to the caller
+template <typename TFunc>
+void parallelFor(unsigned threadCount, PdfArena* arena, const bufferview& view, size_t count, const TFunc& func)
+{
+    atomic<size_t> next(0);
+    exception_ptr error;
+    mutex errorMutex;
+    auto work = [&]() {
+        PdfArena::Scope scope(arena);
+        SpanStreamDevice device(view);
+        try
+        {
+            while (true)
+            {
+                size_t i = next++;
+                if (i >= count)
+                    break;
+
+                func(device, i);
+            }
+        }
+        catch (...)
+        {
+            lock_guard<mutex> lock(errorMutex);
+            if (error == nullptr)
+                error = current_exception();
+
+            // Stop the other workers
+            next = count;
+        }
+    };
+
+    // NOTE: The calling thread is also a worker
+    vector<thread> workers;
+    size_t workerCount = std::min((size_t)threadCount, count);
+    for (size_t i = 1; i < workerCount; i++)
+        workers.emplace_back(work);
+
+    work();
+    for (auto& worker : workers)
+        worker.join();
+
+    if (error != nullptr)
+        rethrow_exception(error);
+}
+
+// Scan the document searching all the markers at once. Every search
+// is a std::string_view::find(), which is accelerated by the vectorized
+// memchr() of common C libraries, so the scan runs close to the memory
+// bandwidth. Stream data is skipped
+void scanDocument(const string_view& data, vector<ScannedObject>& objects, vector<size_t>& trailers)
+{
+    constexpr string_view Markers[] = { "obj"sv, "trailer"sv, "stream"sv, "/XRef"sv, "/ObjStm"sv, "/Catalog"sv };
+    constexpr unsigned MarkerCount = (unsigned)std::size(Markers);
+
+    auto isBoundary = [&data](size_t pos) {
+        return pos >= data.size() || !PoDoFo::IsCharRegular(data[pos]);
+    };
+
+    size_t positions[MarkerCount];
+    for (unsigned i = 0; i < MarkerCount; i++)
+        positions[i] = data.find(Markers[i]);
+
+    while (true)
+    {
+        unsigned marker = 0;
+        for (unsigned i = 1; i < MarkerCount; i++)
+        {
+            if (positions[i] < positions[marker])
+                marker = i;
+        }
+
+        size_t pos = positions[marker];
+        if (pos == string_view::npos)
+            break;
+
+        size_t nextPos = pos + Markers[marker].size();
+        switch ((ScanMarker)marker)
+        {
+            case ScanMarker::Obj:
+            {
+                ScannedObject obj;
+                if (isBoundary(nextPos) && tryReadObjectHeader(data, pos, obj))
+                {
+                    obj.DataOffset = nextPos;
+                    objects.push_back(obj);
+                }
+                break;
+            }
+            case ScanMarker::Trailer:
+            {
+                if ((pos == 0 || isBoundary(pos - 1)) && isBoundary(nextPos))
+                    trailers.push_back(nextPos);
+                break;
+            }
+            case ScanMarker::Stream:
+            {
+                // Skip the stream data, so object headers of
+                // embedded documents are not mistakenly found
+                if (pos != 0 && (PoDoFo::IsCharWhitespace(data[pos - 1]) || data[pos - 1] == '>')
+                    && nextPos < data.size() && (data[nextPos] == '\r' || data[nextPos] == '\n'))
+                {
+                    constexpr string_view EndStream = "endstream"sv;
+                    size_t endPos = data.find(EndStream, nextPos);
+                    if (endPos != string_view::npos)
+                        nextPos = endPos + EndStream.size();
+                }
+                break;
+            }
+            case ScanMarker::XRef:
+            case ScanMarker::ObjStm:
+            case ScanMarker::Catalog:
+            {
+                // The name is attributed to the last found
+                // object. The actual type is checked later
+                if (objects.size() == 0 || !isBoundary(nextPos))
+                    break;
+
+                auto& obj = objects.back();
+                if ((ScanMarker)marker == ScanMarker::XRef)
+                    obj.IsXRef = true;
+                else if ((ScanMarker)marker == ScanMarker::ObjStm)
+                    obj.IsObjStm = true;
+                else
+                    obj.IsCatalog = true;
+                break;
+            }
+            default:
+                PODOFO_RAISE_ERROR(PdfErrorCode::InternalLogic);
+        }
+
+        for (unsigned i = 0; i < MarkerCount; i++)
+        {
+            if (positions[i] < nextPos)
+                positions[i] = data.find(Markers[i], nextPos);
+        }
+    }
+}
+
+// Read backward the "N G" object header before
+// the "obj" keyword at the given position
+bool tryReadObjectHeader(const string_view& data, size_t pos, ScannedObject& obj)
+{
+    uint64_t generation;
+    uint64_t objNum;
+    if (!tryReadNumberBackward(data, pos, 5, generation)
+        || !tryReadNumberBackward(data, pos, 10, objNum)
+        || (pos != 0 && PoDoFo::IsCharRegular(data[pos - 1]))
+        || objNum == 0 || objNum > numeric_limits<uint32_t>::max()
+        || generation > numeric_limits<uint16_t>::max())
+    {
+        return false;
+    }
+
+    obj.ObjectNumber = (uint32_t)objNum;
+    obj.Generation = (uint16_t)generation;
+    obj.Offset = pos;
+    return true;
+}
+
+// Skip the whitespaces, which are required, and read
+// backward a number ending at the given position
+bool tryReadNumberBackward(const string_view& data, size_t& pos, unsigned maxDigits, uint64_t& value)
+{
+    size_t end = pos;
+    while (end != 0 && PoDoFo::IsCharWhitespace(data[end - 1]))
+        end--;
+
+    if (end == pos)
+        return false;
+
+    size_t start = end;
+    while (start != 0 && end - start < maxDigits && data[start - 1] >= '0' && data[start - 1] <= '9')
+        start--;
+
+    if (start == end)
+        return false;
+
+    value = 0;
+    for (size_t i = start; i < end; i++)
+        value = value * 10 + (uint64_t)(data[i] - '0');
+
+    pos = start;
+    return true;
+}
@@ -7,6 +7,8 @@
 #ifndef PDF_PARSER_H
 #define PDF_PARSER_H
 
+#include <unordered_map>
+
 #include <podofo/main/PdfIndirectObjectList.h>
 #include <podofo/main/PdfTokenizer.h>
 
@@ -16,6 +18,8 @@
 namespace PoDoFo {
 
 class PdfEncrypt;
+class PdfObjectStreamCache;
+class PdfObjectStreamParser;
 
 /**
  * PdfParser reads a PDF file into memory.
@@ -56,6 +60,26 @@ public:
      */
     void Parse(InputStreamDevice& device, bool loadOnDemand);
 
+    /** Read only the file header, the xref sections and the trailers,
+     *  and set up the encryption, without loading any object.
+     *  Single objects can then be read with ReadObject()
+     *
+     *  This might throw a PdfError( PdfErrorCode::InvalidPassword ) exception
+     *  as Parse() does
+     */
+    void ParseStructure(InputStreamDevice& device);
+
+    /** Read a single object, from the device or from the object
+     *  stream containing it, after the structure has been read
+     *
+     *  The object is not added to the object list, and it doesn't
+     *  belong to any document, so its references are not resolved.
+     *  Decoded object streams are kept in the object list, to read
+     *  further objects from them
+     *  eturns the object, or nullptr if the reference is not in use
+     */
+    std::unique_ptr<PdfObject> ReadObject(InputStreamDevice& device, const PdfReference& reference);
+
     const PdfObject& GetTrailer() const;
 
     std::unique_ptr<PdfObject> TakeTrailer();
@@ -155,6 +179,57 @@ public:
      */
     inline void SetIgnoreBrokenObjects(bool broken) { m_IgnoreBrokenObjects = broken; }
 
+    /**
+     * \return the number of threads used to parse objects
+     */
+    inline unsigned GetThreadCount() const { return m_ThreadCount; }
+
+    /**
+     * Set the number of threads used to parse objects when
+     * demand loading is disabled. Default is 1.
+     *
+     * Parsing is performed concurrently only if the input device
+     * content is available in memory and the document is not encrypted,
+     * otherwise it silently falls back to the serial loading
+     *
+     * \param count the number of threads. 0 means the number
+     *     of concurrent threads supported by the system
+     */
+    void SetThreadCount(unsigned count);
+
+    /**
+     * \return true if the xref table is rebuilt when it's broken
+     */
+    inline bool GetRebuildBrokenXRef() const { return m_RebuildBrokenXRef; }
+
+    /**
+     * Rebuild the xref table by scanning the whole file, when it
+     * can't be read or it doesn't locate the document catalog.
+     * Default is false.
+     *
+     * The scan looks for "N G obj" object headers, "trailer" dictionaries,
+     * and /XRef, /ObjStm and /Catalog objects. Objects defined later
+     * in the file override previous definitions
+     * \remarks Compressed objects of encrypted documents can't be recovered
+     */
+    inline void SetRebuildBrokenXRef(bool rebuild) { m_RebuildBrokenXRef = rebuild; }
+
+    /**
+     * \return true if the raw data of unencrypted streams is
+     * referenced in the source device, instead of being copied in memory
+     */
+    inline bool GetReferenceStreamData() const { return m_ReferenceStreamData; }
+
+    /**
+     * Reference the raw data of unencrypted streams in the source
+     * device also when demand loading is disabled, so unchanged
+     * streams can be copied verbatim from the device when saving.
+     * Default is false. The data is always referenced when
+     * demand loading is enabled
+     * \remarks The device must outlive the parsed objects
+     */
+    inline void SetReferenceStreamData(bool reference) { m_ReferenceStreamData = reference; }
+
     inline size_t GetXRefOffset() const { return m_XRefOffset; }
 
     inline bool HasXRefStream() const { return m_HasXRefStream; }
@@ -216,6 +291,15 @@ private:
     bool IsPdfFile(InputStreamDevice& device);
 
 private:
+    void parse(InputStreamDevice& device, bool structureOnly);
+
+    /** Set up the encryption session, if the trailer has an /Encrypt entry,
+     *  and authenticate it with the password
+     */
+    void setupEncrypt(InputStreamDevice& device);
+
+    PdfObjectStreamParser& getObjectStreamParser(InputStreamDevice& device, uint32_t objNo);
+
     /** Searches backwards from the specified position of the file
      *  and tries to find a token.
      *  The current file is positioned right after the token.
@@ -239,6 +323,22 @@ private:
      */
     void findXRef(InputStreamDevice& device, size_t& xRefOffset);
 
+    /** Check if the xref entries locate the document catalog
+     */
+    bool isXRefValid(InputStreamDevice& device);
+
+    /** Rebuild the xref entries and the trailer with a linear scan of the file
+     */
+    void rebuildXRef(InputStreamDevice& device);
+
+    /** Add to the xref entries the objects compressed in the
+     * given object stream, if not overridden by later definitions
+     */
+    void rebuildCompressedEntries(InputStreamDevice& device, const PdfReference& reference,
+        size_t offset, std::vector<size_t>& entryPositions);
+
+    std::unique_ptr<PdfObject> tryReadRebuiltTrailer(InputStreamDevice& device, size_t offset);
+
     /** Reads all objects from the pdf into memory
      *  from the previously read entries
      *
@@ -264,7 +364,14 @@ private:
      *  \param index index of the object which should be parsed
      *
      */
-    void readCompressedObjectFromStream(uint32_t objNo, const cspan<int64_t>& objectList);
+    void readCompressedObjectFromStream(uint32_t objNo, const cspan<int64_t>& objectList,
+        const std::shared_ptr<PdfObjectStreamCache>& cache);
+
+    /** Fully load all the objects, including the ones in the
+     * object streams, with a pool of worker threads, each one
+     * reading from its own device on the given memory view
+     */
+    void readObjectsParallel(const bufferview& view, const std::map<int64_t, std::vector<int64_t>>& compressedObjects);
 
     void readNextTrailer(InputStreamDevice& device, bool skipFollowPrevious);
 
@@ -314,17 +421,22 @@ private:
     PdfXRefEntries m_entries;
     PdfIndirectObjectList* m_Objects;
 
-    std::unique_ptr<PdfParserObject> m_Trailer;
+    std::unique_ptr<PdfObject> m_Trailer;
     std::shared_ptr<PdfEncryptSession> m_Encrypt;
 
     std::string m_Password;
 
     bool m_StrictParsing;
     bool m_IgnoreBrokenObjects;
+    unsigned m_ThreadCount;
+    bool m_RebuildBrokenXRef;
+    bool m_ReferenceStreamData;
 
     unsigned m_IncrementalUpdateCount;
 
     std::set<size_t> m_visitedXRefOffsets;
+    // Object streams decoded by ReadObject()
+    std::unordered_map<uint32_t, std::shared_ptr<PdfObjectStreamParser>> m_objectStreams;
 };
 
 };
@@ -10,7 +10,10 @@
 #include <podofo/main/PdfArray.h>
 #include <podofo/main/PdfDictionary.h>
 
+#include <podofo/main/PdfMemoryObjectStream.h>
+
 #include "PdfFilterFactory.h"
+#include "PdfParserObjectStream.h"
 
 using namespace PoDoFo;
 using namespace std;
@@ -38,10 +41,12 @@ PdfParserObject::PdfParserObject(PdfDocument* doc, const PdfReference& indirectR
     InputStreamDevice& device, ssize_t offset) :
     PdfObject(PdfVariant(), indirectReference, true),
     m_device(&device),
+    m_sourceDevice(&device),
     m_Offset(offset < 0 ? device.GetPosition() : offset),
     m_StreamOffset(0),
     m_IsTrailer(false),
     m_HasStream(false),
+    m_ReferenceStreamData(false),
     m_IsRevised(false)
 {
     // Parsed objects by definition are initially not dirty
@@ -67,6 +72,38 @@ void PdfParserObject::ParseStream()
     DelayedLoadStream();
 }
 
+void PdfParserObject::Parse(InputStreamDevice& device)
+{
+    auto prevDevice = m_device;
+    m_device = &device;
+    try
+    {
+        DelayedLoad();
+    }
+    catch (...)
+    {
+        m_device = prevDevice;
+        throw;
+    }
+    m_device = prevDevice;
+}
+
+void PdfParserObject::ParseStream(InputStreamDevice& device)
+{
+    auto prevDevice = m_device;
+    m_device = &device;
+    try
+    {
+        DelayedLoadStream();
+    }
+    catch (...)
+    {
+        m_device = prevDevice;
+        throw;
+    }
+    m_device = prevDevice;
+}
+
 void PdfParserObject::delayedLoad()
 {
     PdfTokenizer tokenizer;
@@ -251,6 +288,17 @@ ReadStream:
         // It's not needed for serialization here
         m_Encrypt = nullptr;
     }
+    else if (m_ReferenceStreamData && size >= 0
+        && dynamic_cast<const PdfMemoryObjectStream*>(&getOrCreateStream().GetProvider()) != nullptr
+        && streamOffset + (size_t)size <= m_device->GetLength())
+    {
+        // Don't copy the data, just reference it in the device. This is
+        // done only when replacing the default provider, since a custom
+        // stream factory may have other requirements. Reference the
+        // source device, since a temporary one may be used for parsing
+        getOrCreateStream().InitData(unique_ptr<PdfObjectStreamProvider>(
+            new PdfParserObjectStream(*m_sourceDevice, streamOffset, (size_t)size)), std::move(filters));
+    }
     else
     {
         getOrCreateStream().InitData(*m_device, static_cast<ssize_t>(size), std::move(filters));
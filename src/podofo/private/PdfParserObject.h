@@ -55,6 +55,13 @@ public:
 
     void ParseStream();
 
+    /** Parse the object, or its stream, reading from a different
+     * device with the same content of the object device. This is
+     * used to parse several objects concurrently
+     */
+    void Parse(InputStreamDevice& device);
+    void ParseStream(InputStreamDevice& device);
+
     /** Gets an offset in which the object beginning is stored in the file.
      *  Note the offset points just after the object identificator ("0 0 obj").
      *
@@ -67,6 +74,12 @@ public:
 
     inline void SetIsTrailer(bool isTrailer) { m_IsTrailer = isTrailer; }
 
+    /** Reference the raw stream data in the source device, instead
+     * of copying it in memory. The device must outlive the object
+     * \remarks It has no effect on encrypted streams
+     */
+    inline void SetReferenceStreamData(bool reference) { m_ReferenceStreamData = reference; }
+
 protected:
     PdfReference ReadReference(PdfTokenizer& tokenizer);
     void Parse(PdfTokenizer& tokenizer);
@@ -102,10 +115,14 @@ private:
 private:
     std::shared_ptr<PdfEncryptSession> m_Encrypt;
     InputStreamDevice* m_device;
+    // The device the object was created with. It differs from
+    // m_device while parsing with a temporary device
+    InputStreamDevice* m_sourceDevice;
     size_t m_Offset;
     size_t m_StreamOffset;
     bool m_IsTrailer;
     bool m_HasStream;
+    bool m_ReferenceStreamData;
     bool m_IsRevised;         ///< True if the object was irreversibly modified since first read
 };
 
@@ -0,0 +1,296 @@
+/**
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#include "PdfDeclarationsPrivate.h"
+#include "PdfParserObjectStream.h"
+
+#include <podofo/auxiliary/StreamDevice.h>
+#include <podofo/main/PdfMemoryObjectStream.h>
+#include <podofo/main/PdfStatefulEncrypt.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/sendfile.h>
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 27))
+#define HAVE_COPY_FILE_RANGE
+#endif
+#endif // __linux__
+
+using namespace std;
+using namespace PoDoFo;
+
+namespace
+{
+    // An input stream reading a range of a device that
+    // is shared with other streams and demand loaded objects
+    class DeviceRangeInputStream final : public InputStream
+    {
+    public:
+        DeviceRangeInputStream(InputStreamDevice& device, size_t offset, size_t length)
+            : m_device(&device), m_Position(offset), m_Remaining(length) { }
+
+    protected:
+        size_t readBuffer(char* buffer, size_t size, bool& eof) override
+        {
+            if (m_Remaining == 0)
+            {
+                eof = true;
+                return 0;
+            }
+
+            // NOTE: Seek before every read, since other
+            // readers may have moved the device position
+            m_device->Seek(m_Position);
+            size_t readCount = ReadBuffer(*m_device, buffer, std::min(size, m_Remaining), eof);
+            m_Position += readCount;
+            m_Remaining -= readCount;
+            eof = eof || m_Remaining == 0;
+            return readCount;
+        }
+
+    private:
+        InputStreamDevice* m_device;
+        size_t m_Position;
+        size_t m_Remaining;
+    };
+}
+
+PdfParserObjectStream::PdfParserObjectStream(InputStreamDevice& device, size_t offset, size_t length)
+    : m_device(&device), m_Offset(offset), m_Length(length)
+{
+}
+
+void PdfParserObjectStream::Init(PdfObject& obj)
+{
+    (void)obj;
+}
+
+void PdfParserObjectStream::Clear()
+{
+    m_device = nullptr;
+    m_buffer.clear();
+}
+
+bool PdfParserObjectStream::TryCopyFrom(const PdfObjectStreamProvider& rhs)
+{
+    // NOTE: Always copy the data in memory, so the
+    // stream doesn't depend on the source device of rhs
+    auto parserStream = dynamic_cast<const PdfParserObjectStream*>(&rhs);
+    if (parserStream != nullptr)
+    {
+        charbuff buffer;
+        if (parserStream->m_device == nullptr)
+            buffer = parserStream->m_buffer;
+        else
+            parserStream->copySourceTo(buffer);
+
+        m_buffer = std::move(buffer);
+        m_device = nullptr;
+        return true;
+    }
+
+    auto memStream = dynamic_cast<const PdfMemoryObjectStream*>(&rhs);
+    if (memStream != nullptr)
+    {
+        m_buffer = memStream->GetBuffer();
+        m_device = nullptr;
+        return true;
+    }
+
+    return false;
+}
+
+bool PdfParserObjectStream::TryMoveFrom(PdfObjectStreamProvider&& rhs)
+{
+    auto parserStream = dynamic_cast<PdfParserObjectStream*>(&rhs);
+    if (parserStream != nullptr)
+    {
+        m_device = parserStream->m_device;
+        m_Offset = parserStream->m_Offset;
+        m_Length = parserStream->m_Length;
+        m_buffer = std::move(parserStream->m_buffer);
+        parserStream->Clear();
+        return true;
+    }
+
+    auto memStream = dynamic_cast<PdfMemoryObjectStream*>(&rhs);
+    if (memStream != nullptr)
+    {
+        m_buffer = std::move(memStream->m_buffer);
+        m_device = nullptr;
+        return true;
+    }
+
+    return false;
+}
+
+unique_ptr<InputStream> PdfParserObjectStream::GetInputStream(PdfObject& obj)
+{
+    (void)obj;
+    if (m_device == nullptr)
+        return unique_ptr<InputStream>(new SpanStreamDevice(m_buffer));
+
+    return getSourceStream();
+}
+
+unique_ptr<OutputStream> PdfParserObjectStream::GetOutputStream(PdfObject& obj)
+{
+    (void)obj;
+
+    // The stream is being modified: stop referencing the source
+    m_device = nullptr;
+    m_buffer.clear();
+    return unique_ptr<OutputStream>(new StringStreamDevice(m_buffer));
+}
+
+void PdfParserObjectStream::Write(OutputStream& stream, const PdfStatefulEncrypt* encrypt)
+{
+    stream.Write("stream\n");
+    if (m_device == nullptr || encrypt != nullptr)
+    {
+        charbuff sourceBuffer;
+        const charbuff* buffer;
+        if (m_device == nullptr)
+        {
+            buffer = &m_buffer;
+        }
+        else
+        {
+            copySourceTo(sourceBuffer);
+            buffer = &sourceBuffer;
+        }
+
+        if (encrypt != nullptr)
+        {
+            charbuff encrypted;
+            encrypt->EncryptTo(encrypted, { buffer->data(), buffer->size() });
+            stream.Write(encrypted);
+        }
+        else
+        {
+            stream.Write(string_view(buffer->data(), buffer->size()));
+        }
+    }
+    else
+    {
+        bufferview view;
+        if (m_device->TryGetView(view))
+            stream.Write(string_view(view.data() + m_Offset, m_Length));
+        else
+            copySourceTo(stream);
+    }
+
+    stream.Write("\nendstream\n");
+}
+
+size_t PdfParserObjectStream::GetLength() const
+{
+    if (m_device == nullptr)
+        return m_buffer.size();
+
+    return m_Length;
+}
+
+unique_ptr<InputStream> PdfParserObjectStream::getSourceStream() const
+{
+    // Prefer reading directly from memory, if possible
+    bufferview view;
+    if (m_device->TryGetView(view))
+        return unique_ptr<InputStream>(new SpanStreamDevice(view.data() + m_Offset, m_Length));
+
+    return unique_ptr<InputStream>(new DeviceRangeInputStream(*m_device, m_Offset, m_Length));
+}
+
+void PdfParserObjectStream::copySourceTo(charbuff& buffer) const
+{
+    buffer.resize(m_Length);
+    getSourceStream()->Read(buffer.data(), m_Length);
+}
+
+void PdfParserObjectStream::copySourceTo(OutputStream& stream) const
+{
+    // Copy the data between files in kernel space, if possible,
+    // then read what is left, if any, through a buffer
+    size_t copied = 0;
+    auto sourceFile = dynamic_cast<FileStreamDevice*>(m_device);
+    auto destFile = dynamic_cast<FileStreamDevice*>(&stream);
+    auto bufferedDevice = dynamic_cast<BufferedOutputStreamDevice*>(&stream);
+    if (bufferedDevice != nullptr)
+        destFile = dynamic_cast<FileStreamDevice*>(&bufferedDevice->GetDevice());
+
+    if (sourceFile != nullptr && destFile != nullptr)
+    {
+        if (bufferedDevice == nullptr)
+        {
+            copied = copyFileRange(*sourceFile, m_Offset, m_Length, *destFile);
+        }
+        else
+        {
+            // Write the buffered data first, then update
+            // the position of the device after the copy
+            bufferedDevice->Flush();
+            copied = copyFileRange(*sourceFile, m_Offset, m_Length, *destFile);
+            bufferedDevice->Seek(0, SeekDirection::Current);
+        }
+    }
+
+    if (copied < m_Length)
+        DeviceRangeInputStream(*m_device, m_Offset + copied, m_Length - copied).CopyTo(stream);
+}
+
+size_t PdfParserObjectStream::copyFileRange(FileStreamDevice& source, size_t offset, size_t length,
+    FileStreamDevice& dest)
+{
+#ifdef __linux__
+    // Flush the buffered output so the descriptor is in sync with
+    // the FILE position, which is restored after the copy
+    dest.Flush();
+    int sourceFd = fileno(source.m_file);
+    int destFd = fileno(dest.m_file);
+    ssize_t destOffset = utls::ftell(dest.m_file);
+    if (sourceFd == -1 || destFd == -1 || destOffset == -1)
+        return 0;
+
+    off_t sourcePos = (off_t)offset;
+    off_t destPos = (off_t)destOffset;
+    size_t copied = 0;
+#ifdef HAVE_COPY_FILE_RANGE
+    while (copied < length)
+    {
+        ssize_t count = copy_file_range(sourceFd, &sourcePos, destFd, &destPos, length - copied, 0);
+        if (count <= 0)
+            break;
+
+        copied += (size_t)count;
+    }
+#endif // HAVE_COPY_FILE_RANGE
+
+    // Fall back to sendfile, e.g. on older kernels or when
+    // copying across file systems. It writes at the current
+    // descriptor position
+    if (copied < length && lseek(destFd, destPos, SEEK_SET) != -1)
+    {
+        while (copied < length)
+        {
+            ssize_t count = sendfile(destFd, sourceFd, &sourcePos, length - copied);
+            if (count <= 0)
+                break;
+
+            destPos += (off_t)count;
+            copied += (size_t)count;
+        }
+    }
+
+    if (utls::fseek(dest.m_file, (ssize_t)destPos, SEEK_SET) != 0)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::IOError, "Failed to seek after copying file data");
+
+    return copied;
+#else // !__linux__
+    (void)source;
+    (void)offset;
+    (void)length;
+    (void)dest;
+    return 0;
+#endif // __linux__
+}
@@ -0,0 +1,73 @@
+/**
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#ifndef PDF_PARSER_OBJECT_STREAM_H
+#define PDF_PARSER_OBJECT_STREAM_H
+
+#include <podofo/main/PdfObjectStreamProvider.h>
+#include <podofo/auxiliary/InputDevice.h>
+
+namespace PoDoFo {
+
+class FileStreamDevice;
+
+/** A stream provider that doesn't hold the raw stream
+ * data in memory, but references the range of the source
+ * device where the data is found, reading it on demand
+ *
+ * The data is copied in memory only when the stream is
+ * written, or cleared. The source device must be kept
+ * alive as long as the stream references it, the same
+ * requirement of demand loaded objects.
+ * \remarks Data of encrypted streams must not be
+ * referenced, since it requires decryption
+ *
+ * Unchanged data is written verbatim from the source, with
+ * no intermediate buffer when the device content is in
+ * memory, or with a copy in kernel space between files
+ * where the platform supports it
+ */
+class PdfParserObjectStream final : public PdfObjectStreamProvider
+{
+public:
+    PdfParserObjectStream(InputStreamDevice& device, size_t offset, size_t length);
+
+public:
+    void Init(PdfObject& obj) override;
+
+    void Clear() override;
+
+    bool TryCopyFrom(const PdfObjectStreamProvider& rhs) override;
+
+    bool TryMoveFrom(PdfObjectStreamProvider&& rhs) override;
+
+    std::unique_ptr<InputStream> GetInputStream(PdfObject& obj) override;
+
+    std::unique_ptr<OutputStream> GetOutputStream(PdfObject& obj) override;
+
+    void Write(OutputStream& stream, const PdfStatefulEncrypt* encrypt) override;
+
+    size_t GetLength() const override;
+
+    /** True if the data is still referenced in the source device
+     */
+    bool IsReferenced() const { return m_device != nullptr; }
+
+private:
+    std::unique_ptr<InputStream> getSourceStream() const;
+    void copySourceTo(charbuff& buffer) const;
+    void copySourceTo(OutputStream& stream) const;
+    static size_t copyFileRange(FileStreamDevice& source, size_t offset, size_t length,
+        FileStreamDevice& dest);
+
+private:
+    InputStreamDevice* m_device;
+    size_t m_Offset;
+    size_t m_Length;
+    charbuff m_buffer;
+};
+
+};
+
+#endif // PDF_PARSER_OBJECT_STREAM_H
@@ -7,10 +7,17 @@
 #include "PdfDeclarationsPrivate.h"
 #include "PdfWriter.h"
 
+#include <atomic>
+#include <mutex>
+#include <thread>
+
 #include <podofo/auxiliary/StreamDevice.h>
 #include <podofo/main/PdfDate.h>
 #include <podofo/main/PdfDictionary.h>
+#include <podofo/main/PdfDocument.h>
 #include "PdfParserObject.h"
+#include "PdfParserObjectStream.h"
+#include "PdfLinearizer.h"
 #include "PdfXRefStream.h"
 #include "OpenSSLInternal.h"
 
@@ -18,6 +25,10 @@
 // 10 spaces
 #define LINEARIZATION_PADDING "          "
 
+// Number of objects serialized ahead by each thread
+// before they are written in order
+static constexpr unsigned SerializeAheadBatchSize = 8;
+
 using namespace std;
 using namespace PoDoFo;
 
@@ -29,6 +40,8 @@ PdfWriter::PdfWriter(PdfIndirectObjectList* objects, const PdfObject& trailer) :
     m_Version(PdfVersionDefault),
     m_PdfALevel(PdfALevel::Unknown),
     m_UseXRefStream(false),
+    m_ObjectStreamSize(DefaultObjectStreamSize),
+    m_ThreadCount(1),
     m_Encrypt(nullptr),
     m_EncryptObj(nullptr),
     m_SaveOptions(PdfSaveOptions::None),
@@ -67,6 +80,31 @@ void PdfWriter::initWriteFlags()
 
 void PdfWriter::Write(OutputStreamDevice& device)
 {
+    // Combine the many small writes of the objects
+    // and of the XRef in a large buffer
+    if (dynamic_cast<BufferedOutputStreamDevice*>(&device) == nullptr)
+    {
+        BufferedOutputStreamDevice bufferedDevice(device);
+        write(bufferedDevice);
+        device.Flush();
+    }
+    else
+    {
+        write(device);
+    }
+}
+
+void PdfWriter::write(OutputStreamDevice& device)
+{
+    // Linearized files are written with XRef tables
+    bool linearize = (m_SaveOptions & PdfSaveOptions::Linearize) != PdfSaveOptions::None && !m_IncrementalUpdate;
+    if (linearize)
+        m_UseXRefStream = false;
+
+    // Object streams can be referenced only by XRef streams
+    if ((m_SaveOptions & PdfSaveOptions::ObjectStreams) != PdfSaveOptions::None && !m_IncrementalUpdate && !linearize)
+        SetUseXRefStream(true);
+
     CreateFileIdentifier(m_identifier, *m_Trailer, &m_originalIdentifier);
 
     // setup encrypt dictionary
@@ -87,15 +125,23 @@ void PdfWriter::Write(OutputStreamDevice& device)
 
     try
     {
-        if (!m_IncrementalUpdate)
-            WritePdfHeader(device);
+        if (linearize)
+        {
+            PdfLinearizer linearizer(*this);
+            linearizer.Write(device);
+        }
+        else
+        {
+            if (!m_IncrementalUpdate)
+                WritePdfHeader(device);
 
-        WritePdfObjects(device, *m_Objects, *xRef);
+            WritePdfObjects(device, *m_Objects, *xRef);
 
-        if (m_IncrementalUpdate)
-            xRef->SetFirstEmptyBlock();
+            if (m_IncrementalUpdate)
+                xRef->SetFirstEmptyBlock();
 
-        xRef->Write(device, m_buffer);
+            xRef->Write(device, m_buffer);
+        }
     }
     catch (PdfError& e)
     {
@@ -128,9 +174,56 @@ void PdfWriter::WritePdfHeader(OutputStreamDevice& device)
 
 void PdfWriter::WritePdfObjects(OutputStreamDevice& device, const PdfIndirectObjectList& objects, PdfXRef& xref)
 {
+    bool packObjects = (m_SaveOptions & PdfSaveOptions::ObjectStreams) != PdfSaveOptions::None
+        && m_UseXRefStream && !m_IncrementalUpdate;
+
+    // The object streams get numbers past all the objects of the list.
+    // Packed objects are added to the XRef in order, with the stream
+    // number and index they will have, so the XRef blocks stay contiguous
+    uint32_t firstStreamNumber = objects.GetObjectCount() + 1;
+    vector<PdfObject*> packedObjects;
+
+    // With more threads, the objects with streams to be compressed
+    // or encrypted are serialized ahead in batches by a pool of
+    // workers, following the order they are written
+    vector<PdfObject*> aheadObjects;
+    if (m_ThreadCount > 1)
+    {
+        for (PdfObject* obj : objects)
+        {
+            if ((m_IncrementalUpdate && !obj->IsDirty())
+                || xref.ShouldSkipWrite(obj->GetIndirectReference())
+                || !canSerializeAhead(*obj))
+            {
+                continue;
+            }
+
+            aheadObjects.push_back(obj);
+        }
+
+        // Resolve the /Metadata object now, since the
+        // workers look it up when compressing the streams
+        PdfDocument* document;
+        if (aheadObjects.size() != 0 && (document = aheadObjects[0]->GetDocument()) != nullptr)
+            (void)document->GetCatalog().GetMetadataObject();
+    }
+
+    vector<charbuff> aheadBuffers;
+    size_t aheadIndex = 0;
+    size_t aheadBatchStart = 0;
+    size_t aheadBatchEnd = 0;
     unique_ptr<PdfStatefulEncrypt> encrypt;
     for (PdfObject* obj : objects)
     {
+        if (packObjects && canPackObject(*obj) && !xref.ShouldSkipWrite(obj->GetIndirectReference()))
+        {
+            unsigned count = (unsigned)packedObjects.size();
+            xref.AddCompressedObject(obj->GetIndirectReference(),
+                firstStreamNumber + count / m_ObjectStreamSize, count % m_ObjectStreamSize);
+            packedObjects.push_back(obj);
+            continue;
+        }
+
         if (m_Encrypt != nullptr && obj != m_EncryptObj)
             encrypt.reset(new PdfStatefulEncrypt(m_Encrypt->GetEncrypt(), m_Encrypt->GetContext(), obj->GetIndirectReference()));
         else
@@ -172,6 +265,20 @@ void PdfWriter::WritePdfObjects(OutputStreamDevice& device, const PdfIndirectObj
             // offset of the object and not retrieve it from the device
             xref.AddInUseObject(obj->GetIndirectReference(), 0xFFFFFFFF);
         }
+        else if (aheadIndex < aheadObjects.size() && aheadObjects[aheadIndex] == obj)
+        {
+            if (aheadIndex == aheadBatchEnd)
+            {
+                aheadBatchStart = aheadIndex;
+                aheadBatchEnd = std::min(aheadObjects.size(),
+                    aheadIndex + (size_t)m_ThreadCount * SerializeAheadBatchSize);
+                serializeAhead(aheadObjects, aheadBatchStart, aheadBatchEnd, aheadBuffers);
+            }
+
+            xref.AddInUseObject(obj->GetIndirectReference(), device.GetPosition());
+            device.Write(aheadBuffers[aheadIndex - aheadBatchStart]);
+            aheadIndex++;
+        }
         else
         {
             xref.AddInUseObject(obj->GetIndirectReference(), device.GetPosition());
@@ -180,12 +287,156 @@ void PdfWriter::WritePdfObjects(OutputStreamDevice& device, const PdfIndirectObj
         }
     }
 
+    if (packedObjects.size() != 0)
+        writeObjectStreams(device, packedObjects, firstStreamNumber, xref);
+
     for (auto& freeObjectRef : objects.GetFreeObjects())
     {
         xref.AddFreeObject(freeObjectRef);
     }
 }
 
+bool PdfWriter::canPackObject(const PdfObject& obj) const
+{
+    // Streams, objects with a non zero generation number and
+    // the encryption dictionary can't be stored in object
+    // streams, see ISO 32000-2:2020 7.5.7 "Object streams"
+    return !obj.HasStream() && obj.GetIndirectReference().GenerationNumber() == 0
+        && &obj != m_EncryptObj;
+}
+
+void PdfWriter::writeObjectStreams(OutputStreamDevice& device, const vector<PdfObject*>& objects,
+    uint32_t firstStreamNumber, PdfXRef& xref)
+{
+    charbuff offsets;
+    charbuff data;
+    unique_ptr<PdfStatefulEncrypt> encrypt;
+    for (size_t i = 0; i < objects.size(); i += m_ObjectStreamSize)
+    {
+        size_t count = std::min((size_t)m_ObjectStreamSize, objects.size() - i);
+        offsets.clear();
+        data.clear();
+        {
+            BufferStreamDevice offsetsDevice(offsets);
+            BufferStreamDevice dataDevice(data);
+            for (size_t j = 0; j < count; j++)
+            {
+                auto& obj = *objects[i + j];
+                utls::FormatTo(m_buffer, "{} {} ", obj.GetIndirectReference().ObjectNumber(), data.size());
+                offsetsDevice.Write(m_buffer);
+
+                // NOTE: Objects in object streams are not encrypted
+                // singularly, the whole stream is encrypted instead
+                obj.GetVariant().Write(dataDevice, m_WriteFlags, nullptr, m_buffer);
+                dataDevice.Write('\n');
+                obj.ResetDirty();
+            }
+        }
+
+        PdfObject objStm;
+        objStm.SetIndirectReference(PdfReference(firstStreamNumber + (uint32_t)(i / m_ObjectStreamSize), 0));
+        auto& dict = objStm.GetDictionary();
+        dict.AddKey("Type"_n, "ObjStm"_n);
+        dict.AddKey("N"_n, static_cast<int64_t>(count));
+        dict.AddKey("First"_n, static_cast<int64_t>(offsets.size()));
+        {
+            auto output = objStm.GetOrCreateStream().GetOutputStream();
+            output.Write(offsets);
+            output.Write(data);
+        }
+
+        if (m_Encrypt != nullptr)
+            encrypt.reset(new PdfStatefulEncrypt(m_Encrypt->GetEncrypt(), m_Encrypt->GetContext(), objStm.GetIndirectReference()));
+
+        xref.AddInUseObject(objStm.GetIndirectReference(), device.GetPosition());
+        objStm.WriteFinal(device, m_WriteFlags, encrypt.get(), m_buffer);
+    }
+}
+
+bool PdfWriter::canSerializeAhead(PdfObject& obj) const
+{
+    if (!obj.HasStream())
+        return false;
+
+    // Load the stream now, since delayed loading reads the source device
+    obj.DelayedLoadStream();
+    auto& stream = *obj.GetStream();
+
+    // Streams still referencing the source device are read serially
+    auto parserStream = dynamic_cast<const PdfParserObjectStream*>(&std::as_const(stream).GetProvider());
+    if (parserStream != nullptr && parserStream->IsReferenced())
+        return false;
+
+    if ((m_WriteFlags & PdfWriteFlags::NoFlateCompress) == PdfWriteFlags::None
+        && stream.GetFilters().size() == 0)
+    {
+        return true;
+    }
+
+    return m_Encrypt != nullptr && &obj != m_EncryptObj;
+}
+
+void PdfWriter::serializeAhead(const vector<PdfObject*>& objects, size_t start, size_t end,
+    vector<charbuff>& buffers)
+{
+    buffers.resize(end - start);
+    atomic<size_t> next(start);
+    exception_ptr error;
+    mutex errorMutex;
+    auto work = [&]() {
+        charbuff buffer;
+        // NOTE: The encryption context holds the state
+        // of the cipher, so every worker needs its own
+        unique_ptr<PdfEncryptContext> context;
+        if (m_Encrypt != nullptr)
+            context.reset(new PdfEncryptContext(m_Encrypt->GetContext()));
+
+        try
+        {
+            unique_ptr<PdfStatefulEncrypt> encrypt;
+            while (true)
+            {
+                size_t i = next++;
+                if (i >= end)
+                    break;
+
+                auto& obj = *objects[i];
+                if (context != nullptr && &obj != m_EncryptObj)
+                    encrypt.reset(new PdfStatefulEncrypt(m_Encrypt->GetEncrypt(), *context, obj.GetIndirectReference()));
+                else
+                    encrypt.reset();
+
+                auto& output = buffers[i - start];
+                output.clear();
+                BufferStreamDevice device(output);
+                obj.WriteFinal(device, m_WriteFlags, encrypt.get(), buffer);
+            }
+        }
+        catch (...)
+        {
+            lock_guard<mutex> lock(errorMutex);
+            if (error == nullptr)
+                error = current_exception();
+
+            // Stop the other workers
+            next = end;
+        }
+    };
+
+    // NOTE: The calling thread is also a worker
+    vector<thread> workers;
+    size_t workerCount = std::min((size_t)m_ThreadCount, end - start);
+    for (size_t i = 1; i < workerCount; i++)
+        workers.emplace_back(work);
+
+    work();
+    for (auto& worker : workers)
+        worker.join();
+
+    if (error != nullptr)
+        rethrow_exception(error);
+}
+
 void PdfWriter::FillTrailerObject(PdfObject& trailer, size_t size, bool onlySizeKey) const
 {
     trailer.GetDictionary().AddKey("Size"_n, static_cast<int64_t>(size));
@@ -235,6 +486,22 @@ void PdfWriter::SetPdfALevel(PdfALevel level)
     initWriteFlags();
 }
 
+void PdfWriter::SetObjectStreamSize(unsigned size)
+{
+    if (size == 0)
+        PODOFO_RAISE_ERROR(PdfErrorCode::ValueOutOfRange);
+
+    m_ObjectStreamSize = size;
+}
+
+void PdfWriter::SetThreadCount(unsigned count)
+{
+    if (count == 0)
+        count = std::max(1u, std::thread::hardware_concurrency());
+
+    m_ThreadCount = count;
+}
+
 void PdfWriter::CreateFileIdentifier(PdfString& identifier, const PdfObject& trailer, PdfString* originalIdentifier)
 {
     NullStreamDevice length;
@@ -26,6 +26,13 @@ class PdfXRef;
  */
 class PdfWriter
 {
+    friend class PdfLinearizer;
+
+public:
+    /** Default count of objects packed in an object stream
+     */
+    static constexpr unsigned DefaultObjectStreamSize = 100;
+
 private:
     PdfWriter(PdfIndirectObjectList* objects, const PdfObject& trailer);
 
@@ -88,6 +95,22 @@ public:
 
     void SetPdfALevel(PdfALevel level);
 
+    /** Set the maximum number of objects packed in a
+     * single object stream, when writing with
+     * PdfSaveOptions::ObjectStreams. Default is 100
+     */
+    void SetObjectStreamSize(unsigned size);
+
+    inline unsigned GetObjectStreamSize() const { return m_ObjectStreamSize; }
+
+    /** Set the number of threads used to compress and encrypt
+     * the streams of the objects. 0 means a thread per hardware
+     * core. Default is 1
+     */
+    void SetThreadCount(unsigned count);
+
+    inline unsigned GetThreadCount() const { return m_ThreadCount; }
+
     inline PdfALevel GetPdfALevel() const { return m_PdfALevel; }
 
     /**
@@ -166,7 +189,14 @@ protected:
     void SetEncryptObj(PdfObject& obj);
 
 private:
+    void write(OutputStreamDevice& device);
     void initWriteFlags();
+    bool canPackObject(const PdfObject& obj) const;
+    void writeObjectStreams(OutputStreamDevice& device, const std::vector<PdfObject*>& objects,
+        uint32_t firstStreamNumber, PdfXRef& xref);
+    bool canSerializeAhead(PdfObject& obj) const;
+    void serializeAhead(const std::vector<PdfObject*>& objects, size_t start, size_t end,
+        std::vector<charbuff>& buffers);
 
 protected:
     charbuff m_buffer;
@@ -178,6 +208,8 @@ private:
     PdfALevel m_PdfALevel;
 
     bool m_UseXRefStream;
+    unsigned m_ObjectStreamSize;
+    unsigned m_ThreadCount;
 
     PdfEncryptSession* m_Encrypt;             // If not nullptr encrypt all strings and streams and
                                               // create an encryption dictionary in the trailer
@@ -14,6 +14,11 @@
 
 #define EMPTY_OBJECT_GENERATION 65535
 
+// The size of the blocks of formatted XRef table entries
+constexpr size_t TableBlockSize = 64 * 1024;
+
+static void formatDigits(char* str, unsigned length, uint64_t value);
+
 using namespace std;
 using namespace PoDoFo;
 
@@ -27,31 +32,41 @@ PdfXRef::~PdfXRef() { }
 
 void PdfXRef::AddInUseObject(const PdfReference& ref, nullable<uint64_t> offset)
 {
-    addObject(ref, offset, true);
+    if (offset == nullptr)
+    {
+        // Objects with no offset provided will not be written
+        // in the entry list
+        if (ref.ObjectNumber() > m_maxObjCount)
+            m_maxObjCount = ref.ObjectNumber();
+
+        return;
+    }
+
+    auto entry = PdfXRefEntry::CreateInUse(*offset, ref.GenerationNumber());
+    addObject(ref, &entry);
+}
+
+void PdfXRef::AddCompressedObject(const PdfReference& ref, uint32_t streamObjectNumber, unsigned index)
+{
+    auto entry = PdfXRefEntry::CreateCompressed(streamObjectNumber, index);
+    addObject(ref, &entry);
 }
 
 void PdfXRef::AddFreeObject(const PdfReference& ref)
 {
-    addObject(ref, nullptr, false);
+    addObject(ref, nullptr);
 }
 
-void PdfXRef::addObject(const PdfReference& ref, nullable<uint64_t> offset, bool inUse)
+void PdfXRef::addObject(const PdfReference& ref, const PdfXRefEntry* entry)
 {
     if (ref.ObjectNumber() > m_maxObjCount)
         m_maxObjCount = ref.ObjectNumber();
 
-    if (inUse && offset == nullptr)
-    {
-        // Objects with no offset provided will not be written
-        // in the entry list
-        return;
-    }
-
     bool insertDone = false;
 
     for (auto& block : m_blocks)
     {
-        if (block.InsertItem(ref, offset, inUse))
+        if (block.InsertItem(ref, entry))
         {
             insertDone = true;
             break;
@@ -63,10 +78,10 @@ void PdfXRef::addObject(const PdfReference& ref, nullable<uint64_t> offset, bool
         PdfXRefBlock block;
         block.First = ref.ObjectNumber();
         block.Count = 1;
-        if (inUse)
-            block.Items.push_back(XRefItem(ref, offset.value()));
-        else
+        if (entry == nullptr)
             block.FreeItems.push_back(ref);
+        else
+            block.Items.push_back(XRefItem(ref, *entry));
 
         m_blocks.push_back(block);
         std::sort(m_blocks.begin(), m_blocks.end());
@@ -108,8 +123,7 @@ void PdfXRef::Write(OutputStreamDevice& device, charbuff& buffer)
         {
             const PdfReference* firstFree = getFirstFreeObject(it, itFree);
             this->WriteXRefEntry(device, PdfReference(0, EMPTY_OBJECT_GENERATION),
-                PdfXRefEntry::CreateFree(firstFree == nullptr ? 0 : firstFree->ObjectNumber(), EMPTY_OBJECT_GENERATION),
-                buffer);
+                PdfXRefEntry::CreateFree(firstFree == nullptr ? 0 : firstFree->ObjectNumber(), EMPTY_OBJECT_GENERATION));
         }
 
         while (itItems != block.Items.end())
@@ -125,12 +139,11 @@ void PdfXRef::Write(OutputStreamDevice& device, charbuff& buffer)
 
                 // write free object
                 this->WriteXRefEntry(device, *itFree,
-                    PdfXRefEntry::CreateFree(nextFree == nullptr ? 0 : nextFree->ObjectNumber(), genNo), buffer);
+                    PdfXRefEntry::CreateFree(nextFree == nullptr ? 0 : nextFree->ObjectNumber(), genNo));
                 itFree++;
             }
 
-            this->WriteXRefEntry(device, itItems->Reference,
-                PdfXRefEntry::CreateInUse(itItems->Offset, itItems->Reference.GenerationNumber()), buffer);
+            this->WriteXRefEntry(device, itItems->Reference, itItems->Entry);
             itItems++;
         }
 
@@ -144,7 +157,7 @@ void PdfXRef::Write(OutputStreamDevice& device, charbuff& buffer)
 
             // write free object
             this->WriteXRefEntry(device, *itFree,
-                PdfXRefEntry::CreateFree(nextFree  == nullptr ? 0 : nextFree->ObjectNumber(), genNo), buffer);
+                PdfXRefEntry::CreateFree(nextFree  == nullptr ? 0 : nextFree->ObjectNumber(), genNo));
             itFree++;
         }
 
@@ -247,7 +260,7 @@ void PdfXRef::mergeBlocks()
 void PdfXRef::BeginWrite(OutputStreamDevice& device, charbuff& buffer)
 {
     (void)buffer;
-    device.Write("xref\n");
+    appendTable(device, "xref\n");
 }
 
 void PdfXRef::WriteSubSection(OutputStreamDevice& device, uint32_t first, uint32_t count, charbuff& buffer)
@@ -256,10 +269,10 @@ void PdfXRef::WriteSubSection(OutputStreamDevice& device, uint32_t first, uint32
     PoDoFo::LogMessage(PdfLogSeverity::Debug, "Writing XRef section: {} {}", first, count);
 #endif // DEBUG
     utls::FormatTo(buffer, "{} {}\n", first, count);
-    device.Write(buffer);
+    appendTable(device, buffer);
 }
 
-void PdfXRef::WriteXRefEntry(OutputStreamDevice& device, const PdfReference& ref, const PdfXRefEntry& entry, charbuff& buffer)
+void PdfXRef::WriteXRefEntry(OutputStreamDevice& device, const PdfReference& ref, const PdfXRefEntry& entry)
 {
     (void)ref;
     uint64_t variant;
@@ -279,8 +292,20 @@ void PdfXRef::WriteXRefEntry(OutputStreamDevice& device, const PdfReference& ref
             PODOFO_RAISE_ERROR(PdfErrorCode::InvalidEnumValue);
     }
 
-    utls::FormatTo(buffer, "{:010d} {:05d} {} \n", variant, entry.Generation, XRefEntryTypeToChar(entry.Type));
-    device.Write(buffer);
+    if (variant > 9999999999)
+        PODOFO_RAISE_ERROR_INFO(PdfErrorCode::ValueOutOfRange, "The offset is too big for a XRef table");
+
+    // Format the fixed size entry by hand, since the
+    // table may have hundreds of thousands of entries
+    char str[20];
+    formatDigits(str, 10, variant);
+    str[10] = ' ';
+    formatDigits(str + 11, 5, entry.Generation);
+    str[16] = ' ';
+    str[17] = XRefEntryTypeToChar(entry.Type);
+    str[18] = ' ';
+    str[19] = '\n';
+    appendTable(device, string_view(str, std::size(str)));
 }
 
 void PdfXRef::EndWriteImpl(OutputStreamDevice& device, charbuff& buffer)
@@ -298,6 +323,7 @@ void PdfXRef::EndWriteImpl(OutputStreamDevice& device, charbuff& buffer)
 
 void PdfXRef::endWrite(OutputStreamDevice& device, charbuff& buffer)
 {
+    flushTable(device);
     EndWriteImpl(device, buffer);
     utls::FormatTo(buffer, "startxref\n{}\n%%EOF\n", GetOffset());
     device.Write(buffer);
@@ -318,18 +344,17 @@ bool PdfXRef::ShouldSkipWrite(const PdfReference& ref)
     return false;
 }
 
-bool PdfXRef::PdfXRefBlock::InsertItem(const PdfReference& ref, nullable<uint64_t> offset, bool inUse)
+bool PdfXRef::PdfXRefBlock::InsertItem(const PdfReference& ref, const PdfXRefEntry* entry)
 {
-    PODOFO_ASSERT(!inUse || offset.has_value());
     if (ref.ObjectNumber() == First + Count)
     {
         // Insert at back
         Count++;
 
-        if (inUse)
-            Items.push_back(XRefItem(ref, offset.value()));
-        else
+        if (entry == nullptr)
             FreeItems.push_back(ref);
+        else
+            Items.push_back(XRefItem(ref, *entry));
 
         return true; // no sorting required
     }
@@ -340,10 +365,10 @@ bool PdfXRef::PdfXRefBlock::InsertItem(const PdfReference& ref, nullable<uint64_
         Count++;
 
         // This is known to be slow, but should not occur actually
-        if (inUse)
-            Items.insert(Items.begin(), XRefItem(ref, offset.value()));
-        else
+        if (entry == nullptr)
             FreeItems.insert(FreeItems.begin(), ref);
+        else
+            Items.insert(Items.begin(), XRefItem(ref, *entry));
 
         return true; // no sorting required
     }
@@ -353,15 +378,15 @@ bool PdfXRef::PdfXRefBlock::InsertItem(const PdfReference& ref, nullable<uint64_
         // Insert at back
         Count++;
 
-        if (inUse)
+        if (entry == nullptr)
         {
-            Items.push_back(XRefItem(ref, offset.value()));
-            std::sort(Items.begin(), Items.end());
+            FreeItems.push_back(ref);
+            std::sort(FreeItems.begin(), FreeItems.end());
         }
         else
         {
-            FreeItems.push_back(ref);
-            std::sort(FreeItems.begin(), FreeItems.end());
+            Items.push_back(XRefItem(ref, *entry));
+            std::sort(Items.begin(), Items.end());
         }
 
         return true;
@@ -369,3 +394,25 @@ bool PdfXRef::PdfXRefBlock::InsertItem(const PdfReference& ref, nullable<uint64_
 
     return false;
 }
+
+void PdfXRef::appendTable(OutputStreamDevice& device, const string_view& str)
+{
+    m_table.append(str);
+    if (m_table.size() >= TableBlockSize)
+        flushTable(device);
+}
+
+void PdfXRef::flushTable(OutputStreamDevice& device)
+{
+    device.Write(m_table);
+    m_table.clear();
+}
+
+void formatDigits(char* str, unsigned length, uint64_t value)
+{
+    for (unsigned i = length; i != 0; i--)
+    {
+        str[i - 1] = (char)('0' + value % 10);
+        value /= 10;
+    }
+}
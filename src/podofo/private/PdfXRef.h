@@ -35,11 +35,11 @@ public:
 protected:
     struct XRefItem
     {
-        XRefItem(const PdfReference& ref, uint64_t off)
-            : Reference(ref), Offset(off) { }
+        XRefItem(const PdfReference& ref, const PdfXRefEntry& entry)
+            : Reference(ref), Entry(entry) { }
 
         PdfReference Reference;
-        uint64_t Offset;
+        PdfXRefEntry Entry;
 
         bool operator<(const XRefItem& rhs) const
         {
@@ -57,7 +57,7 @@ protected:
 
         PdfXRefBlock(const PdfXRefBlock& rhs) = default;
 
-        bool InsertItem(const PdfReference& ref, nullable<uint64_t> offset, bool bUsed);
+        bool InsertItem(const PdfReference& ref, const PdfXRefEntry* entry);
 
         bool operator<(const PdfXRefBlock& rhs) const
         {
@@ -86,6 +86,15 @@ public:
      */
     void AddInUseObject(const PdfReference& ref, nullable<uint64_t> offset);
 
+    /** Add an object compressed in an object stream to the XRef table
+     *
+     *  \param ref reference of this object
+     *  \param streamObjectNumber object number of the object stream
+     *  \param index the index of the object in the stream
+     *  \remarks Only XRef streams can hold these entries
+     */
+    void AddCompressedObject(const PdfReference& ref, uint32_t streamObjectNumber, unsigned index);
+
     /** Add a free object to the XRef table.
      *
      *  \param ref reference of this object
@@ -156,7 +165,7 @@ protected:
      *  \param ref the reference of object of the entry
      *  \param entry the XRefEntry of this object
      */
-    virtual void WriteXRefEntry(OutputStreamDevice& device, const PdfReference& ref, const PdfXRefEntry& entry, charbuff& buffer);
+    virtual void WriteXRefEntry(OutputStreamDevice& device, const PdfReference& ref, const PdfXRefEntry& entry);
 
     /**  Sub classes can overload this method to finish a XRef table.
      *
@@ -166,7 +175,7 @@ protected:
     virtual void EndWriteImpl(OutputStreamDevice& device, charbuff& buffer);
 
 private:
-    void addObject(const PdfReference& ref, nullable<uint64_t> offset, bool inUse);
+    void addObject(const PdfReference& ref, const PdfXRefEntry* entry);
 
     /** Called at the end of writing the XRef table.
      *  Sub classes can overload this method to finish a XRef table.
@@ -187,11 +196,16 @@ private:
      */
     void mergeBlocks();
 
+    void appendTable(OutputStreamDevice& device, const std::string_view& str);
+    void flushTable(OutputStreamDevice& device);
+
 private:
     uint32_t m_maxObjCount;
     XRefBlockList m_blocks;
     PdfWriter* m_writer;
     uint64_t m_offset;
+    // The formatted XRef table, written to the device in large blocks
+    charbuff m_table;
 };
 
 };
@@ -53,10 +53,9 @@ void PdfXRefStream::WriteSubSection(OutputStreamDevice& device, uint32_t first,
 }
 
 void PdfXRefStream::WriteXRefEntry(OutputStreamDevice& device, const PdfReference& ref,
-    const PdfXRefEntry& entry, charbuff& buffer)
+    const PdfXRefEntry& entry)
 {
     (void)device;
-    (void)buffer;
     XRefStreamEntry stmEntry;
     stmEntry.Type = static_cast<uint8_t>(entry.Type);
 
@@ -71,10 +70,14 @@ void PdfXRefStream::WriteXRefEntry(OutputStreamDevice& device, const PdfReferenc
         case PdfXRefEntryType::InUse:
             stmEntry.Variant = AS_BIG_ENDIAN(static_cast<uint32_t>(entry.Offset));
             break;
+        case PdfXRefEntryType::Compressed:
+            stmEntry.Variant = AS_BIG_ENDIAN(static_cast<uint32_t>(entry.ObjectNumber));
+            break;
         default:
             PODOFO_RAISE_ERROR(PdfErrorCode::InvalidEnumValue);
     }
 
+    // NOTE: For compressed entries this is the index in the stream
     stmEntry.Generation = AS_BIG_ENDIAN(static_cast<uint16_t>(entry.Generation));
     m_rawEntries.push_back(stmEntry);
 }
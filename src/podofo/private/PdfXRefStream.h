@@ -44,7 +44,7 @@ protected:
     void WriteSubSection(OutputStreamDevice& device, uint32_t first, uint32_t count,
         charbuff& buffer) override;
     void WriteXRefEntry(OutputStreamDevice& device, const PdfReference& ref,
-        const PdfXRefEntry& entry, charbuff& buffer) override;
+        const PdfXRefEntry& entry) override;
     void EndWriteImpl(OutputStreamDevice& device, charbuff& buffer) override;
 
 private:
@@ -12,6 +12,17 @@
 using namespace std;
 using namespace PoDoFo;
 
+namespace PoDoFo
+{
+    class PdfObjectListTest
+    {
+    public:
+        static void TestSparseNumbers();
+    };
+}
+
+METHOD_AS_TEST_CASE(PdfObjectListTest::TestSparseNumbers, "TestObjectListSparseNumbers")
+
 /** This class tests the basic integer and other types PoDoFo uses
  *  to make sure they satisfy its requirements for behaviour, size, etc.
  */
@@ -105,6 +116,164 @@ TEST_CASE("TestIterations2")
     REQUIRE(fields.size() == 23);
 }
 
+TEST_CASE("TestObjectListIterations")
+{
+    PdfMemDocument doc;
+    auto& objects = doc.GetObjects();
+    auto& arr = doc.GetCatalog().GetDictionary().AddKey("Test"_n, PdfArray()).GetArray();
+    vector<PdfReference> refs;
+    for (unsigned i = 0; i < 5; i++)
+    {
+        auto& obj = objects.CreateDictionaryObject();
+        refs.push_back(obj.GetIndirectReference());
+        if (i != 2)
+            arr.AddIndirect(obj);
+    }
+
+    // Leave a hole in the object numbers
+    objects.CollectGarbage();
+    REQUIRE(objects.GetObject(refs[2]) == nullptr);
+    REQUIRE(objects.GetObject(PdfReference(refs[1].ObjectNumber(), 1)) == nullptr);
+    REQUIRE(&objects.MustGetObject(refs[1]) != nullptr);
+
+    vector<uint32_t> forward;
+    for (auto obj : objects)
+        forward.push_back(obj->GetIndirectReference().ObjectNumber());
+
+    REQUIRE(forward.size() == objects.GetSize());
+    REQUIRE(std::is_sorted(forward.begin(), forward.end()));
+
+    vector<uint32_t> backward;
+    for (auto it = objects.rbegin(); it != objects.rend(); it++)
+        backward.push_back((*it)->GetIndirectReference().ObjectNumber());
+
+    std::reverse(backward.begin(), backward.end());
+    REQUIRE(forward == backward);
+
+    // Objects pushed while iterating are visited as well
+    unsigned count = 0;
+    for (auto obj : objects)
+    {
+        (void)obj;
+        if (count == 0)
+            (void)objects.CreateArrayObject();
+
+        count++;
+    }
+
+    REQUIRE(count == forward.size() + 1);
+}
+
+void PdfObjectListTest::TestSparseNumbers()
+{
+    PdfMemDocument doc;
+    auto& objects = doc.GetObjects();
+    auto& arr = doc.GetCatalog().GetDictionary().AddKey("Test"_n, PdfArray()).GetArray();
+    auto& small = objects.CreateDictionaryObject();
+
+    // Objects with a huge object number don't grow the object
+    // vector, but they are found and iterated in order
+    objects.AddFreeObject(PdfReference(8000000, 0));
+    auto& huge = objects.CreateDictionaryObject();
+    auto& next = objects.CreateDictionaryObject();
+    auto hugeRef = huge.GetIndirectReference();
+    REQUIRE(hugeRef.ObjectNumber() == 8000000);
+    REQUIRE(next.GetIndirectReference().ObjectNumber() == 8000001);
+    REQUIRE(objects.GetObject(hugeRef) == &huge);
+    REQUIRE(objects.GetObject(PdfReference(7999999, 0)) == nullptr);
+    arr.AddIndirect(small);
+    arr.AddIndirect(huge);
+    arr.AddIndirect(next);
+
+    vector<uint32_t> forward;
+    for (auto obj : objects)
+        forward.push_back(obj->GetIndirectReference().ObjectNumber());
+
+    REQUIRE(forward.size() == objects.GetSize());
+    REQUIRE(std::is_sorted(forward.begin(), forward.end()));
+    REQUIRE(forward.back() == 8000001);
+
+    vector<uint32_t> backward;
+    for (auto it = objects.rbegin(); it != objects.rend(); it++)
+        backward.push_back((*it)->GetIndirectReference().ObjectNumber());
+
+    std::reverse(backward.begin(), backward.end());
+    REQUIRE(forward == backward);
+
+    auto hugeIt = --(--objects.end());
+    REQUIRE(*hugeIt == &huge);
+    REQUIRE_THROWS_AS(*objects.end(), PdfError);
+
+    // Unreferenced sparse objects are collected as well
+    arr.RemoveAt(1);
+    objects.CollectGarbage();
+    REQUIRE(objects.GetObject(hugeRef) == nullptr);
+    REQUIRE(objects.GetObject(next.GetIndirectReference()) == &next);
+    REQUIRE(objects.GetSize() == forward.size() - 1);
+
+    // Dereferencing an iterator to a removed object is an error
+    REQUIRE_THROWS_AS(*hugeIt, PdfError);
+}
+
+TEST_CASE("TestIncrementalCollectGarbage")
+{
+    PdfMemDocument doc;
+    auto& objects = doc.GetObjects();
+    auto& arr = doc.GetCatalog().GetDictionary().AddKey("Test"_n, PdfArray()).GetArray();
+
+    // A chain of objects, the first referenced by the catalog
+    vector<PdfReference> refs;
+    PdfObject* prev = nullptr;
+    for (unsigned i = 0; i < 5; i++)
+    {
+        auto& obj = objects.CreateDictionaryObject();
+        refs.push_back(obj.GetIndirectReference());
+        if (prev == nullptr)
+            arr.AddIndirect(obj);
+        else
+            prev->GetDictionary().AddKeyIndirect("Next"_n, obj);
+        prev = &obj;
+    }
+    auto& unreferenced = objects.CreateDictionaryObject();
+
+    doc.CollectGarbage(true);
+    REQUIRE(objects.GetObject(unreferenced.GetIndirectReference()) == nullptr);
+    for (auto& ref : refs)
+        REQUIRE(objects.GetObject(ref) != nullptr);
+
+    // Cut the chain in the middle: the modified object is scanned again
+    objects.MustGetObject(refs[2]).GetDictionary().RemoveKey("Next");
+    doc.CollectGarbage(true);
+    REQUIRE(objects.GetObject(refs[2]) != nullptr);
+    REQUIRE(objects.GetObject(refs[3]) == nullptr);
+    REQUIRE(objects.GetObject(refs[4]) == nullptr);
+
+    // Objects added after the collection are scanned as well
+    auto& added = objects.CreateDictionaryObject();
+    auto& child = objects.CreateDictionaryObject();
+    added.GetDictionary().AddKeyIndirect("Child"_n, child);
+    objects.MustGetObject(refs[2]).GetDictionary().AddKeyIndirect("Next"_n, added);
+    doc.CollectGarbage(true);
+    REQUIRE(objects.GetObject(added.GetIndirectReference()) != nullptr);
+    REQUIRE(objects.GetObject(child.GetIndirectReference()) != nullptr);
+
+    // Modifying a nested direct object touches the indirect object
+    added.GetDictionary().AddKey("Nested"_n, PdfDictionary());
+    added.GetDictionary().MustFindKey("Nested").GetDictionary().AddKeyIndirect("Child"_n, child);
+    added.GetDictionary().RemoveKey("Child");
+    doc.CollectGarbage(true);
+    REQUIRE(objects.GetObject(child.GetIndirectReference()) != nullptr);
+
+    // Full and incremental collections agree
+    arr.Clear();
+    doc.CollectGarbage(true);
+    for (auto& ref : refs)
+        REQUIRE(objects.GetObject(ref) == nullptr);
+    auto size = objects.GetSize();
+    doc.CollectGarbage();
+    REQUIRE(objects.GetSize() == size);
+}
+
 TEST_CASE("ErrorFilePath")
 {
     try
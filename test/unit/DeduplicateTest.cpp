@@ -11,72 +11,55 @@ using namespace PoDoFo;
 TEST_CASE("DeduplicateEmptyDocument")
 {
     PdfMemDocument doc;
-    
+    unsigned initialSize = doc.GetObjects().GetSize();
+
     // Test with empty document - should not crash
     doc.DeduplicateObjects();
-    REQUIRE(doc.GetObjects().GetSize() == 0);
-    
+    REQUIRE(doc.GetObjects().GetSize() == initialSize);
+
     doc.DeduplicateObjects(true);  // aggressive mode
-    REQUIRE(doc.GetObjects().GetSize() == 0);
+    REQUIRE(doc.GetObjects().GetSize() == initialSize);
 }
 
 TEST_CASE("DeduplicateSimpleObjects")
 {
     PdfMemDocument doc;
-    
-    // Create some duplicate objects
-    auto& obj1 = doc.GetObjects().CreateObject(PdfObject(42));
-    auto& obj2 = doc.GetObjects().CreateObject(PdfObject(42));
-    auto& obj3 = doc.GetObjects().CreateObject(PdfObject(100));
-    
+    auto& catalog = doc.GetCatalog().GetDictionary();
+
+    // Create some duplicate objects, referenced by the catalog
+    catalog.AddKeyIndirect("Obj1"_n, doc.GetObjects().CreateObject(PdfObject(static_cast<int64_t>(42))));
+    catalog.AddKeyIndirect("Obj2"_n, doc.GetObjects().CreateObject(PdfObject(static_cast<int64_t>(42))));
+    catalog.AddKeyIndirect("Obj3"_n, doc.GetObjects().CreateObject(PdfObject(static_cast<int64_t>(100))));
+
     unsigned initialSize = doc.GetObjects().GetSize();
-    REQUIRE(initialSize >= 3);
-    
+
     // Perform deduplication
     doc.DeduplicateObjects();
-    
-    // Should have reduced the number of objects
-    unsigned finalSize = doc.GetObjects().GetSize();
-    REQUIRE(finalSize < initialSize);
-    
+
     // The duplicate integer objects should have been merged
-    bool found42 = false;
-    bool found100 = false;
-    
-    for (auto obj : doc.GetObjects())
-    {
-        if (obj->IsNumber() && obj->GetInt64() == 42)
-            found42 = true;
-        else if (obj->IsNumber() && obj->GetInt64() == 100)
-            found100 = true;
-    }
-    
-    REQUIRE(found42);
-    REQUIRE(found100);
+    REQUIRE(doc.GetObjects().GetSize() == initialSize - 1);
+    REQUIRE(catalog.MustGetKey("Obj1").GetReference() == catalog.MustGetKey("Obj2").GetReference());
+    REQUIRE(catalog.MustFindKey("Obj1").GetNumber() == 42);
+    REQUIRE(catalog.MustFindKey("Obj3").GetNumber() == 100);
 }
 
 TEST_CASE("DeduplicateStringObjects")
 {
     PdfMemDocument doc;
-    
+    auto& catalog = doc.GetCatalog().GetDictionary();
+
     // Create duplicate string objects
-    auto& obj1 = doc.GetObjects().CreateObject(PdfObject(PdfString("Hello")));
-    auto& obj2 = doc.GetObjects().CreateObject(PdfObject(PdfString("Hello")));
-    auto& obj3 = doc.GetObjects().CreateObject(PdfObject(PdfString("World")));
-    
-    unsigned initialSize = doc.GetObjects().GetSize();
-    
+    catalog.AddKeyIndirect("Obj1"_n, doc.GetObjects().CreateObject(PdfObject(PdfString("Hello"))));
+    catalog.AddKeyIndirect("Obj2"_n, doc.GetObjects().CreateObject(PdfObject(PdfString("Hello"))));
+    catalog.AddKeyIndirect("Obj3"_n, doc.GetObjects().CreateObject(PdfObject(PdfString("World"))));
+
     // Perform deduplication
     doc.DeduplicateObjects();
-    
-    // Should have reduced the number of objects
-    unsigned finalSize = doc.GetObjects().GetSize();
-    REQUIRE(finalSize < initialSize);
-    
+
     // Count unique strings
     int helloCount = 0;
     int worldCount = 0;
-    
+
     for (auto obj : doc.GetObjects())
     {
         if (obj->IsString())
@@ -87,119 +70,101 @@ TEST_CASE("DeduplicateStringObjects")
                 worldCount++;
         }
     }
-    
+
     REQUIRE(helloCount == 1);  // Should only have one "Hello" object
     REQUIRE(worldCount == 1);  // Should only have one "World" object
+    REQUIRE(catalog.MustGetKey("Obj1").GetReference() == catalog.MustGetKey("Obj2").GetReference());
 }
 
 TEST_CASE("DeduplicateArrayObjects")
 {
     PdfMemDocument doc;
-    
+    auto& catalog = doc.GetCatalog().GetDictionary();
+
     // Create duplicate array objects
     PdfArray arr1;
-    arr1.Add(PdfObject(1));
-    arr1.Add(PdfObject(2));
-    arr1.Add(PdfObject(3));
-    
-    PdfArray arr2;
-    arr2.Add(PdfObject(1));
-    arr2.Add(PdfObject(2));
-    arr2.Add(PdfObject(3));
-    
-    auto& obj1 = doc.GetObjects().CreateObject(arr1);
-    auto& obj2 = doc.GetObjects().CreateObject(arr2);
-    
-    unsigned initialSize = doc.GetObjects().GetSize();
-    
+    arr1.Add(PdfObject(static_cast<int64_t>(1)));
+    arr1.Add(PdfObject(static_cast<int64_t>(2)));
+    arr1.Add(PdfObject(static_cast<int64_t>(3)));
+
+    PdfArray arr2(arr1);
+    PdfArray arr3(arr1);
+    arr3.Add(PdfObject(static_cast<int64_t>(4)));
+
+    catalog.AddKeyIndirect("Obj1"_n, doc.GetObjects().CreateObject(arr1));
+    catalog.AddKeyIndirect("Obj2"_n, doc.GetObjects().CreateObject(arr2));
+    catalog.AddKeyIndirect("Obj3"_n, doc.GetObjects().CreateObject(arr3));
+
     // Perform deduplication
     doc.DeduplicateObjects();
-    
-    // Should have reduced the number of objects
-    unsigned finalSize = doc.GetObjects().GetSize();
-    REQUIRE(finalSize < initialSize);
-    
-    // Should only have one array object
+
+    // Should only have two array objects
     int arrayCount = 0;
     for (auto obj : doc.GetObjects())
     {
         if (obj->IsArray())
             arrayCount++;
     }
-    
-    REQUIRE(arrayCount == 1);
+
+    REQUIRE(arrayCount == 2);
+    REQUIRE(catalog.MustGetKey("Obj1").GetReference() == catalog.MustGetKey("Obj2").GetReference());
+    REQUIRE(catalog.MustGetKey("Obj1").GetReference() != catalog.MustGetKey("Obj3").GetReference());
 }
 
 TEST_CASE("DeduplicateDictionaryObjects")
 {
     PdfMemDocument doc;
-    
-    // Create duplicate dictionary objects
+    auto& catalog = doc.GetCatalog().GetDictionary();
+
+    // Create duplicate dictionary objects, with keys added in different order
     PdfDictionary dict1;
-    dict1.AddKey("Key1", PdfObject(100));
-    dict1.AddKey("Key2", PdfObject(PdfString("Value")));
-    
+    dict1.AddKey("Key1"_n, PdfObject(static_cast<int64_t>(100)));
+    dict1.AddKey("Key2"_n, PdfObject(PdfString("Value")));
+
     PdfDictionary dict2;
-    dict2.AddKey("Key1", PdfObject(100));
-    dict2.AddKey("Key2", PdfObject(PdfString("Value")));
-    
-    auto& obj1 = doc.GetObjects().CreateObject(dict1);
-    auto& obj2 = doc.GetObjects().CreateObject(dict2);
-    
+    dict2.AddKey("Key2"_n, PdfObject(PdfString("Value")));
+    dict2.AddKey("Key1"_n, PdfObject(static_cast<int64_t>(100)));
+
+    catalog.AddKeyIndirect("Obj1"_n, doc.GetObjects().CreateObject(dict1));
+    catalog.AddKeyIndirect("Obj2"_n, doc.GetObjects().CreateObject(dict2));
+
     unsigned initialSize = doc.GetObjects().GetSize();
-    
+
     // Perform deduplication
     doc.DeduplicateObjects();
-    
-    // Should have reduced the number of objects
-    unsigned finalSize = doc.GetObjects().GetSize();
-    REQUIRE(finalSize < initialSize);
-    
-    // Should only have one dictionary object
-    int dictCount = 0;
-    for (auto obj : doc.GetObjects())
-    {
-        if (obj->IsDictionary())
-            dictCount++;
-    }
-    
-    REQUIRE(dictCount == 1);
+
+    REQUIRE(doc.GetObjects().GetSize() == initialSize - 1);
+    REQUIRE(catalog.MustGetKey("Obj1").GetReference() == catalog.MustGetKey("Obj2").GetReference());
+    REQUIRE(catalog.MustFindKey("Obj2").GetDictionary().MustFindKey("Key1").GetNumber() == 100);
 }
 
 TEST_CASE("DeduplicateWithReferences")
 {
     PdfMemDocument doc;
-    
-    // Create objects that reference each other
-    auto& refObj = doc.GetObjects().CreateObject(PdfObject(42));
-    
+    auto& catalog = doc.GetCatalog().GetDictionary();
+
+    // Create arrays that reference equal objects
+    auto& refObj1 = doc.GetObjects().CreateObject(PdfObject(static_cast<int64_t>(42)));
+    auto& refObj2 = doc.GetObjects().CreateObject(PdfObject(static_cast<int64_t>(42)));
+
     PdfArray arr1;
-    arr1.Add(refObj.GetIndirectReference());
-    
+    arr1.Add(refObj1.GetIndirectReference());
+
     PdfArray arr2;
-    arr2.Add(refObj.GetIndirectReference());
-    
-    auto& obj1 = doc.GetObjects().CreateObject(arr1);
-    auto& obj2 = doc.GetObjects().CreateObject(arr2);
-    
+    arr2.Add(refObj2.GetIndirectReference());
+
+    catalog.AddKeyIndirect("Obj1"_n, doc.GetObjects().CreateObject(arr1));
+    catalog.AddKeyIndirect("Obj2"_n, doc.GetObjects().CreateObject(arr2));
+
     unsigned initialSize = doc.GetObjects().GetSize();
-    
+
     // Perform deduplication
     doc.DeduplicateObjects();
-    
-    // Should have reduced the number of objects
-    unsigned finalSize = doc.GetObjects().GetSize();
-    REQUIRE(finalSize < initialSize);
-    
-    // The arrays should have been deduplicated
-    int arrayCount = 0;
-    for (auto obj : doc.GetObjects())
-    {
-        if (obj->IsArray())
-            arrayCount++;
-    }
-    
-    REQUIRE(arrayCount == 1);
+
+    // Both the referenced objects and the arrays should have been merged
+    REQUIRE(doc.GetObjects().GetSize() == initialSize - 2);
+    REQUIRE(catalog.MustGetKey("Obj1").GetReference() == catalog.MustGetKey("Obj2").GetReference());
+    REQUIRE(catalog.MustFindKey("Obj1").GetArray().MustFindAt(0).GetNumber() == 42);
 }
 
 TEST_CASE("DeduplicateAggressiveMode")
@@ -210,9 +175,10 @@ TEST_CASE("DeduplicateAggressiveMode")
     auto& page = doc.GetPages().CreatePage(PdfPageSize::A4);
     
     // Create some content on the page
-    auto& painter = page.GetPainter();
-    painter.SetColor(0.5, 0.5, 0.5);
-    painter.DrawRect(100, 100, 200, 200);
+    PdfPainter painter;
+    painter.SetCanvas(page);
+    painter.GraphicsState.SetNonStrokingColor(PdfColor(0.5, 0.5, 0.5));
+    painter.DrawRectangle(100, 100, 200, 200, PdfPathDrawMode::Fill);
     painter.FinishDrawing();
     
     unsigned initialSize = doc.GetObjects().GetSize();
@@ -236,9 +202,10 @@ TEST_CASE("DeduplicateNonAggressiveMode")
     auto& page = doc.GetPages().CreatePage(PdfPageSize::A4);
     
     // Create some content on the page
-    auto& painter = page.GetPainter();
-    painter.SetColor(0.5, 0.5, 0.5);
-    painter.DrawRect(100, 100, 200, 200);
+    PdfPainter painter;
+    painter.SetCanvas(page);
+    painter.GraphicsState.SetNonStrokingColor(PdfColor(0.5, 0.5, 0.5));
+    painter.DrawRectangle(100, 100, 200, 200, PdfPathDrawMode::Fill);
     painter.FinishDrawing();
     
     unsigned initialSize = doc.GetObjects().GetSize();
@@ -257,34 +224,29 @@ TEST_CASE("DeduplicateNonAggressiveMode")
 TEST_CASE("DeduplicateComplexNestedObjects")
 {
     PdfMemDocument doc;
-    
+    auto& catalog = doc.GetCatalog().GetDictionary();
+
     // Create complex nested objects
     PdfDictionary innerDict1;
-    innerDict1.AddKey("inner", PdfObject(123));
-    
+    innerDict1.AddKey("inner"_n, PdfObject(static_cast<int64_t>(123)));
+
     PdfDictionary innerDict2;
-    innerDict2.AddKey("inner", PdfObject(123));
-    
+    innerDict2.AddKey("inner"_n, PdfObject(static_cast<int64_t>(123)));
+
     PdfArray outerArr1;
     outerArr1.Add(innerDict1);
-    outerArr1.Add(PdfObject(456));
-    
+    outerArr1.Add(PdfObject(static_cast<int64_t>(456)));
+
     PdfArray outerArr2;
     outerArr2.Add(innerDict2);
-    outerArr2.Add(PdfObject(456));
-    
-    auto& obj1 = doc.GetObjects().CreateObject(outerArr1);
-    auto& obj2 = doc.GetObjects().CreateObject(outerArr2);
-    
-    unsigned initialSize = doc.GetObjects().GetSize();
-    
+    outerArr2.Add(PdfObject(static_cast<int64_t>(456)));
+
+    catalog.AddKeyIndirect("Obj1"_n, doc.GetObjects().CreateObject(outerArr1));
+    catalog.AddKeyIndirect("Obj2"_n, doc.GetObjects().CreateObject(outerArr2));
+
     // Perform deduplication
     doc.DeduplicateObjects();
-    
-    // Should have reduced the number of objects
-    unsigned finalSize = doc.GetObjects().GetSize();
-    REQUIRE(finalSize < initialSize);
-    
+
     // Should only have one outer array
     int outerArrayCount = 0;
     for (auto obj : doc.GetObjects())
@@ -292,6 +254,70 @@ TEST_CASE("DeduplicateComplexNestedObjects")
         if (obj->IsArray() && obj->GetArray().GetSize() == 2)
             outerArrayCount++;
     }
-    
+
     REQUIRE(outerArrayCount == 1);
-} 
\ No newline at end of file
+    REQUIRE(catalog.MustGetKey("Obj1").GetReference() == catalog.MustGetKey("Obj2").GetReference());
+}
+
+TEST_CASE("DeduplicateReferenceCycles")
+{
+    PdfMemDocument doc;
+    auto& catalog = doc.GetCatalog().GetDictionary();
+
+    // Two identical cycles, made of distinct objects
+    auto createCycle = [&](const PdfName& key) -> PdfObject& {
+        auto& obj1 = doc.GetObjects().CreateDictionaryObject();
+        auto& obj2 = doc.GetObjects().CreateDictionaryObject();
+        obj1.GetDictionary().AddKey("Value"_n, static_cast<int64_t>(1));
+        obj1.GetDictionary().AddKeyIndirect("Next"_n, obj2);
+        obj2.GetDictionary().AddKey("Value"_n, static_cast<int64_t>(2));
+        obj2.GetDictionary().AddKeyIndirect("Next"_n, obj1);
+        catalog.AddKeyIndirect(key, obj1);
+        return obj1;
+    };
+
+    createCycle("Cycle1"_n);
+    createCycle("Cycle2"_n);
+
+    // A cycle that differs only in the referenced object
+    auto& different = createCycle("Cycle3"_n);
+    different.GetDictionary().MustFindKey("Next").GetDictionary().AddKey("Value"_n, static_cast<int64_t>(3));
+
+    doc.DeduplicateObjects();
+
+    REQUIRE(catalog.MustGetKey("Cycle1").GetReference() == catalog.MustGetKey("Cycle2").GetReference());
+    REQUIRE(catalog.MustGetKey("Cycle1").GetReference() != catalog.MustGetKey("Cycle3").GetReference());
+
+    auto& obj1 = catalog.MustFindKey("Cycle1").GetDictionary();
+    auto& obj2 = obj1.MustFindKey("Next").GetDictionary();
+    REQUIRE(obj2.MustFindKey("Value").GetNumber() == 2);
+    REQUIRE(obj2.MustGetKey("Next").GetReference() == catalog.MustGetKey("Cycle1").GetReference());
+}
+
+static void createDuplicateStreamsDocument(PdfMemDocument& doc);
+
+TEST_CASE("DeduplicateStreamObjects")
+{
+    // Objects with streams are merged only when aggressive
+    for (bool aggressive : { true, false })
+    {
+        PdfMemDocument doc;
+        createDuplicateStreamsDocument(doc);
+        auto& catalog = doc.GetCatalog().GetDictionary();
+        doc.DeduplicateObjects(aggressive);
+        REQUIRE((catalog.MustGetKey("Stream0").GetReference() == catalog.MustGetKey("Stream1").GetReference()) == aggressive);
+        REQUIRE(catalog.MustGetKey("Stream0").GetReference() != catalog.MustGetKey("Stream2").GetReference());
+        REQUIRE(catalog.MustFindKey("Stream2").MustGetStream().GetCopy() == "other data");
+    }
+}
+
+void createDuplicateStreamsDocument(PdfMemDocument& doc)
+{
+    auto& catalog = doc.GetCatalog().GetDictionary();
+    for (unsigned i = 0; i < 3; i++)
+    {
+        auto& obj = doc.GetObjects().CreateDictionaryObject();
+        obj.GetOrCreateStream().SetData(i == 2 ? "other data"sv : "stream data"sv);
+        catalog.AddKeyIndirect(PdfName(utls::Format("Stream{}", i)), obj);
+    }
+}
@@ -25,6 +25,95 @@ TEST_CASE("TestDevices")
         FAIL(utls::Format("Buffer1 size is wrong after 100 attaches: {}", buffer1.size()));
 }
 
+TEST_CASE("TestMappedFileDevice")
+{
+    auto testPath = TestUtils::GetTestOutputFilePath("TestMappedFileDevice.pdf");
+    {
+        PdfMemDocument doc;
+        doc.GetPages().CreatePage(PdfPageSize::A4);
+        doc.GetPages().CreatePage(PdfPageSize::Letter);
+        auto& obj = doc.GetObjects().CreateDictionaryObject();
+        obj.GetOrCreateStream().SetData(string(10000, 'x'));
+        doc.GetCatalog().GetDictionary().AddKeyIndirect("Test"_n, obj);
+        doc.Save(testPath, PdfSaveOptions::NoFlateCompress);
+    }
+
+    charbuff expected;
+    utls::ReadTo(expected, testPath);
+
+    {
+        MappedFileStreamDevice device(testPath);
+        REQUIRE(device.GetLength() == expected.size());
+        REQUIRE(device.GetView().size() == expected.size());
+        REQUIRE(std::memcmp(device.GetView().data(), expected.data(), expected.size()) == 0);
+
+        char ch;
+        REQUIRE(device.Peek(ch));
+        REQUIRE(ch == '%');
+        device.Seek(-5, SeekDirection::End);
+        charbuff tail(5);
+        device.Read(tail.data(), tail.size());
+        REQUIRE(tail == "%EOF\n");
+        REQUIRE(device.Eof());
+        REQUIRE(!device.Read(ch));
+    }
+
+    PdfMemDocument doc;
+    doc.Load(testPath, { }, PdfLoadOptions::MemoryMapped);
+    REQUIRE(doc.GetPages().GetCount() == 2);
+    REQUIRE(doc.GetPages().GetPageAt(1).GetRect().Width == 612);
+
+    // Save onto the mapped file, which is copied first
+    doc.GetPages().RemovePageAt(0);
+    doc.Save(testPath, PdfSaveOptions::NoFlateCompress);
+    REQUIRE(doc.GetPages().GetPageAt(0).GetRect().Width == 612);
+    doc.Load(testPath, { }, PdfLoadOptions::MemoryMapped);
+    REQUIRE(doc.GetPages().GetCount() == 1);
+    REQUIRE(doc.GetCatalog().GetDictionary().MustFindKey("Test").MustGetStream().GetCopy() == string(10000, 'x'));
+}
+
+TEST_CASE("TestBufferedOutputDevice")
+{
+    // Mix writes smaller and bigger than the buffer
+    string expected;
+    for (unsigned i = 0; i < 200; i++)
+        expected.append(utls::Format("{}", i)).append(i % 50 == 0 ? string(100, 'x') : string());
+
+    auto testPath = TestUtils::GetTestOutputFilePath("TestBufferedOutputDevice.bin");
+    {
+        FileStreamDevice file(testPath, FileMode::Create);
+        file.Write("head");
+        charbuff buffer;
+        BufferStreamDevice container(buffer);
+
+        BufferedOutputStreamDevice bufferedFile(file, 64);
+        BufferedOutputStreamDevice bufferedContainer(container, 64);
+        REQUIRE(bufferedFile.GetPosition() == 4);
+        for (unsigned i = 0; i < 200; i++)
+        {
+            string str = utls::Format("{}", i).append(i % 50 == 0 ? string(100, 'x') : string());
+            bufferedFile.Write(str);
+            bufferedContainer.Write(str);
+        }
+
+        REQUIRE(bufferedFile.GetPosition() == expected.size() + 4);
+        REQUIRE(bufferedContainer.GetPosition() == expected.size());
+        bufferedFile.Flush();
+        bufferedContainer.Flush();
+        REQUIRE(file.GetPosition() == expected.size() + 4);
+        REQUIRE(buffer == expected);
+
+        // Seeking writes the buffered data first
+        bufferedFile.Write("tail");
+        bufferedFile.Seek(0);
+        bufferedFile.Write("HEAD");
+    }
+
+    charbuff written;
+    utls::ReadTo(written, testPath);
+    REQUIRE(written == "HEAD" + expected + "tail");
+}
+
 TEST_CASE("TestSaveIncremental")
 {
     PdfMemDocument doc;
@@ -49,3 +138,49 @@ TEST_CASE("TestStreamedDocument")
     painter.DrawText("Hello World!", 56.69, page.GetRect().Height - 56.69);
     painter.FinishDrawing();
 }
+
+TEST_CASE("TestStreamedDocumentFlushPage")
+{
+    constexpr unsigned PageCount = 50;
+    charbuff buffer;
+    {
+        PdfStreamedDocument document(std::make_shared<StringStreamDevice>(buffer));
+        auto& font = document.GetFonts().GetStandard14Font(PdfStandard14FontType::Helvetica);
+        unsigned objectCount = 0;
+        for (unsigned i = 0; i < PageCount; i++)
+        {
+            auto& page = document.GetPages().CreatePage(PdfPageSize::A4);
+            PdfPainter painter;
+            painter.SetCanvas(page);
+            painter.TextState.SetFont(font, 18);
+            painter.DrawText(utls::Format("Page {}", i + 1), 56.69, page.GetRect().Height - 56.69);
+            painter.FinishDrawing();
+            page.GetAnnotations().CreateAnnot<PdfAnnotationLink>(Rect(56, 56, 100, 100));
+
+            document.FlushPage(page);
+            ASSERT_THROW_WITH_ERROR_CODE(document.GetPages().GetPageAt(i), PdfErrorCode::InvalidHandle);
+
+            // The objects still in memory don't grow with the pages,
+            // except for the page tree nodes, one every 32 pages
+            if (i == 1)
+                objectCount = document.GetObjects().GetSize();
+            else if (i > 1)
+                REQUIRE(document.GetObjects().GetSize() == objectCount + i / 32);
+        }
+
+        REQUIRE(document.GetPages().GetCount() == PageCount);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    REQUIRE(doc.GetPages().GetCount() == PageCount);
+    for (unsigned i = 0; i < PageCount; i++)
+    {
+        auto& page = doc.GetPages().GetPageAt(i);
+        REQUIRE(page.GetAnnotations().GetCount() == 1);
+        vector<PdfTextEntry> entries;
+        page.ExtractTextTo(entries);
+        REQUIRE(entries.size() == 1);
+        REQUIRE(entries[0].Text == utls::Format("Page {}", i + 1));
+    }
+}
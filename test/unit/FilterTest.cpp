@@ -34,6 +34,53 @@ TEST_CASE("TestFilters")
     }
 }
 
+TEST_CASE("TestFlateCompressionLevels")
+{
+    string buffer;
+    for (unsigned i = 0; i < 200; i++)
+        buffer.append(s_testBuffer1).append(to_string(i));
+
+    vector<PdfFlateBackend> backends = { PdfFlateBackend::ZLib };
+#ifdef PODOFO_HAVE_LIBDEFLATE
+    backends.push_back(PdfFlateBackend::LibDeflate);
+#else
+    ASSERT_THROW_WITH_ERROR_CODE(PdfCommon::SetFlateBackend(PdfFlateBackend::LibDeflate), PdfErrorCode::NotImplemented);
+#endif // PODOFO_HAVE_LIBDEFLATE
+    ASSERT_THROW_WITH_ERROR_CODE(PdfCommon::SetFlateCompressionLevel(13), PdfErrorCode::ValueOutOfRange);
+
+    auto filter = PdfFilterFactory::Create(PdfFilterType::FlateDecode);
+    for (auto backend : backends)
+    {
+        PdfCommon::SetFlateBackend(backend);
+        size_t storedSize = 0;
+        for (int level : { 0, -1, 1, 9, 12 })
+        {
+            PdfCommon::SetFlateCompressionLevel(level);
+            charbuff encoded;
+            filter->EncodeTo(encoded, buffer);
+            if (level == 0)
+                storedSize = encoded.size();
+            else
+                REQUIRE(encoded.size() < storedSize / 4);
+
+            // Decode with a correct, a too small and a too big /DL
+            for (ssize_t decodedLength : { (ssize_t)buffer.size(), (ssize_t)buffer.size() / 2, (ssize_t)buffer.size() * 2, (ssize_t)-1 })
+            {
+                PdfMemDocument doc;
+                auto& obj = doc.GetObjects().CreateDictionaryObject();
+                obj.GetOrCreateStream().SetData(encoded, { PdfFilterType::FlateDecode }, true);
+                if (decodedLength >= 0)
+                    obj.GetDictionary().AddKey("DL", (int64_t)decodedLength);
+
+                REQUIRE(obj.MustGetStream().GetCopy() == buffer);
+            }
+        }
+    }
+
+    PdfCommon::SetFlateCompressionLevel(-1);
+    PdfCommon::SetFlateBackend(PdfFlateBackend::Default);
+}
+
 void testFilter(PdfFilterType filterType, const bufferview& view)
 {
     charbuff encoded;
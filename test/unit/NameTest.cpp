@@ -7,6 +7,7 @@
  */
 
 #include <PdfTest.h>
+#include <podofo/optional/PdfNames.h>
 
 using namespace PoDoFo;
 using namespace std;
@@ -101,6 +102,23 @@ TEST_CASE("TestFromEscaped")
     TestFromEscape("Length#20With#20Spaces", "Length With Spaces");
 }
 
+TEST_CASE("TestInterning")
+{
+    // Names read by the parser share the same data
+    auto name1 = PdfName::FromEscaped("Interned#20Name");
+    auto name2 = PdfName::FromEscaped("Interned Name");
+    REQUIRE(name1 == name2);
+    REQUIRE(name1.GetRawData().data() == name2.GetRawData().data());
+    REQUIRE(name1.GetString() == "Interned Name");
+
+    // Well known names are preinterned
+    auto type = PdfName::FromEscaped("Type");
+    REQUIRE(type == PdfNames::Type);
+    REQUIRE(type.GetRawData().data() == PdfName::FromEscaped("Type").GetRawData().data());
+
+    REQUIRE(PdfName::FromEscaped("Interned") != name1);
+}
+
 //
 // Test encoding of names.
 // pszString : internal representation, ie unencoded name
@@ -85,3 +85,218 @@ TEST_CASE("TestFlattening")
         REQUIRE(child.GetDictionary().MustGetKey("Parent").GetReference() == pageRootRef);
     }
 }
+
+static void createMergeTestDocument(PdfMemDocument& doc, unsigned pageCount, const string_view& name);
+static unsigned countObjects(const PdfDocument& doc, const string_view& type);
+static string getContentsData(const PdfPage& page);
+
+TEST_CASE("TestMergeSharedResources")
+{
+    PdfMemDocument doc;
+    createMergeTestDocument(doc, 2, "doc0");
+    for (unsigned i = 1; i < 4; i++)
+    {
+        PdfMemDocument source;
+        createMergeTestDocument(source, 2, "doc" + std::to_string(i));
+        doc.GetPages().AppendDocumentPages(source);
+    }
+
+    // The font, its descriptor and the image, equal in
+    // all the documents, are copied only the first time
+    REQUIRE(doc.GetPages().GetCount() == 8);
+    REQUIRE(countObjects(doc, "Font") == 2);
+    REQUIRE(countObjects(doc, "FontDescriptor") == 2);
+    REQUIRE(countObjects(doc, "Image") == 2);
+
+    // The objects not reachable from the pages are not copied
+    REQUIRE(countObjects(doc, "Unused") == 1);
+
+    charbuff buffer;
+    BufferStreamDevice device(buffer);
+    doc.Save(device);
+
+    PdfMemDocument loaded;
+    loaded.LoadFromBuffer(buffer);
+    REQUIRE(loaded.GetPages().GetCount() == 8);
+    REQUIRE(countObjects(loaded, "Font") == 2);
+    REQUIRE(countObjects(loaded, "Image") == 2);
+    auto getFontRef = [&](unsigned pageIndex) {
+        return loaded.GetPages().GetPageAt(pageIndex).GetDictionary().MustFindKey("Resources").GetDictionary()
+            .MustFindKey("Font").GetDictionary().MustGetKey("F1").GetReference();
+    };
+    for (unsigned i = 0; i < 8; i++)
+    {
+        REQUIRE(getContentsData(loaded.GetPages().GetPageAt(i)) == "doc" + std::to_string(i / 2) + " page " + std::to_string(i % 2));
+        if (i >= 2)
+            REQUIRE(getFontRef(i) == getFontRef(2));
+    }
+
+    // Saving finishes the merge, so the next copies
+    // are not compared with the resources copied before
+    PdfMemDocument source;
+    createMergeTestDocument(source, 2, "doc4");
+    doc.GetPages().AppendDocumentPages(source);
+    REQUIRE(countObjects(doc, "Font") == 3);
+}
+
+TEST_CASE("TestMergePageRange")
+{
+    PdfMemDocument source;
+    createMergeTestDocument(source, 4, "source");
+
+    // Link the second page to the third and to the last one
+    auto createLink = [&](unsigned pageIndex) -> PdfObject& {
+        auto& link = source.GetObjects().CreateDictionaryObject("Annot"_n, "Link"_n);
+        PdfArray dest;
+        dest.Add(source.GetPages().GetPageAt(pageIndex).GetObject().GetIndirectReference());
+        dest.Add(PdfName("Fit"));
+        link.GetDictionary().AddKey("Dest"_n, dest);
+        return link;
+    };
+    PdfArray annots;
+    annots.Add(createLink(2).GetIndirectReference());
+    annots.Add(createLink(3).GetIndirectReference());
+    source.GetPages().GetPageAt(1).GetDictionary().AddKey("Annots"_n, annots);
+
+    PdfMemDocument doc;
+    createMergeTestDocument(doc, 1, "doc");
+    size_t objectCount = doc.GetObjects().GetObjectCount();
+    doc.GetPages().AppendDocumentPages(source, 1, 2);
+
+    // Only the two pages, their contents, the resources dictionary,
+    // the font, its descriptor and file, the image and the links
+    // are copied
+    REQUIRE(doc.GetPages().GetCount() == 3);
+    REQUIRE(getContentsData(doc.GetPages().GetPageAt(1)) == "source page 1");
+    REQUIRE(getContentsData(doc.GetPages().GetPageAt(2)) == "source page 2");
+    REQUIRE(doc.GetObjects().GetObjectCount() == objectCount + 11);
+
+    // The link to a page not copied is kept, without the page
+    auto& copiedAnnots = doc.GetPages().GetPageAt(1).GetDictionary().MustFindKey("Annots").GetArray();
+    REQUIRE(copiedAnnots.GetSize() == 2);
+    REQUIRE(copiedAnnots.MustFindAt(0).GetDictionary().MustGetKey("Dest").GetArray()[0].GetReference()
+        == doc.GetPages().GetPageAt(2).GetObject().GetIndirectReference());
+    REQUIRE(copiedAnnots.MustFindAt(1).GetDictionary().MustGetKey("Dest").GetArray()[0].IsNull());
+
+    // Only the shared resources are reused by the next copies
+    doc.GetPages().InsertDocumentPageAt(0, source, 3);
+    REQUIRE(doc.GetPages().GetCount() == 4);
+    REQUIRE(getContentsData(doc.GetPages().GetPageAt(0)) == "source page 3");
+    REQUIRE(getContentsData(doc.GetPages().GetPageAt(1)) == "doc page 0");
+    REQUIRE(doc.GetPages().GetPageAt(0).GetDictionary().GetKey("Resources")->GetReference()
+        != doc.GetPages().GetPageAt(2).GetDictionary().GetKey("Resources")->GetReference());
+    REQUIRE(countObjects(doc, "Font") == 2);
+    REQUIRE(countObjects(doc, "Link") == 2);
+
+    // Copying the same page again copies its contents again
+    doc.GetPages().AppendDocumentPages(source, 1, 1);
+    REQUIRE(doc.GetPages().GetCount() == 5);
+    REQUIRE(doc.GetPages().GetPageAt(4).GetDictionary().GetKey("Contents")->GetReference()
+        != doc.GetPages().GetPageAt(2).GetDictionary().GetKey("Contents")->GetReference());
+    REQUIRE(countObjects(doc, "Font") == 2);
+    REQUIRE(countObjects(doc, "Link") == 4);
+
+    REQUIRE_THROWS_AS(doc.GetPages().AppendDocumentPages(source, 3, 2), PdfError);
+}
+
+TEST_CASE("TestSplit")
+{
+    PdfMemDocument doc;
+    createMergeTestDocument(doc, 6, "doc");
+
+    vector<charbuff> buffers(3);
+    vector<PdfPageRange> ranges = { { 0, 2 }, { 2, 3 }, { 5, 1 } };
+    doc.Split(ranges, [&](unsigned index) {
+        return std::make_shared<BufferStreamDevice>(buffers[index]);
+    });
+
+    for (unsigned i = 0; i < ranges.size(); i++)
+    {
+        PdfMemDocument part;
+        part.LoadFromBuffer(buffers[i]);
+        REQUIRE(part.GetPages().GetCount() == ranges[i].PageCount);
+        for (unsigned j = 0; j < ranges[i].PageCount; j++)
+            REQUIRE(getContentsData(part.GetPages().GetPageAt(j)) == "doc page " + std::to_string(ranges[i].FirstPage + j));
+
+        // Each part has only the objects reachable from its pages
+        REQUIRE(countObjects(part, "Font") == 1);
+        REQUIRE(countObjects(part, "Image") == 1);
+        REQUIRE(countObjects(part, "Unused") == 0);
+    }
+
+    ranges = { { 5, 2 } };
+    REQUIRE_THROWS_AS(doc.Split(ranges, [&](unsigned index) {
+        return std::make_shared<BufferStreamDevice>(buffers[index]);
+    }), PdfError);
+
+    // Write errors of the parts are reported, also when
+    // they happen while finishing the part
+    ranges = { { 0, 1 } };
+    buffers[0].clear();
+    doc.Split(ranges, [&](unsigned index) {
+        return std::make_shared<BufferStreamDevice>(buffers[index]);
+    });
+    charbuff truncated(buffers[0].size() - 10);
+    REQUIRE_THROWS_AS(doc.Split(ranges, [&](unsigned) {
+        return std::make_shared<SpanStreamDevice>(truncated.data(), truncated.size());
+    }), PdfError);
+}
+
+void createMergeTestDocument(PdfMemDocument& doc, unsigned pageCount, const string_view& name)
+{
+    auto& fontFile = doc.GetObjects().CreateDictionaryObject();
+    fontFile.GetOrCreateStream().SetData(bufferview("font program data"));
+    auto& descriptor = doc.GetObjects().CreateDictionaryObject("FontDescriptor"_n);
+    descriptor.GetDictionary().AddKey("FontName"_n, PdfName("TestFont"));
+    descriptor.GetDictionary().AddKeyIndirect("FontFile"_n, fontFile);
+    auto& font = doc.GetObjects().CreateDictionaryObject("Font"_n, "Type1"_n);
+    font.GetDictionary().AddKey("BaseFont"_n, PdfName("TestFont"));
+    font.GetDictionary().AddKeyIndirect("FontDescriptor"_n, descriptor);
+    auto& image = doc.GetObjects().CreateDictionaryObject("XObject"_n, "Image"_n);
+    image.GetOrCreateStream().SetData(bufferview("image data"));
+
+    // An object referenced only by the catalog
+    auto& unused = doc.GetObjects().CreateDictionaryObject("Unused"_n);
+    doc.GetCatalog().GetDictionary().AddKeyIndirect("Unused"_n, unused);
+
+    PdfDictionary fonts;
+    fonts.AddKey("F1"_n, font.GetIndirectReference());
+    PdfDictionary images;
+    images.AddKey("Im1"_n, image.GetIndirectReference());
+    PdfDictionary resources;
+    resources.AddKey("Font"_n, fonts);
+    resources.AddKey("XObject"_n, images);
+    auto& resourcesObj = doc.GetObjects().CreateObject(resources);
+
+    for (unsigned i = 0; i < pageCount; i++)
+    {
+        auto& page = doc.GetPages().CreatePage(PdfPageSize::A4);
+        auto& contents = doc.GetObjects().CreateDictionaryObject();
+        contents.GetOrCreateStream().SetData(string(name) + " page " + std::to_string(i));
+        page.GetDictionary().AddKeyIndirect("Contents"_n, contents);
+        page.GetDictionary().AddKeyIndirect("Resources"_n, resourcesObj);
+    }
+}
+
+unsigned countObjects(const PdfDocument& doc, const string_view& type)
+{
+    unsigned ret = 0;
+    for (auto obj : doc.GetObjects())
+    {
+        const PdfName* name;
+        if (obj->IsDictionary() && (obj->GetDictionary().TryFindKeyAs("Type", name) && *name == type
+            || obj->GetDictionary().TryFindKeyAs("Subtype", name) && *name == type))
+        {
+            ret++;
+        }
+    }
+
+    return ret;
+}
+
+string getContentsData(const PdfPage& page)
+{
+    charbuff buffer;
+    page.GetDictionary().MustFindKey("Contents").MustGetStream().CopyTo(buffer);
+    return string(buffer.data(), buffer.size());
+}
@@ -8,6 +8,8 @@
 
 #include <PdfTest.h>
 
+#include <numeric>
+
 #define TEST_PAGE_KEY "TestPageNumber"_n
 constexpr unsigned TEST_NUM_PAGES = 100;
 
@@ -36,6 +38,9 @@ static void testGetPages(PdfMemDocument& doc);
 static void testInsert(PdfMemDocument& doc);
 static void testDeleteAll(PdfMemDocument& doc);
 static void testGetPagesReverse(PdfMemDocument& doc);
+static unsigned checkBalancedTree(const PdfObject& node, unsigned depth, unsigned& leafDepth,
+    vector<int64_t>& pageNumbers);
+static void checkBalancedTree(PdfMemDocument& doc, const vector<int64_t>& pageNumbers);
 
 TEST_CASE("TestEmptyDoc")
 {
@@ -188,6 +193,202 @@ TEST_CASE("TestDeleteAll")
     testDeleteAll(doc);
 }
 
+TEST_CASE("TestLazyPageAccess")
+{
+    auto doc = PdfPageTest::CreateTestTreeCustom();
+    auto& pages = doc.GetPages();
+    REQUIRE(pages.GetCount() == TEST_NUM_PAGES);
+
+    // Pages are loaded on demand, walking down the tree
+    auto& page57 = pages.GetPageAt(57);
+    REQUIRE(isPageNumber(page57, 57));
+    REQUIRE(page57.GetIndex() == 57);
+    REQUIRE(&pages.GetPageAt(57) == &page57);
+
+    // Pages retrieved by reference are found walking up the tree
+    auto ref73 = doc.GetObjects().MustGetObject(pages.GetObject().GetDictionary()
+        .MustFindKey("Kids").GetArray()[7].GetReference()).GetDictionary()
+        .MustFindKey("Kids").GetArray()[3].GetReference();
+    auto& pageByRef = pages.GetPage(ref73);
+    REQUIRE(isPageNumber(pageByRef, 73));
+    REQUIRE(pageByRef.GetIndex() == 73);
+
+    // Iterating loads the whole tree, reusing the pages already loaded
+    unsigned i = 0;
+    for (auto page : pages)
+    {
+        REQUIRE(isPageNumber(*page, i));
+        REQUIRE(page->GetIndex() == i);
+        i++;
+    }
+    REQUIRE(i == TEST_NUM_PAGES);
+    REQUIRE(&pages.GetPageAt(57) == &page57);
+    REQUIRE(&pages.GetPageAt(73) == &pageByRef);
+}
+
+TEST_CASE("TestLazyPageAccessInconsistentCount")
+{
+    auto doc = PdfPageTest::CreateTestTreeCustom();
+
+    // Remove the /Count of the intermediate nodes: the
+    // collection must fall back to a full tree traversal
+    for (auto kid : doc.GetCatalog().GetDictionary().MustFindKey("Pages")
+        .GetDictionary().MustFindKey("Kids").GetArray().GetIndirectIterator())
+    {
+        kid->GetDictionary().RemoveKey("Count");
+    }
+
+    auto& pages = doc.GetPages();
+    REQUIRE(pages.GetCount() == TEST_NUM_PAGES);
+    REQUIRE(isPageNumber(pages.GetPageAt(57), 57));
+    REQUIRE(isPageNumber(pages.GetPage(pages.GetPageAt(99).GetObject().GetIndirectReference()), 99));
+}
+
+TEST_CASE("TestBalancedTree")
+{
+    constexpr unsigned PageCount = 1000;
+    PdfMemDocument doc;
+    auto& pages = doc.GetPages();
+    vector<int64_t> pageNumbers;
+    for (unsigned i = 0; i < PageCount; i++)
+    {
+        pages.CreatePage(PdfPageSize::A4).GetDictionary().AddKey(TEST_PAGE_KEY, static_cast<int64_t>(i));
+        pageNumbers.push_back(i);
+    }
+    checkBalancedTree(doc, pageNumbers);
+
+    // Insert pages in the middle and at the beginning
+    pages.CreatePagesAt(500, 100, PdfPageSize::A4);
+    for (unsigned i = 0; i < 100; i++)
+        pages.GetPageAt(500 + i).GetDictionary().AddKey(TEST_PAGE_KEY, static_cast<int64_t>(PageCount + i));
+    pageNumbers.insert(pageNumbers.begin() + 500, 100, 0);
+    std::iota(pageNumbers.begin() + 500, pageNumbers.begin() + 600, PageCount);
+    for (unsigned i = 0; i < 50; i++)
+    {
+        pages.CreatePageAt(0, PdfPageSize::A4).GetDictionary().AddKey(TEST_PAGE_KEY, static_cast<int64_t>(2000 + i));
+        pageNumbers.insert(pageNumbers.begin(), 2000 + i);
+    }
+    checkBalancedTree(doc, pageNumbers);
+
+    // Move and remove pages
+    REQUIRE(pages.GetPageAt(10).MoveTo(900));
+    auto moved = pageNumbers[10];
+    pageNumbers.erase(pageNumbers.begin() + 10);
+    pageNumbers.insert(pageNumbers.begin() + 900, moved);
+    for (unsigned i = 0; i < 300; i++)
+        pages.RemovePageAt(100);
+    pageNumbers.erase(pageNumbers.begin() + 100, pageNumbers.begin() + 400);
+    checkBalancedTree(doc, pageNumbers);
+
+    pages.RebalancePageTree();
+    checkBalancedTree(doc, pageNumbers);
+
+    charbuff buffer;
+    BufferStreamDevice device(buffer);
+    doc.Save(device);
+    PdfMemDocument loadedDoc;
+    loadedDoc.LoadFromBuffer(buffer);
+    REQUIRE(loadedDoc.GetPages().GetCount() == pageNumbers.size());
+    for (unsigned i = 0; i < pageNumbers.size(); i++)
+        REQUIRE(isPageNumber(loadedDoc.GetPages().GetPageAt(i), (unsigned)pageNumbers[i]));
+}
+
+TEST_CASE("TestBalancedTreeLoaded")
+{
+    // A loaded tree is modified in place, splitting only the full nodes
+    auto doc = PdfPageTest::CreateTestTreeCustom();
+    auto& pages = doc.GetPages();
+    auto& rootKids = pages.GetDictionary().MustFindKey("Kids").GetArray();
+    auto nodeRefs = rootKids;
+    auto& node = doc.GetObjects().MustGetObject(nodeRefs[5].GetReference());
+    node.GetDictionary().AddKey("Rotate"_n, static_cast<int64_t>(90));
+
+    auto& page = pages.CreatePageAt(50, PdfPageSize::A4);
+    page.GetDictionary().AddKey(TEST_PAGE_KEY, static_cast<int64_t>(TEST_NUM_PAGES));
+    REQUIRE(page.GetDictionary().MustFindKey("Parent").GetIndirectReference() == node.GetIndirectReference());
+    REQUIRE(rootKids == nodeRefs);
+
+    // The new page doesn't inherit the rotation of the node
+    REQUIRE(page.GetDictionary().MustFindKey("Rotate").GetNumber() == 0);
+
+    pages.CreatePagesAt(51, 30, PdfPageSize::A4);
+    for (unsigned i = 0; i < 30; i++)
+        pages.GetPageAt(51 + i).GetDictionary().AddKey(TEST_PAGE_KEY, static_cast<int64_t>(TEST_NUM_PAGES + 1 + i));
+
+    vector<int64_t> pageNumbers(TEST_NUM_PAGES);
+    std::iota(pageNumbers.begin(), pageNumbers.end(), 0);
+    pageNumbers.insert(pageNumbers.begin() + 50, 31, 0);
+    std::iota(pageNumbers.begin() + 50, pageNumbers.begin() + 81, TEST_NUM_PAGES);
+    checkBalancedTree(doc, pageNumbers);
+
+    // The full node is split in a new sibling, that
+    // has the same attributes for the moved pages
+    REQUIRE(rootKids.GetSize() == nodeRefs.GetSize() + 1);
+    for (unsigned i = 0; i < nodeRefs.GetSize(); i++)
+        REQUIRE(rootKids[i < 6 ? i : i + 1] == nodeRefs[i]);
+
+    auto& sibling = doc.GetObjects().MustGetObject(rootKids[6].GetReference());
+    REQUIRE(sibling.GetDictionary().MustFindKey("Rotate").GetNumber() == 90);
+    REQUIRE(pages.GetPageAt(81).GetRotation() == 90);
+
+    // Rebuilding the tree keeps the inherited attributes
+    pages.RebalancePageTree();
+    checkBalancedTree(doc, pageNumbers);
+    REQUIRE(pages.GetPageAt(50).GetRotation() == 0);
+    REQUIRE(pages.GetPageAt(81).GetRotation() == 90);
+}
+
+TEST_CASE("TestBalancedTreeLoadedWrongCount")
+{
+    // A tree with a wrong /Count on the path
+    // to the modified page is rebuilt instead
+    auto doc = PdfPageTest::CreateTestTreeCustom();
+    auto& rootDict = doc.GetCatalog().GetDictionary().MustFindKey("Pages").GetDictionary();
+    rootDict.AddKey("Count"_n, static_cast<int64_t>(TEST_NUM_PAGES - 1));
+    doc.GetObjects().MustGetObject(rootDict.MustFindKey("Kids").GetArray()[2].GetReference())
+        .GetDictionary().AddKey("Count"_n, static_cast<int64_t>(9));
+
+    auto& pages = doc.GetPages();
+    pages.CreatePageAt(25, PdfPageSize::A4).GetDictionary().AddKey(TEST_PAGE_KEY, static_cast<int64_t>(TEST_NUM_PAGES));
+
+    vector<int64_t> pageNumbers(TEST_NUM_PAGES);
+    std::iota(pageNumbers.begin(), pageNumbers.end(), 0);
+    pageNumbers.insert(pageNumbers.begin() + 25, TEST_NUM_PAGES);
+    checkBalancedTree(doc, pageNumbers);
+}
+
+TEST_CASE("TestLazyPageAccessWrongCount")
+{
+    {
+        // An overstated root /Count is detected on load
+        auto doc = PdfPageTest::CreateTestTreeCustom();
+        doc.GetCatalog().GetDictionary().MustFindKey("Pages").GetDictionary()
+            .AddKey("Count"_n, static_cast<int64_t>(TEST_NUM_PAGES + 5));
+
+        auto& pages = doc.GetPages();
+        REQUIRE(pages.GetCount() == TEST_NUM_PAGES);
+        for (unsigned i = 0; i < pages.GetCount(); i++)
+            REQUIRE(isPageNumber(pages.GetPageAt(i), i));
+    }
+
+    {
+        // A wrong /Count of a skipped node is detected while
+        // descending. Pages already handed out stay valid
+        auto doc = PdfPageTest::CreateTestTreeCustom();
+        auto& rootDict = doc.GetCatalog().GetDictionary().MustFindKey("Pages").GetDictionary();
+        rootDict.AddKey("Count"_n, static_cast<int64_t>(TEST_NUM_PAGES - 1));
+        doc.GetObjects().MustGetObject(rootDict.MustFindKey("Kids").GetArray()[2].GetReference())
+            .GetDictionary().AddKey("Count"_n, static_cast<int64_t>(9));
+
+        auto& pages = doc.GetPages();
+        auto& page5 = pages.GetPageAt(5);
+        REQUIRE(isPageNumber(page5, 5));
+        REQUIRE(isPageNumber(pages.GetPageAt(57), 57));
+        REQUIRE(pages.GetCount() == TEST_NUM_PAGES);
+        REQUIRE(&pages.GetPageAt(5) == &page5);
+    }
+}
+
 TEST_CASE("TestMovePage1")
 {
     PdfMemDocument doc;
@@ -282,6 +483,54 @@ TEST_CASE("TestMovePage2")
         REQUIRE(pages.GetPageAt(i).GetObject().GetIndirectReference() == refs[i]);
 }
 
+void checkBalancedTree(PdfMemDocument& doc, const vector<int64_t>& pageNumbers)
+{
+    auto& pages = doc.GetPages();
+    REQUIRE(pages.GetCount() == pageNumbers.size());
+    for (unsigned i = 0; i < pageNumbers.size(); i++)
+    {
+        auto& page = pages.GetPageAt(i);
+        REQUIRE(page.GetIndex() == i);
+        REQUIRE(isPageNumber(page, (unsigned)pageNumbers[i]));
+    }
+
+    unsigned leafDepth = 0;
+    vector<int64_t> treePageNumbers;
+    REQUIRE(checkBalancedTree(pages.GetObject(), 0, leafDepth, treePageNumbers) == pageNumbers.size());
+    REQUIRE(treePageNumbers == pageNumbers);
+}
+
+// Check the nodes have at most 32 kids, all the leaves have the
+// same depth and the /Count and /Parent entries are consistent
+unsigned checkBalancedTree(const PdfObject& node, unsigned depth, unsigned& leafDepth,
+    vector<int64_t>& pageNumbers)
+{
+    auto& kids = node.GetDictionary().MustFindKey("Kids").GetArray();
+    REQUIRE(kids.GetSize() <= 32);
+    REQUIRE((depth == 0 || kids.GetSize() != 0));
+    unsigned count = 0;
+    for (unsigned i = 0; i < kids.GetSize(); i++)
+    {
+        auto& kid = kids.MustFindAt(i);
+        REQUIRE(kid.GetDictionary().MustFindKey("Parent").GetIndirectReference() == node.GetIndirectReference());
+        if (kid.GetDictionary().MustFindKey("Type").GetName() == "Pages")
+        {
+            count += checkBalancedTree(kid, depth + 1, leafDepth, pageNumbers);
+        }
+        else
+        {
+            if (leafDepth == 0)
+                leafDepth = depth + 1;
+            REQUIRE(leafDepth == depth + 1);
+            pageNumbers.push_back(kid.GetDictionary().MustFindKey(TEST_PAGE_KEY).GetNumber());
+            count++;
+        }
+    }
+
+    REQUIRE(node.GetDictionary().MustFindKey("Count").GetNumber() == count);
+    return count;
+}
+
 void testGetPages(PdfMemDocument& doc)
 {
     for (unsigned i = 0; i < TEST_NUM_PAGES; i++)
@@ -412,12 +661,14 @@ PdfMemDocument PdfPageTest::CreateTestTreeCustom()
             page->SetIndex(j);
             page->GetDictionary().AddKey(TEST_PAGE_KEY,
                 static_cast<int64_t>(i) * COUNT + j);
+            page->GetDictionary().AddKey("Parent"_n, node.GetIndirectReference());
 
             nodeKids.Add(page->GetObject().GetIndirectReference());
         }
 
         node.GetDictionary().AddKey("Kids"_n, nodeKids);
         node.GetDictionary().AddKey("Count"_n, static_cast<int64_t>(COUNT));
+        node.GetDictionary().AddKey("Parent"_n, root.GetIndirectReference());
         rootKids.Add(node.GetIndirectReference());
     }
 
@@ -23,11 +23,14 @@
 
 #include <PdfTest.h>
 #include <podofo/private/PdfParser.h>
+#include <podofo/private/PdfArena.h>
+#include <podofo/private/PdfParserObjectStream.h>
 
 using namespace std;
 using namespace PoDoFo;
 
 static string generateXRefEntries(size_t count);
+static string generateObjectStreamDocument();
 static bool canOutOfMemoryKillUnitTests();
 static size_t getStackOverflowDepth();
 
@@ -2818,6 +2821,399 @@ TEST_CASE("TestReclaimObjectMemory")
     REQUIRE(!imageObj->TryUnload());
 }
 
+TEST_CASE("TestDemandLoadObjectStream")
+{
+    auto buffer = generateObjectStreamDocument();
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    REQUIRE(doc.GetPages().GetCount() == 1);
+
+    // Objects compressed in the object stream are loaded on first access
+    auto& obj4 = doc.GetObjects().MustGetObject(PdfReference(4, 0));
+    auto& obj5 = doc.GetObjects().MustGetObject(PdfReference(5, 0));
+    REQUIRE(!obj4.IsDelayedLoadDone());
+    REQUIRE(!obj5.IsDelayedLoadDone());
+    REQUIRE(obj5.GetDictionary().MustFindKey("Value").GetNumber() == 5);
+    REQUIRE(obj5.IsDelayedLoadDone());
+    REQUIRE(!obj4.IsDelayedLoadDone());
+
+    // Object 4 has a wrong index in the XRef stream
+    REQUIRE(obj4.GetDictionary().MustFindKey("Value").GetNumber() == 4);
+
+    // Unloading reads the object again from the stream
+    REQUIRE(obj5.TryUnload());
+    REQUIRE(!obj5.IsDelayedLoadDone());
+    REQUIRE(obj5.GetDictionary().MustFindKey("Value").GetNumber() == 5);
+
+    // Modified objects can't be unloaded
+    obj5.GetDictionary().AddKey("Value"_n, PdfObject(static_cast<int64_t>(6)));
+    REQUIRE(!obj5.TryUnload());
+
+    // Eager loading produces the same objects
+    PdfMemDocument eagerDoc;
+    auto& objects = eagerDoc.GetObjects();
+    PdfParser parser(objects);
+    SpanStreamDevice device(buffer);
+    parser.Parse(device, false);
+    REQUIRE(objects.MustGetObject(PdfReference(4, 0)).IsDelayedLoadDone());
+    REQUIRE(objects.MustGetObject(PdfReference(4, 0)).GetDictionary().MustFindKey("Value").GetNumber() == 4);
+    REQUIRE(objects.MustGetObject(PdfReference(5, 0)).GetDictionary().MustFindKey("Value").GetNumber() == 5);
+}
+
+TEST_CASE("TestParallelLoad")
+{
+    auto buffer = generateObjectStreamDocument();
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer, { }, PdfLoadOptions::ParallelLoad);
+    REQUIRE(doc.GetPages().GetCount() == 1);
+    REQUIRE(doc.GetObjects().MustGetObject(PdfReference(4, 0)).IsDelayedLoadDone());
+
+    // Force more workers than objects
+    PdfMemDocument parallelDoc;
+    auto& objects = parallelDoc.GetObjects();
+    PdfParser parser(objects);
+    parser.SetThreadCount(8);
+    SpanStreamDevice device(buffer);
+    parser.Parse(device, false);
+    for (unsigned i = 1; i <= 5; i++)
+        REQUIRE(objects.MustGetObject(PdfReference(i, 0)).IsDelayedLoadDone());
+
+    REQUIRE(objects.MustGetObject(PdfReference(4, 0)).GetDictionary().MustFindKey("Value").GetNumber() == 4);
+    REQUIRE(objects.MustGetObject(PdfReference(5, 0)).GetDictionary().MustFindKey("Value").GetNumber() == 5);
+
+    // A document with many streams produces the same content
+    // as the serial loading
+    charbuff saved;
+    {
+        PdfMemDocument srcDoc;
+        for (unsigned i = 0; i < 50; i++)
+        {
+            auto& page = srcDoc.GetPages().CreatePage(PdfPageSize::A4);
+            PdfPainter painter;
+            painter.SetCanvas(page);
+            painter.DrawRectangle(10 + i, 10, 100, 100);
+            painter.FinishDrawing();
+        }
+        BufferStreamDevice output(saved);
+        srcDoc.Save(output);
+    }
+
+    PdfMemDocument serialDoc;
+    serialDoc.LoadFromBuffer(saved);
+
+    PdfMemDocument parallelDoc2;
+    PdfParser parser2(parallelDoc2.GetObjects());
+    parser2.SetThreadCount(4);
+    SpanStreamDevice device2(saved);
+    parser2.Parse(device2, false);
+    REQUIRE(parallelDoc2.GetObjects().GetSize() == serialDoc.GetObjects().GetSize());
+    for (auto obj : serialDoc.GetObjects())
+    {
+        auto& other = parallelDoc2.GetObjects().MustGetObject(obj->GetIndirectReference());
+        REQUIRE(other.GetVariant() == obj->GetVariant());
+        if (obj->HasStream())
+            REQUIRE(other.MustGetStream().GetCopy() == obj->MustGetStream().GetCopy());
+    }
+}
+
+TEST_CASE("TestArena")
+{
+    PdfArena arena;
+    void* heapMem = PdfArena::Allocate(24);
+    REQUIRE(!PdfArena::IsArenaMemory(heapMem));
+    REQUIRE(reinterpret_cast<uintptr_t>(heapMem) % PdfArena::HeapAlignment == 0);
+    void* arenaMem;
+    void* nestedHeapMem;
+    {
+        PdfArena::Scope scope(&arena);
+        arenaMem = PdfArena::Allocate(24);
+        REQUIRE(PdfArena::IsArenaMemory(arenaMem));
+        REQUIRE(reinterpret_cast<uintptr_t>(arenaMem) % PdfArena::Alignment == 0);
+
+        // A null arena activates the heap again
+        PdfArena::Scope heapScope(nullptr);
+        nestedHeapMem = PdfArena::Allocate(24);
+        REQUIRE(!PdfArena::IsArenaMemory(nestedHeapMem));
+    }
+
+    auto num = PdfArena::New<int64_t>(5);
+    REQUIRE(!PdfArena::IsArenaMemory(num));
+    PdfArena::Delete(num);
+    PdfArena::Deallocate(arenaMem);
+    PdfArena::Deallocate(nestedHeapMem);
+    PdfArena::Deallocate(heapMem);
+}
+
+TEST_CASE("TestArenaAllocation")
+{
+    auto buffer = generateObjectStreamDocument();
+
+    PdfMemDocument serialDoc;
+    serialDoc.LoadFromBuffer(buffer);
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer, { }, PdfLoadOptions::ParallelLoad | PdfLoadOptions::ArenaAllocation);
+    REQUIRE(doc.GetPages().GetCount() == 1);
+    REQUIRE(doc.GetObjects().GetSize() == serialDoc.GetObjects().GetSize());
+    for (auto obj : serialDoc.GetObjects())
+    {
+        auto& other = doc.GetObjects().MustGetObject(obj->GetIndirectReference());
+        REQUIRE(other.GetVariant() == obj->GetVariant());
+    }
+
+    // Objects created after loading live together with the arena ones
+    auto& obj = doc.GetObjects().MustGetObject(PdfReference(4, 0));
+    (void)doc.GetObjects().CreateDictionaryObject();
+    obj.GetDictionary().AddKey("Other"_n, PdfObject(PdfDictionary()));
+    REQUIRE(obj.GetDictionary().MustFindKey("Other").IsDictionary());
+    REQUIRE(obj.GetDictionary().MustFindKey("Value").GetNumber() == 4);
+
+    // Deleting objects and reloading the document releases the arena
+    doc.CollectGarbage();
+    charbuff saved;
+    BufferStreamDevice output(saved);
+    doc.Save(output);
+    doc.LoadFromBuffer(buffer, { }, PdfLoadOptions::ArenaAllocation);
+    REQUIRE(doc.GetPages().GetCount() == 1);
+    REQUIRE(doc.GetObjects().MustGetObject(PdfReference(4, 0)).GetDictionary().MustFindKey("Value").GetNumber() == 4);
+
+    PdfMemDocument savedDoc;
+    savedDoc.LoadFromBuffer(saved);
+    REQUIRE(savedDoc.GetPages().GetCount() == 1);
+}
+
+TEST_CASE("TestReferenceStreamData")
+{
+    charbuff buffer;
+    PdfReference ref1;
+    PdfReference ref2;
+    {
+        PdfMemDocument doc;
+        auto& obj1 = doc.GetObjects().CreateDictionaryObject();
+        obj1.GetOrCreateStream().SetData("stream data 1"sv, true);
+        ref1 = obj1.GetIndirectReference();
+        doc.GetCatalog().GetDictionary().AddKeyIndirect("Test1"_n, obj1);
+        auto& obj2 = doc.GetObjects().CreateDictionaryObject();
+        obj2.GetOrCreateStream().SetData("stream data 2"sv, true);
+        ref2 = obj2.GetIndirectReference();
+        doc.GetCatalog().GetDictionary().AddKeyIndirect("Test2"_n, obj2);
+        BufferStreamDevice device(buffer);
+        doc.Save(device, PdfSaveOptions::NoFlateCompress);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    auto& obj1 = doc.GetObjects().MustGetObject(ref1);
+    auto& obj2 = doc.GetObjects().MustGetObject(ref2);
+
+    // Raw data of unmodified streams is referenced in the source
+    auto& stream1 = obj1.MustGetStream();
+    auto provider1 = dynamic_cast<const PdfParserObjectStream*>(&std::as_const(stream1).GetProvider());
+    REQUIRE(provider1 != nullptr);
+    REQUIRE(provider1->IsReferenced());
+    REQUIRE(stream1.GetLength() == 13);
+    REQUIRE(stream1.GetCopy() == "stream data 1");
+
+    // Reading interleaved streams works on the shared device
+    {
+        auto input1 = stream1.GetInputStream();
+        auto input2 = obj2.MustGetStream().GetInputStream();
+        REQUIRE(input1.ReadChar() == 's');
+        REQUIRE(input2.ReadChar() == 's');
+        REQUIRE(input1.ReadChar() == 't');
+    }
+
+    // Modified streams are copied in memory
+    obj2.MustGetStream().SetData("modified"sv, true);
+    auto provider2 = dynamic_cast<const PdfParserObjectStream*>(&std::as_const(obj2.MustGetStream()).GetProvider());
+    REQUIRE(provider2 != nullptr);
+    REQUIRE(!provider2->IsReferenced());
+
+    charbuff saved;
+    BufferStreamDevice device(saved);
+    doc.Save(device, PdfSaveOptions::NoFlateCompress);
+    REQUIRE(provider1->IsReferenced());
+
+    PdfMemDocument doc2;
+    doc2.LoadFromBuffer(saved);
+    REQUIRE(doc2.GetObjects().MustGetObject(ref1).MustGetStream().GetCopy() == "stream data 1");
+    REQUIRE(doc2.GetObjects().MustGetObject(ref2).MustGetStream().GetCopy() == "modified");
+
+    // Copies don't reference the source
+    PdfObject copy(obj1);
+    REQUIRE(copy.MustGetStream().GetCopy() == "stream data 1");
+}
+
+TEST_CASE("TestSaveRawStreamPassThrough")
+{
+    auto inputPath = TestUtils::GetTestOutputFilePath("TestSaveRawStreamPassThrough1.pdf");
+    auto outputPath = TestUtils::GetTestOutputFilePath("TestSaveRawStreamPassThrough2.pdf");
+    PdfReference ref;
+    charbuff raw;
+    {
+        PdfMemDocument doc;
+        auto& obj = doc.GetObjects().CreateDictionaryObject();
+        string data;
+        for (unsigned i = 0; i < 1000; i++)
+            data.append(utls::Format("Raw stream line {}\n", i));
+
+        obj.GetOrCreateStream().SetData(data);
+        raw = obj.GetStream()->GetCopy(true);
+        ref = obj.GetIndirectReference();
+        doc.GetCatalog().GetDictionary().AddKeyIndirect("Test"_n, obj);
+        doc.Save(inputPath);
+    }
+
+    auto checkSaved = [&](PdfMemDocument& doc) {
+        // The raw data is referenced in the source file and
+        // it's copied verbatim to the output file
+        auto& stream = doc.GetObjects().MustGetObject(ref).MustGetStream();
+        auto provider = dynamic_cast<const PdfParserObjectStream*>(&std::as_const(stream).GetProvider());
+        REQUIRE(provider != nullptr);
+        REQUIRE(provider->IsReferenced());
+        doc.Save(outputPath);
+        REQUIRE(provider->IsReferenced());
+
+        charbuff output;
+        utls::ReadTo(output, outputPath);
+        REQUIRE(string_view(output.data(), output.size()).find(string_view(raw.data(), raw.size())) != string_view::npos);
+
+        PdfMemDocument saved;
+        saved.Load(outputPath);
+        REQUIRE(saved.GetObjects().MustGetObject(ref).MustGetStream().GetCopy(true) == raw);
+    };
+
+    {
+        PdfMemDocument doc;
+        doc.Load(inputPath);
+        checkSaved(doc);
+    }
+
+    // Streams are referenced also when loading all the objects, on request
+    {
+        PdfMemDocument doc;
+        doc.Load(inputPath, { }, PdfLoadOptions::ParallelLoad | PdfLoadOptions::ReferenceStreamData);
+        checkSaved(doc);
+    }
+
+    {
+        PdfMemDocument doc;
+        doc.Load(inputPath, { }, PdfLoadOptions::ParallelLoad);
+        auto& stream = doc.GetObjects().MustGetObject(ref).MustGetStream();
+        REQUIRE(dynamic_cast<const PdfParserObjectStream*>(&std::as_const(stream).GetProvider()) == nullptr);
+        REQUIRE(stream.GetCopy(true) == raw);
+    }
+}
+
+TEST_CASE("TestRebuildBrokenXRef")
+{
+    charbuff buffer;
+    {
+        PdfMemDocument doc;
+        for (unsigned i = 0; i < 3; i++)
+            doc.GetPages().CreatePage(PdfPageSize::A4);
+
+        BufferStreamDevice device(buffer);
+        doc.Save(device, PdfSaveOptions::NoFlateCompress);
+    }
+
+    // Corrupt the xref keyword
+    string broken(buffer.data(), buffer.size());
+    size_t xrefPos = broken.rfind("\nxref");
+    REQUIRE(xrefPos != string::npos);
+    broken.replace(xrefPos + 1, 4, "xxxx");
+    {
+        PdfMemDocument doc;
+        ASSERT_THROW_WITH_ERROR_CODE(doc.LoadFromBuffer(broken), PdfErrorCode::InvalidNumber);
+        doc.LoadFromBuffer(broken, { }, PdfLoadOptions::RebuildBrokenXRef);
+        REQUIRE(doc.GetPages().GetCount() == 3);
+    }
+
+    // Shift all the offsets with a comment after the header:
+    // the xref table can be read but it doesn't locate the catalog
+    string shifted(buffer.data(), buffer.size());
+    shifted.insert(shifted.find('\n') + 1, "% Garbage inserted by a broken producer\n");
+    {
+        PdfMemDocument doc;
+        doc.LoadFromBuffer(shifted, { }, PdfLoadOptions::RebuildBrokenXRef);
+        REQUIRE(doc.GetPages().GetCount() == 3);
+    }
+
+    // Point startxref to the object stream: compressed
+    // objects are recovered from the object stream
+    auto objStmDoc = generateObjectStreamDocument();
+    size_t startxrefPos = objStmDoc.rfind("startxref\n");
+    REQUIRE(startxrefPos != string::npos);
+    objStmDoc.replace(startxrefPos, objStmDoc.find("%%EOF") - startxrefPos, "startxref\n9\n");
+    {
+        PdfMemDocument doc;
+        doc.LoadFromBuffer(objStmDoc, { }, PdfLoadOptions::RebuildBrokenXRef);
+        REQUIRE(doc.GetPages().GetCount() == 1);
+        REQUIRE(doc.GetObjects().MustGetObject(PdfReference(4, 0)).GetDictionary().MustFindKey("Value").GetNumber() == 4);
+        REQUIRE(doc.GetObjects().MustGetObject(PdfReference(5, 0)).GetDictionary().MustFindKey("Value").GetNumber() == 5);
+    }
+}
+
+TEST_CASE("TestDocumentProbe")
+{
+    PdfMemDocument doc;
+    for (unsigned i = 0; i < 3; i++)
+        doc.GetPages().CreatePage(PdfPageSize::A4);
+
+    doc.GetMetadata().SetTitle(PdfString("ProbeTitle"));
+    doc.GetMetadata().SetAuthor(PdfString("ProbeAuthor"));
+
+    charbuff buffer;
+    BufferStreamDevice device(buffer);
+    doc.Save(device);
+
+    // NOTE: The probe reads the buffer while it's loaded
+    PdfDocumentProbe probe;
+    probe.LoadFromBuffer(buffer);
+    REQUIRE(probe.GetPageCount() == 3);
+    REQUIRE(!probe.IsEncrypted());
+    REQUIRE(probe.GetIncrementalUpdateCount() == 0);
+    auto& metadata = probe.GetMetadata();
+    REQUIRE(metadata.Title->GetString() == "ProbeTitle");
+    REQUIRE(metadata.Author->GetString() == "ProbeAuthor");
+    REQUIRE(metadata.Subject == nullptr);
+    REQUIRE(!probe.IsTagged());
+    REQUIRE(probe.GetEncrypt() == nullptr);
+    REQUIRE(probe.HasInfo());
+    REQUIRE(probe.GetInfoValue("Author")->GetString().GetString() == "ProbeAuthor");
+    REQUIRE(probe.GetInfoValue("Trapped") == nullptr);
+    auto a4 = PdfPage::CreateStandardPageSize(PdfPageSize::A4);
+    REQUIRE(probe.GetFirstPageMediaBox()->Width == a4.Width);
+    REQUIRE(probe.GetFirstPageMediaBox()->Height == a4.Height);
+
+    // Compressed objects, with XMP metadata
+    doc.GetMetadata().SetPdfUALevel(PdfUALevel::L1);
+    charbuff packed;
+    BufferStreamDevice packedDevice(packed);
+    doc.Save(packedDevice, PdfSaveOptions::ObjectStreams);
+    probe.LoadFromBuffer(packed);
+    REQUIRE(probe.GetPageCount() == 3);
+    REQUIRE(probe.GetPdfVersion() >= PdfVersion::V1_5);
+    REQUIRE(probe.GetXMPPacket().find("ProbeTitle") != string::npos);
+    REQUIRE(probe.GetMetadata().Title->GetString() == "ProbeTitle");
+    REQUIRE(probe.GetMetadata().PdfuaLevel == PdfUALevel::L1);
+
+    // Encrypted documents require the password
+    doc.SetEncrypted("user", "owner");
+    charbuff encrypted;
+    BufferStreamDevice encryptedDevice(encrypted);
+    doc.Save(encryptedDevice);
+    probe.LoadFromBuffer(encrypted, "user");
+    REQUIRE(probe.IsEncrypted());
+    REQUIRE(probe.GetEncrypt() != nullptr);
+    REQUIRE(probe.GetPageCount() == 3);
+    REQUIRE(probe.GetMetadata().Title->GetString() == "ProbeTitle");
+
+    ASSERT_THROW_WITH_ERROR_CODE(probe.LoadFromBuffer(encrypted, "wrongpass"), PdfErrorCode::InvalidPassword);
+}
+
 // This tests saving the update on a document with
 // compressed object stream with an indirect length
 // still produces a readable file
@@ -2866,6 +3262,60 @@ string generateXRefEntries(size_t count)
     return strXRefEntries;
 }
 
+string generateObjectStreamDocument()
+{
+    // Objects 1 to 5 are stored in the object stream 6, with
+    // a cross-reference stream with no filters at object 7
+    vector<string> compressedObjs = {
+        "<< /Type /Catalog /Pages 2 0 R >>",
+        "<< /Type /Pages /Kids [ 3 0 R ] /Count 1 >>",
+        "<< /Type /Page /Parent 2 0 R /MediaBox [ 0 0 612 792 ] >>",
+        "<< /Value 4 >>",
+        "<< /Value 5 >>",
+    };
+
+    string header;
+    string objs;
+    for (unsigned i = 0; i < compressedObjs.size(); i++)
+    {
+        header.append(utls::Format("{} {} ", i + 1, objs.size()));
+        objs.append(compressedObjs[i]).append("\n");
+    }
+
+    auto appendEntry = [](string& data, unsigned type, unsigned field2, unsigned field3) {
+        data.push_back((char)type);
+        data.push_back((char)((field2 >> 24) & 0xFF));
+        data.push_back((char)((field2 >> 16) & 0xFF));
+        data.push_back((char)((field2 >> 8) & 0xFF));
+        data.push_back((char)(field2 & 0xFF));
+        data.push_back((char)((field3 >> 8) & 0xFF));
+        data.push_back((char)(field3 & 0xFF));
+    };
+
+    string ret = "%PDF-1.5\n";
+    size_t objStmOffset = ret.size();
+    ret.append(utls::Format("6 0 obj\n<< /Type /ObjStm /N {} /First {} /Length {} >>\nstream\n",
+        compressedObjs.size(), header.size(), header.size() + objs.size()));
+    ret.append(header).append(objs).append("\nendstream\nendobj\n");
+
+    string xrefData;
+    appendEntry(xrefData, 0, 0, 0xFFFF);
+    appendEntry(xrefData, 2, 6, 0);
+    appendEntry(xrefData, 2, 6, 1);
+    appendEntry(xrefData, 2, 6, 2);
+    appendEntry(xrefData, 2, 6, 0); // Wrong index, it should be 3
+    appendEntry(xrefData, 2, 6, 4);
+    appendEntry(xrefData, 1, (unsigned)objStmOffset, 0);
+    size_t xrefOffset = ret.size();
+    appendEntry(xrefData, 1, (unsigned)xrefOffset, 0);
+
+    ret.append(utls::Format("7 0 obj\n<< /Type /XRef /Size 8 /W [ 1 4 2 ] /Root 1 0 R /Length {} >>\nstream\n",
+        xrefData.size()));
+    ret.append(xrefData).append("\nendstream\nendobj\n");
+    ret.append(utls::Format("startxref\n{}\n%%EOF\n", xrefOffset));
+    return ret;
+}
+
 bool canOutOfMemoryKillUnitTests()
 {
     // test if out of memory conditions will kill the unit test process
@@ -195,4 +195,66 @@ TEST_CASE("SelectEdgeCases")
     pageNumbers = { 1, 2, 3 };
     doc.Select(pageNumbers);
     REQUIRE(doc.GetPages().GetCount() == 0); // Should clear document
-} 
\ No newline at end of file
+} 
+
+TEST_CASE("SelectKeepsPageObjects")
+{
+    charbuff buffer;
+    {
+        PdfMemDocument doc;
+        for (unsigned i = 0; i < 100; i++)
+        {
+            auto& page = doc.GetPages().CreatePage(PdfPageSize::A4);
+            auto& contents = doc.GetObjects().CreateDictionaryObject();
+            contents.GetOrCreateStream().SetData("page " + std::to_string(i));
+            page.GetDictionary().AddKeyIndirect("Contents"_n, contents);
+            auto& annot = page.GetAnnotations().CreateAnnot<PdfAnnotationText>(Rect(100, 100, 20, 20));
+            annot.SetContents(PdfString("note " + std::to_string(i)));
+        }
+
+        BufferStreamDevice device(buffer);
+        doc.Save(device);
+    }
+
+    PdfMemDocument doc;
+    doc.LoadFromBuffer(buffer);
+    auto pageRef = doc.GetPages().GetPageAt(70).GetObject().GetIndirectReference();
+    unsigned objectCount = doc.GetObjects().GetSize();
+
+    // Select a page twice: the second is a copy
+    vector<unsigned> pageNumbers = { 70, 3, 70 };
+    doc.Select(pageNumbers);
+    REQUIRE(doc.GetPages().GetCount() == 3);
+    auto& page1 = doc.GetPages().GetPageAt(0);
+    auto& page3 = doc.GetPages().GetPageAt(2);
+    REQUIRE(page1.GetObject().GetIndirectReference() == pageRef);
+    REQUIRE(page3.GetObject().GetIndirectReference() != pageRef);
+    REQUIRE(page3.GetDictionary().MustGetKey("Contents").GetReference()
+        == page1.GetDictionary().MustGetKey("Contents").GetReference());
+
+    // The annotations are kept, and copied for the copied page
+    REQUIRE(page1.GetAnnotations().GetCount() == 1);
+    REQUIRE(page3.GetAnnotations().GetCount() == 1);
+    auto& annot3 = page3.GetAnnotations().GetAnnotAt(0);
+    REQUIRE(*annot3.GetContents() == "note 70");
+    REQUIRE(&annot3.GetObject() != &page1.GetAnnotations().GetAnnotAt(0).GetObject());
+    REQUIRE(annot3.GetDictionary().MustGetKey("P").GetReference() == page3.GetObject().GetIndirectReference());
+
+    // The objects of the pages not selected are removed
+    REQUIRE(doc.GetObjects().GetSize() < objectCount / 10);
+
+    buffer.clear();
+    BufferStreamDevice device(buffer);
+    doc.Save(device);
+
+    PdfMemDocument loaded;
+    loaded.LoadFromBuffer(buffer);
+    REQUIRE(loaded.GetPages().GetCount() == 3);
+    const char* expected[] = { "page 70", "page 3", "page 70" };
+    for (unsigned i = 0; i < 3; i++)
+    {
+        charbuff data;
+        loaded.GetPages().GetPageAt(i).GetDictionary().MustFindKey("Contents").MustGetStream().CopyTo(data);
+        REQUIRE(string(data.data(), data.size()) == expected[i]);
+    }
+}
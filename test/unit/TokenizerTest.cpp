@@ -171,6 +171,47 @@ TEST_CASE("TestComments")
     TestStreamIsNextToken(pszBuffer, pszTokens);
 }
 
+TEST_CASE("TestBufferedDevices")
+{
+    // Tokens scanned directly on the device buffer must
+    // match the ones read with per character reads
+    string_view buffer = "613 0 obj\n% A comment\n<< /Name/Value#20A /Str (Hallo (Welt)\\051\\n) "
+        "/Hex <48 61 6C6C6f> /Arr [1 2.5 3 0 R] >>\nendobj";
+
+    SpanStreamDevice spanDevice(buffer);
+    istringstream stream((string)buffer);
+    StandardStreamDevice streamDevice(stream);
+    PdfTokenizer spanTokenizer;
+    PdfTokenizer streamTokenizer;
+    string_view spanToken;
+    string_view streamToken;
+    for (unsigned i = 0; i < 3; i++)
+    {
+        REQUIRE(spanTokenizer.TryReadNextToken(spanDevice, spanToken));
+        REQUIRE(streamTokenizer.TryReadNextToken(streamDevice, streamToken));
+        REQUIRE(spanToken == streamToken);
+    }
+
+    PdfVariant spanVariant;
+    PdfVariant streamVariant;
+    REQUIRE(spanTokenizer.TryReadNextVariant(spanDevice, spanVariant));
+    REQUIRE(streamTokenizer.TryReadNextVariant(streamDevice, streamVariant));
+    string spanStr;
+    string streamStr;
+    spanVariant.ToString(spanStr);
+    streamVariant.ToString(streamStr);
+    REQUIRE(spanStr == streamStr);
+    REQUIRE(spanStr == "<</Arr[ 1 2.5 3 0 R]/Hex<48616C6C6F>/Name/Value#20A/Str(Hallo \\(Welt\\)\\)\\n)>>");
+
+    // The device position must be just after the last token
+    REQUIRE(spanDevice.GetPosition() == buffer.size() - 7);
+
+    REQUIRE(spanTokenizer.TryReadNextToken(spanDevice, spanToken));
+    REQUIRE(spanToken == "endobj");
+    REQUIRE(spanDevice.Eof());
+    REQUIRE(!spanTokenizer.TryReadNextToken(spanDevice, spanToken));
+}
+
 TEST_CASE("TestLocale")
 {
     // Test with a locale thate uses "," instead of "." for doubles 
@@ -170,6 +170,45 @@ TEST_CASE("TestIsDirtyFalse")
     TestObjectsDirty(objBool, objNum, objReal, objStr, objRef, objArray, objDict, objStream, objVariant, false);
 }
 
+TEST_CASE("TestDictionaryOrder")
+{
+    PdfDictionary dict;
+    auto& first = dict.AddKey("M"_n, PdfObject(static_cast<int64_t>(0)));
+
+    // Insert the keys out of order
+    string keys = "ZYXWVUTSRQPONLKJIHGFEDCBA";
+    for (char ch : keys)
+        dict.AddKey(PdfName(string(1, ch)), PdfObject(static_cast<int64_t>(ch)));
+
+    // Values keep their address on insertions
+    REQUIRE(&first == dict.GetKey("M"));
+    REQUIRE(dict.GetSize() == keys.size() + 1);
+    REQUIRE(dict.MustGetKey("Q").GetNumber() == 'Q');
+    REQUIRE(!dict.HasKey("MM"));
+
+    // Iteration is in ascending key order
+    string iterated;
+    for (auto& pair : std::as_const(dict))
+        iterated.append(pair.first.GetString());
+
+    REQUIRE(iterated == "ABCDEFGHIJKLMNOPQRSTUVWXYZ");
+
+    REQUIRE(dict.RemoveKey("A"));
+    REQUIRE(!dict.RemoveKey("A"));
+    REQUIRE(std::as_const(dict).begin()->first == "B");
+
+    // Values keep their address on removals of
+    // other keys and when they are replaced
+    REQUIRE(&first == dict.GetKey("M"));
+    REQUIRE(&dict.AddKey("M"_n, PdfObject(static_cast<int64_t>(1))) == &first);
+    REQUIRE(first.GetNumber() == 1);
+
+    PdfDictionary copy(dict);
+    REQUIRE(copy == dict);
+    copy.AddKey("B"_n, PdfObject(static_cast<int64_t>(1)));
+    REQUIRE(!(copy == dict));
+}
+
 void TestObjectsDirty(
     const PdfObject& objBool,
     const PdfObject& objNum,
@@ -0,0 +1,254 @@
+/**
+ * SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#include <PdfTest.h>
+
+using namespace std;
+using namespace PoDoFo;
+
+static void drawPages(PdfMemDocument& doc, unsigned pageCount);
+static unsigned countObjectStreams(const PdfMemDocument& doc);
+static const PdfDictionary& getLinearizationDict(const PdfMemDocument& doc);
+
+TEST_CASE("TestSaveObjectStreams")
+{
+    PdfMemDocument doc;
+    auto& arr = doc.GetCatalog().GetDictionary().AddKey("Test"_n, PdfArray()).GetArray();
+    for (unsigned i = 0; i < 250; i++)
+    {
+        auto& obj = doc.GetObjects().CreateDictionaryObject();
+        obj.GetDictionary().AddKey("Value"_n, static_cast<int64_t>(i));
+        arr.AddIndirect(obj);
+    }
+
+    auto& streamObj = doc.GetObjects().CreateDictionaryObject();
+    streamObj.GetOrCreateStream().SetData("stream data"sv);
+    arr.AddIndirect(streamObj);
+
+    charbuff plain;
+    BufferStreamDevice plainDevice(plain);
+    doc.Save(plainDevice);
+
+    charbuff packed;
+    BufferStreamDevice packedDevice(packed);
+    doc.Save(packedDevice, PdfSaveOptions::ObjectStreams);
+    REQUIRE(packed.size() < plain.size());
+    REQUIRE(string_view(packed.data(), packed.size()).find("/XRef") != string_view::npos);
+
+    doc.LoadFromBuffer(packed);
+    auto& loadedArr = doc.GetCatalog().GetDictionary().MustFindKey("Test").GetArray();
+    REQUIRE(loadedArr.GetSize() == 251);
+    for (unsigned i = 0; i < 250; i++)
+        REQUIRE(loadedArr.MustFindAt(i).GetDictionary().MustFindKey("Value").GetNumber() == i);
+
+    // Streams are not compressed in object streams
+    REQUIRE(loadedArr.MustFindAt(250).MustGetStream().GetCopy() == "stream data");
+
+    // The dictionaries fill 3 object streams of 100 objects at most
+    REQUIRE(countObjectStreams(doc) == 3);
+}
+
+TEST_CASE("TestSaveObjectStreamsEncrypted")
+{
+    PdfMemDocument doc;
+    auto& obj = doc.GetObjects().CreateDictionaryObject();
+    obj.GetDictionary().AddKey("Text"_n, PdfString("Object text"));
+    doc.GetCatalog().GetDictionary().AddKeyIndirect("Test"_n, obj);
+    doc.SetEncrypted("user", "owner");
+
+    charbuff buffer;
+    BufferStreamDevice device(buffer);
+    doc.Save(device, PdfSaveOptions::ObjectStreams);
+
+    // The object stream is encrypted as a whole
+    REQUIRE(string_view(buffer.data(), buffer.size()).find("Object text") == string_view::npos);
+    doc.LoadFromBuffer(buffer, "user");
+    REQUIRE(countObjectStreams(doc) == 1);
+    REQUIRE(doc.GetCatalog().GetDictionary().MustFindKey("Test")
+        .GetDictionary().MustFindKey("Text").GetString() == "Object text");
+}
+
+TEST_CASE("TestSaveLinearized")
+{
+    PdfMemDocument doc;
+    drawPages(doc, 3);
+
+    charbuff buffer;
+    BufferStreamDevice device(buffer);
+    doc.Save(device, PdfSaveOptions::Linearize | PdfSaveOptions::NoMetadataUpdate);
+
+    // The linearization dictionary is the first object of the file
+    auto view = string_view(buffer.data(), buffer.size());
+    REQUIRE(view.find("/Linearized 1") < 1024);
+
+    doc.LoadFromBuffer(buffer);
+    REQUIRE(doc.GetPages().GetCount() == 3);
+    vector<PdfTextEntry> entries;
+    doc.GetPages().GetPageAt(2).ExtractTextTo(entries);
+    REQUIRE(entries.size() == 1);
+    REQUIRE(entries[0].Text == "Page 3");
+
+    auto& dict = getLinearizationDict(doc);
+    REQUIRE((size_t)dict.MustFindKey("L").GetNumber() == buffer.size());
+    REQUIRE(dict.MustFindKey("N").GetNumber() == 3);
+    auto firstPageNum = doc.GetPages().GetPageAt(0).GetObject().GetIndirectReference().ObjectNumber();
+    REQUIRE(dict.MustFindKey("O").GetNumber() == firstPageNum);
+
+    // The first page section ends before the other pages
+    auto firstPageEnd = (size_t)dict.MustFindKey("E").GetNumber();
+    auto secondPageNum = doc.GetPages().GetPageAt(1).GetObject().GetIndirectReference().ObjectNumber();
+    REQUIRE(view.find(utls::Format("\n{} 0 obj", firstPageNum)) < firstPageEnd);
+    REQUIRE(view.find(utls::Format("\n{} 0 obj", secondPageNum)) + 1 >= firstPageEnd);
+
+    auto& hint = dict.MustFindKey("H").GetArray();
+    auto hintEnd = (size_t)(hint.MustFindAt(0).GetNumber() + hint.MustFindAt(1).GetNumber());
+    REQUIRE(view.substr(hintEnd - 7, 7) == "endobj\n");
+    auto mainXRefEntries = (size_t)dict.MustFindKey("T").GetNumber();
+    REQUIRE(view.substr(mainXRefEntries, 19) == "\n0000000000 65535 f");
+}
+
+TEST_CASE("TestSaveLinearizedEncrypted")
+{
+    PdfMemDocument doc;
+    drawPages(doc, 2);
+    doc.SetEncrypted("user", "owner");
+
+    charbuff buffer;
+    BufferStreamDevice device(buffer);
+    doc.Save(device, PdfSaveOptions::Linearize);
+
+    doc.LoadFromBuffer(buffer, "user");
+    REQUIRE((size_t)getLinearizationDict(doc).MustFindKey("L").GetNumber() == buffer.size());
+    vector<PdfTextEntry> entries;
+    doc.GetPages().GetPageAt(1).ExtractTextTo(entries);
+    REQUIRE(entries.size() == 1);
+    REQUIRE(entries[0].Text == "Page 2");
+}
+
+TEST_CASE("TestSaveLinearizedLoaded")
+{
+    PdfMemDocument doc;
+    drawPages(doc, 2);
+
+    charbuff packed;
+    BufferStreamDevice packedDevice(packed);
+    doc.Save(packedDevice, PdfSaveOptions::ObjectStreams);
+
+    // The object streams of a loaded document are not copied
+    doc.LoadFromBuffer(packed);
+    charbuff linearized;
+    BufferStreamDevice linearizedDevice(linearized);
+    doc.Save(linearizedDevice, PdfSaveOptions::Linearize);
+    REQUIRE(string_view(linearized.data(), linearized.size()).find("/ObjStm") == string_view::npos);
+
+    // The old linearization dictionary is replaced
+    doc.LoadFromBuffer(linearized);
+    charbuff relinearized;
+    BufferStreamDevice relinearizedDevice(relinearized);
+    doc.Save(relinearizedDevice, PdfSaveOptions::Linearize | PdfSaveOptions::NoCollectGarbage);
+
+    doc.LoadFromBuffer(relinearized);
+    REQUIRE(doc.GetPages().GetCount() == 2);
+    REQUIRE((size_t)getLinearizationDict(doc).MustFindKey("L").GetNumber() == relinearized.size());
+}
+
+TEST_CASE("TestSaveParallelWrite")
+{
+    PdfMemDocument doc;
+    auto& arr = doc.GetCatalog().GetDictionary().AddKey("Test"_n, PdfArray()).GetArray();
+    for (unsigned i = 0; i < 200; i++)
+    {
+        string data;
+        for (unsigned j = 0; j < 100; j++)
+            data.append(utls::Format("Stream {} line {}\n", i, j));
+
+        auto& obj = doc.GetObjects().CreateDictionaryObject();
+        obj.GetOrCreateStream().SetData(data, true);
+        arr.AddIndirect(obj);
+    }
+
+    charbuff serial;
+    BufferStreamDevice serialDevice(serial);
+    doc.Save(serialDevice, PdfSaveOptions::NoMetadataUpdate);
+
+    charbuff parallel;
+    BufferStreamDevice parallelDevice(parallel);
+    doc.Save(parallelDevice, PdfSaveOptions::ParallelWrite | PdfSaveOptions::NoMetadataUpdate);
+
+    // The objects are written in the same order with the same data
+    REQUIRE(parallel == serial);
+
+    doc.LoadFromBuffer(parallel);
+    auto& loadedArr = doc.GetCatalog().GetDictionary().MustFindKey("Test").GetArray();
+    REQUIRE(loadedArr.GetSize() == 200);
+    auto& obj = loadedArr.MustFindAt(199);
+    REQUIRE(obj.GetDictionary().MustFindKey("Filter").GetName() == "FlateDecode");
+    REQUIRE(obj.MustGetStream().GetCopy().find("Stream 199 line 99\n") != string::npos);
+}
+
+TEST_CASE("TestSaveParallelWriteEncrypted")
+{
+    PdfMemDocument doc;
+    auto& arr = doc.GetCatalog().GetDictionary().AddKey("Test"_n, PdfArray()).GetArray();
+    for (unsigned i = 0; i < 10; i++)
+    {
+        auto& obj = doc.GetObjects().CreateDictionaryObject();
+        obj.GetOrCreateStream().SetData(utls::Format("Stream {}", i));
+        arr.AddIndirect(obj);
+    }
+    doc.SetEncrypted("user", "owner");
+
+    charbuff buffer;
+    BufferStreamDevice device(buffer);
+    doc.Save(device, PdfSaveOptions::ParallelWrite);
+
+    doc.LoadFromBuffer(buffer, "user");
+    auto& loadedArr = doc.GetCatalog().GetDictionary().MustFindKey("Test").GetArray();
+    for (unsigned i = 0; i < 10; i++)
+        REQUIRE(loadedArr.MustFindAt(i).MustGetStream().GetCopy() == utls::Format("Stream {}", i));
+}
+
+// Draw pages with a "Page <n>" text line each
+void drawPages(PdfMemDocument& doc, unsigned pageCount)
+{
+    auto& font = doc.GetFonts().GetStandard14Font(PdfStandard14FontType::Helvetica);
+    for (unsigned i = 0; i < pageCount; i++)
+    {
+        auto& page = doc.GetPages().CreatePage(PdfPageSize::A4);
+        PdfPainter painter;
+        painter.SetCanvas(page);
+        painter.TextState.SetFont(font, 15);
+        painter.DrawText(utls::Format("Page {}", i + 1), 100, 500);
+        painter.FinishDrawing();
+    }
+}
+
+unsigned countObjectStreams(const PdfMemDocument& doc)
+{
+    unsigned ret = 0;
+    const PdfName* type;
+    for (auto obj : doc.GetObjects())
+    {
+        if (obj->IsDictionary() && obj->GetDictionary().TryFindKeyAs("Type", type) && *type == "ObjStm")
+        {
+            REQUIRE(obj->GetDictionary().MustFindKey("N").GetNumber() <= 100);
+            ret++;
+        }
+    }
+
+    return ret;
+}
+
+const PdfDictionary& getLinearizationDict(const PdfMemDocument& doc)
+{
+    const PdfDictionary* ret = nullptr;
+    for (auto obj : doc.GetObjects())
+    {
+        if (obj->IsDictionary() && obj->GetDictionary().HasKey("Linearized"))
+            ret = &obj->GetDictionary();
+    }
+
+    REQUIRE(ret != nullptr);
+    return *ret;
+}
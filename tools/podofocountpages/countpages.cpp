@@ -23,9 +23,11 @@ void print_help()
 
 int count_pages(const string_view filename, const bool& shortFormat)
 {
-    PdfMemDocument document;
-    document.Load(filename);
-    unsigned nPages = document.GetPages().GetCount();
+    // Only the page tree root is needed: probe the
+    // document instead of loading it
+    PdfDocumentProbe probe;
+    probe.Load(filename);
+    unsigned nPages = probe.GetPageCount();
     
     if (shortFormat)
         printf("%i\n", nPages);
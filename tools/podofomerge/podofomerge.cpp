@@ -13,21 +13,28 @@ using namespace PoDoFo;
 
 void print_help()
 {
-    printf("Usage: podofomerge [inputfile1] [inputfile2] [outputfile]\n\n");
+    printf("Usage: podofomerge [inputfile1] [inputfile2] ... [outputfile]\n\n");
     printf("\nPoDoFo Version: %s\n\n", PODOFO_VERSION_STRING);
 }
 
-void merge(const string_view input1Path, const string_view input2Path, const string_view outputPath)
+void merge(const cspan<string_view>& inputPaths, const string_view outputPath)
 {
-    printf("Reading file: %s\n", input1Path.data());
+    printf("Reading file: %s\n", inputPaths[0].data());
     PdfMemDocument input1;
-    input1.Load(input1Path);
-    printf("Reading file: %s\n", input2Path.data());
-    PdfMemDocument input2;
-    input2.Load(input2Path);
+    input1.Load(inputPaths[0]);
 
-    printf("Appending %i pages on a document with %i pages.\n", input2.GetPages().GetCount(), input1.GetPages().GetCount());
-    input1.GetPages().AppendDocumentPages(input2);
+    // Each input is loaded and appended in turn, so only one of them is
+    // in memory at a time. Resources equal to ones already appended,
+    // e.g. embedded fonts, are shared and not copied again
+    for (size_t i = 1; i < inputPaths.size(); i++)
+    {
+        printf("Reading file: %s\n", inputPaths[i].data());
+        PdfMemDocument input;
+        input.Load(inputPaths[i]);
+
+        printf("Appending %i pages on a document with %i pages.\n", input.GetPages().GetCount(), input1.GetPages().GetCount());
+        input1.GetPages().AppendDocumentPages(input);
+    }
 
     // we are going to bookmark the insertions
     // using destinations - also adding each as a NamedDest
@@ -56,15 +63,14 @@ void merge(const string_view input1Path, const string_view input2Path, const str
 
 void Main(const cspan<string_view>& args)
 {
-    if (args.size() != 4)
+    if (args.size() < 4)
     {
         print_help();
         exit(-1);
     }
 
-    auto input1Path = args[1];
-    auto input2Path = args[2];
-    auto outputPath = args[3];
+    auto inputPaths = args.subspan(1, args.size() - 2);
+    auto outputPath = args[args.size() - 1];
 
-    merge(input1Path, input2Path, outputPath);
+    merge(inputPaths, outputPath);
 }
@@ -7,6 +7,7 @@
 #include <cstdlib>
 #include <cstdio>
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -38,10 +39,49 @@ void print_help()
     printf("\tbe retrieved from the document though.\n\n");
     printf("\t--move FROM TO\n");
     printf("\tMoves a page FROM TO in the document (FROM and TO are 0-based)\n\n");
+    printf("\t--split COUNT\n");
+    printf("\tSplits the document in parts of COUNT pages, after the other\n");
+    printf("\toperations. The parts are written to files named after the\n");
+    printf("\toutput file with the part number, e.g. output-1.pdf\n\n");
     printf("\nPoDoFo Version: %s\n\n", PODOFO_VERSION_STRING);
 }
 
-void work(const string_view& inputPath, const string_view& outputPath, const vector<Operation*>& operations)
+// Get the path of a part, adding the part number
+// before the extension of the output path
+string getPartPath(const string_view& outputPath, unsigned partNumber)
+{
+    string ret(outputPath);
+    size_t extension = ret.find_last_of('.');
+    size_t separator = ret.find_last_of("/\\");
+    if (extension == string::npos || (separator != string::npos && extension < separator))
+        extension = ret.length();
+
+    ret.insert(extension, "-" + std::to_string(partNumber));
+    return ret;
+}
+
+void split(const PdfMemDocument& doc, const string_view& outputPath, unsigned splitCount)
+{
+    unsigned pageCount = doc.GetPages().GetCount();
+    vector<PdfPageRange> ranges;
+    for (unsigned i = 0; i < pageCount; i += splitCount)
+        ranges.push_back({ i, std::min(splitCount, pageCount - i) });
+
+    cout << "Operations done. Writing " << ranges.size() << " parts to disk." << endl;
+
+    // The document is read once, and each part is
+    // written directly to its file while being copied
+    doc.Split(ranges, [&](unsigned index) {
+        string partPath = getPartPath(outputPath, index + 1);
+        cout << "Part " << index + 1 << ": " << partPath << endl;
+        return std::make_shared<FileStreamDevice>(partPath, FileMode::Create);
+    });
+
+    cout << "Done." << endl;
+}
+
+void work(const string_view& inputPath, const string_view& outputPath, const vector<Operation*>& operations,
+    unsigned splitCount)
 {
     cout << "Input file: " << inputPath << endl;
     cout << "Output file: " << outputPath << endl;
@@ -61,6 +101,12 @@ void work(const string_view& inputPath, const string_view& outputPath, const vec
         i++;
     }
 
+    if (splitCount != 0)
+    {
+        split(doc, outputPath, splitCount);
+        return;
+    }
+
     cout << "Operations done. Writing PDF to disk." << endl;
 
     doc.Save(outputPath);
@@ -90,6 +136,7 @@ void Main(const cspan<string_view>& args)
 
     // Fill operations vector
     vector<Operation*> operations;
+    unsigned splitCount = 0;
     for (unsigned i = 1; i < args.size(); i++)
     {
         string_view argument = args[i];
@@ -107,6 +154,18 @@ void Main(const cspan<string_view>& args)
             i++;
             i++;
         }
+        else if (argument == "--split" || argument == "-split")
+        {
+            int count = static_cast<int>(convertToInt(args[i + 1]));
+            if (count <= 0)
+            {
+                cerr << "The page count of the parts must be positive." << endl;
+                exit(-5);
+            }
+
+            splitCount = (unsigned)count;
+            i++;
+        }
         else
         {
             if (inputPath == NULL)
@@ -142,7 +201,7 @@ void Main(const cspan<string_view>& args)
         exit(-4);
     }
 
-    work(inputPath, outputPath, operations);
+    work(inputPath, outputPath, operations, splitCount);
 
     // Delete operations vector
     vector<Operation*>::iterator it = operations.begin();
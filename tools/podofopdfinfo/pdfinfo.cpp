@@ -11,85 +11,86 @@ using namespace std;
 using namespace PoDoFo;
 
 PdfInfoHelper::PdfInfoHelper(const string& filepath)
+    : m_filepath(filepath)
 {
-    m_doc = new PdfMemDocument();
-    m_doc->Load(filepath);
+    // The document is fully loaded only when
+    // the probed information is not enough
+    m_probe.Load(filepath);
 }
 
-PdfInfoHelper::~PdfInfoHelper()
+PdfMemDocument& PdfInfoHelper::getDocument()
 {
-    if (m_doc)
+    if (m_doc == nullptr)
     {
-        delete m_doc;
-        m_doc = nullptr;
+        m_doc.reset(new PdfMemDocument());
+        m_doc->Load(m_filepath);
     }
+
+    return *m_doc;
 }
 
 void PdfInfoHelper::OutputDocumentInfo(ostream& sOutStream)
 {
-    sOutStream << "\tPDF Version: " << PoDoFo::GetPdfVersionName(m_doc->GetMetadata().GetPdfVersion()).GetString() << endl;
-    sOutStream << "\tPage Count: " << m_doc->GetPages().GetCount() << endl;
+    // NOTE: Without encryption everything is allowed
+    auto encrypt = m_probe.GetEncrypt();
+    sOutStream << "\tPDF Version: " << PoDoFo::GetPdfVersionName(m_probe.GetPdfVersion()).GetString() << endl;
+    sOutStream << "\tPage Count: " << m_probe.GetPageCount() << endl;
     sOutStream << "\tPage Size: " << GuessFormat() << endl;
     sOutStream << endl;
-    sOutStream << "\tTagged: " << (m_doc->GetCatalog().GetStructTreeRootObject() != nullptr ? "Yes" : "No") << endl;
-    sOutStream << "\tEncrypted: " << (m_doc->GetEncrypt() != nullptr ? "Yes" : "No") << endl;
-    sOutStream << "\tPrinting Allowed: " << (m_doc->IsPrintAllowed() ? "Yes" : "No") << endl;
-    sOutStream << "\tModification Allowed: " << (m_doc->IsEditAllowed() ? "Yes" : "No") << endl;
-    sOutStream << "\tCopy&Paste Allowed: " << (m_doc->IsCopyAllowed() ? "Yes" : "No") << endl;
-    sOutStream << "\tAdd/Modify Annotations Allowed: " << (m_doc->IsEditNotesAllowed() ? "Yes" : "No") << endl;
-    sOutStream << "\tFill&Sign Allowed: " << (m_doc->IsFillAndSignAllowed() ? "Yes" : "No") << endl;
-    sOutStream << "\tAccessibility Allowed: " << (m_doc->IsAccessibilityAllowed() ? "Yes" : "No") << endl;
-    sOutStream << "\tDocument Assembly Allowed: " << (m_doc->IsDocAssemblyAllowed() ? "Yes" : "No") << endl;
-    sOutStream << "\tHigh Quality Print Allowed: " << (m_doc->IsHighPrintAllowed() ? "Yes" : "No") << endl;
+    sOutStream << "\tTagged: " << (m_probe.IsTagged() ? "Yes" : "No") << endl;
+    sOutStream << "\tEncrypted: " << (encrypt != nullptr ? "Yes" : "No") << endl;
+    sOutStream << "\tPrinting Allowed: " << (encrypt == nullptr || encrypt->IsPrintAllowed() ? "Yes" : "No") << endl;
+    sOutStream << "\tModification Allowed: " << (encrypt == nullptr || encrypt->IsEditAllowed() ? "Yes" : "No") << endl;
+    sOutStream << "\tCopy&Paste Allowed: " << (encrypt == nullptr || encrypt->IsCopyAllowed() ? "Yes" : "No") << endl;
+    sOutStream << "\tAdd/Modify Annotations Allowed: " << (encrypt == nullptr || encrypt->IsEditNotesAllowed() ? "Yes" : "No") << endl;
+    sOutStream << "\tFill&Sign Allowed: " << (encrypt == nullptr || encrypt->IsFillAndSignAllowed() ? "Yes" : "No") << endl;
+    sOutStream << "\tAccessibility Allowed: " << (encrypt == nullptr || encrypt->IsAccessibilityAllowed() ? "Yes" : "No") << endl;
+    sOutStream << "\tDocument Assembly Allowed: " << (encrypt == nullptr || encrypt->IsDocAssemblyAllowed() ? "Yes" : "No") << endl;
+    sOutStream << "\tHigh Quality Print Allowed: " << (encrypt == nullptr || encrypt->IsHighPrintAllowed() ? "Yes" : "No") << endl;
 }
 
 void PdfInfoHelper::OutputInfoDict(ostream& outStream)
 {
-    if (m_doc->GetInfo() == nullptr)
+    if (!m_probe.HasInfo())
     {
         outStream << "No info dictionary in this PDF file!" << endl;
     }
     else
     {
-        auto author = m_doc->GetInfo()->GetAuthor();
-        if (author != nullptr)
-            outStream << "\tAuthor: " << author->GetString() << endl;
-
-        auto creator = m_doc->GetInfo()->GetCreator();
-        if (creator != nullptr)
-            outStream << "\tCreator: " << creator->GetString() << endl;
-
-        auto subject = m_doc->GetInfo()->GetSubject();
-        if (subject != nullptr)
-            outStream << "\tSubject: " << subject->GetString() << endl;
-
-        auto title = m_doc->GetInfo()->GetTitle();
-        if (title != nullptr)
-            outStream << "\tTitle: " << title->GetString() << endl;
-
-        auto keywords = m_doc->GetInfo()->GetKeywords();
-        if (keywords != nullptr)
-            outStream << "\tKeywords: " << keywords->GetString() << endl;
-
-        auto trapped = m_doc->GetInfo()->GetTrapped();
-        if (trapped != nullptr)
-            outStream << "\tTrapped: " << trapped->GetEscapedName() << endl;
+        OutputInfoString(outStream, "Author");
+        OutputInfoString(outStream, "Creator");
+        OutputInfoString(outStream, "Subject");
+        OutputInfoString(outStream, "Title");
+        OutputInfoString(outStream, "Keywords");
+
+        auto trapped = m_probe.GetInfoValue("Trapped");
+        const PdfName* name;
+        if (trapped != nullptr && trapped->TryGetName(name))
+            outStream << "\tTrapped: " << name->GetEscapedName() << endl;
     }
 }
 
+void PdfInfoHelper::OutputInfoString(ostream& outStream, const string_view& key)
+{
+    auto obj = m_probe.GetInfoValue(key);
+    const PdfString* str;
+    if (obj != nullptr && obj->TryGetString(str))
+        outStream << "\t" << key << ": " << str->GetString() << endl;
+}
+
 void PdfInfoHelper::OutputPageInfo(ostream& outstream)
 {
     PdfArray arr;
     string str;
 
     unsigned annotCount;
-    unsigned pageCount = m_doc->GetPages().GetCount();
+    unsigned pageCount = getDocument().GetPages().GetCount();
     outstream << "Page Count: " << pageCount << endl;
     for (unsigned pg = 0; pg < pageCount; pg++)
     {
         outstream << "Page " << pg << ":" << endl;
 
-        auto& curPage = m_doc->GetPages().GetPageAt(pg);
+        auto& curPage = getDocument().GetPages().GetPageAt(pg);
         outstream << "->Internal Number:" << curPage.GetPageNumber() << endl;
         outstream << "->Object Number:" << curPage.GetObject().GetIndirectReference().ObjectNumber()
             << " " << curPage.GetObject().GetIndirectReference().GenerationNumber() << " R" << endl;
@@ -140,7 +141,7 @@ void PdfInfoHelper::OutputOutlines(ostream& outstream, PdfOutlineItem* item, int
 {
     if (item == nullptr)
     {
-        auto outlines = m_doc->GetOutlines();
+        auto outlines = getDocument().GetOutlines();
         if (outlines == nullptr || !outlines->First())
         {
             outstream << "\tNone Found" << endl;
@@ -197,7 +198,7 @@ void PdfInfoHelper::OutputOneName(ostream& outStream, PdfNameTrees& names,
 
 void PdfInfoHelper::OutputNames(ostream& outStream)
 {
-    auto nameTree = m_doc->GetNames();
+    auto nameTree = getDocument().GetNames();
     if (nameTree == nullptr)
     {
         outStream << "\t\tNone Found" << endl;
@@ -214,13 +215,27 @@ string PdfInfoHelper::GuessFormat()
 {
     using Format = pair<double, double>;
 
-    unsigned pageCount = m_doc->GetPages().GetCount();
+    // NOTE: A single page is read from the probe,
+    // to not load the whole document
+    if (m_probe.GetPageCount() <= 1)
+    {
+        auto& mediaBox = m_probe.GetFirstPageMediaBox();
+        if (mediaBox == nullptr)
+            return "Unknown";
+
+        stringstream ss;
+        ss << mediaBox->Width - mediaBox->X << " x " << mediaBox->Height - mediaBox->Y << " pts";
+        return ss.str();
+    }
+
+    auto& pages = getDocument().GetPages();
+    unsigned pageCount = pages.GetCount();
     map<Format, int> sizes;
     map<Format, int>::iterator it;
     Rect rect;
     for (unsigned i = 0; i < pageCount; i++)
     {
-        auto& currPage = m_doc->GetPages().GetPageAt(i);
+        auto& currPage = pages.GetPageAt(i);
         rect = currPage.GetMediaBox();
         Format s(rect.Width - rect.X, rect.Height - rect.Y);
         it = sizes.find(s);
@@ -13,7 +13,6 @@ class PdfInfoHelper
 {
 public:
     PdfInfoHelper(const std::string& filepath);
-    virtual ~PdfInfoHelper();
 
     void OutputDocumentInfo(std::ostream& outStream);
     void OutputInfoDict(std::ostream& outStream);
@@ -22,10 +21,16 @@ public:
     void OutputNames(std::ostream& outStream);
 
 private:
-    PoDoFo::PdfMemDocument* m_doc;
+    PoDoFo::PdfMemDocument& getDocument();
+
+private:
+    std::string m_filepath;
+    PoDoFo::PdfDocumentProbe m_probe;
+    std::unique_ptr<PoDoFo::PdfMemDocument> m_doc;
 
     void OutputOneName(std::ostream& outStream, PoDoFo::PdfNameTrees& names,
         PoDoFo::PdfKnownNameTree treeName, const std::string_view& title);
+    void OutputInfoString(std::ostream& outStream, const std::string_view& key);
     std::string GuessFormat();
 };
 